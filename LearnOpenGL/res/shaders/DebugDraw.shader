@@ -0,0 +1,44 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec3 position;
+#ifdef WIDE_LINES
+layout(location = 1) in vec3 otherEnd;
+/* half the width in pixels, the sign picks the side of the segment */
+layout(location = 2) in float halfWidth;
+layout(location = 3) in vec4 vertexColor;
+#else
+layout(location = 1) in vec4 vertexColor;
+#endif
+
+out vec4 v_Color;
+
+uniform mat4 u_ViewProjection;
+uniform vec2 u_ViewportSize;
+
+void main()
+{
+   gl_Position = u_ViewProjection * vec4(position, 1.0);
+#ifdef WIDE_LINES
+   /* pushed sideways and past the end in screen space so the width is the same at any distance */
+   vec4 other = u_ViewProjection * vec4(otherEnd, 1.0);
+   vec2 halfViewport = u_ViewportSize * 0.5;
+   vec2 direction = other.xy / other.w * halfViewport - gl_Position.xy / gl_Position.w * halfViewport;
+   direction = length(direction) > 0.0001 ? normalize(direction) : vec2(1.0, 0.0);
+   vec2 offset = vec2(-direction.y, direction.x) * halfWidth - direction * abs(halfWidth);
+   gl_Position.xy += offset / halfViewport * gl_Position.w;
+#endif
+   v_Color = vertexColor;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+	color = v_Color;
+};
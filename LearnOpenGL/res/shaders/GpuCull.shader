@@ -0,0 +1,51 @@
+#shader vertex
+#version 330 core
+
+/* one instance per point, passed through for the geometry stage to keep or drop */
+layout(location = 0) in vec4 positionScale;
+layout(location = 1) in vec4 instanceColor;
+
+out vec4 g_PositionScale;
+out vec4 g_Color;
+
+void main()
+{
+   g_PositionScale = positionScale;
+   g_Color = instanceColor;
+}
+
+#shader geometry
+#version 330 core
+
+layout(points) in;
+layout(points, max_vertices = 1) out;
+
+in vec4 g_PositionScale[];
+in vec4 g_Color[];
+
+/* captured by transform feedback, only for instances that touch the view */
+out vec4 v_PositionScale;
+out vec4 v_Color;
+
+/* inward frustum planes, xyz normal and w distance */
+uniform vec4 u_Planes[6];
+/* the mesh's bounding sphere at scale 1 */
+uniform vec3 u_Center;
+uniform float u_Radius;
+
+void main()
+{
+   float scale = g_PositionScale[0].w;
+   vec3 center = g_PositionScale[0].xyz + u_Center * scale;
+   float radius = u_Radius * scale;
+   for (int i = 0; i < 6; i++)
+   {
+      if (dot(u_Planes[i].xyz, center) + u_Planes[i].w < -radius)
+         return;
+   }
+
+   v_PositionScale = g_PositionScale[0];
+   v_Color = g_Color[0];
+   EmitVertex();
+   EndPrimitive();
+}
@@ -0,0 +1,73 @@
+#shader vertex
+#version 330 core
+
+/* locations come from MeshData::GetShaderDefines, they depend on which attributes the mesh has */
+layout(location = POSITION_LOCATION) in vec3 position;
+#ifdef HAS_NORMAL
+layout(location = NORMAL_LOCATION) in vec3 normal;
+#endif
+#ifdef HAS_COLOR
+layout(location = COLOR_LOCATION) in vec4 vertexColor;
+#endif
+#ifdef INSTANCED
+/* from GpuCuller, after the at most four mesh attributes. Uniform scale then translation, u_Model is unused */
+layout(location = 4) in vec4 instancePositionScale;
+layout(location = 5) in vec4 instanceColor;
+#endif
+
+out vec3 v_WorldPosition;
+out vec3 v_Normal;
+out vec4 v_Color;
+
+uniform mat4 u_MVP;
+uniform mat4 u_Model;
+
+void main()
+{
+#ifdef INSTANCED
+   /* u_MVP is the view projection, instances are already in world space */
+   v_WorldPosition = position * instancePositionScale.w + instancePositionScale.xyz;
+   gl_Position = u_MVP * vec4(v_WorldPosition, 1.0);
+#else
+   gl_Position = u_MVP * vec4(position, 1.0);
+   v_WorldPosition = vec3(u_Model * vec4(position, 1.0));
+#endif
+#if defined(HAS_NORMAL) && defined(INSTANCED)
+   v_Normal = normal;
+#elif defined(HAS_NORMAL)
+   v_Normal = mat3(u_Model) * normal;
+#else
+   v_Normal = vec3(0.0);
+#endif
+#ifdef HAS_COLOR
+   v_Color = vertexColor;
+#else
+   v_Color = vec4(1.0);
+#endif
+#ifdef INSTANCED
+   v_Color *= instanceColor;
+#endif
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_WorldPosition;
+in vec3 v_Normal;
+in vec4 v_Color;
+
+uniform vec4 u_Color;
+
+void main()
+{
+#ifdef HAS_NORMAL
+	vec3 normal = normalize(v_Normal);
+#else
+	/* faceted normal from the screen space slope of the surface */
+	vec3 normal = normalize(cross(dFdx(v_WorldPosition), dFdy(v_WorldPosition)));
+#endif
+	float diffuse = abs(dot(normal, normalize(vec3(0.4, 0.8, 0.6))));
+	color = u_Color * v_Color * vec4(vec3(0.2 + 0.8 * diffuse), 1.0);
+};
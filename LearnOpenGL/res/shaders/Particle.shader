@@ -0,0 +1,67 @@
+#shader vertex
+#version 330 core
+
+/* quad corner per vertex, the particle per instance */
+layout(location = 0) in vec2 corner;
+#ifdef LIFE_FRACTION
+/* CPU particles arrive live only, with the fraction of their life already worked out */
+layout(location = 1) in vec4 positionLife;
+#else
+layout(location = 1) in vec4 positionAge;
+layout(location = 2) in vec4 velocityLifetime;
+#endif
+
+out vec4 v_Color;
+out vec2 v_Corner;
+
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+/* half size at birth and at death */
+uniform vec2 u_Size;
+/* colors over life, evenly spaced from birth to death */
+uniform vec4 u_Colors[4];
+
+void main()
+{
+#ifdef LIFE_FRACTION
+   vec3 position = positionLife.xyz;
+   float life = positionLife.w;
+#else
+   vec3 position = positionAge.xyz;
+   float life = positionAge.w / max(velocityLifetime.w, 0.0001);
+#endif
+   v_Corner = corner;
+   if (life >= 1.0)
+   {
+      /* dead, every corner lands on the same point outside the clip volume */
+      v_Color = vec4(0.0);
+      gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+      return;
+   }
+
+   float key = life * 3.0;
+   int index = min(int(key), 2);
+   v_Color = mix(u_Colors[index], u_Colors[index + 1], key - float(index));
+
+   /* expanded in view space so the quad always faces the camera */
+   vec4 center = u_View * vec4(position, 1.0);
+   center.xy += corner * mix(u_Size.x, u_Size.y, life);
+   gl_Position = u_Projection * center;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+in vec2 v_Corner;
+
+void main()
+{
+   /* round and soft edged */
+   float distance = dot(v_Corner, v_Corner);
+   if (distance > 1.0)
+      discard;
+   color = vec4(v_Color.rgb, v_Color.a * (1.0 - distance));
+}
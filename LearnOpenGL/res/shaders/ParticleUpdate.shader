@@ -0,0 +1,33 @@
+#shader vertex
+#version 330 core
+
+/* one point per particle, rasterizing is off and transform feedback captures the outputs */
+layout(location = 0) in vec4 positionAge;
+layout(location = 1) in vec4 velocityLifetime;
+
+out vec4 v_PositionAge;
+out vec4 v_VelocityLifetime;
+
+uniform float u_DeltaTime;
+uniform vec3 u_Gravity;
+/* velocity kept after this frame's drag */
+uniform float u_Damping;
+
+void main()
+{
+   vec3 position = positionAge.xyz;
+   vec3 velocity = velocityLifetime.xyz;
+   float age = positionAge.w;
+   float lifetime = velocityLifetime.w;
+
+   /* dead particles are copied unchanged until an emit reuses their slot */
+   if (age < lifetime)
+   {
+      velocity = (velocity + u_Gravity * u_DeltaTime) * u_Damping;
+      position += velocity * u_DeltaTime;
+      age += u_DeltaTime;
+   }
+
+   v_PositionAge = vec4(position, age);
+   v_VelocityLifetime = vec4(velocity, lifetime);
+}
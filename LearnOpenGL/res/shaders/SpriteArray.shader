@@ -0,0 +1,34 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 textCoord;
+layout(location = 2) in vec4 tint;
+
+out vec3 v_TextCoord;
+out vec4 v_Color;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+   gl_Position = u_MVP * position;
+   /* z is the texture array layer */
+   v_TextCoord = textCoord;
+   v_Color = tint;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_TextCoord;
+in vec4 v_Color;
+
+uniform sampler2DArray u_Textures;
+
+void main()
+{
+	color = texture(u_Textures, v_TextCoord) * v_Color;
+};
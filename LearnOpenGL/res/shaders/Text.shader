@@ -0,0 +1,38 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 textCoord;
+layout(location = 2) in vec4 tint;
+
+out vec3 v_TextCoord;
+out vec4 v_Color;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+   gl_Position = u_MVP * position;
+   /* z is the glyph cache page */
+   v_TextCoord = textCoord;
+   v_Color = tint;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_TextCoord;
+in vec4 v_Color;
+
+uniform sampler2DArray u_Atlas;
+
+void main()
+{
+	/* 0.5 is the outline, fwidth keeps the edge about a pixel wide at any size */
+	float distance = texture(u_Atlas, v_TextCoord).r;
+	float width = max(fwidth(distance) * 0.5, 1e-4);
+	float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+	color = vec4(v_Color.rgb, v_Color.a * coverage);
+};
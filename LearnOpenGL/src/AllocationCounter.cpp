@@ -0,0 +1,161 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static std::atomic<unsigned long long> s_Allocations(0);
+static std::atomic<unsigned long long> s_Bytes(0);
+static std::atomic<AllocationCounter::Hook> s_Hook(nullptr);
+static thread_local unsigned long long s_ThreadAllocations = 0;
+
+#if ALLOCATION_COUNTER_ENABLED
+
+static thread_local bool s_InHook = false;
+
+static void Count(std::size_t size)
+{
+	s_Allocations.fetch_add(1, std::memory_order_relaxed);
+	s_Bytes.fetch_add(size, std::memory_order_relaxed);
+	s_ThreadAllocations++;
+
+	AllocationCounter::Hook hook = s_Hook.load(std::memory_order_acquire);
+	if (hook && !s_InHook)
+	{
+		s_InHook = true;
+		hook(size);
+		s_InHook = false;
+	}
+}
+
+static void* Allocate(std::size_t size)
+{
+	/* zero sized allocations still need a unique pointer */
+	void* memory = std::malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	Count(size);
+	return memory;
+}
+
+static void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+	/* posix_memalign wants at least pointer alignment, _aligned_malloc takes anything */
+	std::size_t bytes = size ? size : 1;
+	std::size_t align = std::max((std::size_t)alignment, sizeof(void*));
+#ifdef _WIN32
+	void* memory = _aligned_malloc(bytes, align);
+#else
+	void* memory = nullptr;
+	if (posix_memalign(&memory, align, bytes) != 0)
+		memory = nullptr;
+#endif
+	if (!memory)
+		throw std::bad_alloc();
+	Count(size);
+	return memory;
+}
+
+static void FreeAligned(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+/*
+* The nothrow and placement forms are left to the library, its nothrow
+* versions forward to these. Aligned memory has to go back through
+* FreeAligned, _aligned_malloc blocks cannot be passed to free.
+*/
+void* operator new(std::size_t size)
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+#endif
+
+namespace AllocationCounter
+{
+	unsigned long long GetAllocations()
+	{
+		return s_Allocations.load(std::memory_order_relaxed);
+	}
+
+	unsigned long long GetBytes()
+	{
+		return s_Bytes.load(std::memory_order_relaxed);
+	}
+
+	unsigned long long GetThreadAllocations()
+	{
+		return s_ThreadAllocations;
+	}
+
+	void SetHook(Hook hook)
+	{
+		s_Hook.store(hook, std::memory_order_release);
+	}
+}
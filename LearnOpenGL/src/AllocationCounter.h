@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+
+/*
+* Set to 0 to leave the global operator new and delete to the library, for
+* builds that link an allocator of their own or a tool that replaces them.
+* Nothing is counted then and IsEnabled says so.
+*/
+#ifndef ALLOCATION_COUNTER_ENABLED
+#define ALLOCATION_COUNTER_ENABLED 1
+#endif
+
+/*
+* Counts every heap allocation made through operator new
+* AllocationCounter.cpp replaces the global operator new and delete, the
+* aligned forms included, so standard containers, strings and streams are
+* all counted, whichever thread they run on. Counting is a relaxed atomic
+* add next to malloc. Allocations straight through malloc, by drivers or C
+* libraries, are not seen.
+*/
+namespace AllocationCounter
+{
+	/* false when compiled out, every count stays at zero */
+	inline bool IsEnabled() { return ALLOCATION_COUNTER_ENABLED != 0; }
+
+	/*
+	* Called after every counted allocation on the allocating thread. It must
+	* not allocate itself, allocations made from inside it are counted but do
+	* not call it again.
+	*/
+	typedef void (*Hook)(std::size_t size);
+
+	/* since the program started, all threads */
+	unsigned long long GetAllocations();
+	unsigned long long GetBytes();
+	/* since the calling thread started */
+	unsigned long long GetThreadAllocations();
+
+	/* null removes it */
+	void SetHook(Hook hook);
+}
@@ -1,10 +1,17 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "Renderer.h"
 
@@ -14,50 +21,612 @@
 #include "VertexArray.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "FramePacer.h"
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+#include "TransformBenchmark.h"
+#include "TransformHierarchy.h"
+#include "Culler.h"
+#include "CullingBenchmark.h"
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "FrameCapture.h"
+#include "PerfSuite.h"
+#include "StatsOverlay.h"
+#include "GpuMemory.h"
+#include "TextureStreamer.h"
+#include "UploadBenchmark.h"
+#include "TextBenchmark.h"
+#include "TextRenderer.h"
+#include "DebugDraw.h"
+#include "MeshImporter.h"
+#include "LodSelector.h"
+#include "ParticleSystem.h"
+#include "CpuParticleSystem.h"
+#include "ParticleBenchmark.h"
+#include "GpuCuller.h"
+#include "OcclusionBuffer.h"
+#include "SoftwareRasterBenchmark.h"
+#include "GLTraceReplay.h"
+#include "MicroBenchmark.h"
+#include "RenderThread.h"
+#include "RenderThreadBenchmark.h"
+#include "AllocationCounter.h"
+#include "FrameArena.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
-int main(void)
+/* Settings picked on the command line */
+struct AppOptions
 {
-    GLFWwindow* window;
+    bool Headless;
+    int Width, Height;
+    /* headless only, number of frames to render before exiting */
+    unsigned int FrameCount;
+    /* frames are captured here when not empty, a directory for images or a file for Y4M */
+    std::string OutputPath;
+    CaptureFormat Format;
+    CapturePolicy Policy;
+    /* runs the perf and image regression suite from this directory instead of the demo */
+    std::string SuiteDirectory;
+    std::string ReportPath;
+    bool UpdateBaseline;
+    /* renderer counters and frame time graph, on by default when windowed */
+    bool Overlay;
+    /* GPU memory budget in megabytes, 0 for none */
+    unsigned int GpuBudget;
+    /* evict streamed texture levels when over the budget instead of only warning */
+    bool GpuEvict;
+    /* measures 1080p texture upload rates instead of running the demo */
+    bool UploadBenchmark;
+    /* TrueType font for text, the demo draws a label with it */
+    std::string FontPath;
+    /* measures text layout and rendering with FontPath instead of running the demo */
+    bool TextBenchmark;
+    /* outlines the culling bounds of every visible object and tints mesh copies by level of detail */
+    bool DebugDraw;
+    /* OBJ, glTF or GLB drawn spinning over the demo */
+    std::string MeshPath;
+    /* LOD target errors for the mesh, relative to its bounding radius. With any the mesh is drawn as a field of copies */
+    std::vector<float> LodErrors;
+    /* capacity of the GPU particle fountain, 0 for none */
+    unsigned int ParticleCount;
+    /* capacity of the CPU particle fountain next to it, 0 for none */
+    unsigned int CpuParticleCount;
+    /* measures CPU particle updates of a million particles per thread count instead of running the demo */
+    bool ParticleBenchmark;
+    /* boxes in the GPU culled city, 0 for none */
+    unsigned int GpuCullCount;
+    /* the city draws last frame's culling results instead of waiting for this frame's */
+    bool GpuCullLatency;
+    /* boxes in the same city culled on the CPU against a software depth buffer of the walls, 0 for none */
+    unsigned int OcclusionCount;
+    /* measures the CPU rasterizer and compares it with GL when a context can be made, instead of running the demo */
+    bool SoftRasterBenchmark;
+    /* every GL call of the run is recorded here when not empty */
+    std::string TracePath;
+    /* plays this GL trace back and times it instead of running the demo */
+    std::string ReplayPath;
+    /* the replay keeps to the frame times of the capture instead of going as fast as it can */
+    bool ReplayPaced;
+    /* times the wrappers' hot paths against a null GL device and writes ReportPath, no GPU needed */
+    bool MicroBenchmark;
+    /* only micro benchmarks whose name contains this */
+    std::string BenchmarkFilter;
+    /* sprites in a CPU heavy scene measured with and without a render thread instead of the demo, 0 for none */
+    unsigned int RenderThreadSprites;
+    /* fails the run when a frame after the first half of FrameCount allocates from the heap on any thread */
+    bool AllocationCheck;
+    /* the frame arena asks for 2 MB pages */
+    bool HugePages;
+    /* times the job system on 1 to every hardware thread instead of running the demo, no GPU needed */
+    bool JobBenchmark;
+    /* times TransformHierarchy against a naive glm scene graph instead of running the demo, no GPU needed */
+    bool TransformBenchmark;
+    /* culls a million objects with every index instead of running the demo, no GPU needed */
+    bool CullingBenchmark;
+    /* rounds of the job system stress test to run instead of the demo, 0 for none */
+    unsigned int JobStressRounds;
+    /* how frames are presented, headless runs are uncapped unless limited */
+    PresentMode Present;
+    /* frame rate the limited mode keeps to */
+    double TargetFPS;
+};
 
-    /* Initialize the library */
-    if (!glfwInit())
-        return -1;
+static void PrintUsage()
+{
+    std::cout << "Usage: LearnOpenGL [--windowed | --headless] [--width N] [--height N] [--frames N]" << std::endl;
+    std::cout << "                  [--output PATH] [--format png|qoi|ppm|y4m] [--policy drop|block]" << std::endl;
+    std::cout << "                  [--overlay | --no-overlay] [--gpu-budget MB [--gpu-evict]]" << std::endl;
+    std::cout << "                  [--suite DIR [--report PATH] [--update-baseline]] [--upload-bench]" << std::endl;
+    std::cout << "                  [--font PATH] [--text-bench] [--debug-draw] [--mesh PATH [--lod | --lod-errors E,E,...]]" << std::endl;
+    std::cout << "                  [--particles N] [--cpu-particles N] [--particle-bench] [--gpu-cull N [--gpu-cull-latency] | --occlusion N]" << std::endl;
+    std::cout << "                  [--soft-raster] [--trace PATH] [--replay PATH [--replay-paced]]" << std::endl;
+    std::cout << "                  [--micro-bench [--bench-filter NAME] [--report PATH]] [--render-thread N]" << std::endl;
+    std::cout << "                  [--job-bench] [--job-stress ROUNDS] [--transform-bench] [--cull-bench] [--alloc-check] [--huge-pages] [--present vsync|adaptive|uncapped|limited] [--fps N]" << std::endl;
+}
 
-    /* Create window and context with CORE profile*/
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); 
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+static bool ParseCommandLine(int argc, char** argv, AppOptions& options)
+{
+    options.Headless = false;
+    options.Width = 960;
+    options.Height = 540;
+    options.FrameCount = 60;
+    options.Format = CaptureFormat::PNG;
+    options.ReportPath = "suite_report.json";
+    options.UpdateBaseline = false;
+    options.GpuBudget = 0;
+    options.GpuEvict = false;
+    options.UploadBenchmark = false;
+    options.TextBenchmark = false;
+    options.DebugDraw = false;
+    options.ParticleCount = 0;
+    options.CpuParticleCount = 0;
+    options.ParticleBenchmark = false;
+    options.GpuCullCount = 0;
+    options.GpuCullLatency = false;
+    options.OcclusionCount = 0;
+    options.SoftRasterBenchmark = false;
+    options.ReplayPaced = false;
+    options.MicroBenchmark = false;
+    options.RenderThreadSprites = 0;
+    options.JobBenchmark = false;
+    options.JobStressRounds = 0;
+    options.TransformBenchmark = false;
+    options.CullingBenchmark = false;
+    options.AllocationCheck = false;
+    options.HugePages = false;
+    options.Present = PresentMode::VSync;
+    options.TargetFPS = 60.0;
+#ifdef _WIN32
+    options.FontPath = "C:/Windows/Fonts/arial.ttf";
+#endif
+    bool policySet = false;
+    bool overlaySet = false;
+    bool reportSet = false;
+    bool presentSet = false;
+    bool fpsSet = false;
 
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(960, 540, "OpenGL Practice", NULL, NULL);
-    if (!window)
+    for (int i = 1; i < argc; i++)
     {
-        glfwTerminate();
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--headless")
+            options.Headless = true;
+        else if (arg == "--windowed")
+            options.Headless = false;
+        else if (arg == "--width" && hasValue)
+            options.Width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue)
+            options.Height = std::atoi(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            options.FrameCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--output" && hasValue)
+            options.OutputPath = argv[++i];
+        else if (arg == "--format" && hasValue)
+        {
+            std::string format = argv[++i];
+            if (format == "png")
+                options.Format = CaptureFormat::PNG;
+            else if (format == "qoi")
+                options.Format = CaptureFormat::QOI;
+            else if (format == "ppm")
+                options.Format = CaptureFormat::PPM;
+            else if (format == "y4m")
+                options.Format = CaptureFormat::Y4M;
+            else
+                return false;
+        }
+        else if (arg == "--policy" && hasValue)
+        {
+            std::string policy = argv[++i];
+            if (policy != "drop" && policy != "block")
+                return false;
+            options.Policy = policy == "drop" ? CapturePolicy::Drop : CapturePolicy::Block;
+            policySet = true;
+        }
+        else if (arg == "--suite" && hasValue)
+        {
+            options.SuiteDirectory = argv[++i];
+            options.Headless = true;
+        }
+        else if (arg == "--report" && hasValue)
+        {
+            options.ReportPath = argv[++i];
+            reportSet = true;
+        }
+        else if (arg == "--update-baseline")
+            options.UpdateBaseline = true;
+        else if (arg == "--upload-bench")
+        {
+            options.UploadBenchmark = true;
+            options.Headless = true;
+        }
+        else if (arg == "--font" && hasValue)
+            options.FontPath = argv[++i];
+        else if (arg == "--text-bench")
+        {
+            options.TextBenchmark = true;
+            options.Headless = true;
+        }
+        else if (arg == "--mesh" && hasValue)
+            options.MeshPath = argv[++i];
+        else if (arg == "--lod")
+            options.LodErrors = { 0.0025f, 0.01f, 0.04f, 0.15f };
+        else if (arg == "--lod-errors" && hasValue)
+        {
+            options.LodErrors.clear();
+            std::stringstream list(argv[++i]);
+            std::string error;
+            while (std::getline(list, error, ','))
+                options.LodErrors.push_back((float)std::atof(error.c_str()));
+        }
+        else if (arg == "--particles" && hasValue)
+            options.ParticleCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--cpu-particles" && hasValue)
+            options.CpuParticleCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--particle-bench")
+        {
+            options.ParticleBenchmark = true;
+            options.Headless = true;
+        }
+        else if (arg == "--gpu-cull" && hasValue)
+            options.GpuCullCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--gpu-cull-latency")
+            options.GpuCullLatency = true;
+        else if (arg == "--occlusion" && hasValue)
+            options.OcclusionCount = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--soft-raster")
+        {
+            options.SoftRasterBenchmark = true;
+            options.Headless = true;
+        }
+        else if (arg == "--trace" && hasValue)
+            options.TracePath = argv[++i];
+        else if (arg == "--replay" && hasValue)
+        {
+            options.ReplayPath = argv[++i];
+            options.Headless = true;
+        }
+        else if (arg == "--replay-paced")
+            options.ReplayPaced = true;
+        else if (arg == "--micro-bench")
+        {
+            options.MicroBenchmark = true;
+            options.Headless = true;
+        }
+        else if (arg == "--bench-filter" && hasValue)
+            options.BenchmarkFilter = argv[++i];
+        else if (arg == "--render-thread" && hasValue)
+            options.RenderThreadSprites = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--job-bench")
+            options.JobBenchmark = true;
+        else if (arg == "--job-stress" && hasValue)
+            options.JobStressRounds = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--transform-bench")
+            options.TransformBenchmark = true;
+        else if (arg == "--cull-bench")
+            options.CullingBenchmark = true;
+        else if (arg == "--alloc-check")
+            options.AllocationCheck = true;
+        else if (arg == "--huge-pages")
+            options.HugePages = true;
+        else if (arg == "--present" && hasValue)
+        {
+            std::string present = argv[++i];
+            if (present == "vsync")
+                options.Present = PresentMode::VSync;
+            else if (present == "adaptive")
+                options.Present = PresentMode::AdaptiveVSync;
+            else if (present == "uncapped")
+                options.Present = PresentMode::Uncapped;
+            else if (present == "limited")
+                options.Present = PresentMode::Limited;
+            else
+                return false;
+            presentSet = true;
+        }
+        else if (arg == "--fps" && hasValue)
+        {
+            options.TargetFPS = std::atof(argv[++i]);
+            if (options.TargetFPS <= 0.0)
+                return false;
+            fpsSet = true;
+        }
+        else if (arg == "--debug-draw")
+            options.DebugDraw = true;
+        else if (arg == "--gpu-budget" && hasValue)
+            options.GpuBudget = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--gpu-evict")
+            options.GpuEvict = true;
+        else if (arg == "--overlay" || arg == "--no-overlay")
+        {
+            options.Overlay = arg == "--overlay";
+            overlaySet = true;
+        }
+        else
+        {
+            std::cout << "Unknown argument " << arg << std::endl;
+            return false;
+        }
+    }
+
+    /* headless output is for review, keep every frame unless asked otherwise */
+    if (!policySet)
+        options.Policy = options.Headless ? CapturePolicy::Block : CapturePolicy::Drop;
+    if (!overlaySet)
+        options.Overlay = !options.Headless;
+    /* a target frame rate alone means the limiter */
+    if (!presentSet && fpsSet)
+        options.Present = PresentMode::Limited;
+    if (!reportSet && options.MicroBenchmark)
+        options.ReportPath = "micro_bench.json";
+
+    /* both draw the same city */
+    if (options.GpuCullCount > 0 && options.OcclusionCount > 0)
+        return false;
+
+    return options.Width > 0 && options.Height > 0;
+}
+
+/*
+* Loads the GL entry points for the current context. A GLEW built for GLX
+* still loads them all under an EGL context but reports that there is no GLX
+* display, so that one error only counts as success on the EGL headless path.
+*/
+static bool InitGlew(const HeadlessContext& headlessContext)
+{
+    glewExperimental = GL_TRUE;
+    GLenum result = glewInit();
+    if (result == GLEW_OK || (result == GLEW_ERROR_NO_GLX_DISPLAY && headlessContext.IsEGL()))
+        return true;
+
+    std::cout << "Error! glewInit failed: " << glewGetErrorString(result) << std::endl;
+    return false;
+}
+
+/* set by the threads that work on frames, so the first steady state allocation can say where it came from */
+static thread_local const char* s_FrameThreadName = nullptr;
+static thread_local unsigned long long s_FrameThreadFrame = 0;
+
+/* first steady state allocation on any thread, a breakpoint here stops on it */
+static std::atomic<bool> s_SteadyAllocationSeen(false);
+static std::size_t s_FirstSteadyAllocation = 0;
+static const char* s_FirstSteadyThread = nullptr;
+static unsigned long long s_FirstSteadyFrame = 0;
+static void RecordSteadyAllocation(std::size_t size)
+{
+    if (s_SteadyAllocationSeen.exchange(true))
+        return;
+    s_FirstSteadyAllocation = size;
+    s_FirstSteadyThread = s_FrameThreadName;
+    s_FirstSteadyFrame = s_FrameThreadFrame;
+}
+
+/*
+* A city of count boxes in blocks of 16 x 16 on the xz plane, block by block
+* so each block is one contiguous range, and walls across it that hide whole
+* blocks from the camera at street level. Returns half the city's width.
+*/
+static float BuildCity(unsigned int count, std::vector<GpuInstance>& instances, std::vector<unsigned int>& blockSizes, std::vector<AABB>& walls)
+{
+    const unsigned int blockSize = 16;
+    const float spacing = 4.0f;
+    unsigned int blocksPerSide = (unsigned int)std::ceil(std::sqrt(count / (float)(blockSize * blockSize)));
+    float halfSize = blocksPerSide * blockSize * spacing * 0.5f;
+
+    unsigned int random = 1;
+    auto nextRandom = [&random]() {
+        random = random * 1664525u + 1013904223u;
+        return (random >> 8) * (1.0f / 16777216.0f);
+    };
+    for (unsigned int block = 0; block < blocksPerSide * blocksPerSide && instances.size() < count; block++)
+    {
+        unsigned int blockCount = 0;
+        for (unsigned int i = 0; i < blockSize * blockSize && instances.size() < count; i++, blockCount++)
+        {
+            float x = ((block % blocksPerSide) * blockSize + i % blockSize + 0.5f) * spacing - halfSize;
+            float z = ((block / blocksPerSide) * blockSize + i / blockSize + 0.5f) * spacing - halfSize;
+            float scale = 0.4f + 0.8f * nextRandom();
+            instances.push_back({ x, scale, z, scale, 0.5f + 0.5f * nextRandom(), 0.5f + 0.5f * nextRandom(), 0.5f + 0.5f * nextRandom(), 1.0f });
+        }
+        blockSizes.push_back(blockCount);
+    }
+
+    for (int i = 1; i < 5; i++)
+    {
+        float z = -halfSize + i * halfSize * 0.4f;
+        walls.push_back(AABB(glm::vec3(-halfSize, 0.0f, z - 0.5f), glm::vec3(halfSize, 12.0f, z + 0.5f)));
+    }
+    return halfSize;
+}
+
+int main(int argc, char** argv)
+{
+    AppOptions options;
+    if (!ParseCommandLine(argc, argv, options))
+    {
+        PrintUsage();
         return -1;
     }
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
+
+    /* plain CPU work, build with LEARNOPENGL_SANITIZE_THREAD to run the stress test under ThreadSanitizer */
+    if (options.JobBenchmark || options.JobStressRounds > 0)
+    {
+        JobBenchmark benchmark;
+        bool passed = options.JobStressRounds == 0 || benchmark.RunStress(options.JobStressRounds);
+        if (options.JobBenchmark)
+            passed = benchmark.RunScaling() && passed;
+        return passed ? 0 : 1;
+    }
+
+    if (options.TransformBenchmark)
+    {
+        TransformBenchmark benchmark(100000, options.FrameCount);
+        return benchmark.Run() ? 0 : 1;
+    }
+
+    if (options.CullingBenchmark)
+    {
+        CullingBenchmark benchmark(1000000, options.FrameCount);
+        return benchmark.Run() ? 0 : 1;
+    }
+
+    /* GL goes to a null device, so this runs on machines without a GPU */
+    if (options.MicroBenchmark)
+    {
+        MicroBenchmark benchmark;
+        benchmark.SetFilter(options.BenchmarkFilter);
+        return benchmark.Run(options.ReportPath) ? 0 : 1;
+    }
+
+    /* the CPU rasterizer needs no context, render nodes without a GPU only skip the comparison */
+    if (options.SoftRasterBenchmark)
+    {
+        /* the output path, if any, gets the CPU image of the demo quad */
+        SoftwareRasterBenchmark benchmark(options.Width, options.Height, options.FrameCount);
+        benchmark.Run(options.OutputPath);
+        if (!headlessContext.Create())
+            return 0;
+        if (!InitGlew(headlessContext))
+            return 1;
+        return benchmark.CompareWithGL(2) ? 0 : 1;
+    }
+
+    if (options.Headless)
+    {
+        /* no window, frames go into a framebuffer object and are read back */
+        if (!headlessContext.Create())
+            return -1;
+    }
+    else
+    {
+        /* Initialize the library */
+        if (!glfwInit())
+            return -1;
+
+        /* Create window and context with CORE profile*/
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); 
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); 
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    /* synchronizes with our monitor's frame rate */
-    glfwSwapInterval(1);
+        /* Create a windowed mode window and its OpenGL context */
+        window = glfwCreateWindow(options.Width, options.Height, "OpenGL Practice", NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        /* Make the window's context current */
+        glfwMakeContextCurrent(window);
+    }
 
     /* 
     * Initialization succeeded
     * Can use the available extensions as well as core OpenGL functionality 
     */
-    if (glewInit() != GLEW_OK)
-        std::cout << "Error!" << std::endl;
+    if (!InitGlew(headlessContext))
+    {
+        if (window)
+            glfwTerminate();
+        return -1;
+    }
+
+    /* moves the context to whichever thread renders, the render thread takes it and hands it back */
+    auto bindContext = [window, &headlessContext](bool current)
+    {
+        if (window)
+            glfwMakeContextCurrent(current ? window : NULL);
+        else if (current)
+            headlessContext.MakeCurrent();
+        else
+            headlessContext.ReleaseCurrent();
+    };
 
     /* Print OpenGL version */ 
     std::cout << glGetString(GL_VERSION) << std::endl; 
 
+    if (options.GpuBudget)
+    {
+        GpuMemory::SetBudget((unsigned long long)options.GpuBudget * 1024 * 1024);
+        GpuMemory::SetBudgetCallback([](unsigned long long used, unsigned long long budget)
+        {
+            std::cout << "Warning: GPU memory " << used / (1024 * 1024) << " MB is over the "
+                << budget / (1024 * 1024) << " MB budget" << std::endl;
+        });
+        /* streamed textures are the only evictable allocations, they load their levels again when wanted */
+        GpuMemory::SetEvictOverBudget(options.GpuEvict);
+    }
+
+    if (!options.SuiteDirectory.empty())
+    {
+        PerfSuite suite(options.SuiteDirectory, options.Width, options.Height);
+        suite.SetUpdateBaseline(options.UpdateBaseline);
+        /* non zero exit code so scripts can fail on regressions */
+        return suite.Run(options.ReportPath) ? 0 : 1;
+    }
+
+    if (options.UploadBenchmark)
+    {
+        JobSystem jobs;
+        UploadBenchmark benchmark(&jobs, 1920, 1080, options.FrameCount);
+        return benchmark.Run() ? 0 : 1;
+    }
+
+    if (options.TextBenchmark)
+    {
+        /* the output path, if any, gets the last frame so the text can be checked by eye */
+        TextBenchmark benchmark(options.FontPath, options.Width, options.Height, options.FrameCount);
+        return benchmark.Run(options.OutputPath) ? 0 : 1;
+    }
+
+    if (options.ParticleBenchmark)
+    {
+        ParticleBenchmark benchmark(1000000, options.FrameCount);
+        return benchmark.Run() ? 0 : 1;
+    }
+
+    /* windowed too, the render thread then swaps and the main thread keeps polling events */
+    if (options.RenderThreadSprites > 0)
+    {
+        bool complete;
+        {
+            RenderThreadBenchmark benchmark(options.Width, options.Height, options.FrameCount, options.RenderThreadSprites);
+            complete = benchmark.Run(window, bindContext);
+        }
+        if (!options.Headless)
+            glfwTerminate();
+        return complete ? 0 : 1;
+    }
+
+    if (!options.ReplayPath.empty())
+    {
+        GLTraceReplay replay(options.ReplayPath);
+        return replay.Run(options.ReplayPaced) ? 0 : 1;
+    }
+
+    /* from here on every GL call goes into the trace, resources included, so the replay is self contained */
+    if (!options.TracePath.empty() && !GLTrace::Begin(options.TracePath, options.Width, options.Height))
+        return -1;
+
+    if (options.AllocationCheck && !AllocationCounter::IsEnabled())
+    {
+        std::cout << "Allocation check is not available, operator new is not replaced (ALLOCATION_COUNTER_ENABLED 0)" << std::endl;
+        return 1;
+    }
+    bool allocationCheckPassed = true;
+
     /* Placed inside new scope so Buffers are destroyed before glfwTerminate when the glfw context is destroyed */
     /* Best to heap allocate buffers and destroy before glfwTerminate. Rare case here as making vBuffers in main func scope */
     {
+        /* worker threads for asset loading and per-object work, main thread helps while waiting */
+        JobSystem jobs;
 
         float positions[] = {
             100.0f, 100.0f, 0.0f, 0.0f, //Bottom left, last two floats are text coords
@@ -99,7 +668,11 @@ int main(void)
         * moderl matrix 
         * moving moderl 200 to the right and 200 upwards
         */
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(200, 200, 0));
+        TransformHierarchy transforms(&jobs);
+        TransformHierarchy::NodeID quadNode = transforms.CreateNode();
+        transforms.SetPosition(quadNode, glm::vec3(200, 200, 0));
+        transforms.Update();
+        glm::mat4 model = transforms.GetWorldMatrix(quadNode);
 
         // in reverse order due to OpenGL expecting data in column major order
         glm::mat4 mvp = proj * view * model; 
@@ -109,8 +682,10 @@ int main(void)
         shader.SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
         shader.SetUniformMat4f("u_MVP", mvp);
 
-        Texture texture("res/textures/Emily_D&P_NoBG.png");
-        texture.Bind();
+        /* only the mip levels the quad's size on screen needs are kept resident, in 64 MB or what --gpu-budget leaves */
+        TextureStreamer streamer(&jobs, 64ull * 1024 * 1024);
+        StreamedTexture* texture = streamer.Load("res/textures/Emily_D&P_NoBG.png");
+        texture->Bind();
         // Pass in 0 b/c we have bound texture to slot 0
         shader.SetUniform1i("u_Texture", 0);
 
@@ -121,12 +696,194 @@ int main(void)
 
         Renderer renderer;
 
+        std::unique_ptr<StatsOverlay> overlay;
+        if (options.Overlay)
+            overlay.reset(new StatsOverlay(options.Width, options.Height));
+
+        /* label drawn with the font when one is available */
+        TrueTypeFont font;
+        std::unique_ptr<TextRenderer> text;
+        if (!options.FontPath.empty() && font.Load(options.FontPath))
+            text.reset(new TextRenderer());
+
+        /* the binary cache next to the file makes every load after the first a straight upload */
+        std::unique_ptr<Mesh> mesh;
+        std::unique_ptr<Shader> meshShader;
+        float meshAngle = 0.0f;
+        if (!options.MeshPath.empty())
+        {
+            MeshImporter importer(&jobs);
+            importer.SetLodErrors(options.LodErrors);
+            mesh = importer.Load(options.MeshPath);
+            if (mesh)
+            {
+                const MeshImportStats& stats = importer.GetStats();
+                std::cout << "Mesh " << options.MeshPath << ": " << stats.Vertices << " vertices, " << stats.Triangles << " triangles, "
+                    << (stats.FromCache ? "from cache" : "imported") << " in " << stats.LoadMilliseconds << " ms, uploaded in "
+                    << stats.UploadMilliseconds << " ms" << std::endl;
+                if (stats.LodMilliseconds > 0.0f)
+                    std::cout << "Built " << stats.LodCount - 1 << " levels of detail in " << stats.LodMilliseconds << " ms" << std::endl;
+                for (unsigned int level = 1; level < mesh->GetLodCount(); level++)
+                    std::cout << "  LOD " << level << ": " << mesh->GetLod(level).IndexCount / 3 << " triangles, error " << mesh->GetLod(level).Error << std::endl;
+                meshShader.reset(new Shader("res/shaders/Mesh.shader", mesh->GetShaderDefines()));
+            }
+        }
+
+        /* with levels of detail the mesh becomes a field of copies, each keeping the level it had last frame */
+        const int lodFieldSize = 16;
+        std::vector<unsigned int> lodLevels(lodFieldSize * lodFieldSize, 0);
+        LodSelector lodSelector;
+        unsigned long long lodTrianglesDrawn = 0, lodTrianglesFull = 0, lodSwitches = 0, lodFrames = 0;
+
+        /* a fountain that keeps every slot busy, lifetimes average out to the capacity */
+        std::unique_ptr<ParticleSystem> particles;
+        ParticleEmitter fountain = { glm::vec3(0.0f, -1.0f, 0.0f), 0.05f, glm::vec3(0.0f, 6.0f, 0.0f), 1.5f, 0.0f, 1.5f, 2.5f };
+        if (options.ParticleCount > 0)
+        {
+            particles.reset(new ParticleSystem(options.ParticleCount));
+            particles->SetDrag(0.3f);
+            particles->SetSize(0.02f, 0.005f);
+            fountain.Rate = options.ParticleCount / fountain.MaxLifetime;
+        }
+
+        /* the CPU one stands to the right and bounces off the floor at its base */
+        std::unique_ptr<CpuParticleSystem> cpuParticles;
+        ParticleEmitter cpuFountain = { glm::vec3(2.0f, -1.0f, 0.0f), 0.05f, glm::vec3(0.0f, 6.0f, 0.0f), 1.5f, 0.0f, 1.5f, 2.5f };
+        if (options.CpuParticleCount > 0)
+        {
+            cpuParticles.reset(new CpuParticleSystem(options.CpuParticleCount, &jobs));
+            cpuParticles->SetDrag(0.3f);
+            cpuParticles->SetSize(0.02f, 0.005f);
+            cpuParticles->SetGround(-1.0f, 0.5f);
+            cpuFountain.Rate = options.CpuParticleCount / cpuFountain.MaxLifetime;
+        }
+
+        /* the same city either way, --gpu-cull culls it on the GPU and --occlusion on the CPU */
+        std::unique_ptr<Mesh> cityBox;
+        std::unique_ptr<GpuCuller> gpuCuller;
+        std::unique_ptr<Shader> wallShader;
+        std::vector<GpuInstance> cityInstances;
+        std::vector<AABB> walls;
+        float cityAngle = 0.0f, cityHalfSize = 0.0f;
+        unsigned long long cityVisible = 0, cityTested = 0, cityOccluded = 0, cityFrames = 0;
+        double cityWait = 0.0;
+        std::unique_ptr<Culler> boxCuller;
+        std::unique_ptr<OcclusionBuffer> occlusion;
+        std::unique_ptr<Texture> occlusionTexture;
+        std::unique_ptr<Shader> occlusionShader;
+        MeshData cityBoxData = MeshData::MakeCube();
+        std::vector<unsigned int> cityObjects;
+        std::vector<unsigned char> occlusionPixels;
+        double occlusionRasterize = 0.0, occlusionTest = 0.0;
+        unsigned int cityCount = std::max(options.GpuCullCount, options.OcclusionCount);
+        if (cityCount > 0)
+        {
+            cityBox.reset(new Mesh(cityBoxData));
+            wallShader.reset(new Shader("res/shaders/Mesh.shader", cityBox->GetShaderDefines()));
+            std::vector<unsigned int> blockSizes;
+            cityHalfSize = BuildCity(cityCount, cityInstances, blockSizes, walls);
+
+            if (options.GpuCullCount > 0)
+            {
+                gpuCuller.reset(new GpuCuller(*cityBox, options.GpuCullCount));
+                gpuCuller->SetLatency(options.GpuCullLatency);
+                gpuCuller->SetInstances(cityInstances.data(), (unsigned int)cityInstances.size(), blockSizes.data(), (unsigned int)blockSizes.size());
+            }
+            else
+            {
+                /* object ids are the instance indices */
+                boxCuller.reset(new Culler(SpatialIndexType::BVH));
+                for (const GpuInstance& instance : cityInstances)
+                {
+                    glm::vec3 center(instance.X, instance.Y, instance.Z);
+                    boxCuller->Add(AABB(center - instance.Scale, center + instance.Scale));
+                }
+                /* every box could be visible at once, so the list never grows while the camera turns */
+                cityObjects.reserve(cityInstances.size());
+                occlusion.reset(new OcclusionBuffer(256, 128, &jobs));
+                if (options.DebugDraw)
+                {
+                    occlusionTexture.reset(new Texture(occlusion->GetWidth(), occlusion->GetHeight(), nullptr));
+                    occlusionShader.reset(new Shader("res/shaders/Sprite.shader"));
+                }
+            }
+        }
+
+        std::unique_ptr<DebugDraw> debugDraw;
+        if (options.DebugDraw)
+            debugDraw.reset(new DebugDraw(options.Width, options.Height));
+
+        /* quad bounds in world space, the same corners as positions[] moved by the model matrix */
+        Culler culler(SpatialIndexType::LooseQuadtree, AABB(glm::vec3(-1920.0f, -1080.0f, -1.0f), glm::vec3(2880.0f, 1620.0f, 1.0f)));
+        unsigned int quadObject = culler.Add(AABB::Transform(AABB(glm::vec3(100.0f, 100.0f, 0.0f), glm::vec3(200.0f, 200.0f, 0.0f)), model));
+        std::vector<unsigned int> visible;
+
+        /* synchronizes with our monitor's frame rate unless asked otherwise, swap interval is set by the pacer */
+        FramePacer pacer(window, options.Present, options.TargetFPS);
+        pacer.SetWaitForPreviousFrame(true);
+
+        /* headless renders into an offscreen target */
+        std::unique_ptr<Framebuffer> framebuffer;
+        if (options.Headless)
+        {
+            framebuffer.reset(new Framebuffer(options.Width, options.Height));
+        }
+        else
+        {
+            GLCall(glViewport(0, 0, options.Width, options.Height));
+        }
+
+        /* reads back whatever is bound for reading, the framebuffer object or the window's back buffer */
+        std::unique_ptr<FrameCapture> capture;
+        if (!options.OutputPath.empty())
+        {
+            CaptureSettings settings;
+            settings.Format = options.Format;
+            settings.Policy = options.Policy;
+            settings.OutputPath = options.OutputPath;
+            capture.reset(new FrameCapture(options.Width, options.Height, settings));
+        }
+        unsigned long long frameIndex = 0;
+
+        /* scratch memory for the frame, reset after it is presented */
+        FrameArena frameArena(4 * 1024 * 1024, options.HugePages);
+
+        /*
+        * Steady state starts after the first half, by then caches and scratch buffers have grown
+        * to size. Every allocation from then on fails the check, whichever thread makes it.
+        */
+        unsigned long long allocationWarmup = options.FrameCount / 2;
+        unsigned long long steadyFrames = 0, steadyAllocations = 0, mainThreadAllocations = 0;
+        s_FrameThreadName = "the main thread";
+
         float r = 0.0f;
-        float increment = 0.05f;
+        /* color change per second, animation no longer depends on the refresh rate */
+        float increment = 3.0f;
+        /* clamped so a breakpoint or a dragged window does not turn into one huge simulation step */
+        const float maxDeltaTime = 0.25f;
+        std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+        /* the quad never moves, only whether it is in view changes */
+        const AABB quadBounds = culler.GetBounds(quadObject);
 
-        /* Loop until the user closes the window */
-        while (!glfwWindowShouldClose(window))
+        /*
+        * The main thread polls events, simulates and fills a packet, the render thread makes
+        * every GL call and presents, one frame behind. Subsystems that upload while they
+        * update, the streamer, particles and both kinds of city culling, run there whole.
+        */
+        auto bindRenderThread = [&bindContext, &jobs](bool current)
         {
+            bindContext(current);
+            /* ParallelFor and Wait on the render thread go through the main thread's deque, not the inject queue */
+            jobs.BindCurrentThread(current);
+        };
+        RenderThread renderThread(2, bindRenderThread, [&](const FramePacket& packet)
+        {
+            s_FrameThreadName = "the render thread";
+            s_FrameThreadFrame = packet.Frame;
+            pacer.BeginFrame();
+            if (framebuffer)
+                framebuffer->Bind();
+
             /* Render here */
             renderer.Clear();
 
@@ -135,27 +892,379 @@ int main(void)
             * Therefore, uniforms would not have to be handled as below. 
             * Will get to materials (shaders + uniforms) in the future. 
             */
-            shader.Bind();
-            shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
+            if (packet.QuadVisible)
+            {
+                shader.Bind();
+                shader.SetUniform4f("u_Color", packet.QuadColor.r, packet.QuadColor.g, packet.QuadColor.b, packet.QuadColor.a);
 
-            renderer.Draw(va, ib, shader);
+                texture->Bind();
+                streamer.RequestFootprint(texture, TextureStreamer::ComputeScreenFootprint(mvp,
+                    AABB(glm::vec3(100.0f, 100.0f, 0.0f), glm::vec3(200.0f, 200.0f, 0.0f)), options.Width, options.Height));
+                renderer.Draw(va, ib, shader);
+
+                if (debugDraw)
+                    debugDraw->Box(quadBounds, glm::vec4(0.2f, 1.0f, 0.2f, 1.0f), 0.0f, DebugDepth::Overlay);
+            }
+            /* uploads levels that finished loading and queues the next ones */
+            streamer.Update(&frameArena);
+
+            if (mesh && !options.LodErrors.empty())
+            {
+                meshShader->Bind();
+                GLCall(glEnable(GL_DEPTH_TEST));
+                for (unsigned int copy = 0; copy < packet.MeshModels.size(); copy++)
+                {
+                    /* debug drawing tints copies by level, full detail stays white */
+                    unsigned int level = packet.MeshLevels[copy];
+                    const glm::mat4& meshModel = packet.MeshModels[copy];
+                    float tint = options.DebugDraw ? (float)level / mesh->GetLodCount() : 0.0f;
+                    meshShader->SetUniformMat4f("u_MVP", packet.MeshProjection * packet.MeshView * meshModel);
+                    meshShader->SetUniformMat4f("u_Model", meshModel);
+                    meshShader->SetUniform4f("u_Color", 0.9f, 0.85f - tint * 0.6f, 0.8f - tint * 0.8f, 1.0f);
+                    const MeshLod& lod = mesh->GetLod(level);
+                    renderer.Draw(mesh->GetVertexArray(), mesh->GetIndexBuffer(), *meshShader, lod.IndexCount, lod.FirstIndex);
+                }
+                GLCall(glDisable(GL_DEPTH_TEST));
+            }
+            else if (mesh)
+            {
+                const glm::mat4& meshModel = packet.MeshModels[0];
+                meshShader->Bind();
+                meshShader->SetUniformMat4f("u_MVP", packet.MeshProjection * packet.MeshView * meshModel);
+                meshShader->SetUniformMat4f("u_Model", meshModel);
+                meshShader->SetUniform4f("u_Color", 0.9f, 0.85f, 0.8f, 1.0f);
+                GLCall(glEnable(GL_DEPTH_TEST));
+                renderer.Draw(mesh->GetVertexArray(), mesh->GetIndexBuffer(), *meshShader);
+                GLCall(glDisable(GL_DEPTH_TEST));
+            }
+
+            if (cityBox)
+            {
+                const glm::mat4& cityView = packet.CityView;
+                const glm::mat4& cityProj = packet.CityProjection;
+                glm::mat4 cityViewProj = cityProj * cityView;
+
+                /* early, so the GPU has the counts by the time Draw reads them */
+                if (gpuCuller)
+                    gpuCuller->Cull(cityViewProj);
+
+                /* the walls are the occluders, drawn and rasterized on the CPU alike */
+                if (occlusion)
+                    occlusion->Begin(cityViewProj);
+                GLCall(glEnable(GL_DEPTH_TEST));
+                wallShader->Bind();
+                wallShader->SetUniform4f("u_Color", 0.5f, 0.5f, 0.55f, 1.0f);
+                for (const AABB& wall : walls)
+                {
+                    glm::mat4 wallModel = glm::scale(glm::translate(glm::mat4(1.0f), wall.GetCenter()), wall.GetExtents());
+                    wallShader->SetUniformMat4f("u_MVP", cityViewProj * wallModel);
+                    wallShader->SetUniformMat4f("u_Model", wallModel);
+                    renderer.Draw(cityBox->GetVertexArray(), cityBox->GetIndexBuffer(), *wallShader);
+                    if (occlusion)
+                        occlusion->AddOccluder(cityBoxData, wallModel);
+                }
+
+                if (gpuCuller)
+                {
+                    gpuCuller->TestOcclusion(renderer, cityView, cityProj);
+                    gpuCuller->Draw(renderer, cityViewProj);
+
+                    GpuCullingStats cityStats = gpuCuller->GetStats();
+                    cityVisible += cityStats.Visible;
+                    cityTested += cityStats.GroupsTested;
+                    cityOccluded += cityStats.GroupsOccluded;
+                    cityWait += cityStats.WaitMilliseconds;
+                }
+                else
+                {
+                    occlusion->Rasterize(&frameArena);
+                    boxCuller->Cull(cityViewProj, cityObjects);
+                    occlusion->Filter(*boxCuller, cityObjects);
+                    for (unsigned int object : cityObjects)
+                    {
+                        const GpuInstance& instance = cityInstances[object];
+                        glm::mat4 boxModel = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(instance.X, instance.Y, instance.Z)), glm::vec3(instance.Scale));
+                        wallShader->SetUniformMat4f("u_MVP", cityViewProj * boxModel);
+                        wallShader->SetUniform4f("u_Color", instance.R, instance.G, instance.B, instance.A);
+                        renderer.Draw(cityBox->GetVertexArray(), cityBox->GetIndexBuffer(), *wallShader);
+                    }
+
+                    const OcclusionStats& occlusionStats = occlusion->GetStats();
+                    cityVisible += cityObjects.size();
+                    cityTested += occlusionStats.Tested;
+                    cityOccluded += occlusionStats.Occluded;
+                    occlusionRasterize += occlusionStats.RasterizeMilliseconds;
+                    occlusionTest += occlusionStats.TestMilliseconds;
+                }
+                GLCall(glDisable(GL_DEPTH_TEST));
+                cityFrames++;
+
+                /* the depth buffer in the top left corner, drawn with the demo quad's vertices */
+                if (occlusionTexture)
+                {
+                    occlusion->GetDebugImage(occlusionPixels);
+                    occlusionTexture->Update(occlusionPixels.data());
+                    occlusionTexture->Bind();
+                    glm::vec2 size((float)occlusion->GetWidth(), (float)occlusion->GetHeight());
+                    glm::mat4 debugModel = glm::translate(glm::mat4(1.0f), glm::vec3(8.0f, options.Height - 8.0f - size.y, 0.0f));
+                    debugModel = glm::translate(glm::scale(debugModel, glm::vec3(size / 100.0f, 1.0f)), glm::vec3(-100.0f, -100.0f, 0.0f));
+                    occlusionShader->Bind();
+                    occlusionShader->SetUniformMat4f("u_MVP", glm::ortho(0.0f, (float)options.Width, 0.0f, (float)options.Height, -1.0f, 1.0f) * debugModel);
+                    occlusionShader->SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+                    occlusionShader->SetUniform1i("u_Texture", 0);
+                    renderer.Draw(va, ib, *occlusionShader);
+                }
+            }
+
+            if (particles || cpuParticles)
+            {
+                glm::mat4 particleView = glm::lookAt(glm::vec3(0.0f, 0.5f, 6.0f), glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                glm::mat4 particleProj = glm::perspective(glm::radians(60.0f), (float)options.Width / options.Height, 0.1f, 100.0f);
+                if (particles)
+                {
+                    particles->Emit(fountain, packet.DeltaTime);
+                    particles->Update(packet.DeltaTime);
+                    particles->Draw(renderer, particleView, particleProj);
+                }
+                if (cpuParticles)
+                {
+                    cpuParticles->Emit(cpuFountain, packet.DeltaTime);
+                    cpuParticles->Update(packet.DeltaTime);
+                    cpuParticles->Draw(renderer, particleView, particleProj);
+                }
+            }
+
+            if (text)
+            {
+                text->Begin(glm::ortho(0.0f, (float)options.Width, 0.0f, (float)options.Height, -1.0f, 1.0f));
+                text->DrawString(font, "LearnOpenGL", options.Width - 260.0f, options.Height - 48.0f, 40.0f, glm::vec4(1.0f));
+                text->End();
+            }
+
+            if (debugDraw)
+                debugDraw->Draw(renderer, packet.Projection * packet.View, packet.DeltaTime);
+
+            /* numbers are from the previous frame, the current one is still being counted */
+            if (overlay)
+                overlay->Draw(renderer, RenderStats::GetLastFrame());
+
+            if (capture)
+                capture->Capture(packet.Frame);
+
+            /* Limits if requested and swaps front and back buffers */
+            pacer.EndFrame();
+            RenderStats::EndFrame();
+            GLTrace::EndFrame();
+            frameArena.Reset();
+        });
+        bindRenderThread(false);
+        renderThread.Start();
+
+        /* Loop until the user closes the window, or the requested frame count when headless */
+        while (options.Headless ? frameIndex < options.FrameCount : !glfwWindowShouldClose(window))
+        {
+            if (options.AllocationCheck && frameIndex == allocationWarmup + 1)
+            {
+                /* the last warm up frame is rendered first, so none of its allocations land in the count */
+                renderThread.Flush();
+                steadyAllocations = AllocationCounter::GetAllocations();
+                mainThreadAllocations = AllocationCounter::GetThreadAllocations();
+                AllocationCounter::SetHook(RecordSteadyAllocation);
+            }
+            s_FrameThreadFrame = frameIndex;
+
+            /* waits while the render thread is a whole frame behind */
+            FramePacket& packet = renderThread.BeginPacket();
+
+            float deltaTime;
+            if (options.Headless)
+            {
+                /* fixed step so headless output is the same on every run */
+                deltaTime = 1.0f / 60.0f;
+            }
+            else
+            {
+                /* Poll for and process events, after the wait so input is as fresh as possible */
+                glfwPollEvents();
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                deltaTime = std::min(std::chrono::duration<float>(now - lastFrame).count(), maxDeltaTime);
+                lastFrame = now;
+            }
+
+            packet.Frame = frameIndex;
+            packet.DeltaTime = deltaTime;
+            packet.View = view;
+            packet.Projection = proj;
+
+            culler.Cull(proj * view, visible);
+            packet.QuadVisible = std::find(visible.begin(), visible.end(), quadObject) != visible.end();
+            packet.QuadColor = glm::vec4(r, 0.3f, 0.8f, 1.0f);
 
             if (r > 1.0f)
-                increment = -0.05f;
+                increment = -3.0f;
             else if (r < 0.0f)
-                increment = 0.05f;
+                increment = 3.0f;
+
+            r += increment * deltaTime;
+
+            if (mesh && !options.LodErrors.empty())
+            {
+                /* the camera glides over the field and back, so copies change level while it moves */
+                meshAngle += deltaTime * 0.5f;
+                const AABB& bounds = mesh->GetBounds();
+                float radius = std::max(mesh->GetBoundingRadius(), 0.0001f);
+                float spacing = radius * 3.0f;
+                float fieldDepth = spacing * lodFieldSize;
+                glm::vec3 eye(0.0f, radius * 4.0f, radius * 4.0f - (0.5f - 0.5f * std::cos(meshAngle)) * fieldDepth * 0.5f);
+                packet.MeshView = glm::lookAt(eye, eye + glm::vec3(0.0f, -0.35f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                packet.MeshProjection = glm::perspective(glm::radians(60.0f), (float)options.Width / options.Height, radius * 0.1f, fieldDepth * 2.0f);
+                packet.MeshModels.resize(lodFieldSize * lodFieldSize);
+                packet.MeshLevels.resize(lodFieldSize * lodFieldSize);
+
+                lodSelector.BeginFrame();
+                for (int row = 0; row < lodFieldSize; row++)
+                {
+                    for (int column = 0; column < lodFieldSize; column++)
+                    {
+                        glm::vec3 position((column - (lodFieldSize - 1) * 0.5f) * spacing, 0.0f, -row * spacing);
+                        glm::vec3 viewCenter = glm::vec3(packet.MeshView * glm::vec4(position, 1.0f));
+                        float screenRadius = LodSelector::GetScreenRadius(viewCenter, radius, packet.MeshProjection, options.Height);
+                        unsigned int copy = row * lodFieldSize + column;
+                        packet.MeshModels[copy] = glm::translate(glm::mat4(1.0f), position) * glm::translate(glm::mat4(1.0f), -bounds.GetCenter());
+                        packet.MeshLevels[copy] = lodSelector.Select(*mesh, screenRadius, lodLevels[copy]);
+                    }
+                }
+
+                const LodStats& lodStats = lodSelector.GetStats();
+                lodTrianglesDrawn += lodStats.TrianglesDrawn;
+                lodTrianglesFull += lodStats.TrianglesFull;
+                lodSwitches += lodStats.Switches;
+                lodFrames++;
+            }
+            else if (mesh)
+            {
+                /* fitted to the bounds, turning around the vertical axis */
+                meshAngle += deltaTime * 0.5f;
+                const AABB& bounds = mesh->GetBounds();
+                float radius = std::max(glm::length(bounds.GetExtents()), 0.0001f);
+                packet.MeshModels.resize(1);
+                packet.MeshModels[0] = glm::rotate(glm::mat4(1.0f), meshAngle, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::translate(glm::mat4(1.0f), -bounds.GetCenter());
+                packet.MeshView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -radius * 2.5f));
+                packet.MeshProjection = glm::perspective(glm::radians(45.0f), (float)options.Width / options.Height, radius * 0.1f, radius * 10.0f);
+            }
 
-            r += increment;
+            if (cityBox)
+            {
+                /* turns on the spot in the middle of the city, looking along the street between two walls and then into them */
+                cityAngle += deltaTime * 0.3f;
+                glm::vec3 eye(0.0f, 3.0f, 0.0f);
+                packet.CityView = glm::lookAt(eye, eye + glm::vec3(std::sin(cityAngle), -0.05f, std::cos(cityAngle)), glm::vec3(0.0f, 1.0f, 0.0f));
+                packet.CityProjection = glm::perspective(glm::radians(60.0f), (float)options.Width / options.Height, 0.5f, cityHalfSize * 3.0f);
+            }
 
-            /* Swap front and back buffers */
-            GLCall(glfwSwapBuffers(window));
+            renderThread.SubmitPacket();
+            if (options.AllocationCheck && frameIndex > allocationWarmup)
+                steadyFrames++;
+            frameIndex++;
+        }
 
-            /* Poll for and process events */
-            GLCall(glfwPollEvents());
+        /* the last frames are still being rendered, everything after this reads what they left behind */
+        renderThread.Stop();
+        if (options.AllocationCheck && steadyFrames > 0)
+        {
+            /* the render thread's last frame is in, nothing has been torn down yet */
+            AllocationCounter::SetHook(nullptr);
+            steadyAllocations = AllocationCounter::GetAllocations() - steadyAllocations;
+            mainThreadAllocations = AllocationCounter::GetThreadAllocations() - mainThreadAllocations;
         }
+        bindRenderThread(true);
 
+        if (options.AllocationCheck)
+        {
+            std::cout << "Allocation check: " << steadyFrames << " steady state frames after " << allocationWarmup + 1 << " warm up frames, "
+                << steadyAllocations << " heap allocations, " << mainThreadAllocations << " of them on the main thread" << std::endl;
+            const FrameArenaStats& arena = frameArena.GetStats();
+            std::cout << "  frame arena: peak " << arena.PeakUsed / 1024.0 << " KB of " << arena.Capacity / 1024 << " KB, "
+                << arena.OverflowAllocations << " overflowed onto the heap, " << (arena.HugePages ? "huge pages" : "normal pages") << std::endl;
+            if (steadyAllocations > 0)
+            {
+                std::cout << "  FAILED: first " << s_FirstSteadyAllocation << " bytes";
+                if (s_FirstSteadyThread)
+                    std::cout << " on " << s_FirstSteadyThread << " in frame " << s_FirstSteadyFrame << std::endl;
+                else
+                    std::cout << " on another thread" << std::endl;
+                allocationCheckPassed = false;
+            }
+        }
+
+        if (lodFrames > 0)
+        {
+            std::cout << "LOD: " << lodTrianglesDrawn / lodFrames << " triangles per frame, " << lodTrianglesFull / lodFrames
+                << " without LOD (" << 100.0 * lodTrianglesDrawn / std::max(lodTrianglesFull, 1ull) << "%), "
+                << lodSwitches << " level switches" << std::endl;
+        }
+
+        if (particles)
+        {
+            particles->FinishTiming();
+            ParticleStats stats = particles->GetStats();
+            float millions = stats.Capacity / 1.0e6f;
+            std::cout << "Particles: " << stats.Capacity << ", " << stats.Emitted << " emitted, GPU simulate "
+                << stats.SimulateMilliseconds << " ms (" << stats.SimulateMilliseconds / millions << " ms per million), draw "
+                << stats.DrawMilliseconds << " ms (" << stats.DrawMilliseconds / millions << " ms per million)" << std::endl;
+        }
+
+        if (occlusion)
+        {
+            OcclusionStats stats = occlusion->GetStats();
+            std::cout << "Occlusion culling: " << cityInstances.size() << " boxes, " << stats.OccluderTriangles << " occluder triangles in "
+                << occlusion->GetWidth() << " x " << occlusion->GetHeight() << ", rasterize " << occlusionRasterize / cityFrames << " ms on "
+                << jobs.GetThreadCount() << " threads, " << cityTested / std::max(occlusionTest, 1.0e-3) << " tests per ms, "
+                << cityOccluded / cityFrames << " of " << cityTested / cityFrames << " frustum visible boxes occluded ("
+                << 100.0 * cityOccluded / std::max(cityTested, 1ull) << "%), " << cityVisible / cityFrames << " drawn per frame" << std::endl;
+        }
+
+        if (gpuCuller)
+        {
+            gpuCuller->FinishTiming();
+            GpuCullingStats stats = gpuCuller->GetStats();
+            std::cout << "GPU culling: " << stats.Instances << " instances in " << stats.Groups << " groups, "
+                << cityVisible / cityFrames << " visible per frame (" << 100.0 * cityVisible / cityFrames / std::max(stats.Instances, 1u)
+                << "%), " << cityOccluded / cityFrames << " of " << cityTested / cityFrames << " tested groups occluded, "
+                << cityWait / cityFrames << " ms waiting for counts, cull pass " << stats.CullMilliseconds << " ms GPU"
+                << (options.GpuCullLatency ? ", one frame latency" : "") << std::endl;
+        }
+
+        if (cpuParticles)
+        {
+            CpuParticleStats stats = cpuParticles->GetStats();
+            std::cout << "CPU particles: " << stats.Alive << " of " << stats.Capacity << " alive, " << stats.Emitted << " emitted, update "
+                << stats.AverageUpdateMilliseconds << " ms on " << jobs.GetThreadCount() << " threads, SIMD "
+                << CpuParticleSystem::s_SimdWidth << " wide" << std::endl;
+        }
+
+        GpuMemory::PrintReport(std::cout);
+        TextureStreamingStats streaming = streamer.GetStats();
+        std::cout << "Texture streaming: " << streaming.ResidentLevels << " levels resident, " << streaming.ResidentBytes / 1024
+            << " KB of " << streaming.BudgetBytes / 1024 << " KB, " << streaming.LevelsLoaded << " levels loaded, "
+            << streaming.LevelsEvicted << " evicted, " << streaming.Starved << " textures waiting" << std::endl;
+
+        if (capture)
+        {
+            capture->Finish();
+            CaptureStats stats = capture->GetStats();
+            std::cout << "Captured " << stats.Encoded << " frames at " << options.Width << "x" << options.Height << ", dropped " << stats.Dropped
+                << ", " << stats.EncodeMilliseconds << " ms per encode" << std::endl;
+            std::cout << "Capture render thread time: " << stats.RenderThreadMilliseconds << " ms per frame, "
+                << stats.MaxRenderThreadMilliseconds << " ms worst, " << stats.OverBudget << " of " << stats.Captured
+                << " frames over the " << CaptureSettings().RenderThreadBudgetMilliseconds << " ms budget" << std::endl;
+        }
     }
 
-    glfwTerminate();
-    return 0;
+    GLTrace::End();
+
+    /* headless context is torn down by its destructor */
+    if (!options.Headless)
+        glfwTerminate();
+    return allocationCheckPassed ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "AsyncReadback.h"
+
+#include <iostream>
+
+#include "Renderer.h"
+#include "GpuMemory.h"
+
+AsyncReadback::AsyncReadback(int width, int height, unsigned int ringSize)
+	: m_Next(0), m_Pending(0), m_Width(width), m_Height(height)
+{
+	ASSERT(ringSize > 0);
+
+	m_Slots.resize(ringSize);
+	for (Slot& slot : m_Slots)
+	{
+		GLCall(glGenBuffers(1, &slot.Buffer));
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer));
+		/* STREAM_READ, written once by the GPU and read once by us */
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ));
+		slot.Fence = nullptr;
+		slot.Frame = 0;
+		slot.Held = false;
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	m_MemoryID = GpuMemory::Track(GpuMemoryCategory::Readback, (unsigned long long)width * height * 4 * ringSize, "Readback ring");
+}
+
+AsyncReadback::~AsyncReadback()
+{
+	for (unsigned int i = 0; i < m_Slots.size(); i++)
+	{
+		Slot& slot = m_Slots[i];
+		if (slot.Held)
+			Release(i);
+		if (slot.Fence)
+		{
+			GLCall(glDeleteSync(slot.Fence));
+		}
+		GLCall(glDeleteBuffers(1, &slot.Buffer));
+	}
+	GpuMemory::Release(m_MemoryID);
+}
+
+void AsyncReadback::Request(unsigned long long frame, const Callback& callback)
+{
+	if (m_Pending == m_Slots.size())
+		DeliverOldest(callback, true);
+
+	Slot& slot = m_Slots[m_Next];
+	ASSERT(!slot.Held);
+	slot.Frame = frame;
+
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer));
+	/* rows are tightly packed, width * 4 is always a multiple of the default alignment of 4 */
+	GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	GLCall(slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+	m_Next = (m_Next + 1) % m_Slots.size();
+	m_Pending++;
+}
+
+void AsyncReadback::Poll(const Callback& callback)
+{
+	while (m_Pending > 0 && DeliverOldest(callback, false))
+		;
+}
+
+void AsyncReadback::Flush(const Callback& callback)
+{
+	while (m_Pending > 0)
+		DeliverOldest(callback, true);
+}
+
+bool AsyncReadback::DeliverOldest(const Callback& callback, bool wait)
+{
+	unsigned int index = (m_Next + (unsigned int)m_Slots.size() - m_Pending) % m_Slots.size();
+	Slot& slot = m_Slots[index];
+
+	/* timeout 0 only polls, the flush bit makes sure the fence reaches the GPU so a later wait can finish */
+	GLuint64 timeout = wait ? ~(GLuint64)0 : 0;
+	GLCall(GLenum result = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout));
+	if (result == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	GLCall(glDeleteSync(slot.Fence));
+	slot.Fence = nullptr;
+
+	if (result == GL_WAIT_FAILED)
+	{
+		/* context is in trouble, drop the frame rather than waiting forever */
+		std::cout << "Readback of frame " << slot.Frame << " failed" << std::endl;
+		m_Pending--;
+		return true;
+	}
+
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer));
+	GLCall(const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_Width * m_Height * 4, GL_MAP_READ_BIT));
+	slot.Held = pixels && !callback((const unsigned char*)pixels, m_Width, m_Height, slot.Frame, index);
+	if (!slot.Held)
+	{
+		GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	m_Pending--;
+	return true;
+}
+
+void AsyncReadback::Release(unsigned int slot)
+{
+	ASSERT(m_Slots[slot].Held);
+
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_Slots[slot].Buffer));
+	GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	m_Slots[slot].Held = false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <GL/glew.h>
+
+/*
+* Reads frames back through a ring of pixel pack buffers
+* glReadPixels into a bound GL_PIXEL_PACK_BUFFER returns immediately, the copy
+* happens on the GPU timeline. A fence per slot says when the buffer can be
+* mapped without stalling, which is normally a frame or two later. A consumer
+* can keep a delivered buffer mapped and hand the pointer to another thread,
+* the slot is then not reused until it is released.
+*/
+class AsyncReadback
+{
+public:
+	/*
+	* pixels are RGBA8, bottom row first as OpenGL returns them. Return true when done with them,
+	* false keeps the buffer mapped and the pixels valid until Release(slot).
+	*/
+	typedef std::function<bool(const unsigned char* pixels, int width, int height, unsigned long long frame, unsigned int slot)> Callback;
+
+private:
+	struct Slot
+	{
+		unsigned int Buffer;
+		GLsync Fence;
+		unsigned long long Frame;
+		/* delivered and still mapped for the consumer */
+		bool Held;
+	};
+
+	std::vector<Slot> m_Slots;
+	/* slot the next request writes to, the oldest pending slot is m_Pending slots behind it */
+	unsigned int m_Next;
+	unsigned int m_Pending;
+	int m_Width, m_Height;
+	/* GpuMemory allocation id, covers the whole ring */
+	unsigned int m_MemoryID;
+public:
+	AsyncReadback(int width, int height, unsigned int ringSize = 3);
+	~AsyncReadback();
+
+	/*
+	* Queues a read of the currently bound read framebuffer. If every slot is
+	* still in flight the oldest one is waited on and delivered first, so a
+	* consumer slower than the GPU shows up as a stall here rather than lost frames.
+	* The slot it writes to must not be held, see IsNextHeld.
+	*/
+	void Request(unsigned long long frame, const Callback& callback);
+	/* Delivers every finished read in order without blocking */
+	void Poll(const Callback& callback);
+	/* Blocks until all queued reads are delivered */
+	void Flush(const Callback& callback);
+	/* Unmaps a slot the callback kept, on the GL thread */
+	void Release(unsigned int slot);
+
+	/* true when Request would have to wait for the GPU */
+	inline bool IsFull() const { return m_Pending == m_Slots.size() || IsNextHeld(); }
+	/* the consumer still has the slot the next Request writes to */
+	inline bool IsNextHeld() const { return m_Slots[m_Next].Held; }
+	inline unsigned int GetPendingCount() const { return m_Pending; }
+
+private:
+	bool DeliverOldest(const Callback& callback, bool wait);
+};
@@ -0,0 +1,508 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <memory_resource>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define BVH_USE_SSE 1
+#endif
+
+#include "Renderer.h"
+
+const int BoundingVolumeHierarchy::s_Null;
+
+/*
+* Traversal stacks live in a buffer on the call stack, a balanced tree
+* never gets near it and a degenerate one spills over onto the heap
+*/
+static const unsigned int s_StackBufferSize = 256;
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy(float marginScale)
+	: m_Root(s_Null), m_FreeList(s_Null), m_MarginScale(marginScale), m_LeafCount(0), m_ChangedLeaves(0)
+{
+}
+
+AABB BoundingVolumeHierarchy::Fatten(const AABB& box) const
+{
+	/* the same margin on every axis, a flat sprite still gets room along z */
+	glm::vec3 size = box.Max - box.Min;
+	glm::vec3 margin(m_MarginScale * std::max(size.x, std::max(size.y, size.z)));
+	return AABB(box.Min - margin, box.Max + margin);
+}
+
+int BoundingVolumeHierarchy::AllocateNode()
+{
+	if (m_FreeList == s_Null)
+	{
+		m_Nodes.push_back(Node());
+		m_FreeList = (int)m_Nodes.size() - 1;
+		m_Nodes[m_FreeList].Parent = s_Null;
+	}
+
+	/* free nodes are chained through Parent */
+	int node = m_FreeList;
+	m_FreeList = m_Nodes[node].Parent;
+
+	Node& n = m_Nodes[node];
+	n.Parent = s_Null;
+	n.Left = s_Null;
+	n.Right = s_Null;
+	n.Object = 0;
+	n.Height = 0;
+	return node;
+}
+
+void BoundingVolumeHierarchy::FreeNode(int node)
+{
+	m_Nodes[node].Parent = m_FreeList;
+	m_Nodes[node].Height = -1;
+	m_FreeList = node;
+}
+
+void BoundingVolumeHierarchy::Insert(unsigned int object, const AABB& box)
+{
+	if (object >= m_LeafOfObject.size())
+		m_LeafOfObject.resize(object + 1, s_Null);
+	ASSERT(m_LeafOfObject[object] == s_Null);
+
+	int leaf = AllocateNode();
+	m_Nodes[leaf].Box = Fatten(box);
+	m_Nodes[leaf].Object = object;
+	m_LeafOfObject[object] = leaf;
+	m_LeafCount++;
+	m_ChangedLeaves++;
+
+	InsertLeaf(leaf);
+}
+
+bool BoundingVolumeHierarchy::Update(unsigned int object, const AABB& box)
+{
+	int leaf = m_LeafOfObject[object];
+	if (m_Nodes[leaf].Box.Contains(box))
+		return false;
+
+	RemoveLeaf(leaf);
+	m_Nodes[leaf].Box = Fatten(box);
+	InsertLeaf(leaf);
+	m_ChangedLeaves++;
+	return true;
+}
+
+void BoundingVolumeHierarchy::Remove(unsigned int object)
+{
+	int leaf = m_LeafOfObject[object];
+	ASSERT(leaf != s_Null);
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	m_LeafOfObject[object] = s_Null;
+	m_LeafCount--;
+	m_ChangedLeaves++;
+}
+
+void BoundingVolumeHierarchy::Linearize()
+{
+	if (m_Root == s_Null || m_ChangedLeaves * 8 < m_LeafCount)
+		return;
+	m_ChangedLeaves = 0;
+
+	/*
+	* Siblings side by side, a query tests both children of a node together and they
+	* share a cache line or two. Left subtrees come first, so the nodes one walk
+	* down the tree touches are close together as well.
+	*/
+	m_LinearNodes.clear();
+	m_LinearNodes.reserve(m_Nodes.size());
+	m_NewIndex.assign(m_Nodes.size(), s_Null);
+	int stackBuffer[s_StackBufferSize];
+	std::pmr::monotonic_buffer_resource stackMemory(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<int> stack(&stackMemory);
+	stack.reserve(64);
+	m_NewIndex[m_Root] = 0;
+	m_LinearNodes.push_back(m_Nodes[m_Root]);
+	if (!m_Nodes[m_Root].IsLeaf())
+		stack.push_back(m_Root);
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		int children[2] = { node.Left, node.Right };
+		for (int child : children)
+		{
+			m_NewIndex[child] = (int)m_LinearNodes.size();
+			m_LinearNodes.push_back(m_Nodes[child]);
+		}
+		for (int i = 1; i >= 0; i--)
+		{
+			if (!m_Nodes[children[i]].IsLeaf())
+				stack.push_back(children[i]);
+		}
+	}
+
+	/* links still hold old indices, free nodes were left behind */
+	for (Node& node : m_LinearNodes)
+	{
+		if (node.Parent != s_Null)
+			node.Parent = m_NewIndex[node.Parent];
+		if (node.IsLeaf())
+		{
+			m_LeafOfObject[node.Object] = (int)(&node - m_LinearNodes.data());
+			continue;
+		}
+		node.Left = m_NewIndex[node.Left];
+		node.Right = m_NewIndex[node.Right];
+	}
+
+	m_Nodes.swap(m_LinearNodes);
+	m_Root = 0;
+	m_FreeList = s_Null;
+}
+
+void BoundingVolumeHierarchy::InsertLeaf(int leaf)
+{
+	if (m_Root == s_Null)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].Parent = s_Null;
+		return;
+	}
+
+	/* descend to the sibling that grows the total surface area the least */
+	AABB leafBox = m_Nodes[leaf].Box;
+	int index = m_Root;
+	while (!m_Nodes[index].IsLeaf())
+	{
+		const Node& node = m_Nodes[index];
+		float area = node.Box.GetSurfaceArea();
+		float combinedArea = AABB::Merge(node.Box, leafBox).GetSurfaceArea();
+
+		/* cost of pairing with this node, and the minimum cost pushed down to any child */
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		int children[2] = { node.Left, node.Right };
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = m_Nodes[children[i]];
+			float merged = AABB::Merge(leafBox, child.Box).GetSurfaceArea();
+			childCosts[i] = (child.IsLeaf() ? merged : merged - child.Box.GetSurfaceArea()) + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = m_Nodes[sibling].Parent;
+	int newParent = AllocateNode();
+
+	m_Nodes[newParent].Parent = oldParent;
+	m_Nodes[newParent].Box = AABB::Merge(leafBox, m_Nodes[sibling].Box);
+	m_Nodes[newParent].Height = m_Nodes[sibling].Height + 1;
+	m_Nodes[newParent].Left = sibling;
+	m_Nodes[newParent].Right = leaf;
+	m_Nodes[sibling].Parent = newParent;
+	m_Nodes[leaf].Parent = newParent;
+
+	if (oldParent == s_Null)
+		m_Root = newParent;
+	else if (m_Nodes[oldParent].Left == sibling)
+		m_Nodes[oldParent].Left = newParent;
+	else
+		m_Nodes[oldParent].Right = newParent;
+
+	/* refit and rebalance on the way back up */
+	index = m_Nodes[leaf].Parent;
+	while (index != s_Null)
+	{
+		index = Balance(index);
+		Node& node = m_Nodes[index];
+		node.Height = 1 + std::max(m_Nodes[node.Left].Height, m_Nodes[node.Right].Height);
+		node.Box = AABB::Merge(m_Nodes[node.Left].Box, m_Nodes[node.Right].Box);
+		index = node.Parent;
+	}
+}
+
+void BoundingVolumeHierarchy::RemoveLeaf(int leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = s_Null;
+		return;
+	}
+
+	int parent = m_Nodes[leaf].Parent;
+	int grandParent = m_Nodes[parent].Parent;
+	int sibling = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+
+	/* sibling takes the parent's place */
+	FreeNode(parent);
+	if (grandParent == s_Null)
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].Parent = s_Null;
+		return;
+	}
+
+	if (m_Nodes[grandParent].Left == parent)
+		m_Nodes[grandParent].Left = sibling;
+	else
+		m_Nodes[grandParent].Right = sibling;
+	m_Nodes[sibling].Parent = grandParent;
+
+	int index = grandParent;
+	while (index != s_Null)
+	{
+		index = Balance(index);
+		Node& node = m_Nodes[index];
+		node.Height = 1 + std::max(m_Nodes[node.Left].Height, m_Nodes[node.Right].Height);
+		node.Box = AABB::Merge(m_Nodes[node.Left].Box, m_Nodes[node.Right].Box);
+		index = node.Parent;
+	}
+}
+
+/* Rotates the taller child up if the subtree at a is unbalanced, returns the new subtree root */
+int BoundingVolumeHierarchy::Balance(int a)
+{
+	Node& A = m_Nodes[a];
+	if (A.IsLeaf() || A.Height < 2)
+		return a;
+
+	int b = A.Left;
+	int c = A.Right;
+	Node& B = m_Nodes[b];
+	Node& C = m_Nodes[c];
+	int balance = C.Height - B.Height;
+
+	if (balance > 1)
+	{
+		/* rotate C up */
+		int f = C.Left;
+		int g = C.Right;
+		Node& F = m_Nodes[f];
+		Node& G = m_Nodes[g];
+
+		C.Left = a;
+		C.Parent = A.Parent;
+		A.Parent = c;
+
+		if (C.Parent == s_Null)
+			m_Root = c;
+		else if (m_Nodes[C.Parent].Left == a)
+			m_Nodes[C.Parent].Left = c;
+		else
+			m_Nodes[C.Parent].Right = c;
+
+		/* keep the taller grandchild under C */
+		if (F.Height > G.Height)
+		{
+			C.Right = f;
+			A.Right = g;
+			G.Parent = a;
+			A.Box = AABB::Merge(B.Box, G.Box);
+			C.Box = AABB::Merge(A.Box, F.Box);
+			A.Height = 1 + std::max(B.Height, G.Height);
+			C.Height = 1 + std::max(A.Height, F.Height);
+		}
+		else
+		{
+			C.Right = g;
+			A.Right = f;
+			F.Parent = a;
+			A.Box = AABB::Merge(B.Box, F.Box);
+			C.Box = AABB::Merge(A.Box, G.Box);
+			A.Height = 1 + std::max(B.Height, F.Height);
+			C.Height = 1 + std::max(A.Height, G.Height);
+		}
+		return c;
+	}
+
+	if (balance < -1)
+	{
+		/* rotate B up */
+		int d = B.Left;
+		int e = B.Right;
+		Node& D = m_Nodes[d];
+		Node& E = m_Nodes[e];
+
+		B.Left = a;
+		B.Parent = A.Parent;
+		A.Parent = b;
+
+		if (B.Parent == s_Null)
+			m_Root = b;
+		else if (m_Nodes[B.Parent].Left == a)
+			m_Nodes[B.Parent].Left = b;
+		else
+			m_Nodes[B.Parent].Right = b;
+
+		if (D.Height > E.Height)
+		{
+			B.Right = d;
+			A.Left = e;
+			E.Parent = a;
+			A.Box = AABB::Merge(C.Box, E.Box);
+			B.Box = AABB::Merge(A.Box, D.Box);
+			A.Height = 1 + std::max(C.Height, E.Height);
+			B.Height = 1 + std::max(A.Height, D.Height);
+		}
+		else
+		{
+			B.Right = e;
+			A.Left = d;
+			D.Parent = a;
+			A.Box = AABB::Merge(C.Box, D.Box);
+			B.Box = AABB::Merge(A.Box, E.Box);
+			A.Height = 1 + std::max(C.Height, D.Height);
+			B.Height = 1 + std::max(A.Height, E.Height);
+		}
+		return b;
+	}
+
+	return a;
+}
+
+#ifdef BVH_USE_SSE
+/*
+* The six planes over two registers, so a box is tested against all of them
+* without a branch per plane. The two spare lanes hold a plane every box is
+* inside of.
+*/
+struct FrustumPlanes
+{
+	__m128 X[2], Y[2], Z[2], W[2];
+	__m128 AbsX[2], AbsY[2], AbsZ[2];
+
+	FrustumPlanes(const Frustum& frustum)
+	{
+		alignas(16) float values[7][8];
+		for (int p = 0; p < 8; p++)
+		{
+			glm::vec4 plane = p < 6 ? frustum.Planes[p] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			values[0][p] = plane.x;
+			values[1][p] = plane.y;
+			values[2][p] = plane.z;
+			values[3][p] = plane.w;
+			values[4][p] = std::abs(plane.x);
+			values[5][p] = std::abs(plane.y);
+			values[6][p] = std::abs(plane.z);
+		}
+		for (int half = 0; half < 2; half++)
+		{
+			X[half] = _mm_load_ps(&values[0][half * 4]);
+			Y[half] = _mm_load_ps(&values[1][half * 4]);
+			Z[half] = _mm_load_ps(&values[2][half * 4]);
+			W[half] = _mm_load_ps(&values[3][half * 4]);
+			AbsX[half] = _mm_load_ps(&values[4][half * 4]);
+			AbsY[half] = _mm_load_ps(&values[5][half * 4]);
+			AbsZ[half] = _mm_load_ps(&values[6][half * 4]);
+		}
+	}
+
+	FrustumTest Test(const AABB& box) const
+	{
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 minX = _mm_set1_ps(box.Min.x), minY = _mm_set1_ps(box.Min.y), minZ = _mm_set1_ps(box.Min.z);
+		__m128 maxX = _mm_set1_ps(box.Max.x), maxY = _mm_set1_ps(box.Max.y), maxZ = _mm_set1_ps(box.Max.z);
+		__m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+		__m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+		__m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+		__m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		__m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		__m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+		const __m128 zero = _mm_setzero_ps();
+
+		int outside = 0, straddling = 0;
+		for (int i = 0; i < 2; i++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(X[i], cx), _mm_mul_ps(Y[i], cy)), _mm_add_ps(_mm_mul_ps(Z[i], cz), W[i]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(AbsX[i], ex), _mm_mul_ps(AbsY[i], ey)), _mm_mul_ps(AbsZ[i], ez));
+			outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			straddling |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+		}
+		return outside ? FrustumTest::Outside : straddling ? FrustumTest::Intersecting : FrustumTest::Inside;
+	}
+};
+#else
+typedef Frustum FrustumPlanes;
+#endif
+
+void BoundingVolumeHierarchy::Query(const Frustum& frustum, std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const
+{
+	if (m_Root == s_Null)
+		return;
+
+	FrustumPlanes planes(frustum);
+	FrustumTest rootTest = planes.Test(m_Nodes[m_Root].Box);
+	if (rootTest == FrustumTest::Outside)
+		return;
+	if (rootTest == FrustumTest::Inside)
+	{
+		CollectLeaves(m_Root, inside);
+		return;
+	}
+	if (m_Nodes[m_Root].IsLeaf())
+	{
+		intersecting.push_back(m_Nodes[m_Root].Object);
+		return;
+	}
+
+	/*
+	* The stack holds nodes that straddle the frustum. Both children are tested as
+	* soon as a node comes off it, after Linearize they sit next to each other.
+	*/
+	int stackBuffer[s_StackBufferSize];
+	std::pmr::monotonic_buffer_resource stackMemory(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<int> stack(&stackMemory);
+	stack.reserve(64);
+	stack.push_back(m_Root);
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		/* right first, so the left child is the next one taken off the stack */
+		int children[2] = { node.Right, node.Left };
+		for (int child : children)
+		{
+			const Node& childNode = m_Nodes[child];
+			FrustumTest test = planes.Test(childNode.Box);
+			if (test == FrustumTest::Outside)
+				continue;
+
+			/* whole subtree visible, skip every plane test below */
+			if (test == FrustumTest::Inside)
+				CollectLeaves(child, inside);
+			else if (childNode.IsLeaf())
+				intersecting.push_back(childNode.Object);
+			else
+				stack.push_back(child);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::CollectLeaves(int node, std::vector<unsigned int>& out) const
+{
+	int stackBuffer[s_StackBufferSize];
+	std::pmr::monotonic_buffer_resource stackMemory(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<int> stack(&stackMemory);
+	stack.reserve(64);
+	stack.push_back(node);
+	while (!stack.empty())
+	{
+		const Node& n = m_Nodes[stack.back()];
+		stack.pop_back();
+		if (n.IsLeaf())
+		{
+			out.push_back(n.Object);
+			continue;
+		}
+		stack.push_back(n.Right);
+		stack.push_back(n.Left);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+
+#include "Bounds.h"
+
+/*
+* Dynamic AABB tree for 3D scenes
+* Leaves store a fattened box, so an object that moves a little stays inside its
+* leaf and Update costs nothing. Only when it escapes is the leaf removed and
+* reinserted, with the surface area heuristic picking the sibling and tree
+* rotations keeping it balanced. The margin scales with each box, a sprite
+* measured in pixels and a crate measured in meters both get room to move.
+* Inserts and rotations scatter nodes over the array, Linearize puts them
+* back in depth first order so a query mostly walks memory front to back.
+*/
+class BoundingVolumeHierarchy
+{
+private:
+	static const int s_Null = -1;
+
+	struct Node
+	{
+		AABB Box;
+		int Parent;
+		int Left;
+		int Right;
+		/* leaf only */
+		unsigned int Object;
+		/* leaf is 0, -1 marks a free node */
+		int Height;
+
+		inline bool IsLeaf() const { return Left == s_Null; }
+	};
+
+	std::vector<Node> m_Nodes;
+	int m_Root;
+	int m_FreeList;
+	float m_MarginScale;
+	/* indexed by object id */
+	std::vector<int> m_LeafOfObject;
+	unsigned int m_LeafCount;
+	/* leaves inserted, reinserted or removed since the last Linearize */
+	unsigned int m_ChangedLeaves;
+	/* Linearize builds into these, kept so relaying the tree out does not allocate */
+	std::vector<Node> m_LinearNodes;
+	std::vector<int> m_NewIndex;
+public:
+	/* boxes are fattened on every side by marginScale times their largest size */
+	BoundingVolumeHierarchy(float marginScale = 0.25f);
+
+	void Insert(unsigned int object, const AABB& box);
+	/* returns true when the object left its fat box and was reinserted */
+	bool Update(unsigned int object, const AABB& box);
+	void Remove(unsigned int object);
+
+	/*
+	* Renumbers the nodes depth first with siblings side by side.
+	* Does nothing until an eighth of the leaves changed since the last time, so the
+	* cost is spread over many frames of moving objects.
+	*/
+	void Linearize();
+
+	/* objects under nodes fully inside go to inside, the rest of the touched leaves to intersecting */
+	void Query(const Frustum& frustum, std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const;
+
+	inline int GetHeight() const { return m_Root == s_Null ? 0 : m_Nodes[m_Root].Height; }
+
+private:
+	AABB Fatten(const AABB& box) const;
+	int AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int node);
+	void CollectLeaves(int node, std::vector<unsigned int>& out) const;
+};
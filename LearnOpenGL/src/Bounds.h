@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+/* axis aligned bounding box */
+struct AABB
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	AABB()
+		: Min(0.0f), Max(0.0f) {}
+	AABB(const glm::vec3& min, const glm::vec3& max)
+		: Min(min), Max(max) {}
+
+	inline glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	inline glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	inline bool Contains(const AABB& other) const
+	{
+		return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z
+			&& Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+	}
+
+	inline float GetSurfaceArea() const
+	{
+		glm::vec3 d = Max - Min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	static inline AABB Merge(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.Min, b.Min), glm::max(a.Max, b.Max));
+	}
+
+	/* transformed box still axis aligned, see Arvo's method */
+	static inline AABB Transform(const AABB& box, const glm::mat4& matrix)
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(box.GetCenter(), 1.0f));
+		glm::vec3 extents = box.GetExtents();
+		glm::vec3 newExtents(0.0f);
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				newExtents[i] += std::abs(matrix[j][i]) * extents[j];
+		return AABB(center - newExtents, center + newExtents);
+	}
+};
+
+enum class FrustumTest
+{
+	Outside, Intersecting, Inside
+};
+
+/*
+* Six planes pointing inwards, pulled straight out of a view projection
+* matrix (Gribb/Hartmann). Works for ortho and perspective alike.
+*/
+struct Frustum
+{
+	/* xyz normal, w distance. Order: left, right, bottom, top, near, far */
+	glm::vec4 Planes[6];
+
+	static Frustum FromMatrix(const glm::mat4& viewProj)
+	{
+		Frustum frustum;
+		/* glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]) */
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+			rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+		frustum.Planes[0] = rows[3] + rows[0];
+		frustum.Planes[1] = rows[3] - rows[0];
+		frustum.Planes[2] = rows[3] + rows[1];
+		frustum.Planes[3] = rows[3] - rows[1];
+		frustum.Planes[4] = rows[3] + rows[2];
+		frustum.Planes[5] = rows[3] - rows[2];
+
+		for (int i = 0; i < 6; i++)
+			frustum.Planes[i] /= glm::length(glm::vec3(frustum.Planes[i]));
+
+		return frustum;
+	}
+
+	FrustumTest Test(const AABB& box) const
+	{
+		glm::vec3 center = box.GetCenter();
+		glm::vec3 extents = box.GetExtents();
+		FrustumTest result = FrustumTest::Inside;
+		for (int i = 0; i < 6; i++)
+		{
+			glm::vec3 normal = glm::vec3(Planes[i]);
+			float distance = glm::dot(normal, center) + Planes[i].w;
+			/* projected radius of the box onto the plane normal */
+			float radius = glm::dot(glm::abs(normal), extents);
+			if (distance + radius < 0.0f)
+				return FrustumTest::Outside;
+			if (distance - radius < 0.0f)
+				result = FrustumTest::Intersecting;
+		}
+		return result;
+	}
+};
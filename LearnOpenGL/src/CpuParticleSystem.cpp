@@ -0,0 +1,351 @@
+#include "CpuParticleSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "VertexBufferLayout.h"
+#include "JobSystem.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLE_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_SIMD_SSE
+#endif
+
+/*
+* The few operations the kernels need, so they are written once for every
+* width. Masks are all ones per lane where a compare held.
+*/
+#if defined(PARTICLE_SIMD_AVX)
+typedef __m256 Floats;
+const unsigned int CpuParticleSystem::s_SimdWidth = 8;
+static inline Floats Load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void Store(float* p, Floats a) { _mm256_storeu_ps(p, a); }
+static inline Floats Set(float a) { return _mm256_set1_ps(a); }
+static inline Floats Add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+static inline Floats Mul(Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+static inline Floats Less(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline Floats Select(Floats mask, Floats a, Floats b) { return _mm256_blendv_ps(b, a, mask); }
+static inline unsigned int MoveMask(Floats mask) { return (unsigned int)_mm256_movemask_ps(mask); }
+#elif defined(PARTICLE_SIMD_SSE)
+typedef __m128 Floats;
+const unsigned int CpuParticleSystem::s_SimdWidth = 4;
+static inline Floats Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Store(float* p, Floats a) { _mm_storeu_ps(p, a); }
+static inline Floats Set(float a) { return _mm_set1_ps(a); }
+static inline Floats Add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+static inline Floats Mul(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+static inline Floats Less(Floats a, Floats b) { return _mm_cmplt_ps(a, b); }
+/* SSE2 has no blend, and/andnot/or does the same */
+static inline Floats Select(Floats mask, Floats a, Floats b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline unsigned int MoveMask(Floats mask) { return (unsigned int)_mm_movemask_ps(mask); }
+#else
+typedef float Floats;
+const unsigned int CpuParticleSystem::s_SimdWidth = 1;
+static inline Floats Load(const float* p) { return *p; }
+static inline void Store(float* p, Floats a) { *p = a; }
+static inline Floats Set(float a) { return a; }
+static inline Floats Add(Floats a, Floats b) { return a + b; }
+static inline Floats Mul(Floats a, Floats b) { return a * b; }
+static inline Floats Less(Floats a, Floats b) { return a < b ? 1.0f : 0.0f; }
+static inline Floats Select(Floats mask, Floats a, Floats b) { return mask != 0.0f ? a : b; }
+static inline unsigned int MoveMask(Floats mask) { return mask != 0.0f ? 1u : 0u; }
+#endif
+
+const unsigned int CpuParticleSystem::s_ColorKeyCount;
+
+/* chunks are a multiple of the SIMD width and never smaller than this, smaller ones cost more to hand out than to run */
+static const unsigned int s_MinChunkSize = 4096;
+
+/* one quad per instance as a triangle strip, corners in units of the particle size */
+static const float s_Corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+static unsigned int CountBits(unsigned int bits)
+{
+	unsigned int count = 0;
+	for (; bits; bits &= bits - 1)
+		count++;
+	return count;
+}
+
+void ParticlePool::Resize(unsigned int capacity)
+{
+	for (std::vector<float>* values : { &PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &Age, &InverseLifetime })
+		values->resize(capacity);
+}
+
+CpuParticleSystem::CpuParticleSystem(unsigned int capacity, JobSystem* jobs)
+	: m_Jobs(jobs), m_Capacity(std::max(capacity, 1u)), m_Current(0), m_Count(0),
+	m_Shader("res/shaders/Particle.shader", "#define LIFE_FRACTION"), m_Corners(s_Corners, sizeof(s_Corners)),
+	m_Instances(m_Capacity * (unsigned int)sizeof(Instance)), m_InstanceCount(0), m_EmitRemainder(0.0f), m_RandomState(1),
+	m_Gravity(0.0f, -9.81f, 0.0f), m_Drag(0.0f), m_GroundHeight(-1.0e30f), m_Restitution(0.5f), m_UseSimd(true),
+	m_StartSize(0.05f), m_EndSize(0.02f), m_TotalMilliseconds(0.0), m_Updates(0), m_Stats()
+{
+	m_Pools[0].Resize(m_Capacity);
+	m_Pools[1].Resize(m_Capacity);
+
+	VertexBufferLayout cornerLayout;
+	cornerLayout.Push<float>(2);
+	VertexBufferLayout instanceLayout;
+	instanceLayout.Push<float>(4);
+	m_VertexArray.AddBuffer(m_Corners, cornerLayout);
+	m_VertexArray.AddBuffer(m_Instances, instanceLayout, 1, 1);
+
+	glm::vec4 colors[s_ColorKeyCount] = {
+		glm::vec4(0.6f, 0.8f, 1.0f, 1.0f), glm::vec4(0.3f, 0.5f, 1.0f, 0.8f),
+		glm::vec4(0.1f, 0.2f, 0.6f, 0.5f), glm::vec4(0.05f, 0.05f, 0.1f, 0.0f)
+	};
+	SetColorOverLife(colors);
+	m_Stats.Capacity = m_Capacity;
+}
+
+void CpuParticleSystem::SetColorOverLife(const glm::vec4* colors)
+{
+	std::copy(colors, colors + s_ColorKeyCount, m_Colors);
+}
+
+void CpuParticleSystem::Emit(const ParticleEmitter& emitter, float deltaTime)
+{
+	float count = emitter.Rate * deltaTime + m_EmitRemainder;
+	unsigned int whole = (unsigned int)count;
+	m_EmitRemainder = count - whole;
+
+	whole = std::min(whole, m_Capacity - m_Count);
+	ParticlePool& pool = m_Pools[m_Current];
+	for (unsigned int i = m_Count; i < m_Count + whole; i++)
+	{
+		glm::vec3 position, velocity;
+		float lifetime;
+		emitter.Spawn(m_RandomState, position, velocity, lifetime);
+		pool.PositionX[i] = position.x;
+		pool.PositionY[i] = position.y;
+		pool.PositionZ[i] = position.z;
+		pool.VelocityX[i] = velocity.x;
+		pool.VelocityY[i] = velocity.y;
+		pool.VelocityZ[i] = velocity.z;
+		pool.Age[i] = 0.0f;
+		/* a zero lifetime is dead on the first update, like on the GPU */
+		pool.InverseLifetime[i] = lifetime > 0.0f ? 1.0f / lifetime : 1.0e30f;
+	}
+	m_Count += whole;
+	m_Stats.Emitted += whole;
+}
+
+template<typename Function>
+void CpuParticleSystem::ForEachChunk(unsigned int chunkCount, const Function& function)
+{
+	if (!m_Jobs || chunkCount <= 1)
+	{
+		for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+			function(chunk);
+		return;
+	}
+
+	JobCounter counter;
+	m_Jobs->ParallelFor(chunkCount, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int chunk = begin; chunk < end; chunk++)
+			function(chunk);
+	}, &counter, 1);
+	m_Jobs->Wait(counter);
+}
+
+void CpuParticleSystem::Update(float deltaTime)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	ParticlePool& source = m_Pools[m_Current];
+	ParticlePool& target = m_Pools[1 - m_Current];
+	/* per frame factor that loses m_Drag of the velocity over a second whatever the frame rate */
+	float damping = std::pow(std::max(1.0f - m_Drag, 0.0f), deltaTime);
+
+	/* fixed chunks so the second pass knows where each one's survivors go */
+	unsigned int count = m_Count;
+	unsigned int threads = m_Jobs ? m_Jobs->GetThreadCount() : 1;
+	unsigned int chunkSize = (count + threads * 4 - 1) / (threads * 4);
+	chunkSize = std::max((chunkSize + s_SimdWidth - 1) / s_SimdWidth * s_SimdWidth, s_MinChunkSize);
+	unsigned int chunkCount = (count + chunkSize - 1) / chunkSize;
+	m_ChunkOffsets.assign(chunkCount, 0);
+
+	ForEachChunk(chunkCount, [&](unsigned int chunk) {
+		unsigned int begin = chunk * chunkSize;
+		m_ChunkOffsets[chunk] = Integrate(source, begin, std::min(begin + chunkSize, count), deltaTime, damping);
+	});
+
+	unsigned int alive = 0;
+	for (unsigned int& offset : m_ChunkOffsets)
+	{
+		unsigned int survivors = offset;
+		offset = alive;
+		alive += survivors;
+	}
+
+	if (alive > 0)
+	{
+		/* workers write the mapped storage directly, the GL calls stay on this thread */
+		Instance* instances = (Instance*)m_Instances.Map(alive * (unsigned int)sizeof(Instance));
+		ForEachChunk(chunkCount, [&](unsigned int chunk) {
+			unsigned int begin = chunk * chunkSize;
+			Compact(source, target, begin, std::min(begin + chunkSize, count), m_ChunkOffsets[chunk], instances);
+		});
+		m_Instances.Unmap();
+	}
+
+	m_Current = 1 - m_Current;
+	m_Count = alive;
+	/* whatever came in since the last Update was emitted */
+	m_Stats.EmittedLastFrame = count - m_InstanceCount;
+	m_InstanceCount = alive;
+
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_TotalMilliseconds += milliseconds;
+	m_Updates++;
+	m_Stats.Alive = alive;
+	m_Stats.KilledLastFrame = count - alive;
+	m_Stats.UpdateMilliseconds = milliseconds;
+	m_Stats.AverageUpdateMilliseconds = (float)(m_TotalMilliseconds / m_Updates);
+}
+
+void CpuParticleSystem::Draw(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection)
+{
+	if (m_InstanceCount == 0)
+		return;
+
+	m_Shader.Bind();
+	m_Shader.SetUniformMat4f("u_View", view);
+	m_Shader.SetUniformMat4f("u_Projection", projection);
+	m_Shader.SetUniform2f("u_Size", m_StartSize, m_EndSize);
+	m_Shader.SetUniform4fv("u_Colors", s_ColorKeyCount, &m_Colors[0].x);
+
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
+	GLCall(glDepthMask(GL_FALSE));
+	renderer.DrawArraysInstanced(m_VertexArray, m_Shader, GL_TRIANGLE_STRIP, 0, 4, m_InstanceCount);
+	GLCall(glDepthMask(GL_TRUE));
+	/* back to the blending everything else uses */
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+}
+
+CpuParticleStats CpuParticleSystem::GetStats() const
+{
+	return m_Stats;
+}
+
+unsigned int CpuParticleSystem::Integrate(ParticlePool& pool, unsigned int begin, unsigned int end, float deltaTime, float damping) const
+{
+	float* px = pool.PositionX.data();
+	float* py = pool.PositionY.data();
+	float* pz = pool.PositionZ.data();
+	float* vx = pool.VelocityX.data();
+	float* vy = pool.VelocityY.data();
+	float* vz = pool.VelocityZ.data();
+	float* age = pool.Age.data();
+	const float* inverseLifetime = pool.InverseLifetime.data();
+
+	unsigned int alive = 0;
+	unsigned int i = begin;
+	if (m_UseSimd)
+	{
+		Floats gravityX = Set(m_Gravity.x * deltaTime), gravityY = Set(m_Gravity.y * deltaTime), gravityZ = Set(m_Gravity.z * deltaTime);
+		Floats step = Set(deltaTime), drag = Set(damping), ground = Set(m_GroundHeight), bounce = Set(-m_Restitution), one = Set(1.0f);
+		for (; i + s_SimdWidth <= end; i += s_SimdWidth)
+		{
+			Floats velocityX = Mul(Add(Load(vx + i), gravityX), drag);
+			Floats velocityY = Mul(Add(Load(vy + i), gravityY), drag);
+			Floats velocityZ = Mul(Add(Load(vz + i), gravityZ), drag);
+			Floats positionY = Add(Load(py + i), Mul(velocityY, step));
+
+			/* below the ground: put back on it and reflect the vertical speed */
+			Floats below = Less(positionY, ground);
+			positionY = Select(below, ground, positionY);
+			velocityY = Select(below, Mul(velocityY, bounce), velocityY);
+
+			Store(px + i, Add(Load(px + i), Mul(velocityX, step)));
+			Store(py + i, positionY);
+			Store(pz + i, Add(Load(pz + i), Mul(velocityZ, step)));
+			Store(vx + i, velocityX);
+			Store(vy + i, velocityY);
+			Store(vz + i, velocityZ);
+
+			Floats older = Add(Load(age + i), step);
+			Store(age + i, older);
+			alive += CountBits(MoveMask(Less(Mul(older, Load(inverseLifetime + i)), one)));
+		}
+	}
+
+	/* the tail that does not fill a register, or everything with SIMD off */
+	for (; i < end; i++)
+	{
+		vx[i] = (vx[i] + m_Gravity.x * deltaTime) * damping;
+		vy[i] = (vy[i] + m_Gravity.y * deltaTime) * damping;
+		vz[i] = (vz[i] + m_Gravity.z * deltaTime) * damping;
+		px[i] += vx[i] * deltaTime;
+		py[i] += vy[i] * deltaTime;
+		pz[i] += vz[i] * deltaTime;
+		if (py[i] < m_GroundHeight)
+		{
+			py[i] = m_GroundHeight;
+			vy[i] *= -m_Restitution;
+		}
+		age[i] += deltaTime;
+		alive += age[i] * inverseLifetime[i] < 1.0f ? 1 : 0;
+	}
+	return alive;
+}
+
+void CpuParticleSystem::Compact(const ParticlePool& source, ParticlePool& target, unsigned int begin, unsigned int end,
+	unsigned int to, Instance* instances) const
+{
+	const float* const sources[] = { source.PositionX.data(), source.PositionY.data(), source.PositionZ.data(), source.VelocityX.data(),
+		source.VelocityY.data(), source.VelocityZ.data(), source.Age.data(), source.InverseLifetime.data() };
+	float* const targets[] = { target.PositionX.data(), target.PositionY.data(), target.PositionZ.data(), target.VelocityX.data(),
+		target.VelocityY.data(), target.VelocityZ.data(), target.Age.data(), target.InverseLifetime.data() };
+	const unsigned int arrayCount = sizeof(sources) / sizeof(sources[0]);
+	const float* age = source.Age.data();
+	const float* inverseLifetime = source.InverseLifetime.data();
+
+	unsigned int i = begin;
+	if (m_UseSimd)
+	{
+		const unsigned int allAlive = (1u << s_SimdWidth) - 1;
+		Floats one = Set(1.0f);
+		for (; i + s_SimdWidth <= end; i += s_SimdWidth)
+		{
+			/* the same compare as Integrate, so the counts match */
+			unsigned int mask = MoveMask(Less(Mul(Load(age + i), Load(inverseLifetime + i)), one));
+			if (mask == allAlive)
+			{
+				/* the usual case, a whole register moves at once */
+				for (unsigned int array = 0; array < arrayCount; array++)
+					Store(targets[array] + to, Load(sources[array] + i));
+				for (unsigned int lane = 0; lane < s_SimdWidth; lane++)
+					instances[to + lane] = { sources[0][i + lane], sources[1][i + lane], sources[2][i + lane], age[i + lane] * inverseLifetime[i + lane] };
+				to += s_SimdWidth;
+				continue;
+			}
+
+			for (; mask; mask &= mask - 1)
+			{
+				unsigned int lane = 0;
+				while (!(mask & (1u << lane)))
+					lane++;
+				for (unsigned int array = 0; array < arrayCount; array++)
+					targets[array][to] = sources[array][i + lane];
+				instances[to] = { sources[0][i + lane], sources[1][i + lane], sources[2][i + lane], age[i + lane] * inverseLifetime[i + lane] };
+				to++;
+			}
+		}
+	}
+
+	for (; i < end; i++)
+	{
+		float life = age[i] * inverseLifetime[i];
+		if (life >= 1.0f)
+			continue;
+		for (unsigned int array = 0; array < arrayCount; array++)
+			targets[array][to] = sources[array][i];
+		instances[to] = { sources[0][i], sources[1][i], sources[2][i], life };
+		to++;
+	}
+}
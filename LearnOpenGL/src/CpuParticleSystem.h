@@ -0,0 +1,138 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "ParticleSystem.h"
+
+class JobSystem;
+
+/* Particles as one array per component so SIMD loads are contiguous, live ones packed at the front */
+struct ParticlePool
+{
+	std::vector<float> PositionX, PositionY, PositionZ;
+	std::vector<float> VelocityX, VelocityY, VelocityZ;
+	std::vector<float> Age;
+	/* 1 / lifetime, dead once Age * InverseLifetime reaches 1 */
+	std::vector<float> InverseLifetime;
+
+	void Resize(unsigned int capacity);
+};
+
+struct CpuParticleStats
+{
+	unsigned int Capacity;
+	unsigned int Alive;
+	unsigned int EmittedLastFrame;
+	unsigned int KilledLastFrame;
+	unsigned long long Emitted;
+	/* wall clock of the last Update and the mean of all of them */
+	float UpdateMilliseconds;
+	float AverageUpdateMilliseconds;
+};
+
+/*
+* Particles simulated on the CPU, for effects gameplay code needs to see
+* State lives in two SoA pools. Update works in two passes over fixed
+* chunks on the job system: the first integrates gravity, drag and a
+* ground plane bounce with SSE or AVX, ages the particles and counts the
+* survivors of each chunk from the compare mask. A prefix sum over the
+* counts tells each chunk where its survivors go, and the second pass
+* copies them into the other pool while writing position and life fraction
+* straight into the mapped instance buffer. One instanced draw then shows
+* every live particle, nothing dead is sent to the GPU.
+*
+* Compaction keeps order, so the result is the same for any thread count.
+*/
+class CpuParticleSystem
+{
+public:
+	/* floats per SIMD register the kernels were built for, 1 without SSE */
+	static const unsigned int s_SimdWidth;
+	static const unsigned int s_ColorKeyCount = ParticleSystem::s_ColorKeyCount;
+
+private:
+	/* what the draw reads per instance */
+	struct Instance
+	{
+		float X, Y, Z;
+		float Life;
+	};
+
+	JobSystem* m_Jobs;
+	unsigned int m_Capacity;
+	ParticlePool m_Pools[2];
+	/* pool with the latest state and how many of its particles are live */
+	unsigned int m_Current;
+	unsigned int m_Count;
+	/* survivors per chunk, then where each chunk's survivors start */
+	std::vector<unsigned int> m_ChunkOffsets;
+
+	Shader m_Shader;
+	VertexBuffer m_Corners;
+	VertexBuffer m_Instances;
+	VertexArray m_VertexArray;
+	/* instances written by the last Update */
+	unsigned int m_InstanceCount;
+
+	float m_EmitRemainder;
+	unsigned int m_RandomState;
+
+	glm::vec3 m_Gravity;
+	float m_Drag;
+	float m_GroundHeight;
+	float m_Restitution;
+	bool m_UseSimd;
+	glm::vec4 m_Colors[s_ColorKeyCount];
+	float m_StartSize;
+	float m_EndSize;
+
+	double m_TotalMilliseconds;
+	unsigned int m_Updates;
+	CpuParticleStats m_Stats;
+public:
+	/* jobs may be null, everything then runs on the calling thread */
+	CpuParticleSystem(unsigned int capacity, JobSystem* jobs);
+
+	CpuParticleSystem(const CpuParticleSystem&) = delete;
+	CpuParticleSystem& operator=(const CpuParticleSystem&) = delete;
+
+	/* adds the particles emitter gives off over deltaTime, they move from the next Update. Drops what does not fit */
+	void Emit(const ParticleEmitter& emitter, float deltaTime);
+	/* advances every particle by deltaTime, removes the dead and refills the instance buffer. GL thread */
+	void Update(float deltaTime);
+	/* additive blending, depth is left unwritten */
+	void Draw(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+
+	inline void SetGravity(const glm::vec3& gravity) { m_Gravity = gravity; }
+	/* fraction of velocity lost per second */
+	inline void SetDrag(float drag) { m_Drag = drag; }
+	/* particles bounce off the plane y = height keeping restitution of their vertical speed */
+	inline void SetGround(float height, float restitution) { m_GroundHeight = height; m_Restitution = restitution; }
+	/* world units, the quad's half size at birth and at death */
+	inline void SetSize(float startSize, float endSize) { m_StartSize = startSize; m_EndSize = endSize; }
+	void SetColorOverLife(const glm::vec4* colors);
+	/* off runs the plain scalar loops, for comparison */
+	inline void SetSimd(bool enabled) { m_UseSimd = enabled; }
+
+	/* live particles, the first GetCount entries of every array in the pool */
+	inline unsigned int GetCount() const { return m_Count; }
+	inline const ParticlePool& GetPool() const { return m_Pools[m_Current]; }
+	CpuParticleStats GetStats() const;
+
+private:
+	/*
+	* runs function(chunk) for every chunk, on the job system when there is one. A template so
+	* the kernels' captures are not copied into a std::function, which would allocate every frame
+	*/
+	template<typename Function>
+	void ForEachChunk(unsigned int chunkCount, const Function& function);
+	/* advances [begin, end) in place, returns how many are still alive */
+	unsigned int Integrate(ParticlePool& pool, unsigned int begin, unsigned int end, float deltaTime, float damping) const;
+	/* copies the live particles of [begin, end) to target from index to on, with their instances */
+	void Compact(const ParticlePool& source, ParticlePool& target, unsigned int begin, unsigned int end,
+		unsigned int to, Instance* instances) const;
+};
@@ -0,0 +1,229 @@
+#include "Culler.h"
+
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CULLER_USE_SSE 1
+#endif
+
+#include "Renderer.h"
+#include "LooseQuadtree.h"
+#include "BoundingVolumeHierarchy.h"
+
+/* removed objects keep their slot with a negative extent, which fails every plane test */
+static const float s_RemovedExtent = -1e30f;
+
+Culler::Culler(SpatialIndexType indexType, const AABB& worldBounds)
+	: m_IndexType(indexType), m_Stats()
+{
+	if (indexType == SpatialIndexType::LooseQuadtree)
+		m_Quadtree.reset(new LooseQuadtree(worldBounds));
+	else if (indexType == SpatialIndexType::BVH)
+		m_BVH.reset(new BoundingVolumeHierarchy());
+}
+
+Culler::~Culler()
+{
+}
+
+unsigned int Culler::Add(const AABB& box)
+{
+	unsigned int object;
+	if (!m_FreeIDs.empty())
+	{
+		object = m_FreeIDs.back();
+		m_FreeIDs.pop_back();
+	}
+	else
+	{
+		object = (unsigned int)m_CenterX.size();
+		m_CenterX.push_back(0.0f);
+		m_CenterY.push_back(0.0f);
+		m_CenterZ.push_back(0.0f);
+		m_ExtentX.push_back(0.0f);
+		m_ExtentY.push_back(0.0f);
+		m_ExtentZ.push_back(0.0f);
+	}
+
+	SetBounds(object, box);
+	if (m_Quadtree)
+		m_Quadtree->Insert(object, box);
+	else if (m_BVH)
+		m_BVH->Insert(object, box);
+
+	return object;
+}
+
+void Culler::Update(unsigned int object, const AABB& box)
+{
+	SetBounds(object, box);
+	if (m_Quadtree)
+		m_Quadtree->Update(object, box);
+	else if (m_BVH)
+		m_BVH->Update(object, box);
+}
+
+void Culler::Remove(unsigned int object)
+{
+	if (m_Quadtree)
+		m_Quadtree->Remove(object);
+	else if (m_BVH)
+		m_BVH->Remove(object);
+
+	m_ExtentX[object] = m_ExtentY[object] = m_ExtentZ[object] = s_RemovedExtent;
+	m_FreeIDs.push_back(object);
+}
+
+AABB Culler::GetBounds(unsigned int object) const
+{
+	glm::vec3 center(m_CenterX[object], m_CenterY[object], m_CenterZ[object]);
+	glm::vec3 extents(m_ExtentX[object], m_ExtentY[object], m_ExtentZ[object]);
+	return AABB(center - extents, center + extents);
+}
+
+void Culler::SetBounds(unsigned int object, const AABB& box)
+{
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+	m_CenterX[object] = center.x;
+	m_CenterY[object] = center.y;
+	m_CenterZ[object] = center.z;
+	m_ExtentX[object] = extents.x;
+	m_ExtentY[object] = extents.y;
+	m_ExtentZ[object] = extents.z;
+}
+
+void Culler::Cull(const glm::mat4& viewProj, std::vector<unsigned int>& visible)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	Frustum frustum = Frustum::FromMatrix(viewProj);
+	visible.clear();
+
+	if (m_IndexType == SpatialIndexType::None)
+	{
+		m_Stats.Tested = (unsigned int)m_CenterX.size();
+		TestObjects(frustum, nullptr, (unsigned int)m_CenterX.size(), visible);
+	}
+	else
+	{
+		/* neither can hold more than every object, so they only grow when objects are added, never as the camera moves */
+		m_Inside.clear();
+		m_Intersecting.clear();
+		m_Inside.reserve(m_CenterX.size());
+		m_Intersecting.reserve(m_CenterX.size());
+		if (m_Quadtree)
+		{
+			m_Quadtree->Query(frustum, m_Inside, m_Intersecting);
+		}
+		else
+		{
+			m_BVH->Linearize();
+			m_BVH->Query(frustum, m_Inside, m_Intersecting);
+		}
+
+		/* everything in fully visible regions is accepted without a test */
+		visible.insert(visible.end(), m_Inside.begin(), m_Inside.end());
+		m_Stats.Tested = (unsigned int)m_Intersecting.size();
+		TestObjects(frustum, m_Intersecting.data(), (unsigned int)m_Intersecting.size(), visible);
+	}
+
+	m_Stats.Objects = GetObjectCount();
+	m_Stats.Visible = (unsigned int)visible.size();
+	m_Stats.Culled = m_Stats.Objects - m_Stats.Visible;
+	m_Stats.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Culler::TestObjects(const Frustum& frustum, const unsigned int* ids, unsigned int count, std::vector<unsigned int>& visible) const
+{
+#ifdef CULLER_USE_SSE
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = frustum.Planes[p];
+		planeX[p] = _mm_set1_ps(plane.x);
+		planeY[p] = _mm_set1_ps(plane.y);
+		planeZ[p] = _mm_set1_ps(plane.z);
+		planeW[p] = _mm_set1_ps(plane.w);
+		absX[p] = _mm_set1_ps(std::abs(plane.x));
+		absY[p] = _mm_set1_ps(std::abs(plane.y));
+		absZ[p] = _mm_set1_ps(std::abs(plane.z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		unsigned int lanes = std::min(count - i, 4u);
+		__m128 cx, cy, cz, ex, ey, ez;
+
+		if (!ids && lanes == 4)
+		{
+			cx = _mm_loadu_ps(&m_CenterX[i]);
+			cy = _mm_loadu_ps(&m_CenterY[i]);
+			cz = _mm_loadu_ps(&m_CenterZ[i]);
+			ex = _mm_loadu_ps(&m_ExtentX[i]);
+			ey = _mm_loadu_ps(&m_ExtentY[i]);
+			ez = _mm_loadu_ps(&m_ExtentZ[i]);
+		}
+		else
+		{
+			/* gather candidates from the index, unused tail lanes look like removed objects */
+			alignas(16) float gathered[6][4];
+			for (unsigned int lane = 0; lane < 4; lane++)
+			{
+				if (lane < lanes)
+				{
+					unsigned int object = ids ? ids[i + lane] : i + lane;
+					gathered[0][lane] = m_CenterX[object];
+					gathered[1][lane] = m_CenterY[object];
+					gathered[2][lane] = m_CenterZ[object];
+					gathered[3][lane] = m_ExtentX[object];
+					gathered[4][lane] = m_ExtentY[object];
+					gathered[5][lane] = m_ExtentZ[object];
+				}
+				else
+				{
+					gathered[0][lane] = gathered[1][lane] = gathered[2][lane] = 0.0f;
+					gathered[3][lane] = gathered[4][lane] = gathered[5][lane] = s_RemovedExtent;
+				}
+			}
+			cx = _mm_load_ps(gathered[0]);
+			cy = _mm_load_ps(gathered[1]);
+			cz = _mm_load_ps(gathered[2]);
+			ex = _mm_load_ps(gathered[3]);
+			ey = _mm_load_ps(gathered[4]);
+			ez = _mm_load_ps(gathered[5]);
+		}
+
+		/* a box is outside if it is fully behind any one plane */
+		__m128 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int visibleMask = ~_mm_movemask_ps(outside) & ((1 << lanes) - 1);
+		while (visibleMask)
+		{
+			unsigned int lane = 0;
+			while (!(visibleMask & (1 << lane)))
+				lane++;
+			visibleMask &= ~(1 << lane);
+			visible.push_back(ids ? ids[i + lane] : i + lane);
+		}
+	}
+#else
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int object = ids ? ids[i] : i;
+		glm::vec3 center(m_CenterX[object], m_CenterY[object], m_CenterZ[object]);
+		glm::vec3 extents(m_ExtentX[object], m_ExtentY[object], m_ExtentZ[object]);
+		if (frustum.Test(AABB(center - extents, center + extents)) != FrustumTest::Outside)
+			visible.push_back(object);
+	}
+#endif
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Bounds.h"
+
+class LooseQuadtree;
+class BoundingVolumeHierarchy;
+
+enum class SpatialIndexType
+{
+	/* test every object, still SIMD and often fine for a few thousand objects */
+	None,
+	/* 2D scenes on the xy plane */
+	LooseQuadtree,
+	/* 3D scenes */
+	BVH
+};
+
+struct CullingStats
+{
+	unsigned int Objects;
+	/* objects that needed a per object test after the index pruned whole regions */
+	unsigned int Tested;
+	unsigned int Visible;
+	unsigned int Culled;
+	float Milliseconds;
+};
+
+/*
+* Keeps a bounding box per renderable and produces the list of visible ones
+* for a view projection matrix. The spatial index rejects or accepts whole
+* regions, the objects left over are tested four at a time with SSE.
+*/
+class Culler
+{
+private:
+	SpatialIndexType m_IndexType;
+	std::unique_ptr<LooseQuadtree> m_Quadtree;
+	std::unique_ptr<BoundingVolumeHierarchy> m_BVH;
+
+	/* tight bounds as center/extents, one array per component so four objects load at once */
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+	std::vector<unsigned int> m_FreeIDs;
+
+	/* scratch kept between frames so culling does not allocate */
+	std::vector<unsigned int> m_Inside;
+	std::vector<unsigned int> m_Intersecting;
+
+	CullingStats m_Stats;
+public:
+	/* worldBounds is only used by the quadtree */
+	Culler(SpatialIndexType indexType = SpatialIndexType::None, const AABB& worldBounds = AABB());
+	~Culler();
+
+	unsigned int Add(const AABB& box);
+	void Update(unsigned int object, const AABB& box);
+	void Remove(unsigned int object);
+	/* the box last given for the object */
+	AABB GetBounds(unsigned int object) const;
+
+	/* Fills visible with the ids of every object touching the view */
+	void Cull(const glm::mat4& viewProj, std::vector<unsigned int>& visible);
+
+	inline const CullingStats& GetStats() const { return m_Stats; }
+	inline unsigned int GetObjectCount() const { return (unsigned int)(m_CenterX.size() - m_FreeIDs.size()); }
+
+private:
+	void SetBounds(unsigned int object, const AABB& box);
+	/* appends the ids that pass, ids may be null to test objects [0, count) */
+	void TestObjects(const Frustum& frustum, const unsigned int* ids, unsigned int count, std::vector<unsigned int>& visible) const;
+};
@@ -0,0 +1,136 @@
+#include "CullingBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+CullingBenchmark::CullingBenchmark(unsigned int objectCount, unsigned int frames)
+	: m_ObjectCount(std::max(objectCount, 100u)), m_Frames(std::max(frames, 1u))
+{
+}
+
+bool CullingBenchmark::Run()
+{
+	std::cout << "Culling benchmark: " << m_ObjectCount << " objects, " << m_Frames << " frames, 1% of the objects move every frame" << std::endl;
+
+	unsigned int random = 1;
+	auto nextRandom = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) * (1.0f / 16777216.0f);
+	};
+
+	bool correct = true;
+
+	/* sprites over 32 x 32 screens of 960 x 540, the camera pans diagonally across a few of them */
+	{
+		const float width = 960.0f * 32.0f, height = 540.0f * 32.0f;
+		std::vector<AABB> boxes(m_ObjectCount);
+		for (AABB& box : boxes)
+		{
+			glm::vec3 min(nextRandom() * width, nextRandom() * height, 0.0f);
+			float size = 16.0f + nextRandom() * 48.0f;
+			box = AABB(min, min + glm::vec3(size, size, 0.0f));
+		}
+
+		std::vector<glm::mat4> viewProjs(m_Frames);
+		glm::mat4 proj = glm::ortho(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+		for (unsigned int frame = 0; frame < m_Frames; frame++)
+		{
+			glm::vec3 camera(width * 0.4f + frame * 16.0f, height * 0.4f + frame * 9.0f, 0.0f);
+			viewProjs[frame] = proj * glm::translate(glm::mat4(1.0f), -camera);
+		}
+
+		AABB world(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(width, height, 1.0f));
+		correct = RunScene("2D", boxes, viewProjs, SpatialIndexType::None, world) && correct;
+		correct = RunScene("2D", boxes, viewProjs, SpatialIndexType::LooseQuadtree, world) && correct;
+		correct = RunScene("2D", boxes, viewProjs, SpatialIndexType::BVH, world) && correct;
+	}
+
+	/* boxes through a cube, the camera sits in the middle and turns around */
+	{
+		const float size = 1000.0f;
+		std::vector<AABB> boxes(m_ObjectCount);
+		for (AABB& box : boxes)
+		{
+			glm::vec3 center = glm::vec3(nextRandom(), nextRandom(), nextRandom()) * size - size * 0.5f;
+			glm::vec3 extents = glm::vec3(0.25f + nextRandom(), 0.25f + nextRandom(), 0.25f + nextRandom());
+			box = AABB(center - extents, center + extents);
+		}
+
+		std::vector<glm::mat4> viewProjs(m_Frames);
+		glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 250.0f);
+		for (unsigned int frame = 0; frame < m_Frames; frame++)
+		{
+			float angle = frame * 0.05f;
+			viewProjs[frame] = proj * glm::lookAt(glm::vec3(0.0f), glm::vec3(std::sin(angle), 0.1f, -std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+
+		correct = RunScene("3D", boxes, viewProjs, SpatialIndexType::None, AABB()) && correct;
+		correct = RunScene("3D", boxes, viewProjs, SpatialIndexType::BVH, AABB()) && correct;
+	}
+
+	return correct;
+}
+
+bool CullingBenchmark::RunScene(const char* name, const std::vector<AABB>& startBoxes, const std::vector<glm::mat4>& viewProjs,
+	SpatialIndexType indexType, const AABB& worldBounds)
+{
+	std::vector<AABB> boxes = startBoxes;
+
+	auto start = std::chrono::steady_clock::now();
+	Culler culler(indexType, worldBounds);
+	for (const AABB& box : boxes)
+		culler.Add(box);
+	/* the first cull lays the BVH out for traversal, that is part of building it */
+	std::vector<unsigned int> visible;
+	culler.Cull(viewProjs[0], visible);
+	float buildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	double updateMilliseconds = 0.0, cullMilliseconds = 0.0;
+	unsigned long long visibleSum = 0, culledSum = 0, testedSum = 0;
+	unsigned int moving = m_ObjectCount / 100;
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		/* the same objects move the same way for every index, a stride spreads them over the scene, each steps 5% of its size */
+		start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < moving; i++)
+		{
+			unsigned int object = (unsigned int)(((unsigned long long)frame * moving + i) * 7919 % m_ObjectCount);
+			glm::vec3 offset = glm::vec3(std::sin(frame * 0.3f + i), std::cos(frame * 0.3f + i), 0.0f) * (boxes[object].Max.x - boxes[object].Min.x) * 0.05f;
+			boxes[object] = AABB(boxes[object].Min + offset, boxes[object].Max + offset);
+			culler.Update(object, boxes[object]);
+		}
+		updateMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		visible.clear();
+		culler.Cull(viewProjs[frame], visible);
+		const CullingStats& stats = culler.GetStats();
+		cullMilliseconds += stats.Milliseconds;
+		visibleSum += stats.Visible;
+		culledSum += stats.Culled;
+		testedSum += stats.Tested;
+	}
+
+	/* plain scalar test of every object against the last frame's view */
+	Frustum frustum = Frustum::FromMatrix(viewProjs.back());
+	std::vector<unsigned int> expected;
+	for (unsigned int object = 0; object < m_ObjectCount; object++)
+	{
+		if (frustum.Test(boxes[object]) != FrustumTest::Outside)
+			expected.push_back(object);
+	}
+	std::sort(visible.begin(), visible.end());
+	bool same = visible == expected;
+
+	const char* indexName = indexType == SpatialIndexType::LooseQuadtree ? "loose quadtree" : indexType == SpatialIndexType::BVH ? "BVH" : "no index";
+	std::cout << "  " << name << ", " << indexName << ": " << visibleSum / m_Frames << " visible, " << culledSum / m_Frames << " culled, "
+		<< testedSum / m_Frames << " tested per frame, cull " << cullMilliseconds / m_Frames << " ms, update "
+		<< updateMilliseconds / m_Frames << " ms per frame, build " << buildMilliseconds << " ms"
+		<< (same ? "" : ", DIFFERENT VISIBLE LIST") << std::endl;
+	if (!same)
+		std::cout << "    last frame " << visible.size() << " visible, a test of every object finds " << expected.size() << std::endl;
+	return same;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+#include "Bounds.h"
+#include "Culler.h"
+
+/*
+* Culling report on a scene with a million objects
+* A 2D scene of sprites spread over 32 x 32 screens under a panning ortho
+* camera, and a 3D scene of boxes under a perspective camera turning in
+* place. Every frame 1% of the objects move, then the view is culled. Each
+* scene runs with every index that suits it and prints visible, culled and
+* tested counts with the update and cull cost per frame. The last frame's
+* visible list must match a plain Frustum::Test of every object.
+*/
+class CullingBenchmark
+{
+private:
+	unsigned int m_ObjectCount;
+	unsigned int m_Frames;
+public:
+	CullingBenchmark(unsigned int objectCount = 1000000, unsigned int frames = 60);
+
+	/* Prints a line per scene and index, returns false if any visible list was wrong */
+	bool Run();
+
+private:
+	/* viewProjs holds the camera of every frame, moves the objects the same way for every index */
+	bool RunScene(const char* name, const std::vector<AABB>& boxes, const std::vector<glm::mat4>& viewProjs,
+		SpatialIndexType indexType, const AABB& worldBounds);
+};
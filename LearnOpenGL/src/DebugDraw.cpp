@@ -0,0 +1,300 @@
+#include "DebugDraw.h"
+
+#if DEBUG_DRAW_ENABLED
+
+#include <algorithm>
+#include <cmath>
+
+#include "VertexBufferLayout.h"
+
+/* starting size of each streaming buffer in bytes, they grow to fit the busiest frame */
+static const unsigned int s_InitialBufferSize = 1024 * 1024;
+
+DebugDraw::DebugDraw(int width, int height)
+	: m_LineShader("res/shaders/DebugDraw.shader"),
+	m_WideShader("res/shaders/DebugDraw.shader", "#define WIDE_LINES"),
+	m_LineBuffer(s_InitialBufferSize), m_WideBuffer(s_InitialBufferSize)
+{
+	VertexBufferLayout lineLayout;
+	lineLayout.Push<float>(3);
+	lineLayout.Push<unsigned char>(4);
+	m_LineVertexArray.AddBuffer(m_LineBuffer, lineLayout);
+
+	VertexBufferLayout wideLayout;
+	wideLayout.Push<float>(3);
+	wideLayout.Push<float>(3);
+	wideLayout.Push<float>(1);
+	wideLayout.Push<unsigned char>(4);
+	m_WideVertexArray.AddBuffer(m_WideBuffer, wideLayout);
+
+	m_WideShader.Bind();
+	m_WideShader.SetUniform2f("u_ViewportSize", (float)width, (float)height);
+}
+
+unsigned int DebugDraw::PackColor(const glm::vec4& color)
+{
+	glm::vec4 clamped = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	/* bytes in memory are r, g, b, a on little endian machines */
+	return (unsigned int)clamped.r | (unsigned int)clamped.g << 8 | (unsigned int)clamped.b << 16 | (unsigned int)clamped.a << 24;
+}
+
+void DebugDraw::Line(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color, float duration, DebugDepth depth)
+{
+	Batch<LineVertex>& batch = m_Lines[(int)depth];
+	std::vector<LineVertex>& vertices = duration > 0.0f ? batch.Timed : batch.Vertices;
+	unsigned int packed = PackColor(color);
+	vertices.push_back({ from.x, from.y, from.z, packed });
+	vertices.push_back({ to.x, to.y, to.z, packed });
+	if (duration > 0.0f)
+		batch.Remaining.push_back(duration);
+}
+
+void DebugDraw::AddWideSegment(const glm::vec3& from, const glm::vec3& to, unsigned int color, float halfWidth,
+	float duration, DebugDepth depth)
+{
+	Batch<WideVertex>& batch = m_WideLines[(int)depth];
+	std::vector<WideVertex>& vertices = duration > 0.0f ? batch.Timed : batch.Vertices;
+
+	/*
+	* Each end is moved towards the side its sign picks as seen looking at the
+	* other end, so from +w and to -w lie on the same side of the segment
+	*/
+	WideVertex fromLeft = { from.x, from.y, from.z, to.x, to.y, to.z, halfWidth, color };
+	WideVertex fromRight = fromLeft;
+	fromRight.HalfWidth = -halfWidth;
+	WideVertex toLeft = { to.x, to.y, to.z, from.x, from.y, from.z, -halfWidth, color };
+	WideVertex toRight = toLeft;
+	toRight.HalfWidth = halfWidth;
+
+	vertices.push_back(fromLeft);
+	vertices.push_back(fromRight);
+	vertices.push_back(toRight);
+	vertices.push_back(toRight);
+	vertices.push_back(toLeft);
+	vertices.push_back(fromLeft);
+	if (duration > 0.0f)
+		batch.Remaining.push_back(duration);
+}
+
+void DebugDraw::Polyline(const glm::vec3* points, unsigned int count, const glm::vec4& color, float thickness,
+	bool closed, float duration, DebugDepth depth)
+{
+	if (count < 2)
+		return;
+
+	unsigned int segments = closed ? count : count - 1;
+	if (thickness <= 1.0f)
+	{
+		for (unsigned int i = 0; i < segments; i++)
+			Line(points[i], points[(i + 1) % count], color, duration, depth);
+		return;
+	}
+
+	/* ends are extended by half the width, which also fills the gap at each corner */
+	unsigned int packed = PackColor(color);
+	for (unsigned int i = 0; i < segments; i++)
+		AddWideSegment(points[i], points[(i + 1) % count], packed, thickness * 0.5f, duration, depth);
+}
+
+void DebugDraw::Box(const AABB& box, const glm::vec4& color, float duration, DebugDepth depth)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = glm::vec3(i & 1 ? box.Max.x : box.Min.x, i & 2 ? box.Max.y : box.Min.y, i & 4 ? box.Max.z : box.Min.z);
+	}
+
+	/* corners that differ in one bit share an edge */
+	for (int i = 0; i < 8; i++)
+	{
+		for (int bit = 1; bit < 8; bit <<= 1)
+		{
+			if (!(i & bit))
+				Line(corners[i], corners[i | bit], color, duration, depth);
+		}
+	}
+}
+
+void DebugDraw::Circle(const glm::vec3& center, const glm::vec3& normal, float radius, const glm::vec4& color,
+	unsigned int segments, float duration, DebugDepth depth)
+{
+	if (segments < 3)
+		segments = 3;
+
+	glm::vec3 axis = glm::normalize(normal);
+	glm::vec3 helper = std::abs(axis.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 u = glm::normalize(glm::cross(axis, helper)) * radius;
+	glm::vec3 v = glm::cross(axis, u);
+
+	glm::vec3 previous = center + u;
+	for (unsigned int i = 1; i <= segments; i++)
+	{
+		float angle = 6.28318531f * i / segments;
+		glm::vec3 point = center + u * std::cos(angle) + v * std::sin(angle);
+		Line(previous, point, color, duration, depth);
+		previous = point;
+	}
+}
+
+void DebugDraw::Arrow(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color, float headSize,
+	float duration, DebugDepth depth)
+{
+	Line(from, to, color, duration, depth);
+
+	glm::vec3 direction = to - from;
+	float length = glm::length(direction);
+	if (length <= 0.0f)
+		return;
+	direction /= length;
+
+	/* head opens in the XY plane, the one the 2D scenes use, unless the arrow points along z */
+	glm::vec3 up = std::abs(direction.z) < 0.9f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 side = glm::normalize(glm::cross(direction, up)) * (headSize * 0.5f);
+	glm::vec3 back = to - direction * headSize;
+	Line(to, back + side, color, duration, depth);
+	Line(to, back - side, color, duration, depth);
+}
+
+void DebugDraw::Grid(const glm::vec3& origin, const glm::vec3& stepU, const glm::vec3& stepV, unsigned int countU, unsigned int countV,
+	const glm::vec4& color, float duration, DebugDepth depth)
+{
+	glm::vec3 spanU = stepU * (float)countU;
+	glm::vec3 spanV = stepV * (float)countV;
+	for (unsigned int i = 0; i <= countU; i++)
+	{
+		glm::vec3 start = origin + stepU * (float)i;
+		Line(start, start + spanV, color, duration, depth);
+	}
+	for (unsigned int i = 0; i <= countV; i++)
+	{
+		glm::vec3 start = origin + stepV * (float)i;
+		Line(start, start + spanU, color, duration, depth);
+	}
+}
+
+template<typename T>
+void DebugDraw::PrepareBatch(Batch<T>& batch, unsigned int verticesPerPrimitive, float deltaTime)
+{
+	batch.Vertices.insert(batch.Vertices.end(), batch.Timed.begin(), batch.Timed.end());
+
+	/* compacts in place, the order of what is kept does not change */
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < batch.Remaining.size(); i++)
+	{
+		float remaining = batch.Remaining[i] - deltaTime;
+		if (remaining <= 0.0f)
+			continue;
+
+		if (kept != i)
+		{
+			std::copy(batch.Timed.begin() + i * verticesPerPrimitive, batch.Timed.begin() + (i + 1) * verticesPerPrimitive,
+				batch.Timed.begin() + kept * verticesPerPrimitive);
+		}
+		batch.Remaining[kept++] = remaining;
+	}
+	batch.Timed.resize(kept * verticesPerPrimitive);
+	batch.Remaining.resize(kept);
+}
+
+template<typename T>
+void DebugDraw::Upload(VertexBuffer& buffer, Batch<T>* batches)
+{
+	unsigned int testBytes = (unsigned int)(batches[(int)DebugDepth::Test].Vertices.size() * sizeof(T));
+	unsigned int overlayBytes = (unsigned int)(batches[(int)DebugDepth::Overlay].Vertices.size() * sizeof(T));
+	if (testBytes + overlayBytes == 0)
+		return;
+
+	buffer.Orphan(testBytes + overlayBytes);
+	if (testBytes)
+		buffer.SetSubData(batches[(int)DebugDepth::Test].Vertices.data(), 0, testBytes);
+	if (overlayBytes)
+		buffer.SetSubData(batches[(int)DebugDepth::Overlay].Vertices.data(), testBytes, overlayBytes);
+}
+
+void DebugDraw::Draw(const Renderer& renderer, const glm::mat4& viewProjection, float deltaTime)
+{
+	for (int depth = 0; depth < 2; depth++)
+	{
+		PrepareBatch(m_Lines[depth], 2, deltaTime);
+		PrepareBatch(m_WideLines[depth], 6, deltaTime);
+	}
+	Upload(m_LineBuffer, m_Lines);
+	Upload(m_WideBuffer, m_WideLines);
+
+	unsigned int lineCounts[2] = { (unsigned int)m_Lines[0].Vertices.size(), (unsigned int)m_Lines[1].Vertices.size() };
+	unsigned int wideCounts[2] = { (unsigned int)m_WideLines[0].Vertices.size(), (unsigned int)m_WideLines[1].Vertices.size() };
+	for (int depth = 0; depth < 2; depth++)
+	{
+		m_Lines[depth].Vertices.clear();
+		m_WideLines[depth].Vertices.clear();
+	}
+	if (lineCounts[0] + lineCounts[1] + wideCounts[0] + wideCounts[1] == 0)
+		return;
+
+	m_LineShader.Bind();
+	m_LineShader.SetUniformMat4f("u_ViewProjection", viewProjection);
+	m_WideShader.Bind();
+	m_WideShader.SetUniformMat4f("u_ViewProjection", viewProjection);
+
+	/* depth is tested but never written, so debug shapes do not hide each other or later geometry */
+	GLboolean depthTest;
+	GLboolean depthMask;
+	int depthFunc;
+	GLCall(depthTest = glIsEnabled(GL_DEPTH_TEST));
+	GLCall(glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask));
+	GLCall(glGetIntegerv(GL_DEPTH_FUNC, &depthFunc));
+	GLCall(glDepthMask(GL_FALSE));
+	GLCall(glDepthFunc(GL_LEQUAL));
+
+	for (int depth = 0; depth < 2; depth++)
+	{
+		if (lineCounts[depth] + wideCounts[depth] == 0)
+			continue;
+
+		if (depth == (int)DebugDepth::Test)
+		{
+			GLCall(glEnable(GL_DEPTH_TEST));
+		}
+		else
+		{
+			GLCall(glDisable(GL_DEPTH_TEST));
+		}
+
+		/* overlay vertices follow the depth tested ones in each buffer */
+		unsigned int lineFirst = depth == (int)DebugDepth::Test ? 0 : lineCounts[0];
+		unsigned int wideFirst = depth == (int)DebugDepth::Test ? 0 : wideCounts[0];
+		if (lineCounts[depth])
+			renderer.DrawArrays(m_LineVertexArray, m_LineShader, GL_LINES, lineFirst, lineCounts[depth]);
+		if (wideCounts[depth])
+			renderer.DrawArrays(m_WideVertexArray, m_WideShader, GL_TRIANGLES, wideFirst, wideCounts[depth]);
+	}
+
+	if (depthTest)
+	{
+		GLCall(glEnable(GL_DEPTH_TEST));
+	}
+	else
+	{
+		GLCall(glDisable(GL_DEPTH_TEST));
+	}
+	GLCall(glDepthMask(depthMask));
+	GLCall(glDepthFunc(depthFunc));
+}
+
+unsigned int DebugDraw::GetLineCount() const
+{
+	size_t vertices = 0;
+	for (const Batch<LineVertex>& batch : m_Lines)
+		vertices += batch.Vertices.size() + batch.Timed.size();
+	return (unsigned int)(vertices / 2);
+}
+
+unsigned int DebugDraw::GetWideLineCount() const
+{
+	size_t vertices = 0;
+	for (const Batch<WideVertex>& batch : m_WideLines)
+		vertices += batch.Vertices.size() + batch.Timed.size();
+	return (unsigned int)(vertices / 6);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "Bounds.h"
+
+/*
+* Set to 0 to compile debug drawing out, DebugDraw then keeps its interface
+* but every call is an empty inline function and no GL objects are made.
+*/
+#ifndef DEBUG_DRAW_ENABLED
+#define DEBUG_DRAW_ENABLED 1
+#endif
+
+enum class DebugDepth
+{
+	/* hidden behind scene geometry that wrote depth */
+	Test,
+	/* always on top */
+	Overlay
+};
+
+#if DEBUG_DRAW_ENABLED
+
+/*
+* Immediate mode lines and shapes for debugging, queued from anywhere during a frame
+* Calls only append vertices to CPU arrays. Draw uploads them into streaming
+* vertex buffers and issues at most four draws: one pixel lines and wide
+* lines, each depth tested and as an overlay. Wide lines are expanded to
+* quads in the vertex shader so their width is in pixels. A duration in
+* seconds keeps a primitive around for later frames, zero draws it once.
+*/
+class DebugDraw
+{
+private:
+	struct LineVertex
+	{
+		float X, Y, Z;
+		unsigned int Color;
+	};
+
+	struct WideVertex
+	{
+		float X, Y, Z;
+		float OtherX, OtherY, OtherZ;
+		float HalfWidth;
+		unsigned int Color;
+	};
+
+	/* vertices of one kind of primitive in one depth mode */
+	template<typename T>
+	struct Batch
+	{
+		std::vector<T> Vertices;
+		/* primitives with a duration, copied into Vertices every frame until they expire */
+		std::vector<T> Timed;
+		std::vector<float> Remaining;
+	};
+
+	Shader m_LineShader;
+	Shader m_WideShader;
+	VertexArray m_LineVertexArray;
+	VertexArray m_WideVertexArray;
+	VertexBuffer m_LineBuffer;
+	VertexBuffer m_WideBuffer;
+	/* indexed by DebugDepth */
+	Batch<LineVertex> m_Lines[2];
+	Batch<WideVertex> m_WideLines[2];
+public:
+	/* width and height of the viewport in pixels, wide line widths are relative to it */
+	DebugDraw(int width, int height);
+
+	DebugDraw(const DebugDraw&) = delete;
+	DebugDraw& operator=(const DebugDraw&) = delete;
+
+	void Line(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color,
+		float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+	/* thickness in pixels, one pixel or less draws plain lines */
+	void Polyline(const glm::vec3* points, unsigned int count, const glm::vec4& color, float thickness = 1.0f,
+		bool closed = false, float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+	void Box(const AABB& box, const glm::vec4& color, float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+	/* circle in the plane through center facing normal */
+	void Circle(const glm::vec3& center, const glm::vec3& normal, float radius, const glm::vec4& color,
+		unsigned int segments = 32, float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+	/* headSize is the length of the two head lines in world units */
+	void Arrow(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color, float headSize,
+		float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+	/* countU by countV cells starting at origin, each cell spanned by stepU and stepV */
+	void Grid(const glm::vec3& origin, const glm::vec3& stepU, const glm::vec3& stepV, unsigned int countU, unsigned int countV,
+		const glm::vec4& color, float duration = 0.0f, DebugDepth depth = DebugDepth::Test);
+
+	/*
+	* Draws everything queued since the last call with viewProjection, then
+	* ages timed primitives by deltaTime and forgets the ones drawn only once
+	*/
+	void Draw(const Renderer& renderer, const glm::mat4& viewProjection, float deltaTime);
+
+	/* primitives queued for the next Draw, timed ones included */
+	unsigned int GetLineCount() const;
+	unsigned int GetWideLineCount() const;
+
+private:
+	void AddWideSegment(const glm::vec3& from, const glm::vec3& to, unsigned int color, float halfWidth,
+		float duration, DebugDepth depth);
+	/* appends the timed vertices for drawing and keeps the ones with time left */
+	template<typename T>
+	static void PrepareBatch(Batch<T>& batch, unsigned int verticesPerPrimitive, float deltaTime);
+	/* uploads both depth modes of a kind into one buffer, depth tested first */
+	template<typename T>
+	static void Upload(VertexBuffer& buffer, Batch<T>* batches);
+	static unsigned int PackColor(const glm::vec4& color);
+};
+
+#else
+
+class DebugDraw
+{
+public:
+	DebugDraw(int, int) {}
+
+	inline void Line(const glm::vec3&, const glm::vec3&, const glm::vec4&, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+	inline void Polyline(const glm::vec3*, unsigned int, const glm::vec4&, float = 1.0f, bool = false, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+	inline void Box(const AABB&, const glm::vec4&, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+	inline void Circle(const glm::vec3&, const glm::vec3&, float, const glm::vec4&, unsigned int = 32, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+	inline void Arrow(const glm::vec3&, const glm::vec3&, const glm::vec4&, float, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+	inline void Grid(const glm::vec3&, const glm::vec3&, const glm::vec3&, unsigned int, unsigned int, const glm::vec4&, float = 0.0f, DebugDepth = DebugDepth::Test) {}
+
+	inline void Draw(const Renderer&, const glm::mat4&, float) {}
+
+	inline unsigned int GetLineCount() const { return 0; }
+	inline unsigned int GetWideLineCount() const { return 0; }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "DynamicTexture.h"
+
+#include <cstring>
+
+#include "Renderer.h"
+#include "GpuMemory.h"
+
+DynamicTexture::DynamicTexture(int width, int height, unsigned int ringSize, bool allowPersistent)
+	: m_Texture(width, height, nullptr), m_Next(0), m_Size((unsigned int)width * height * 4),
+	m_Persistent(allowPersistent && GLEW_ARB_buffer_storage), m_Stalls(0)
+{
+	ASSERT(ringSize > 0);
+
+	/* coherent, so writes from any thread are visible to the GPU without a flush */
+	GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	m_Slots.resize(ringSize);
+	for (Slot& slot : m_Slots)
+	{
+		slot.Fence = nullptr;
+		slot.Mapped = nullptr;
+		slot.Writing = false;
+
+		GLCall(glGenBuffers(1, &slot.Buffer));
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer));
+		if (m_Persistent)
+		{
+			GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_Size, nullptr, storageFlags));
+			GLCall(slot.Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_Size, storageFlags));
+		}
+		else
+		{
+			/* STREAM_DRAW, written once by us and read once by the GPU */
+			GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+		}
+	}
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+	m_MemoryID = GpuMemory::Track(GpuMemoryCategory::Other, (unsigned long long)m_Size * ringSize, "Texture upload ring");
+}
+
+DynamicTexture::~DynamicTexture()
+{
+	for (Slot& slot : m_Slots)
+	{
+		if (slot.Fence)
+		{
+			GLCall(glDeleteSync(slot.Fence));
+		}
+		/* deleting a buffer unmaps it */
+		GLCall(glDeleteBuffers(1, &slot.Buffer));
+	}
+	GpuMemory::Release(m_MemoryID);
+}
+
+DynamicTextureWrite DynamicTexture::BeginWrite()
+{
+	Slot& slot = m_Slots[m_Next];
+	if (slot.Writing)
+		return { nullptr, m_Next };
+
+	if (slot.Fence)
+	{
+		/* poll first so only real waits count as stalls */
+		GLCall(GLenum result = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			m_Stalls++;
+			GLCall(glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, ~(GLuint64)0));
+		}
+		GLCall(glDeleteSync(slot.Fence));
+		slot.Fence = nullptr;
+	}
+
+	if (!m_Persistent)
+	{
+		/* orphan the old storage, the driver keeps it alive until pending uploads are done */
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer));
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+		GLCall(slot.Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_Size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		if (!slot.Mapped)
+			return { nullptr, m_Next };
+	}
+
+	slot.Writing = true;
+	DynamicTextureWrite write = { slot.Mapped, m_Next };
+	m_Next = (m_Next + 1) % m_Slots.size();
+	return write;
+}
+
+void DynamicTexture::Commit(const DynamicTextureWrite& write)
+{
+	Slot& slot = m_Slots[write.Slot];
+	ASSERT(slot.Writing);
+
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer));
+	if (!m_Persistent)
+	{
+		GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		slot.Mapped = nullptr;
+	}
+	/* pixels is an offset into the bound buffer, returns before the copy is done */
+	m_Texture.Update(nullptr);
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	/* an orphaned buffer gets new storage on the next write, only persistent memory needs to wait for the GPU */
+	if (m_Persistent)
+	{
+		GLCall(slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+
+	slot.Writing = false;
+}
+
+void DynamicTexture::Update(const unsigned char* pixels)
+{
+	DynamicTextureWrite write = BeginWrite();
+	if (!write.Pixels)
+	{
+		/* ring is full of writes in progress, go straight to the texture instead */
+		m_Texture.Update(pixels);
+		return;
+	}
+
+	memcpy(write.Pixels, pixels, m_Size);
+	Commit(write);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+
+#include "Texture.h"
+
+/* A slot of the ring handed out by BeginWrite, Pixels holds width * height RGBA8 */
+struct DynamicTextureWrite
+{
+	unsigned char* Pixels;
+	unsigned int Slot;
+};
+
+/*
+* Texture rewritten every frame through a ring of pixel unpack buffers
+* BeginWrite hands out mapped buffer memory that any thread may fill, Commit
+* then starts glTexSubImage2D from that buffer, which the GPU copies on its
+* own timeline. A fence per slot says when the GPU is done with a buffer so
+* a worker can write the next frame while the last one is still uploading.
+* With GL_ARB_buffer_storage the buffers stay mapped for their whole life,
+* otherwise each write orphans the buffer and maps it again.
+*/
+class DynamicTexture
+{
+private:
+	struct Slot
+	{
+		unsigned int Buffer;
+		GLsync Fence;
+		/* persistent mapping, or the mapping of the current write */
+		unsigned char* Mapped;
+		bool Writing;
+	};
+
+	Texture m_Texture;
+	std::vector<Slot> m_Slots;
+	unsigned int m_Next;
+	unsigned int m_Size;
+	bool m_Persistent;
+	/* BeginWrite calls that had to wait for the GPU to release a slot */
+	unsigned long long m_Stalls;
+	/* GpuMemory allocation id, covers the whole ring */
+	unsigned int m_MemoryID;
+public:
+	/* allowPersistent false forces the orphaning path even when persistent mapping is supported */
+	DynamicTexture(int width, int height, unsigned int ringSize = 3, bool allowPersistent = true);
+	~DynamicTexture();
+
+	DynamicTexture(const DynamicTexture&) = delete;
+	DynamicTexture& operator=(const DynamicTexture&) = delete;
+
+	/*
+	* GL thread. Takes the next slot, waiting if the GPU still reads from it.
+	* Pixels is null when every slot is already being written or mapping failed.
+	*/
+	DynamicTextureWrite BeginWrite();
+	/* GL thread, after the write finished. Uploads the slot into the texture */
+	void Commit(const DynamicTextureWrite& write);
+	/* copies pixels into the next slot and commits it, for data that is already in memory */
+	void Update(const unsigned char* pixels);
+
+	inline void Bind(unsigned int slot = 0) const { m_Texture.Bind(slot); }
+	inline void UnBind() const { m_Texture.UnBind(); }
+
+	inline const Texture& GetTexture() const { return m_Texture; }
+	inline int GetWidth() const { return m_Texture.GetWidth(); }
+	inline int GetHeight() const { return m_Texture.GetHeight(); }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline unsigned long long GetStallCount() const { return m_Stalls; }
+};
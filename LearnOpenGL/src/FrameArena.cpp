@@ -0,0 +1,151 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+#ifdef _WIN32
+
+static unsigned char* MapBlock(std::size_t& capacity, bool hugePages, bool& onHugePages)
+{
+	onHugePages = false;
+	SIZE_T largePage = GetLargePageMinimum();
+	if (hugePages && largePage)
+	{
+		SIZE_T size = AlignUp(capacity, largePage);
+		void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory)
+		{
+			capacity = size;
+			onHugePages = true;
+			return (unsigned char*)memory;
+		}
+	}
+	return (unsigned char*)VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void UnmapBlock(unsigned char* memory, std::size_t)
+{
+	VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+#else
+
+static const std::size_t s_HugePageSize = 2 * 1024 * 1024;
+
+static unsigned char* MapBlock(std::size_t& capacity, bool hugePages, bool& onHugePages)
+{
+	onHugePages = false;
+	if (hugePages)
+	{
+		std::size_t size = AlignUp(capacity, s_HugePageSize);
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (memory != MAP_FAILED)
+		{
+			capacity = size;
+			onHugePages = true;
+			return (unsigned char*)memory;
+		}
+	}
+
+	void* memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return nullptr;
+	if (hugePages)
+		madvise(memory, capacity, MADV_HUGEPAGE);
+	return (unsigned char*)memory;
+}
+
+static void UnmapBlock(unsigned char* memory, std::size_t capacity)
+{
+	munmap(memory, capacity);
+}
+
+#endif
+
+FrameArena::FrameArena(std::size_t capacity, bool hugePages)
+	: m_Memory(nullptr), m_Capacity(std::max<std::size_t>(capacity, 4096)), m_Offset(0), m_Overflow(nullptr), m_Stats()
+{
+	m_Memory = MapBlock(m_Capacity, hugePages, m_Stats.HugePages);
+	if (m_Memory)
+	{
+		/* faults every page in now instead of during the first frames */
+		std::memset(m_Memory, 0, m_Capacity);
+	}
+	else
+	{
+		/* everything overflows onto the heap, slower but still correct */
+		m_Capacity = 0;
+	}
+	m_Stats.Capacity = m_Capacity;
+}
+
+FrameArena::~FrameArena()
+{
+	FreeOverflow();
+	if (m_Memory)
+		UnmapBlock(m_Memory, m_Capacity);
+}
+
+void FrameArena::Reset()
+{
+	FreeOverflow();
+	m_Offset = 0;
+	m_Stats.Used = 0;
+	m_Stats.OverflowBytes = 0;
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	std::size_t offset = AlignUp(m_Offset, alignment);
+	if (offset + bytes <= m_Capacity)
+	{
+		m_Offset = offset + bytes;
+		m_Stats.Used = m_Offset;
+		m_Stats.PeakUsed = std::max(m_Stats.PeakUsed, m_Offset + m_Stats.OverflowBytes);
+		return m_Memory + offset;
+	}
+
+	/* the link sits at the start of the heap block, the memory handed out after it at the alignment asked for */
+	unsigned char* block = (unsigned char*)::operator new(sizeof(Overflow) + alignment + bytes);
+	Overflow* overflow = (Overflow*)block;
+	overflow->Next = m_Overflow;
+	m_Overflow = overflow;
+
+	m_Stats.OverflowBytes += bytes;
+	m_Stats.OverflowAllocations++;
+	m_Stats.PeakUsed = std::max(m_Stats.PeakUsed, m_Offset + m_Stats.OverflowBytes);
+	return (void*)AlignUp((std::uintptr_t)(block + sizeof(Overflow)), alignment);
+}
+
+void FrameArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+void FrameArena::FreeOverflow()
+{
+	while (m_Overflow)
+	{
+		Overflow* next = m_Overflow->Next;
+		::operator delete(m_Overflow);
+		m_Overflow = next;
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+struct FrameArenaStats
+{
+	std::size_t Capacity;
+	/* this frame so far */
+	std::size_t Used;
+	/* the most any frame used, overflow included, the capacity to ask for */
+	std::size_t PeakUsed;
+	/* this frame, taken from the heap because the arena was full */
+	std::size_t OverflowBytes;
+	unsigned long long OverflowAllocations;
+	/* the block is on huge pages rather than only asked to be */
+	bool HugePages;
+};
+
+/*
+* Linear allocator for memory that only lives until the end of the frame
+* One block is reserved up front and touched so it is resident, then
+* allocating is a pointer bump and freeing does nothing, Reset at the end
+* of the frame takes everything back at once. It is a pmr memory resource,
+* so scratch containers use it with std::pmr::vector and friends, and
+* nothing allocated from it may be used after Reset. When a frame needs
+* more than the capacity the rest comes from the heap and is freed by the
+* next Reset, PeakUsed then says how much to reserve.
+*
+* With hugePages the block is asked for on 2 MB pages, which needs the lock
+* pages privilege on Windows and reserved huge pages on Linux. Without them
+* it falls back to normal pages, on Linux marked for transparent huge pages.
+* Not thread safe, one arena per thread.
+*/
+class FrameArena : public std::pmr::memory_resource
+{
+private:
+	/* heads each heap block taken when full, they are chained for Reset */
+	struct Overflow
+	{
+		Overflow* Next;
+	};
+
+	unsigned char* m_Memory;
+	std::size_t m_Capacity;
+	std::size_t m_Offset;
+	Overflow* m_Overflow;
+	FrameArenaStats m_Stats;
+public:
+	FrameArena(std::size_t capacity, bool hugePages = false);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	/* end of frame, everything allocated since the last Reset is gone */
+	void Reset();
+
+	inline const FrameArenaStats& GetStats() const { return m_Stats; }
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	/* a no op, Reset frees */
+	void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	void FreeOverflow();
+};
@@ -0,0 +1,221 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "ImageWriter.h"
+#include "Renderer.h"
+
+FrameCapture::FrameCapture(int width, int height, const CaptureSettings& settings)
+	: m_Settings(settings), m_Width(width), m_Height(height), m_Readback(width, height, std::max(settings.QueueDepth, 2u)),
+	m_QueueFront(0), m_QueueSize(0), m_HeldSlots(0), m_NextSequence(0), m_NextSequenceToWrite(0), m_Stopping(false),
+	m_Captured(0), m_Dropped(0), m_Encoded(0), m_RenderThreadTime(0.0), m_MaxRenderThreadTime(0.0), m_OverBudget(0), m_EncodeMicroseconds(0)
+{
+	ASSERT(settings.QueueDepth > 0);
+
+	m_Queue.resize(std::max(settings.QueueDepth, 2u));
+	m_EncodedSlots.reserve(std::max(settings.QueueDepth, 2u));
+	m_ReleasingSlots.reserve(std::max(settings.QueueDepth, 2u));
+
+	if (m_Settings.Format == CaptureFormat::Y4M)
+	{
+		m_VideoStream.open(m_Settings.OutputPath, std::ios::binary);
+		if (!m_VideoStream)
+			std::cout << "Failed to open " << m_Settings.OutputPath << " for writing" << std::endl;
+		m_VideoStream << ImageWriter::GetY4MHeader(width, height, m_Settings.FrameRate);
+	}
+
+	unsigned int encoderCount = m_Settings.EncoderThreads;
+	if (encoderCount == 0)
+		encoderCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+	for (unsigned int i = 0; i < encoderCount; i++)
+		m_Encoders.emplace_back(&FrameCapture::EncoderLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	Finish();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& encoder : m_Encoders)
+		encoder.join();
+}
+
+void FrameCapture::Capture(unsigned long long frame)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	AsyncReadback::Callback callback = [this](const unsigned char* pixels, int, int, unsigned long long frame, unsigned int slot)
+	{
+		return OnFrameRead(pixels, frame, slot);
+	};
+
+	/* hand over whatever the GPU has finished so far */
+	ReleaseEncodedSlots();
+	m_Readback.Poll(callback);
+
+	if (m_Settings.Policy == CapturePolicy::Drop && m_Readback.IsFull())
+	{
+		m_Dropped++;
+	}
+	else
+	{
+		/* the read goes into the oldest slot, which an encoder may still be reading */
+		while (m_Readback.IsNextHeld())
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_SpaceAvailable.wait(lock, [this] { return !m_EncodedSlots.empty(); });
+			}
+			ReleaseEncodedSlots();
+		}
+		m_Readback.Request(frame, callback);
+	}
+	m_Captured++;
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_RenderThreadTime += seconds;
+	m_MaxRenderThreadTime = std::max(m_MaxRenderThreadTime, seconds);
+	if (seconds * 1000.0 > m_Settings.RenderThreadBudgetMilliseconds)
+		m_OverBudget++;
+}
+
+void FrameCapture::Finish()
+{
+	m_Readback.Flush([this](const unsigned char* pixels, int, int, unsigned long long frame, unsigned int slot)
+	{
+		return OnFrameRead(pixels, frame, slot);
+	});
+
+	while (true)
+	{
+		ReleaseEncodedSlots();
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_HeldSlots == 0)
+			break;
+		m_SpaceAvailable.wait(lock, [this] { return !m_EncodedSlots.empty(); });
+	}
+
+	std::lock_guard<std::mutex> videoLock(m_VideoMutex);
+	if (m_VideoStream.is_open())
+		m_VideoStream.flush();
+}
+
+CaptureStats FrameCapture::GetStats() const
+{
+	CaptureStats stats;
+	stats.Captured = m_Captured;
+	stats.Dropped = m_Dropped;
+	stats.Encoded = m_Encoded;
+	stats.RenderThreadMilliseconds = m_Captured ? (float)(m_RenderThreadTime * 1000.0 / m_Captured) : 0.0f;
+	stats.MaxRenderThreadMilliseconds = (float)(m_MaxRenderThreadTime * 1000.0);
+	stats.OverBudget = m_OverBudget;
+	stats.EncodeMilliseconds = stats.Encoded ? (float)(m_EncodeMicroseconds / 1000.0 / stats.Encoded) : 0.0f;
+	return stats;
+}
+
+bool FrameCapture::OnFrameRead(const unsigned char* pixels, unsigned long long frame, unsigned int slot)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ASSERT(m_QueueSize < m_Queue.size());
+		m_Queue[(m_QueueFront + m_QueueSize) % m_Queue.size()] = { pixels, slot, frame, m_NextSequence++ };
+		m_QueueSize++;
+		m_HeldSlots++;
+	}
+	m_WorkAvailable.notify_one();
+	return false;
+}
+
+void FrameCapture::ReleaseEncodedSlots()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ReleasingSlots.swap(m_EncodedSlots);
+		m_HeldSlots -= (unsigned int)m_ReleasingSlots.size();
+	}
+
+	for (unsigned int slot : m_ReleasingSlots)
+		m_Readback.Release(slot);
+	m_ReleasingSlots.clear();
+}
+
+void FrameCapture::EncoderLoop()
+{
+	/* kept per thread so it is allocated once */
+	EncoderScratch scratch;
+
+	while (true)
+	{
+		QueuedFrame queued;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [this] { return m_Stopping || m_QueueSize > 0; });
+			if (m_QueueSize == 0)
+				return;
+
+			queued = m_Queue[m_QueueFront];
+			m_QueueFront = (m_QueueFront + 1) % m_Queue.size();
+			m_QueueSize--;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		Encode(queued, scratch);
+		m_EncodeMicroseconds += (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		m_Encoded++;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_EncodedSlots.push_back(queued.Slot);
+		}
+		m_SpaceAvailable.notify_all();
+	}
+}
+
+void FrameCapture::Encode(const QueuedFrame& queued, EncoderScratch& scratch)
+{
+	const unsigned char* pixels = queued.Pixels;
+
+	if (m_Settings.Format == CaptureFormat::Y4M)
+	{
+		/* conversion runs in parallel, the writes are serialized in queue order */
+		ImageWriter::ConvertToYUV420(pixels, m_Width, m_Height, scratch.Output);
+
+		std::unique_lock<std::mutex> lock(m_VideoMutex);
+		m_SequenceWritten.wait(lock, [this, &queued] { return m_NextSequenceToWrite == queued.Sequence; });
+		m_VideoStream << "FRAME\n";
+		m_VideoStream.write((const char*)scratch.Output.data(), scratch.Output.size());
+		m_NextSequenceToWrite++;
+		lock.unlock();
+		m_SequenceWritten.notify_all();
+		return;
+	}
+
+	static const char* extensions[] = { "png", "qoi", "ppm" };
+	char name[32];
+	snprintf(name, sizeof(name), "/frame_%04llu.%s", queued.Frame, extensions[(int)m_Settings.Format]);
+	/* assigned in place, the string keeps its capacity from the last frame */
+	scratch.Path.assign(m_Settings.OutputPath).append(name);
+
+	switch (m_Settings.Format)
+	{
+	case CaptureFormat::PNG:
+		ImageWriter::EncodePNG(pixels, m_Width, m_Height, scratch.Output, scratch.PNG);
+		break;
+	case CaptureFormat::QOI:
+		ImageWriter::EncodeQOI(pixels, m_Width, m_Height, scratch.Output);
+		break;
+	default:
+		ImageWriter::EncodePPM(pixels, m_Width, m_Height, scratch.Output);
+		break;
+	}
+	ImageWriter::WriteFile(scratch.Path, scratch.Output);
+}
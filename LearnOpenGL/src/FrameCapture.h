@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncReadback.h"
+#include "ImageWriter.h"
+
+enum class CaptureFormat
+{
+	PNG, QOI, PPM, Y4M
+};
+
+/*
+* What happens when the encoders fall behind and the queue is full
+* Drop - the frame is skipped, the render thread never waits
+* Block - the render thread waits for a free queue entry, every frame is kept
+*/
+enum class CapturePolicy
+{
+	Drop, Block
+};
+
+struct CaptureSettings
+{
+	CaptureFormat Format = CaptureFormat::PNG;
+	CapturePolicy Policy = CapturePolicy::Drop;
+	/* image formats write frame_0000.png ... into this directory, Y4M writes a single file */
+	std::string OutputPath = ".";
+	/* frames being read back or waiting for an encoder, each is a mapped pixel pack buffer of the whole frame */
+	unsigned int QueueDepth = 8;
+	/* 0 picks half the hardware threads */
+	unsigned int EncoderThreads = 0;
+	/* only stored in the Y4M header */
+	int FrameRate = 60;
+	/* render thread time Capture may take per frame, frames over it are counted in the stats */
+	float RenderThreadBudgetMilliseconds = 0.5f;
+};
+
+struct CaptureStats
+{
+	unsigned long long Captured;
+	unsigned long long Dropped;
+	unsigned long long Encoded;
+	/* average and longest time Capture spent on the render thread */
+	float RenderThreadMilliseconds;
+	float MaxRenderThreadMilliseconds;
+	/* captures that took longer than CaptureSettings::RenderThreadBudgetMilliseconds */
+	unsigned long long OverBudget;
+	/* average time to encode and write one frame on an encoder thread */
+	float EncodeMilliseconds;
+};
+
+/*
+* Captures frames to disk without stalling the render loop
+* The read framebuffer (default or an FBO) is copied into a pixel pack buffer
+* ring. Finished reads stay mapped and encoder threads read them in place, so
+* the render thread never copies a frame, it only maps and unmaps. Encoding
+* and file IO use their own threads rather than the job system because a job
+* system worker blocked on the disk would stall frame work.
+*/
+class FrameCapture
+{
+private:
+	struct QueuedFrame
+	{
+		/* mapped readback slot, valid until the render thread releases it */
+		const unsigned char* Pixels;
+		unsigned int Slot;
+		unsigned long long Frame;
+		/* order frames were queued in, Y4M frames must be written in this order */
+		unsigned long long Sequence;
+	};
+
+	/* what an encoder thread keeps between frames, so a steady capture never allocates */
+	struct EncoderScratch
+	{
+		std::vector<unsigned char> Output;
+		ImageWriter::PNGScratch PNG;
+		std::string Path;
+	};
+
+	CaptureSettings m_Settings;
+	int m_Width, m_Height;
+	AsyncReadback m_Readback;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_SpaceAvailable;
+	/* ring of one entry per readback slot, a queued frame holds its slot so it never overflows */
+	std::vector<QueuedFrame> m_Queue;
+	unsigned int m_QueueFront;
+	unsigned int m_QueueSize;
+	/* slots the encoders are done with, the render thread unmaps them since only it has the context */
+	std::vector<unsigned int> m_EncodedSlots;
+	/* m_EncodedSlots is swapped with this, both keep their capacity so a steady capture never allocates */
+	std::vector<unsigned int> m_ReleasingSlots;
+	/* slots mapped for the encoders and not released yet */
+	unsigned int m_HeldSlots;
+	unsigned long long m_NextSequence;
+	unsigned long long m_NextSequenceToWrite;
+	bool m_Stopping;
+
+	std::vector<std::thread> m_Encoders;
+	/* separate from m_Mutex so a slow disk write never blocks the render thread */
+	std::mutex m_VideoMutex;
+	std::condition_variable m_SequenceWritten;
+	std::ofstream m_VideoStream;
+
+	unsigned long long m_Captured;
+	std::atomic<unsigned long long> m_Dropped;
+	std::atomic<unsigned long long> m_Encoded;
+	double m_RenderThreadTime;
+	double m_MaxRenderThreadTime;
+	unsigned long long m_OverBudget;
+	std::atomic<unsigned long long> m_EncodeMicroseconds;
+public:
+	FrameCapture(int width, int height, const CaptureSettings& settings);
+	/* finishes every queued frame before returning */
+	~FrameCapture();
+
+	/*
+	* Queues a read of the currently bound read framebuffer. Call after the
+	* frame is drawn and before the swap when capturing the default framebuffer.
+	*/
+	void Capture(unsigned long long frame);
+	/* Waits for all outstanding reads and encodes, needs the GL context */
+	void Finish();
+
+	CaptureStats GetStats() const;
+
+private:
+	/* always keeps the slot mapped, the frame goes to the encoders as it is */
+	bool OnFrameRead(const unsigned char* pixels, unsigned long long frame, unsigned int slot);
+	/* unmaps the slots the encoders finished with, on the render thread */
+	void ReleaseEncodedSlots();
+	void EncoderLoop();
+	void Encode(const QueuedFrame& queued, EncoderScratch& scratch);
+};
@@ -0,0 +1,135 @@
+#include "FramePacer.h"
+
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <thread>
+
+#include "Renderer.h"
+
+/* OS sleep granularity can be a few ms, so the last stretch before the deadline is spun */
+static const double s_SpinThreshold = 0.002;
+/* give up waiting on the fence after 100ms rather than hanging on a lost context */
+static const GLuint64 s_FenceTimeout = 100000000;
+
+FramePacer::FramePacer(GLFWwindow* window, PresentMode mode, double targetFPS)
+	: m_Window(window), m_Mode(mode), m_TargetFrameTime(1.0 / targetFPS),
+	m_WaitForPreviousFrame(false), m_FrameFence(nullptr),
+	m_Deadline(Clock::now())
+{
+	SetPresentMode(mode);
+}
+
+FramePacer::~FramePacer()
+{
+	if (m_FrameFence)
+	{
+		GLCall(glDeleteSync(m_FrameFence));
+	}
+}
+
+void FramePacer::SetPresentMode(PresentMode mode)
+{
+	/* headless, nothing to present so only the limiter applies */
+	if (!m_Window)
+	{
+		m_Mode = mode == PresentMode::Limited ? mode : PresentMode::Uncapped;
+		m_Deadline = Clock::now();
+		return;
+	}
+
+	if (mode == PresentMode::AdaptiveVSync
+		&& !glfwExtensionSupported("WGL_EXT_swap_control_tear")
+		&& !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+	{
+		std::cout << "Warning: EXT_swap_control_tear not supported, falling back to vsync" << std::endl;
+		mode = PresentMode::VSync;
+	}
+
+	m_Mode = mode;
+	m_Deadline = Clock::now();
+
+	switch (m_Mode)
+	{
+		case PresentMode::VSync:         glfwSwapInterval(1);  break;
+		case PresentMode::AdaptiveVSync: glfwSwapInterval(-1); break;
+		case PresentMode::Uncapped:
+		case PresentMode::Limited:       glfwSwapInterval(0);  break;
+	}
+}
+
+void FramePacer::SetTargetFPS(double fps)
+{
+	ASSERT(fps > 0.0);
+	m_TargetFrameTime = 1.0 / fps;
+	m_Deadline = Clock::now();
+}
+
+void FramePacer::SetWaitForPreviousFrame(bool wait)
+{
+	m_WaitForPreviousFrame = wait;
+}
+
+void FramePacer::BeginFrame()
+{
+	if (m_FrameFence)
+	{
+		if (m_WaitForPreviousFrame)
+		{
+			/* flush bit makes sure the fence itself has been submitted, otherwise the wait could never return */
+			GLCall(GLenum result = glClientWaitSync(m_FrameFence, GL_SYNC_FLUSH_COMMANDS_BIT, s_FenceTimeout));
+			if (result == GL_TIMEOUT_EXPIRED)
+			{
+				std::cout << "Warning: previous frame still not finished after " << s_FenceTimeout / 1000000 << " ms" << std::endl;
+			}
+			else if (result == GL_WAIT_FAILED)
+			{
+				/* the fence is unusable, stop waiting rather than failing every frame */
+				std::cout << "Warning: waiting on the previous frame failed, no longer waiting" << std::endl;
+				m_WaitForPreviousFrame = false;
+			}
+		}
+		GLCall(glDeleteSync(m_FrameFence));
+		m_FrameFence = nullptr;
+	}
+}
+
+void FramePacer::EndFrame()
+{
+	if (m_Mode == PresentMode::Limited)
+		LimitFrameRate();
+
+	/* Swap front and back buffers */
+	if (m_Window)
+	{
+		GLCall(glfwSwapBuffers(m_Window));
+	}
+
+	if (m_WaitForPreviousFrame)
+	{
+		GLCall(m_FrameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+}
+
+void FramePacer::LimitFrameRate()
+{
+	/*
+	* The deadline moves by exactly one period each frame, so neither frame cost
+	* nor the time spent swapping adds to the cadence
+	*/
+	m_Deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_TargetFrameTime));
+
+	Clock::time_point now = Clock::now();
+	if (now >= m_Deadline)
+	{
+		/* late, start the cadence again from here instead of rushing the next frames to catch up */
+		m_Deadline = now;
+		return;
+	}
+
+	double remaining = std::chrono::duration<double>(m_Deadline - now).count();
+	if (remaining > s_SpinThreshold)
+		std::this_thread::sleep_for(std::chrono::duration<double>(remaining - s_SpinThreshold));
+
+	while (Clock::now() < m_Deadline)
+		std::this_thread::yield();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <GL/glew.h>
+
+struct GLFWwindow;
+
+/*
+* How frames are handed to the display
+* VSync - swap interval 1, waits for vertical blank
+* AdaptiveVSync - swap interval -1 (EXT_swap_control_tear), tears instead of stalling when a frame is late
+* Uncapped - swap interval 0, renders as fast as possible
+* Limited - swap interval 0, sleep + spin limiter to a target frame rate
+*/
+enum class PresentMode
+{
+	VSync, AdaptiveVSync, Uncapped, Limited
+};
+
+class FramePacer
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	GLFWwindow* m_Window;
+	PresentMode m_Mode;
+	double m_TargetFrameTime;
+	bool m_WaitForPreviousFrame;
+	/* fence inserted after the previous frame was submitted */
+	GLsync m_FrameFence;
+
+	/* when the limiter lets the current frame present, advanced one period per frame */
+	Clock::time_point m_Deadline;
+public:
+	/* window may be null when rendering headless, frames are then paced but never swapped */
+	FramePacer(GLFWwindow* window, PresentMode mode = PresentMode::VSync, double targetFPS = 60.0);
+	~FramePacer();
+
+	void SetPresentMode(PresentMode mode);
+	void SetTargetFPS(double fps);
+	/*
+	* Waits on the previous frame's fence before input is sampled so the CPU
+	* cannot run ahead of the GPU by more than one frame. Trades a little
+	* throughput for lower input latency.
+	*/
+	void SetWaitForPreviousFrame(bool wait);
+
+	/*
+	* Call at the top of the loop before polling events. Simulation time is the
+	* caller's, the pacer may run on a render thread a frame behind it.
+	*/
+	void BeginFrame();
+	/* Call after all draw submission, limits and swaps */
+	void EndFrame();
+
+	inline PresentMode GetPresentMode() const { return m_Mode; }
+
+private:
+	void LimitFrameRate();
+};
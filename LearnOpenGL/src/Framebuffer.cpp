@@ -0,0 +1,58 @@
+#include "Framebuffer.h"
+
+#include <iostream>
+
+#include "Renderer.h"
+#include "GpuMemory.h"
+
+Framebuffer::Framebuffer(int width, int height)
+	: m_RendererID(0), m_ColorAttachment(0), m_DepthAttachment(0), m_Width(width), m_Height(height),
+	m_MemoryID(0)
+{
+	GLCall(glGenFramebuffers(1, &m_RendererID));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+
+	GLCall(glGenTextures(1, &m_ColorAttachment));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_ColorAttachment));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorAttachment, 0));
+
+	GLCall(glGenRenderbuffers(1, &m_DepthAttachment));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthAttachment));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthAttachment));
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer incomplete: " << status << std::endl;
+	ASSERT(status == GL_FRAMEBUFFER_COMPLETE);
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	/* RGBA8 color plus packed 24 bit depth and 8 bit stencil */
+	m_MemoryID = GpuMemory::Track(GpuMemoryCategory::RenderTarget, GpuMemory::EstimateTextureBytes(width, height, 4 + 4, false), "Framebuffer");
+}
+
+Framebuffer::~Framebuffer()
+{
+	GLCall(glDeleteRenderbuffers(1, &m_DepthAttachment));
+	GLCall(glDeleteTextures(1, &m_ColorAttachment));
+	GLCall(glDeleteFramebuffers(1, &m_RendererID));
+	GpuMemory::Release(m_MemoryID);
+}
+
+void Framebuffer::Bind() const
+{
+	RENDER_STAT(FramebufferBinds, 1);
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glViewport(0, 0, m_Width, m_Height));
+}
+
+void Framebuffer::UnBind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+/*
+* Offscreen render target with an RGBA8 color texture and a depth/stencil renderbuffer
+* Color is a texture rather than a renderbuffer so it can be sampled later.
+*/
+class Framebuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_ColorAttachment;
+	unsigned int m_DepthAttachment;
+	int m_Width, m_Height;
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
+public:
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	/* binds for drawing and reading and sets the viewport to the full target */
+	void Bind() const;
+	void UnBind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetColorAttachment() const { return m_ColorAttachment; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
@@ -0,0 +1,990 @@
+#define GL_TRACE_IMPLEMENTATION
+#include "GLTrace.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+static const char* s_Names[] = {
+	"FrameEnd", "MappedWrite",
+	"glActiveTexture", "glAttachShader", "glBeginConditionalRender", "glBeginQuery", "glBeginTransformFeedback",
+	"glBindBuffer", "glBindBufferBase", "glBindBufferRange", "glBindFramebuffer", "glBindRenderbuffer", "glBindTexture", "glBindVertexArray",
+	"glBlendFunc", "glBufferData", "glBufferStorage", "glBufferSubData", "glCheckFramebufferStatus", "glClear", "glClientWaitSync", "glColorMask",
+	"glCompileShader", "glCreateProgram", "glCreateShader", "glDeleteBuffers", "glDeleteFramebuffers", "glDeleteProgram", "glDeleteQueries",
+	"glDeleteRenderbuffers", "glDeleteShader", "glDeleteSync", "glDeleteTextures", "glDeleteVertexArrays", "glDepthFunc", "glDepthMask",
+	"glDisable", "glDrawArrays", "glDrawArraysInstanced", "glDrawElements", "glDrawElementsInstanced", "glEnable", "glEnableVertexAttribArray",
+	"glEndConditionalRender", "glEndQuery", "glEndTransformFeedback", "glFenceSync", "glFinish", "glFramebufferRenderbuffer",
+	"glFramebufferTexture2D", "glGenBuffers", "glGenFramebuffers", "glGenQueries", "glGenRenderbuffers", "glGenTextures", "glGenVertexArrays",
+	"glGetBooleanv", "glGetIntegerv", "glGetQueryObjectiv", "glGetQueryObjectui64v", "glGetQueryObjectuiv", "glGetShaderInfoLog",
+	"glGetShaderiv", "glGetString", "glGetTexImage", "glGetUniformLocation", "glIsEnabled", "glLinkProgram", "glMapBufferRange", "glPixelStorei",
+	"glReadPixels", "glRenderbufferStorage", "glShaderSource", "glTexImage2D", "glTexImage3D", "glTexParameteri", "glTexSubImage2D",
+	"glTexSubImage3D", "glTransformFeedbackVaryings", "glUniform1f", "glUniform1i", "glUniform2f", "glUniform3f", "glUniform4f", "glUniform4fv",
+	"glUniformMatrix4fv", "glUnmapBuffer", "glUseProgram", "glValidateProgram", "glVertexAttribDivisor", "glVertexAttribPointer", "glViewport"
+};
+static_assert(sizeof(s_Names) / sizeof(s_Names[0]) == (size_t)GLTraceOp::Count, "a name per op");
+
+#if GL_TRACE_ENABLED
+
+/* what the application mapped, written out when GL gets to see it */
+struct TraceMapping
+{
+	unsigned char* Pointer;
+	long long Offset;
+	long long Length;
+	GLbitfield Access;
+};
+
+struct TraceState
+{
+	bool Recording = false;
+	std::ofstream File;
+	std::string Path;
+	std::vector<unsigned char> Buffer;
+	std::chrono::steady_clock::time_point Start;
+	unsigned long long Calls = 0, Bytes = 0, Frames = 0;
+
+	/* state the payload sizes depend on */
+	std::unordered_map<GLenum, GLuint> BoundBuffers;
+	std::unordered_map<GLuint, TraceMapping> Mappings;
+	GLint UnpackAlignment = 4, PackAlignment = 4;
+	std::unordered_map<GLsync, unsigned long long> Syncs;
+	unsigned long long NextSync = 1;
+};
+
+static TraceState s_Trace;
+
+static void WriteVarint(unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		s_Trace.Buffer.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	s_Trace.Buffer.push_back((unsigned char)value);
+}
+
+/* signed values go through their 32 bit pattern, -1 then costs five bytes instead of ten */
+static unsigned long long Signed(GLint value) { return (unsigned int)value; }
+static unsigned long long Bits(GLfloat value)
+{
+	unsigned int bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+static unsigned long long Offset(const void* pointer) { return (unsigned long long)(std::uintptr_t)pointer; }
+
+static void Record(GLTraceOp op, std::initializer_list<unsigned long long> arguments, const void* payload = nullptr, size_t payloadSize = 0)
+{
+	s_Trace.Buffer.push_back((unsigned char)op);
+	s_Trace.Buffer.push_back((unsigned char)arguments.size());
+	for (unsigned long long argument : arguments)
+		WriteVarint(argument);
+	WriteVarint(payload ? payloadSize : 0);
+	if (payload && payloadSize)
+		s_Trace.Buffer.insert(s_Trace.Buffer.end(), (const unsigned char*)payload, (const unsigned char*)payload + payloadSize);
+	s_Trace.Calls++;
+}
+
+static void Flush()
+{
+	s_Trace.File.write((const char*)s_Trace.Buffer.data(), s_Trace.Buffer.size());
+	s_Trace.Bytes += s_Trace.Buffer.size();
+	s_Trace.Buffer.clear();
+}
+
+static GLuint GetBound(GLenum target)
+{
+	auto found = s_Trace.BoundBuffers.find(target);
+	return found != s_Trace.BoundBuffers.end() ? found->second : 0;
+}
+
+static size_t GetPixelSize(GLenum format, GLenum type)
+{
+	if (type == GL_UNSIGNED_INT_24_8 || type == GL_UNSIGNED_INT_8_8_8_8 || type == GL_UNSIGNED_INT_8_8_8_8_REV)
+		return 4;
+	size_t components = format == GL_RED || format == GL_DEPTH_COMPONENT || format == GL_STENCIL_INDEX || format == GL_RED_INTEGER ? 1
+		: format == GL_RG ? 2 : format == GL_RGB || format == GL_BGR ? 3 : 4;
+	size_t bytes = type == GL_UNSIGNED_BYTE || type == GL_BYTE ? 1
+		: type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT ? 2 : 4;
+	return components * bytes;
+}
+
+/* client memory size of an image, rows padded to the alignment */
+static size_t GetImageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint alignment)
+{
+	size_t row = (size_t)width * GetPixelSize(format, type);
+	row = (row + alignment - 1) / alignment * alignment;
+	return row * height * depth;
+}
+
+/*
+* Image data GL reads: none, client memory as the payload or an offset into
+* the unpack buffer. Bytes written through a persistent mapping of that
+* buffer are only visible now, so they go in first as a MappedWrite.
+*/
+static void RecordUpload(GLTraceOp op, std::initializer_list<unsigned long long> arguments, const void* pixels,
+	GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type)
+{
+	std::vector<unsigned long long> all(arguments);
+	GLuint unpackBuffer = GetBound(GL_PIXEL_UNPACK_BUFFER);
+	size_t size = GetImageSize(width, height, depth, format, type, s_Trace.UnpackAlignment);
+	if (unpackBuffer)
+	{
+		auto mapping = s_Trace.Mappings.find(unpackBuffer);
+		if (mapping != s_Trace.Mappings.end() && (mapping->second.Access & GL_MAP_PERSISTENT_BIT))
+		{
+			long long start = (long long)Offset(pixels) - mapping->second.Offset;
+			if (start >= 0 && start + (long long)size <= mapping->second.Length)
+				Record(GLTraceOp::MappedWrite, { unpackBuffer, (unsigned long long)start }, mapping->second.Pointer + start, size);
+		}
+		all.push_back(2);
+		all.push_back(Offset(pixels));
+	}
+	else
+	{
+		all.push_back(pixels ? 1 : 0);
+		all.push_back(0);
+	}
+
+	/* the initializer list form needs a fixed count, so write it out here */
+	s_Trace.Buffer.push_back((unsigned char)op);
+	s_Trace.Buffer.push_back((unsigned char)all.size());
+	for (unsigned long long argument : all)
+		WriteVarint(argument);
+	bool client = !unpackBuffer && pixels;
+	WriteVarint(client ? size : 0);
+	if (client)
+		s_Trace.Buffer.insert(s_Trace.Buffer.end(), (const unsigned char*)pixels, (const unsigned char*)pixels + size);
+	s_Trace.Calls++;
+}
+
+/* GL writes into pixels, the replay needs the size when it is client memory */
+static void RecordReadback(GLTraceOp op, std::initializer_list<unsigned long long> arguments, void* pixels, size_t size)
+{
+	std::vector<unsigned long long> all(arguments);
+	bool packBuffer = GetBound(GL_PIXEL_PACK_BUFFER) != 0;
+	all.push_back(packBuffer ? Offset(pixels) : 0);
+	all.push_back(packBuffer ? 0 : size);
+
+	s_Trace.Buffer.push_back((unsigned char)op);
+	s_Trace.Buffer.push_back((unsigned char)all.size());
+	for (unsigned long long argument : all)
+		WriteVarint(argument);
+	WriteVarint(0);
+	s_Trace.Calls++;
+}
+
+static void RecordNames(GLTraceOp op, GLsizei n, const GLuint* names)
+{
+	Record(op, { (unsigned long long)n }, names, sizeof(GLuint) * (n > 0 ? n : 0));
+}
+
+static unsigned long long GetSyncID(GLsync sync)
+{
+	auto found = s_Trace.Syncs.find(sync);
+	return found != s_Trace.Syncs.end() ? found->second : 0;
+}
+
+namespace GLTrace
+{
+	bool Begin(const std::string& path, int width, int height)
+	{
+		End();
+		s_Trace.File.open(path, std::ios::binary);
+		if (!s_Trace.File)
+		{
+			std::cout << "Could not create GL trace " << path << std::endl;
+			return false;
+		}
+
+		s_Trace.Path = path;
+		s_Trace.Calls = s_Trace.Bytes = s_Trace.Frames = 0;
+		s_Trace.Start = std::chrono::steady_clock::now();
+		const char magic[4] = { 'G', 'L', 'T', 'R' };
+		s_Trace.Buffer.insert(s_Trace.Buffer.end(), magic, magic + 4);
+		/* version, then the size of the default framebuffer */
+		WriteVarint(1);
+		WriteVarint(width);
+		WriteVarint(height);
+		s_Trace.Recording = true;
+		return true;
+	}
+
+	void EndFrame()
+	{
+		if (!s_Trace.Recording)
+			return;
+		unsigned long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Trace.Start).count();
+		Record(GLTraceOp::FrameEnd, { nanoseconds });
+		s_Trace.Frames++;
+		Flush();
+	}
+
+	void End()
+	{
+		if (!s_Trace.Recording)
+			return;
+		/* calls after the last frame become one more */
+		if (!s_Trace.Buffer.empty())
+			EndFrame();
+		s_Trace.Recording = false;
+		s_Trace.File.close();
+		std::cout << "GL trace: " << s_Trace.Frames << " frames, " << s_Trace.Calls << " records, "
+			<< s_Trace.Bytes / 1024 << " KB written to " << s_Trace.Path << std::endl;
+	}
+
+	bool IsRecording()
+	{
+		return s_Trace.Recording;
+	}
+
+	const char* GetName(GLTraceOp op)
+	{
+		return op < GLTraceOp::Count ? s_Names[(int)op] : "unknown";
+	}
+
+	void ActiveTexture(GLenum texture)
+	{
+		glActiveTexture(texture);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::ActiveTexture, { texture });
+	}
+
+	void AttachShader(GLuint program, GLuint shader)
+	{
+		glAttachShader(program, shader);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::AttachShader, { program, shader });
+	}
+
+	void BeginConditionalRender(GLuint id, GLenum mode)
+	{
+		glBeginConditionalRender(id, mode);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BeginConditionalRender, { id, mode });
+	}
+
+	void BeginQuery(GLenum target, GLuint id)
+	{
+		glBeginQuery(target, id);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BeginQuery, { target, id });
+	}
+
+	void BeginTransformFeedback(GLenum primitiveMode)
+	{
+		glBeginTransformFeedback(primitiveMode);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BeginTransformFeedback, { primitiveMode });
+	}
+
+	/* bindings are tracked even between traces, a trace can start with buffers already bound */
+	void BindBuffer(GLenum target, GLuint buffer)
+	{
+		glBindBuffer(target, buffer);
+		s_Trace.BoundBuffers[target] = buffer;
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindBuffer, { target, buffer });
+	}
+
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		glBindBufferBase(target, index, buffer);
+		s_Trace.BoundBuffers[target] = buffer;
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindBufferBase, { target, index, buffer });
+	}
+
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		glBindBufferRange(target, index, buffer, offset, size);
+		s_Trace.BoundBuffers[target] = buffer;
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindBufferRange, { target, index, buffer, (unsigned long long)offset, (unsigned long long)size });
+	}
+
+	void BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		glBindFramebuffer(target, framebuffer);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindFramebuffer, { target, framebuffer });
+	}
+
+	void BindRenderbuffer(GLenum target, GLuint renderbuffer)
+	{
+		glBindRenderbuffer(target, renderbuffer);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindRenderbuffer, { target, renderbuffer });
+	}
+
+	void BindTexture(GLenum target, GLuint texture)
+	{
+		glBindTexture(target, texture);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindTexture, { target, texture });
+	}
+
+	void BindVertexArray(GLuint array)
+	{
+		glBindVertexArray(array);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BindVertexArray, { array });
+	}
+
+	void BlendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		glBlendFunc(sfactor, dfactor);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BlendFunc, { sfactor, dfactor });
+	}
+
+	void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		glBufferData(target, size, data, usage);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BufferData, { target, (unsigned long long)size, usage }, data, size);
+	}
+
+	void BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		glBufferStorage(target, size, data, flags);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BufferStorage, { target, (unsigned long long)size, flags }, data, size);
+	}
+
+	void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		glBufferSubData(target, offset, size, data);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::BufferSubData, { target, (unsigned long long)offset, (unsigned long long)size }, data, size);
+	}
+
+	GLenum CheckFramebufferStatus(GLenum target)
+	{
+		GLenum status = glCheckFramebufferStatus(target);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::CheckFramebufferStatus, { target });
+		return status;
+	}
+
+	void Clear(GLbitfield mask)
+	{
+		glClear(mask);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Clear, { mask });
+	}
+
+	GLenum ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		GLenum result = glClientWaitSync(sync, flags, timeout);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::ClientWaitSync, { GetSyncID(sync), flags, timeout });
+		return result;
+	}
+
+	void ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+	{
+		glColorMask(red, green, blue, alpha);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::ColorMask, { red, green, blue, alpha });
+	}
+
+	void CompileShader(GLuint shader)
+	{
+		glCompileShader(shader);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::CompileShader, { shader });
+	}
+
+	GLuint CreateProgram()
+	{
+		GLuint program = glCreateProgram();
+		if (s_Trace.Recording)
+			Record(GLTraceOp::CreateProgram, { program });
+		return program;
+	}
+
+	GLuint CreateShader(GLenum type)
+	{
+		GLuint shader = glCreateShader(type);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::CreateShader, { type, shader });
+		return shader;
+	}
+
+	void DeleteBuffers(GLsizei n, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < n; i++)
+			s_Trace.Mappings.erase(buffers[i]);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteBuffers, n, buffers);
+		glDeleteBuffers(n, buffers);
+	}
+
+	void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+	{
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteFramebuffers, n, framebuffers);
+		glDeleteFramebuffers(n, framebuffers);
+	}
+
+	void DeleteProgram(GLuint program)
+	{
+		glDeleteProgram(program);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DeleteProgram, { program });
+	}
+
+	void DeleteQueries(GLsizei n, const GLuint* ids)
+	{
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteQueries, n, ids);
+		glDeleteQueries(n, ids);
+	}
+
+	void DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+	{
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteRenderbuffers, n, renderbuffers);
+		glDeleteRenderbuffers(n, renderbuffers);
+	}
+
+	void DeleteShader(GLuint shader)
+	{
+		glDeleteShader(shader);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DeleteShader, { shader });
+	}
+
+	void DeleteSync(GLsync sync)
+	{
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DeleteSync, { GetSyncID(sync) });
+		s_Trace.Syncs.erase(sync);
+		glDeleteSync(sync);
+	}
+
+	void DeleteTextures(GLsizei n, const GLuint* textures)
+	{
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteTextures, n, textures);
+		glDeleteTextures(n, textures);
+	}
+
+	void DeleteVertexArrays(GLsizei n, const GLuint* arrays)
+	{
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::DeleteVertexArrays, n, arrays);
+		glDeleteVertexArrays(n, arrays);
+	}
+
+	void DepthFunc(GLenum func)
+	{
+		glDepthFunc(func);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DepthFunc, { func });
+	}
+
+	void DepthMask(GLboolean flag)
+	{
+		glDepthMask(flag);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DepthMask, { flag });
+	}
+
+	void Disable(GLenum cap)
+	{
+		glDisable(cap);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Disable, { cap });
+	}
+
+	void DrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		glDrawArrays(mode, first, count);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DrawArrays, { mode, Signed(first), Signed(count) });
+	}
+
+	void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		glDrawArraysInstanced(mode, first, count, instanceCount);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DrawArraysInstanced, { mode, Signed(first), Signed(count), Signed(instanceCount) });
+	}
+
+	/* indices are always an offset into the bound element buffer here */
+	void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		glDrawElements(mode, count, type, indices);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DrawElements, { mode, Signed(count), type, Offset(indices) });
+	}
+
+	void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount)
+	{
+		glDrawElementsInstanced(mode, count, type, indices, instanceCount);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::DrawElementsInstanced, { mode, Signed(count), type, Offset(indices), Signed(instanceCount) });
+	}
+
+	void Enable(GLenum cap)
+	{
+		glEnable(cap);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Enable, { cap });
+	}
+
+	void EnableVertexAttribArray(GLuint index)
+	{
+		glEnableVertexAttribArray(index);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::EnableVertexAttribArray, { index });
+	}
+
+	void EndConditionalRender()
+	{
+		glEndConditionalRender();
+		if (s_Trace.Recording)
+			Record(GLTraceOp::EndConditionalRender, {});
+	}
+
+	void EndQuery(GLenum target)
+	{
+		glEndQuery(target);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::EndQuery, { target });
+	}
+
+	void EndTransformFeedback()
+	{
+		glEndTransformFeedback();
+		if (s_Trace.Recording)
+			Record(GLTraceOp::EndTransformFeedback, {});
+	}
+
+	GLsync FenceSync(GLenum condition, GLbitfield flags)
+	{
+		GLsync sync = glFenceSync(condition, flags);
+		if (s_Trace.Recording)
+		{
+			s_Trace.Syncs[sync] = s_Trace.NextSync;
+			Record(GLTraceOp::FenceSync, { condition, flags, s_Trace.NextSync++ });
+		}
+		return sync;
+	}
+
+	void Finish()
+	{
+		glFinish();
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Finish, {});
+	}
+
+	void FramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer)
+	{
+		glFramebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::FramebufferRenderbuffer, { target, attachment, renderbufferTarget, renderbuffer });
+	}
+
+	void FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level)
+	{
+		glFramebufferTexture2D(target, attachment, textureTarget, texture, level);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::FramebufferTexture2D, { target, attachment, textureTarget, texture, Signed(level) });
+	}
+
+	void GenBuffers(GLsizei n, GLuint* buffers)
+	{
+		glGenBuffers(n, buffers);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenBuffers, n, buffers);
+	}
+
+	void GenFramebuffers(GLsizei n, GLuint* framebuffers)
+	{
+		glGenFramebuffers(n, framebuffers);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenFramebuffers, n, framebuffers);
+	}
+
+	void GenQueries(GLsizei n, GLuint* ids)
+	{
+		glGenQueries(n, ids);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenQueries, n, ids);
+	}
+
+	void GenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+	{
+		glGenRenderbuffers(n, renderbuffers);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenRenderbuffers, n, renderbuffers);
+	}
+
+	void GenTextures(GLsizei n, GLuint* textures)
+	{
+		glGenTextures(n, textures);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenTextures, n, textures);
+	}
+
+	void GenVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		glGenVertexArrays(n, arrays);
+		if (s_Trace.Recording)
+			RecordNames(GLTraceOp::GenVertexArrays, n, arrays);
+	}
+
+	void GetBooleanv(GLenum pname, GLboolean* data)
+	{
+		glGetBooleanv(pname, data);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetBooleanv, { pname });
+	}
+
+	void GetIntegerv(GLenum pname, GLint* data)
+	{
+		glGetIntegerv(pname, data);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetIntegerv, { pname });
+	}
+
+	/* query results are where the CPU waits on the GPU, the replay has to wait the same way */
+	void GetQueryObjectiv(GLuint id, GLenum pname, GLint* params)
+	{
+		glGetQueryObjectiv(id, pname, params);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetQueryObjectiv, { id, pname });
+	}
+
+	void GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+	{
+		glGetQueryObjectui64v(id, pname, params);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetQueryObjectui64v, { id, pname });
+	}
+
+	void GetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params)
+	{
+		glGetQueryObjectuiv(id, pname, params);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetQueryObjectuiv, { id, pname });
+	}
+
+	void GetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+	{
+		glGetShaderInfoLog(shader, bufSize, length, infoLog);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetShaderInfoLog, { shader, Signed(bufSize) });
+	}
+
+	void GetShaderiv(GLuint shader, GLenum pname, GLint* params)
+	{
+		glGetShaderiv(shader, pname, params);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetShaderiv, { shader, pname });
+	}
+
+	const GLubyte* GetString(GLenum name)
+	{
+		const GLubyte* string = glGetString(name);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetString, { name });
+		return string;
+	}
+
+	void GetTexImage(GLenum target, GLint level, GLenum format, GLenum type, void* pixels)
+	{
+		glGetTexImage(target, level, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			GLint width = 0, height = 0;
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
+			RecordReadback(GLTraceOp::GetTexImage, { target, Signed(level), format, type }, pixels,
+				GetImageSize(width, height, 1, format, type, s_Trace.PackAlignment));
+		}
+	}
+
+	GLint GetUniformLocation(GLuint program, const GLchar* name)
+	{
+		GLint location = glGetUniformLocation(program, name);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::GetUniformLocation, { program, Signed(location) }, name, std::strlen(name));
+		return location;
+	}
+
+	GLboolean IsEnabled(GLenum cap)
+	{
+		GLboolean enabled = glIsEnabled(cap);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::IsEnabled, { cap });
+		return enabled;
+	}
+
+	void LinkProgram(GLuint program)
+	{
+		glLinkProgram(program);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::LinkProgram, { program });
+	}
+
+	/* the buffer bound to target goes in too, the replay keys its own mapping by it */
+	void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		void* pointer = glMapBufferRange(target, offset, length, access);
+		GLuint buffer = GetBound(target);
+		if (pointer)
+			s_Trace.Mappings[buffer] = { (unsigned char*)pointer, (long long)offset, (long long)length, access };
+		if (s_Trace.Recording)
+			Record(GLTraceOp::MapBufferRange, { target, (unsigned long long)offset, (unsigned long long)length, access, buffer });
+		return pointer;
+	}
+
+	void PixelStorei(GLenum pname, GLint param)
+	{
+		glPixelStorei(pname, param);
+		if (pname == GL_UNPACK_ALIGNMENT)
+			s_Trace.UnpackAlignment = param;
+		else if (pname == GL_PACK_ALIGNMENT)
+			s_Trace.PackAlignment = param;
+		if (s_Trace.Recording)
+			Record(GLTraceOp::PixelStorei, { pname, Signed(param) });
+	}
+
+	void ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+	{
+		glReadPixels(x, y, width, height, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			RecordReadback(GLTraceOp::ReadPixels, { Signed(x), Signed(y), Signed(width), Signed(height), format, type }, pixels,
+				GetImageSize(width, height, 1, format, type, s_Trace.PackAlignment));
+		}
+	}
+
+	void RenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height)
+	{
+		glRenderbufferStorage(target, internalFormat, width, height);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::RenderbufferStorage, { target, internalFormat, Signed(width), Signed(height) });
+	}
+
+	/* the strings joined into one */
+	void ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+	{
+		glShaderSource(shader, count, string, length);
+		if (s_Trace.Recording)
+		{
+			std::string source;
+			for (GLsizei i = 0; i < count; i++)
+				source.append(string[i], length && length[i] >= 0 ? (size_t)length[i] : std::strlen(string[i]));
+			Record(GLTraceOp::ShaderSource, { shader }, source.data(), source.size());
+		}
+	}
+
+	void TexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const void* pixels)
+	{
+		glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			RecordUpload(GLTraceOp::TexImage2D, { target, Signed(level), Signed(internalFormat), Signed(width), Signed(height),
+				Signed(border), format, type }, pixels, width, height, 1, format, type);
+		}
+	}
+
+	void TexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth,
+		GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			RecordUpload(GLTraceOp::TexImage3D, { target, Signed(level), Signed(internalFormat), Signed(width), Signed(height),
+				Signed(depth), Signed(border), format, type }, pixels, width, height, depth, format, type);
+		}
+	}
+
+	void TexParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		glTexParameteri(target, pname, param);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::TexParameteri, { target, pname, Signed(param) });
+	}
+
+	void TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void* pixels)
+	{
+		glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			RecordUpload(GLTraceOp::TexSubImage2D, { target, Signed(level), Signed(xoffset), Signed(yoffset), Signed(width),
+				Signed(height), format, type }, pixels, width, height, 1, format, type);
+		}
+	}
+
+	void TexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width,
+		GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+	{
+		glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+		if (s_Trace.Recording)
+		{
+			RecordUpload(GLTraceOp::TexSubImage3D, { target, Signed(level), Signed(xoffset), Signed(yoffset), Signed(zoffset),
+				Signed(width), Signed(height), Signed(depth), format, type }, pixels, width, height, depth, format, type);
+		}
+	}
+
+	/* the names each end with a zero */
+	void TransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode)
+	{
+		glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+		if (s_Trace.Recording)
+		{
+			std::string names;
+			for (GLsizei i = 0; i < count; i++)
+				names.append(varyings[i], std::strlen(varyings[i]) + 1);
+			Record(GLTraceOp::TransformFeedbackVaryings, { program, Signed(count), bufferMode }, names.data(), names.size());
+		}
+	}
+
+	void Uniform1f(GLint location, GLfloat v0)
+	{
+		glUniform1f(location, v0);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform1f, { Signed(location), Bits(v0) });
+	}
+
+	void Uniform1i(GLint location, GLint v0)
+	{
+		glUniform1i(location, v0);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform1i, { Signed(location), Signed(v0) });
+	}
+
+	void Uniform2f(GLint location, GLfloat v0, GLfloat v1)
+	{
+		glUniform2f(location, v0, v1);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform2f, { Signed(location), Bits(v0), Bits(v1) });
+	}
+
+	void Uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+	{
+		glUniform3f(location, v0, v1, v2);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform3f, { Signed(location), Bits(v0), Bits(v1), Bits(v2) });
+	}
+
+	void Uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+	{
+		glUniform4f(location, v0, v1, v2, v3);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform4f, { Signed(location), Bits(v0), Bits(v1), Bits(v2), Bits(v3) });
+	}
+
+	void Uniform4fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		glUniform4fv(location, count, value);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Uniform4fv, { Signed(location), Signed(count) }, value, sizeof(GLfloat) * 4 * count);
+	}
+
+	void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		glUniformMatrix4fv(location, count, transpose, value);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::UniformMatrix4fv, { Signed(location), Signed(count), transpose }, value, sizeof(GLfloat) * 16 * count);
+	}
+
+	/* what the application wrote into a mapping for writing, persistent ones go through MappedWrite instead */
+	GLboolean UnmapBuffer(GLenum target)
+	{
+		GLuint buffer = GetBound(target);
+		auto mapping = s_Trace.Mappings.find(buffer);
+		if (s_Trace.Recording)
+		{
+			bool written = mapping != s_Trace.Mappings.end() && (mapping->second.Access & GL_MAP_WRITE_BIT)
+				&& !(mapping->second.Access & GL_MAP_PERSISTENT_BIT);
+			Record(GLTraceOp::UnmapBuffer, { target, buffer }, written ? mapping->second.Pointer : nullptr,
+				written ? (size_t)mapping->second.Length : 0);
+		}
+		/* cleared rather than erased, buffers mapped every frame would otherwise allocate a node each time */
+		if (mapping != s_Trace.Mappings.end())
+			mapping->second = TraceMapping();
+		return glUnmapBuffer(target);
+	}
+
+	void UseProgram(GLuint program)
+	{
+		glUseProgram(program);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::UseProgram, { program });
+	}
+
+	void ValidateProgram(GLuint program)
+	{
+		glValidateProgram(program);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::ValidateProgram, { program });
+	}
+
+	void VertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		glVertexAttribDivisor(index, divisor);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::VertexAttribDivisor, { index, divisor });
+	}
+
+	/* pointer is always an offset into the bound array buffer here */
+	void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::VertexAttribPointer, { index, Signed(size), type, normalized, Signed(stride), Offset(pointer) });
+	}
+
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		glViewport(x, y, width, height);
+		if (s_Trace.Recording)
+			Record(GLTraceOp::Viewport, { Signed(x), Signed(y), Signed(width), Signed(height) });
+	}
+}
+
+#else
+
+/* compiled out, only the names are left for the replay */
+namespace GLTrace
+{
+	bool Begin(const std::string& path, int, int)
+	{
+		std::cout << "Could not create GL trace " << path << ", tracing is compiled out (GL_TRACE_ENABLED 0)" << std::endl;
+		return false;
+	}
+
+	void EndFrame()
+	{
+	}
+
+	void End()
+	{
+	}
+
+	bool IsRecording()
+	{
+		return false;
+	}
+
+	const char* GetName(GLTraceOp op)
+	{
+		return op < GLTraceOp::Count ? s_Names[(int)op] : "unknown";
+	}
+}
+
+#endif
@@ -0,0 +1,342 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+
+/*
+* Set to 0 to compile tracing out, gl* calls then go straight to GL without
+* a wrapper in between and Begin reports that tracing is not available.
+*/
+#ifndef GL_TRACE_ENABLED
+#define GL_TRACE_ENABLED 1
+#endif
+
+/* One per traced GL function, plus the frame and persistent mapping markers */
+enum class GLTraceOp : unsigned char
+{
+	FrameEnd,
+	/* bytes the application wrote through a persistent mapping, captured where GL reads them */
+	MappedWrite,
+	ActiveTexture, AttachShader, BeginConditionalRender, BeginQuery, BeginTransformFeedback,
+	BindBuffer, BindBufferBase, BindBufferRange, BindFramebuffer, BindRenderbuffer, BindTexture, BindVertexArray,
+	BlendFunc, BufferData, BufferStorage, BufferSubData, CheckFramebufferStatus, Clear, ClientWaitSync, ColorMask,
+	CompileShader, CreateProgram, CreateShader, DeleteBuffers, DeleteFramebuffers, DeleteProgram, DeleteQueries,
+	DeleteRenderbuffers, DeleteShader, DeleteSync, DeleteTextures, DeleteVertexArrays, DepthFunc, DepthMask,
+	Disable, DrawArrays, DrawArraysInstanced, DrawElements, DrawElementsInstanced, Enable, EnableVertexAttribArray,
+	EndConditionalRender, EndQuery, EndTransformFeedback, FenceSync, Finish, FramebufferRenderbuffer,
+	FramebufferTexture2D, GenBuffers, GenFramebuffers, GenQueries, GenRenderbuffers, GenTextures, GenVertexArrays,
+	GetBooleanv, GetIntegerv, GetQueryObjectiv, GetQueryObjectui64v, GetQueryObjectuiv, GetShaderInfoLog,
+	GetShaderiv, GetString, GetTexImage, GetUniformLocation, IsEnabled, LinkProgram, MapBufferRange, PixelStorei,
+	ReadPixels, RenderbufferStorage, ShaderSource, TexImage2D, TexImage3D, TexParameteri, TexSubImage2D,
+	TexSubImage3D, TransformFeedbackVaryings, Uniform1f, Uniform1i, Uniform2f, Uniform3f, Uniform4f, Uniform4fv,
+	UniformMatrix4fv, UnmapBuffer, UseProgram, ValidateProgram, VertexAttribDivisor, VertexAttribPointer, Viewport,
+	Count
+};
+
+/*
+* Records GL calls into a binary trace for GLTraceReplay
+* Renderer.h includes this after glew, and the defines at the bottom route
+* every GL function the project uses through a wrapper here. A wrapper only
+* checks a flag when no trace is running, otherwise it writes the call with
+* its arguments and whatever memory GL reads: buffer and texture data,
+* uniform arrays, shader sources, and what was written into mapped buffers
+* when they are unmapped or, for persistent mappings, when a texture upload
+* reads them. Names GL hands out are recorded so the replay can map them to
+* its own. glGetError is left out, it belongs to GLCall's checking rather
+* than the frame.
+*
+* A record is the op, the argument count, each argument as a varint and a
+* payload size plus its bytes. Calls are buffered and written out at every
+* EndFrame. GL is only called from the thread holding the context, so
+* neither is locked.
+*/
+namespace GLTrace
+{
+	/* starts a trace of a width x height output, false when the file cannot be created */
+	bool Begin(const std::string& path, int width, int height);
+	/* marks a frame boundary with the time since Begin, for replaying at the captured cadence */
+	void EndFrame();
+	/* writes what is left and closes the file, prints what was captured */
+	void End();
+	bool IsRecording();
+
+	const char* GetName(GLTraceOp op);
+
+	void ActiveTexture(GLenum texture);
+	void AttachShader(GLuint program, GLuint shader);
+	void BeginConditionalRender(GLuint id, GLenum mode);
+	void BeginQuery(GLenum target, GLuint id);
+	void BeginTransformFeedback(GLenum primitiveMode);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void BindFramebuffer(GLenum target, GLuint framebuffer);
+	void BindRenderbuffer(GLenum target, GLuint renderbuffer);
+	void BindTexture(GLenum target, GLuint texture);
+	void BindVertexArray(GLuint array);
+	void BlendFunc(GLenum sfactor, GLenum dfactor);
+	void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+	void BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+	GLenum CheckFramebufferStatus(GLenum target);
+	void Clear(GLbitfield mask);
+	GLenum ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+	void ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+	void CompileShader(GLuint shader);
+	GLuint CreateProgram();
+	GLuint CreateShader(GLenum type);
+	void DeleteBuffers(GLsizei n, const GLuint* buffers);
+	void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+	void DeleteProgram(GLuint program);
+	void DeleteQueries(GLsizei n, const GLuint* ids);
+	void DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+	void DeleteShader(GLuint shader);
+	void DeleteSync(GLsync sync);
+	void DeleteTextures(GLsizei n, const GLuint* textures);
+	void DeleteVertexArrays(GLsizei n, const GLuint* arrays);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean flag);
+	void Disable(GLenum cap);
+	void DrawArrays(GLenum mode, GLint first, GLsizei count);
+	void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+	void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+	void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+	void Enable(GLenum cap);
+	void EnableVertexAttribArray(GLuint index);
+	void EndConditionalRender();
+	void EndQuery(GLenum target);
+	void EndTransformFeedback();
+	GLsync FenceSync(GLenum condition, GLbitfield flags);
+	void Finish();
+	void FramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer);
+	void FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level);
+	void GenBuffers(GLsizei n, GLuint* buffers);
+	void GenFramebuffers(GLsizei n, GLuint* framebuffers);
+	void GenQueries(GLsizei n, GLuint* ids);
+	void GenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+	void GenTextures(GLsizei n, GLuint* textures);
+	void GenVertexArrays(GLsizei n, GLuint* arrays);
+	void GetBooleanv(GLenum pname, GLboolean* data);
+	void GetIntegerv(GLenum pname, GLint* data);
+	void GetQueryObjectiv(GLuint id, GLenum pname, GLint* params);
+	void GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params);
+	void GetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params);
+	void GetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+	void GetShaderiv(GLuint shader, GLenum pname, GLint* params);
+	const GLubyte* GetString(GLenum name);
+	void GetTexImage(GLenum target, GLint level, GLenum format, GLenum type, void* pixels);
+	GLint GetUniformLocation(GLuint program, const GLchar* name);
+	GLboolean IsEnabled(GLenum cap);
+	void LinkProgram(GLuint program);
+	void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	void PixelStorei(GLenum pname, GLint param);
+	void ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+	void RenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height);
+	void ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+	void TexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const void* pixels);
+	void TexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth,
+		GLint border, GLenum format, GLenum type, const void* pixels);
+	void TexParameteri(GLenum target, GLenum pname, GLint param);
+	void TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void* pixels);
+	void TexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width,
+		GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+	void TransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode);
+	void Uniform1f(GLint location, GLfloat v0);
+	void Uniform1i(GLint location, GLint v0);
+	void Uniform2f(GLint location, GLfloat v0, GLfloat v1);
+	void Uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+	void Uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+	void Uniform4fv(GLint location, GLsizei count, const GLfloat* value);
+	void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	GLboolean UnmapBuffer(GLenum target);
+	void UseProgram(GLuint program);
+	void ValidateProgram(GLuint program);
+	void VertexAttribDivisor(GLuint index, GLuint divisor);
+	void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+}
+
+/* GLTrace.cpp and the replay call GL itself */
+#if GL_TRACE_ENABLED && !defined(GL_TRACE_IMPLEMENTATION)
+#undef glActiveTexture
+#define glActiveTexture GLTrace::ActiveTexture
+#undef glAttachShader
+#define glAttachShader GLTrace::AttachShader
+#undef glBeginConditionalRender
+#define glBeginConditionalRender GLTrace::BeginConditionalRender
+#undef glBeginQuery
+#define glBeginQuery GLTrace::BeginQuery
+#undef glBeginTransformFeedback
+#define glBeginTransformFeedback GLTrace::BeginTransformFeedback
+#undef glBindBuffer
+#define glBindBuffer GLTrace::BindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase GLTrace::BindBufferBase
+#undef glBindBufferRange
+#define glBindBufferRange GLTrace::BindBufferRange
+#undef glBindFramebuffer
+#define glBindFramebuffer GLTrace::BindFramebuffer
+#undef glBindRenderbuffer
+#define glBindRenderbuffer GLTrace::BindRenderbuffer
+#undef glBindTexture
+#define glBindTexture GLTrace::BindTexture
+#undef glBindVertexArray
+#define glBindVertexArray GLTrace::BindVertexArray
+#undef glBlendFunc
+#define glBlendFunc GLTrace::BlendFunc
+#undef glBufferData
+#define glBufferData GLTrace::BufferData
+#undef glBufferStorage
+#define glBufferStorage GLTrace::BufferStorage
+#undef glBufferSubData
+#define glBufferSubData GLTrace::BufferSubData
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus GLTrace::CheckFramebufferStatus
+#undef glClear
+#define glClear GLTrace::Clear
+#undef glClientWaitSync
+#define glClientWaitSync GLTrace::ClientWaitSync
+#undef glColorMask
+#define glColorMask GLTrace::ColorMask
+#undef glCompileShader
+#define glCompileShader GLTrace::CompileShader
+#undef glCreateProgram
+#define glCreateProgram GLTrace::CreateProgram
+#undef glCreateShader
+#define glCreateShader GLTrace::CreateShader
+#undef glDeleteBuffers
+#define glDeleteBuffers GLTrace::DeleteBuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers GLTrace::DeleteFramebuffers
+#undef glDeleteProgram
+#define glDeleteProgram GLTrace::DeleteProgram
+#undef glDeleteQueries
+#define glDeleteQueries GLTrace::DeleteQueries
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers GLTrace::DeleteRenderbuffers
+#undef glDeleteShader
+#define glDeleteShader GLTrace::DeleteShader
+#undef glDeleteSync
+#define glDeleteSync GLTrace::DeleteSync
+#undef glDeleteTextures
+#define glDeleteTextures GLTrace::DeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays GLTrace::DeleteVertexArrays
+#undef glDepthFunc
+#define glDepthFunc GLTrace::DepthFunc
+#undef glDepthMask
+#define glDepthMask GLTrace::DepthMask
+#undef glDisable
+#define glDisable GLTrace::Disable
+#undef glDrawArrays
+#define glDrawArrays GLTrace::DrawArrays
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced GLTrace::DrawArraysInstanced
+#undef glDrawElements
+#define glDrawElements GLTrace::DrawElements
+#undef glDrawElementsInstanced
+#define glDrawElementsInstanced GLTrace::DrawElementsInstanced
+#undef glEnable
+#define glEnable GLTrace::Enable
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray GLTrace::EnableVertexAttribArray
+#undef glEndConditionalRender
+#define glEndConditionalRender GLTrace::EndConditionalRender
+#undef glEndQuery
+#define glEndQuery GLTrace::EndQuery
+#undef glEndTransformFeedback
+#define glEndTransformFeedback GLTrace::EndTransformFeedback
+#undef glFenceSync
+#define glFenceSync GLTrace::FenceSync
+#undef glFinish
+#define glFinish GLTrace::Finish
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer GLTrace::FramebufferRenderbuffer
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D GLTrace::FramebufferTexture2D
+#undef glGenBuffers
+#define glGenBuffers GLTrace::GenBuffers
+#undef glGenFramebuffers
+#define glGenFramebuffers GLTrace::GenFramebuffers
+#undef glGenQueries
+#define glGenQueries GLTrace::GenQueries
+#undef glGenRenderbuffers
+#define glGenRenderbuffers GLTrace::GenRenderbuffers
+#undef glGenTextures
+#define glGenTextures GLTrace::GenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays GLTrace::GenVertexArrays
+#undef glGetBooleanv
+#define glGetBooleanv GLTrace::GetBooleanv
+#undef glGetIntegerv
+#define glGetIntegerv GLTrace::GetIntegerv
+#undef glGetQueryObjectiv
+#define glGetQueryObjectiv GLTrace::GetQueryObjectiv
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v GLTrace::GetQueryObjectui64v
+#undef glGetQueryObjectuiv
+#define glGetQueryObjectuiv GLTrace::GetQueryObjectuiv
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog GLTrace::GetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv GLTrace::GetShaderiv
+#undef glGetString
+#define glGetString GLTrace::GetString
+#undef glGetTexImage
+#define glGetTexImage GLTrace::GetTexImage
+#undef glGetUniformLocation
+#define glGetUniformLocation GLTrace::GetUniformLocation
+#undef glIsEnabled
+#define glIsEnabled GLTrace::IsEnabled
+#undef glLinkProgram
+#define glLinkProgram GLTrace::LinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange GLTrace::MapBufferRange
+#undef glPixelStorei
+#define glPixelStorei GLTrace::PixelStorei
+#undef glReadPixels
+#define glReadPixels GLTrace::ReadPixels
+#undef glRenderbufferStorage
+#define glRenderbufferStorage GLTrace::RenderbufferStorage
+#undef glShaderSource
+#define glShaderSource GLTrace::ShaderSource
+#undef glTexImage2D
+#define glTexImage2D GLTrace::TexImage2D
+#undef glTexImage3D
+#define glTexImage3D GLTrace::TexImage3D
+#undef glTexParameteri
+#define glTexParameteri GLTrace::TexParameteri
+#undef glTexSubImage2D
+#define glTexSubImage2D GLTrace::TexSubImage2D
+#undef glTexSubImage3D
+#define glTexSubImage3D GLTrace::TexSubImage3D
+#undef glTransformFeedbackVaryings
+#define glTransformFeedbackVaryings GLTrace::TransformFeedbackVaryings
+#undef glUniform1f
+#define glUniform1f GLTrace::Uniform1f
+#undef glUniform1i
+#define glUniform1i GLTrace::Uniform1i
+#undef glUniform2f
+#define glUniform2f GLTrace::Uniform2f
+#undef glUniform3f
+#define glUniform3f GLTrace::Uniform3f
+#undef glUniform4f
+#define glUniform4f GLTrace::Uniform4f
+#undef glUniform4fv
+#define glUniform4fv GLTrace::Uniform4fv
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv GLTrace::UniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer GLTrace::UnmapBuffer
+#undef glUseProgram
+#define glUseProgram GLTrace::UseProgram
+#undef glValidateProgram
+#define glValidateProgram GLTrace::ValidateProgram
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor GLTrace::VertexAttribDivisor
+#undef glVertexAttribPointer
+#define glVertexAttribPointer GLTrace::VertexAttribPointer
+#undef glViewport
+#define glViewport GLTrace::Viewport
+#endif
@@ -0,0 +1,519 @@
+/* the replay calls GL itself, it must not record into a trace of its own */
+#define GL_TRACE_IMPLEMENTATION
+#include "GLTraceReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#include "GLTrace.h"
+#include "Framebuffer.h"
+
+/* no wrapper takes more */
+static const unsigned int s_MaxArguments = 16;
+
+static bool ReadVarint(const std::vector<unsigned char>& data, size_t& position, unsigned long long& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && position < data.size(); shift += 7)
+	{
+		unsigned char byte = data[position++];
+		value |= (unsigned long long)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static GLint Signed(unsigned long long value) { return (GLint)(unsigned int)value; }
+static GLfloat Float(unsigned long long value)
+{
+	unsigned int bits = (unsigned int)value;
+	GLfloat result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+static const void* Pointer(unsigned long long offset) { return (const void*)(uintptr_t)offset; }
+
+/* image data of a TexImage or TexSubImage record: none, the payload or an offset into the unpack buffer */
+static const void* GetPixels(unsigned long long source, unsigned long long offset, const unsigned char* payload)
+{
+	return source == 1 ? payload : source == 2 ? Pointer(offset) : nullptr;
+}
+
+GLTraceReplay::GLTraceReplay(const std::string& path)
+	: m_Start(0), m_Width(0), m_Height(0), m_Program(0)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Could not open GL trace " << path << std::endl;
+		return;
+	}
+	m_Data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	size_t position = 4;
+	unsigned long long version, width, height;
+	if (m_Data.size() < 4 || std::memcmp(m_Data.data(), "GLTR", 4) != 0 || !ReadVarint(m_Data, position, version) || version != 1
+		|| !ReadVarint(m_Data, position, width) || !ReadVarint(m_Data, position, height))
+	{
+		std::cout << path << " is not a GL trace of this version" << std::endl;
+		return;
+	}
+	m_Width = (int)width;
+	m_Height = (int)height;
+	m_Start = position;
+}
+
+GLTraceReplay::~GLTraceReplay()
+{
+}
+
+bool GLTraceReplay::Run(bool paced)
+{
+	if (!IsLoaded())
+		return false;
+
+	/* the capture's framebuffer 0 */
+	m_DefaultFramebuffer.reset(new Framebuffer(m_Width, m_Height));
+	m_Framebuffers[0] = m_DefaultFramebuffer->GetRendererID();
+	m_DefaultFramebuffer->Bind();
+
+	using Clock = std::chrono::steady_clock;
+	const unsigned int opCount = (unsigned int)GLTraceOp::Count;
+	std::vector<double> opNanoseconds(opCount, 0.0);
+	std::vector<unsigned long long> opCalls(opCount, 0);
+	std::vector<double> frameMilliseconds;
+	double frameSubmit = 0.0;
+	unsigned long long capturedNanoseconds = 0;
+
+	Clock::time_point start = Clock::now();
+	size_t position = m_Start;
+	while (position < m_Data.size())
+	{
+		if (m_Data.size() - position < 2)
+			return false;
+		unsigned char op = m_Data[position++];
+		unsigned int argumentCount = m_Data[position++];
+		/* missing arguments read as zero, so a short record cannot read past the array */
+		unsigned long long arguments[s_MaxArguments] = {};
+		unsigned long long payloadSize;
+		if (argumentCount > s_MaxArguments)
+			return false;
+		for (unsigned int i = 0; i < argumentCount; i++)
+		{
+			if (!ReadVarint(m_Data, position, arguments[i]))
+				return false;
+		}
+		if (!ReadVarint(m_Data, position, payloadSize) || payloadSize > m_Data.size() - position)
+			return false;
+		const unsigned char* payload = payloadSize ? &m_Data[position] : nullptr;
+		position += (size_t)payloadSize;
+
+		if (op == (unsigned char)GLTraceOp::FrameEnd)
+		{
+			frameMilliseconds.push_back(frameSubmit * 1.0e-6);
+			frameSubmit = 0.0;
+			capturedNanoseconds = arguments[0];
+			if (paced)
+				std::this_thread::sleep_until(start + std::chrono::nanoseconds(capturedNanoseconds));
+			continue;
+		}
+
+		Clock::time_point before = Clock::now();
+		if (!Execute(op, arguments, payload, (size_t)payloadSize))
+		{
+			std::cout << "Unknown op " << (int)op << " in the GL trace" << std::endl;
+			return false;
+		}
+		double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count();
+		opNanoseconds[op] += nanoseconds;
+		opCalls[op]++;
+		frameSubmit += nanoseconds;
+	}
+	glFinish();
+	double wallMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	m_DefaultFramebuffer->UnBind();
+	m_DefaultFramebuffer.reset();
+
+	unsigned long long calls = 0;
+	double total = 0.0;
+	for (unsigned int op = 0; op < opCount; op++)
+	{
+		calls += opCalls[op];
+		total += opNanoseconds[op];
+	}
+	std::cout << "GL trace replay" << (paced ? " at the captured pace: " : ": ") << frameMilliseconds.size() << " frames, "
+		<< calls << " calls, " << total * 1.0e-6 << " ms in GL calls, " << wallMilliseconds << " ms in total";
+	if (paced)
+		std::cout << " (captured " << capturedNanoseconds * 1.0e-6 << " ms)";
+	std::cout << std::endl;
+
+	if (!frameMilliseconds.empty())
+	{
+		double sum = 0.0;
+		for (double milliseconds : frameMilliseconds)
+			sum += milliseconds;
+		/* the first frame creates everything, the rest are what a frame costs */
+		auto steady = frameMilliseconds.size() > 1 ? frameMilliseconds.begin() + 1 : frameMilliseconds.begin();
+		std::cout << "  Per frame: first " << frameMilliseconds[0] << " ms, average " << sum / frameMilliseconds.size() << " ms, min "
+			<< *std::min_element(steady, frameMilliseconds.end()) << " ms, max " << *std::max_element(steady, frameMilliseconds.end())
+			<< " ms" << std::endl;
+	}
+
+	std::vector<unsigned int> order;
+	for (unsigned int op = 0; op < opCount; op++)
+	{
+		if (opCalls[op])
+			order.push_back(op);
+	}
+	std::sort(order.begin(), order.end(), [&opNanoseconds](unsigned int a, unsigned int b) { return opNanoseconds[a] > opNanoseconds[b]; });
+	for (size_t i = 0; i < order.size() && i < 10; i++)
+	{
+		unsigned int op = order[i];
+		std::cout << "  " << GLTrace::GetName((GLTraceOp)op) << ": " << opCalls[op] << " calls, " << opNanoseconds[op] * 1.0e-6
+			<< " ms, " << opNanoseconds[op] / opCalls[op] / 1000.0 << " us per call" << std::endl;
+	}
+	return true;
+}
+
+unsigned int GLTraceReplay::MapName(const std::unordered_map<unsigned int, unsigned int>& names, unsigned long long name) const
+{
+	auto found = names.find((unsigned int)name);
+	return found != names.end() ? found->second : (unsigned int)name;
+}
+
+/* locations can differ between drivers, they are looked up again for the program in use */
+int GLTraceReplay::MapUniformLocation(unsigned long long location) const
+{
+	auto program = m_UniformLocations.find(m_Program);
+	if (program == m_UniformLocations.end())
+		return Signed(location);
+	auto found = program->second.find(Signed(location));
+	return found != program->second.end() ? found->second : Signed(location);
+}
+
+void GLTraceReplay::AddNames(std::unordered_map<unsigned int, unsigned int>& names, const unsigned char* payload, const std::vector<unsigned int>& replayed)
+{
+	for (size_t i = 0; i < replayed.size(); i++)
+	{
+		unsigned int captured;
+		std::memcpy(&captured, payload + i * sizeof(captured), sizeof(captured));
+		names[captured] = replayed[i];
+	}
+}
+
+std::vector<unsigned int> GLTraceReplay::RemoveNames(std::unordered_map<unsigned int, unsigned int>& names, const unsigned char* payload, size_t payloadSize)
+{
+	std::vector<unsigned int> replayed(payloadSize / sizeof(unsigned int));
+	for (size_t i = 0; i < replayed.size(); i++)
+	{
+		unsigned int captured;
+		std::memcpy(&captured, payload + i * sizeof(captured), sizeof(captured));
+		auto found = names.find(captured);
+		replayed[i] = found != names.end() ? found->second : captured;
+		if (found != names.end())
+			names.erase(found);
+	}
+	return replayed;
+}
+
+bool GLTraceReplay::Execute(unsigned char op, const unsigned long long* a, const unsigned char* payload, size_t payloadSize)
+{
+	/* Gen records carry their names, n is only checked against them */
+	GLsizei names = (GLsizei)(payloadSize / sizeof(GLuint));
+
+	switch ((GLTraceOp)op)
+	{
+	case GLTraceOp::MappedWrite:
+	{
+		auto mapping = m_Mappings.find((unsigned int)a[0]);
+		if (mapping != m_Mappings.end() && (long long)(a[1] + payloadSize) <= mapping->second.Length)
+			std::memcpy(mapping->second.Pointer + a[1], payload, payloadSize);
+		break;
+	}
+	case GLTraceOp::ActiveTexture: glActiveTexture((GLenum)a[0]); break;
+	case GLTraceOp::AttachShader: glAttachShader(MapName(m_Programs, a[0]), MapName(m_Shaders, a[1])); break;
+	case GLTraceOp::BeginConditionalRender: glBeginConditionalRender(MapName(m_Queries, a[0]), (GLenum)a[1]); break;
+	case GLTraceOp::BeginQuery: glBeginQuery((GLenum)a[0], MapName(m_Queries, a[1])); break;
+	case GLTraceOp::BeginTransformFeedback: glBeginTransformFeedback((GLenum)a[0]); break;
+	case GLTraceOp::BindBuffer: glBindBuffer((GLenum)a[0], MapName(m_Buffers, a[1])); break;
+	case GLTraceOp::BindBufferBase: glBindBufferBase((GLenum)a[0], (GLuint)a[1], MapName(m_Buffers, a[2])); break;
+	case GLTraceOp::BindBufferRange:
+		glBindBufferRange((GLenum)a[0], (GLuint)a[1], MapName(m_Buffers, a[2]), (GLintptr)a[3], (GLsizeiptr)a[4]);
+		break;
+	case GLTraceOp::BindFramebuffer: glBindFramebuffer((GLenum)a[0], MapName(m_Framebuffers, a[1])); break;
+	case GLTraceOp::BindRenderbuffer: glBindRenderbuffer((GLenum)a[0], MapName(m_Renderbuffers, a[1])); break;
+	case GLTraceOp::BindTexture: glBindTexture((GLenum)a[0], MapName(m_Textures, a[1])); break;
+	case GLTraceOp::BindVertexArray: glBindVertexArray(MapName(m_VertexArrays, a[0])); break;
+	case GLTraceOp::BlendFunc: glBlendFunc((GLenum)a[0], (GLenum)a[1]); break;
+	case GLTraceOp::BufferData: glBufferData((GLenum)a[0], (GLsizeiptr)a[1], payload, (GLenum)a[2]); break;
+	case GLTraceOp::BufferStorage: glBufferStorage((GLenum)a[0], (GLsizeiptr)a[1], payload, (GLbitfield)a[2]); break;
+	case GLTraceOp::BufferSubData: glBufferSubData((GLenum)a[0], (GLintptr)a[1], (GLsizeiptr)a[2], payload); break;
+	case GLTraceOp::CheckFramebufferStatus: glCheckFramebufferStatus((GLenum)a[0]); break;
+	case GLTraceOp::Clear: glClear((GLbitfield)a[0]); break;
+	case GLTraceOp::ClientWaitSync: glClientWaitSync((GLsync)m_Syncs[a[0]], (GLbitfield)a[1], (GLuint64)a[2]); break;
+	case GLTraceOp::ColorMask: glColorMask((GLboolean)a[0], (GLboolean)a[1], (GLboolean)a[2], (GLboolean)a[3]); break;
+	case GLTraceOp::CompileShader: glCompileShader(MapName(m_Shaders, a[0])); break;
+	case GLTraceOp::CreateProgram: m_Programs[(unsigned int)a[0]] = glCreateProgram(); break;
+	case GLTraceOp::CreateShader: m_Shaders[(unsigned int)a[1]] = glCreateShader((GLenum)a[0]); break;
+	case GLTraceOp::DeleteBuffers:
+	{
+		for (GLsizei i = 0; i < names; i++)
+		{
+			unsigned int captured;
+			std::memcpy(&captured, payload + i * sizeof(captured), sizeof(captured));
+			m_Mappings.erase(captured);
+		}
+		std::vector<GLuint> replayed = RemoveNames(m_Buffers, payload, payloadSize);
+		glDeleteBuffers(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DeleteFramebuffers:
+	{
+		std::vector<GLuint> replayed = RemoveNames(m_Framebuffers, payload, payloadSize);
+		glDeleteFramebuffers(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DeleteProgram:
+		glDeleteProgram(MapName(m_Programs, a[0]));
+		m_UniformLocations.erase((unsigned int)a[0]);
+		m_Programs.erase((unsigned int)a[0]);
+		break;
+	case GLTraceOp::DeleteQueries:
+	{
+		std::vector<GLuint> replayed = RemoveNames(m_Queries, payload, payloadSize);
+		glDeleteQueries(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DeleteRenderbuffers:
+	{
+		std::vector<GLuint> replayed = RemoveNames(m_Renderbuffers, payload, payloadSize);
+		glDeleteRenderbuffers(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DeleteShader:
+		glDeleteShader(MapName(m_Shaders, a[0]));
+		m_Shaders.erase((unsigned int)a[0]);
+		break;
+	case GLTraceOp::DeleteSync:
+		glDeleteSync((GLsync)m_Syncs[a[0]]);
+		m_Syncs.erase(a[0]);
+		break;
+	case GLTraceOp::DeleteTextures:
+	{
+		std::vector<GLuint> replayed = RemoveNames(m_Textures, payload, payloadSize);
+		glDeleteTextures(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DeleteVertexArrays:
+	{
+		std::vector<GLuint> replayed = RemoveNames(m_VertexArrays, payload, payloadSize);
+		glDeleteVertexArrays(names, replayed.data());
+		break;
+	}
+	case GLTraceOp::DepthFunc: glDepthFunc((GLenum)a[0]); break;
+	case GLTraceOp::DepthMask: glDepthMask((GLboolean)a[0]); break;
+	case GLTraceOp::Disable: glDisable((GLenum)a[0]); break;
+	case GLTraceOp::DrawArrays: glDrawArrays((GLenum)a[0], Signed(a[1]), Signed(a[2])); break;
+	case GLTraceOp::DrawArraysInstanced: glDrawArraysInstanced((GLenum)a[0], Signed(a[1]), Signed(a[2]), Signed(a[3])); break;
+	case GLTraceOp::DrawElements: glDrawElements((GLenum)a[0], Signed(a[1]), (GLenum)a[2], Pointer(a[3])); break;
+	case GLTraceOp::DrawElementsInstanced:
+		glDrawElementsInstanced((GLenum)a[0], Signed(a[1]), (GLenum)a[2], Pointer(a[3]), Signed(a[4]));
+		break;
+	case GLTraceOp::Enable: glEnable((GLenum)a[0]); break;
+	case GLTraceOp::EnableVertexAttribArray: glEnableVertexAttribArray((GLuint)a[0]); break;
+	case GLTraceOp::EndConditionalRender: glEndConditionalRender(); break;
+	case GLTraceOp::EndQuery: glEndQuery((GLenum)a[0]); break;
+	case GLTraceOp::EndTransformFeedback: glEndTransformFeedback(); break;
+	case GLTraceOp::FenceSync: m_Syncs[a[2]] = glFenceSync((GLenum)a[0], (GLbitfield)a[1]); break;
+	case GLTraceOp::Finish: glFinish(); break;
+	case GLTraceOp::FramebufferRenderbuffer:
+		glFramebufferRenderbuffer((GLenum)a[0], (GLenum)a[1], (GLenum)a[2], MapName(m_Renderbuffers, a[3]));
+		break;
+	case GLTraceOp::FramebufferTexture2D:
+		glFramebufferTexture2D((GLenum)a[0], (GLenum)a[1], (GLenum)a[2], MapName(m_Textures, a[3]), Signed(a[4]));
+		break;
+	case GLTraceOp::GenBuffers:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenBuffers(names, replayed.data());
+		AddNames(m_Buffers, payload, replayed);
+		break;
+	}
+	case GLTraceOp::GenFramebuffers:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenFramebuffers(names, replayed.data());
+		AddNames(m_Framebuffers, payload, replayed);
+		break;
+	}
+	case GLTraceOp::GenQueries:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenQueries(names, replayed.data());
+		AddNames(m_Queries, payload, replayed);
+		break;
+	}
+	case GLTraceOp::GenRenderbuffers:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenRenderbuffers(names, replayed.data());
+		AddNames(m_Renderbuffers, payload, replayed);
+		break;
+	}
+	case GLTraceOp::GenTextures:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenTextures(names, replayed.data());
+		AddNames(m_Textures, payload, replayed);
+		break;
+	}
+	case GLTraceOp::GenVertexArrays:
+	{
+		std::vector<GLuint> replayed(names);
+		glGenVertexArrays(names, replayed.data());
+		AddNames(m_VertexArrays, payload, replayed);
+		break;
+	}
+	/* results are thrown away, but the call and any wait it implies are kept */
+	case GLTraceOp::GetBooleanv:
+		m_Scratch.resize(64 * sizeof(GLint));
+		glGetBooleanv((GLenum)a[0], (GLboolean*)m_Scratch.data());
+		break;
+	case GLTraceOp::GetIntegerv:
+		m_Scratch.resize(64 * sizeof(GLint));
+		glGetIntegerv((GLenum)a[0], (GLint*)m_Scratch.data());
+		break;
+	case GLTraceOp::GetQueryObjectiv:
+	{
+		GLint result;
+		glGetQueryObjectiv(MapName(m_Queries, a[0]), (GLenum)a[1], &result);
+		break;
+	}
+	case GLTraceOp::GetQueryObjectui64v:
+	{
+		GLuint64 result;
+		glGetQueryObjectui64v(MapName(m_Queries, a[0]), (GLenum)a[1], &result);
+		break;
+	}
+	case GLTraceOp::GetQueryObjectuiv:
+	{
+		GLuint result;
+		glGetQueryObjectuiv(MapName(m_Queries, a[0]), (GLenum)a[1], &result);
+		break;
+	}
+	case GLTraceOp::GetShaderInfoLog:
+		m_Scratch.resize(std::max(Signed(a[1]), 1));
+		glGetShaderInfoLog(MapName(m_Shaders, a[0]), Signed(a[1]), nullptr, (GLchar*)m_Scratch.data());
+		break;
+	case GLTraceOp::GetShaderiv:
+	{
+		GLint result;
+		glGetShaderiv(MapName(m_Shaders, a[0]), (GLenum)a[1], &result);
+		break;
+	}
+	case GLTraceOp::GetString: glGetString((GLenum)a[0]); break;
+	case GLTraceOp::GetTexImage:
+		if (a[5])
+			m_Scratch.resize((size_t)a[5]);
+		glGetTexImage((GLenum)a[0], Signed(a[1]), (GLenum)a[2], (GLenum)a[3], a[5] ? (void*)m_Scratch.data() : (void*)Pointer(a[4]));
+		break;
+	case GLTraceOp::GetUniformLocation:
+	{
+		std::string name((const char*)payload, payloadSize);
+		m_UniformLocations[(unsigned int)a[0]][Signed(a[1])] = glGetUniformLocation(MapName(m_Programs, a[0]), name.c_str());
+		break;
+	}
+	case GLTraceOp::IsEnabled: glIsEnabled((GLenum)a[0]); break;
+	case GLTraceOp::LinkProgram: glLinkProgram(MapName(m_Programs, a[0])); break;
+	case GLTraceOp::MapBufferRange:
+	{
+		void* pointer = glMapBufferRange((GLenum)a[0], (GLintptr)a[1], (GLsizeiptr)a[2], (GLbitfield)a[3]);
+		if (pointer)
+			m_Mappings[(unsigned int)a[4]] = { (unsigned char*)pointer, (long long)a[2] };
+		break;
+	}
+	case GLTraceOp::PixelStorei: glPixelStorei((GLenum)a[0], Signed(a[1])); break;
+	case GLTraceOp::ReadPixels:
+		if (a[7])
+			m_Scratch.resize((size_t)a[7]);
+		glReadPixels(Signed(a[0]), Signed(a[1]), Signed(a[2]), Signed(a[3]), (GLenum)a[4], (GLenum)a[5],
+			a[7] ? (void*)m_Scratch.data() : (void*)Pointer(a[6]));
+		break;
+	case GLTraceOp::RenderbufferStorage: glRenderbufferStorage((GLenum)a[0], (GLenum)a[1], Signed(a[2]), Signed(a[3])); break;
+	case GLTraceOp::ShaderSource:
+	{
+		const GLchar* source = (const GLchar*)payload;
+		GLint length = (GLint)payloadSize;
+		glShaderSource(MapName(m_Shaders, a[0]), 1, &source, &length);
+		break;
+	}
+	case GLTraceOp::TexImage2D:
+		glTexImage2D((GLenum)a[0], Signed(a[1]), Signed(a[2]), Signed(a[3]), Signed(a[4]), Signed(a[5]), (GLenum)a[6], (GLenum)a[7],
+			GetPixels(a[8], a[9], payload));
+		break;
+	case GLTraceOp::TexImage3D:
+		glTexImage3D((GLenum)a[0], Signed(a[1]), Signed(a[2]), Signed(a[3]), Signed(a[4]), Signed(a[5]), Signed(a[6]), (GLenum)a[7],
+			(GLenum)a[8], GetPixels(a[9], a[10], payload));
+		break;
+	case GLTraceOp::TexParameteri: glTexParameteri((GLenum)a[0], (GLenum)a[1], Signed(a[2])); break;
+	case GLTraceOp::TexSubImage2D:
+		glTexSubImage2D((GLenum)a[0], Signed(a[1]), Signed(a[2]), Signed(a[3]), Signed(a[4]), Signed(a[5]), (GLenum)a[6], (GLenum)a[7],
+			GetPixels(a[8], a[9], payload));
+		break;
+	case GLTraceOp::TexSubImage3D:
+		glTexSubImage3D((GLenum)a[0], Signed(a[1]), Signed(a[2]), Signed(a[3]), Signed(a[4]), Signed(a[5]), Signed(a[6]), Signed(a[7]),
+			(GLenum)a[8], (GLenum)a[9], GetPixels(a[10], a[11], payload));
+		break;
+	case GLTraceOp::TransformFeedbackVaryings:
+	{
+		std::vector<const GLchar*> varyings;
+		for (size_t i = 0; i < payloadSize; i += std::strlen((const char*)payload + i) + 1)
+			varyings.push_back((const GLchar*)payload + i);
+		glTransformFeedbackVaryings(MapName(m_Programs, a[0]), (GLsizei)varyings.size(), varyings.data(), (GLenum)a[2]);
+		break;
+	}
+	case GLTraceOp::Uniform1f: glUniform1f(MapUniformLocation(a[0]), Float(a[1])); break;
+	case GLTraceOp::Uniform1i: glUniform1i(MapUniformLocation(a[0]), Signed(a[1])); break;
+	case GLTraceOp::Uniform2f: glUniform2f(MapUniformLocation(a[0]), Float(a[1]), Float(a[2])); break;
+	case GLTraceOp::Uniform3f: glUniform3f(MapUniformLocation(a[0]), Float(a[1]), Float(a[2]), Float(a[3])); break;
+	case GLTraceOp::Uniform4f: glUniform4f(MapUniformLocation(a[0]), Float(a[1]), Float(a[2]), Float(a[3]), Float(a[4])); break;
+	case GLTraceOp::Uniform4fv:
+		glUniform4fv(MapUniformLocation(a[0]), (GLsizei)(payloadSize / (4 * sizeof(GLfloat))), (const GLfloat*)payload);
+		break;
+	case GLTraceOp::UniformMatrix4fv:
+		glUniformMatrix4fv(MapUniformLocation(a[0]), (GLsizei)(payloadSize / (16 * sizeof(GLfloat))), (GLboolean)a[2], (const GLfloat*)payload);
+		break;
+	case GLTraceOp::UnmapBuffer:
+	{
+		auto mapping = m_Mappings.find((unsigned int)a[1]);
+		if (mapping != m_Mappings.end())
+		{
+			if (payload && (long long)payloadSize <= mapping->second.Length)
+				std::memcpy(mapping->second.Pointer, payload, payloadSize);
+			m_Mappings.erase(mapping);
+		}
+		glUnmapBuffer((GLenum)a[0]);
+		break;
+	}
+	case GLTraceOp::UseProgram:
+		m_Program = (unsigned int)a[0];
+		glUseProgram(MapName(m_Programs, a[0]));
+		break;
+	case GLTraceOp::ValidateProgram: glValidateProgram(MapName(m_Programs, a[0])); break;
+	case GLTraceOp::VertexAttribDivisor: glVertexAttribDivisor((GLuint)a[0], (GLuint)a[1]); break;
+	case GLTraceOp::VertexAttribPointer:
+		glVertexAttribPointer((GLuint)a[0], Signed(a[1]), (GLenum)a[2], (GLboolean)a[3], Signed(a[4]), Pointer(a[5]));
+		break;
+	case GLTraceOp::Viewport: glViewport(Signed(a[0]), Signed(a[1]), Signed(a[2]), Signed(a[3])); break;
+	default:
+		return false;
+	}
+	return true;
+}
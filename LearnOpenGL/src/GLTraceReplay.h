@@ -0,0 +1,68 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Framebuffer;
+
+/*
+* Plays a GLTrace file back and times it
+* Every recorded call is made again with the names, uniform locations and
+* syncs this context hands out in place of the captured ones, and with the
+* recorded memory for buffer and texture data. Nothing but GL runs between
+* the calls, so the time per call is what the driver costs. The default
+* framebuffer of the capture becomes a Framebuffer of the captured size.
+* Needs a current GL context.
+*/
+class GLTraceReplay
+{
+private:
+	struct Mapping
+	{
+		unsigned char* Pointer;
+		long long Length;
+	};
+
+	std::vector<unsigned char> m_Data;
+	/* where the records start, after the header */
+	size_t m_Start;
+	int m_Width, m_Height;
+
+	/* captured name to replayed name, one table per kind of object */
+	std::unordered_map<unsigned int, unsigned int> m_Buffers, m_Textures, m_VertexArrays, m_Framebuffers,
+		m_Renderbuffers, m_Queries, m_Shaders, m_Programs;
+	/* GLsync, by the id the trace gave it */
+	std::unordered_map<unsigned long long, void*> m_Syncs;
+	/* per captured program, captured uniform location to replayed */
+	std::unordered_map<unsigned int, std::unordered_map<int, int>> m_UniformLocations;
+	unsigned int m_Program;
+	/* by captured buffer */
+	std::unordered_map<unsigned int, Mapping> m_Mappings;
+	std::unique_ptr<Framebuffer> m_DefaultFramebuffer;
+	/* where Get calls write */
+	std::vector<unsigned char> m_Scratch;
+public:
+	GLTraceReplay(const std::string& path);
+	~GLTraceReplay();
+
+	inline bool IsLoaded() const { return m_Start > 0; }
+
+	/*
+	* Replays the whole trace once, as fast as it goes or, when paced, with each
+	* frame starting no earlier than it did in the capture. Prints frame times
+	* and the calls that took the most time. False when the trace is broken.
+	*/
+	bool Run(bool paced);
+
+private:
+	/* makes one call, false for an op this version does not know */
+	bool Execute(unsigned char op, const unsigned long long* arguments, const unsigned char* payload, size_t payloadSize);
+
+	unsigned int MapName(const std::unordered_map<unsigned int, unsigned int>& names, unsigned long long name) const;
+	int MapUniformLocation(unsigned long long location) const;
+	/* pairs the captured names in payload with the replayed ones */
+	static void AddNames(std::unordered_map<unsigned int, unsigned int>& names, const unsigned char* payload, const std::vector<unsigned int>& replayed);
+	/* the replayed names of the captured ones in payload, forgotten */
+	static std::vector<unsigned int> RemoveNames(std::unordered_map<unsigned int, unsigned int>& names, const unsigned char* payload, size_t payloadSize);
+};
@@ -0,0 +1,196 @@
+#include "GlyphCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "TrueTypeFont.h"
+
+const int GlyphCache::s_PixelHeight;
+const int GlyphCache::s_Spread;
+
+/* empty pixels between glyphs so bilinear filtering never reads a neighbour */
+static const int s_Gutter = 1;
+
+GlyphCache::GlyphCache(int pageSize, unsigned int pageCount)
+	: m_Atlas(pageSize, pageSize, pageCount, 1), m_Frame(1), m_Stats()
+{
+	m_Pages.resize(pageCount);
+	for (Page& page : m_Pages)
+	{
+		page.ShelfX = page.ShelfY = page.ShelfHeight = 0;
+		page.LastUsedFrame = 0;
+		page.Epoch = 0;
+	}
+}
+
+const CachedGlyph* GlyphCache::GetGlyph(const TrueTypeFont& font, int glyph)
+{
+	unsigned long long key = ((unsigned long long)font.GetID() << 32) | (unsigned int)glyph;
+	auto it = m_Glyphs.find(key);
+	if (it != m_Glyphs.end())
+	{
+		if (it->second.Page >= 0)
+			TouchPage(it->second.Page);
+		return &it->second;
+	}
+
+	float scale = font.GetScale((float)s_PixelHeight);
+	CachedGlyph cached = {};
+	cached.Page = -1;
+	cached.Advance = font.GetAdvance(glyph) * scale / s_PixelHeight;
+
+	/* a fifth of a pixel is below what the distance field can show */
+	GlyphOutline outline;
+	if (!font.GetOutline(glyph, outline, 0.2f / scale) || outline.Edges.empty())
+		return &m_Glyphs.emplace(key, cached).first->second;
+
+	/* whole pixel origin so the field lines up with the atlas texels */
+	int x0 = (int)std::floor(outline.MinX * scale) - s_Spread;
+	int y0 = (int)std::floor(outline.MinY * scale) - s_Spread;
+	int width = (int)std::ceil(outline.MaxX * scale) + s_Spread - x0;
+	int height = (int)std::ceil(outline.MaxY * scale) + s_Spread - y0;
+
+	int page, x, y;
+	if (!Allocate(width, height, page, x, y))
+	{
+		m_Stats.Failed++;
+		return nullptr;
+	}
+
+	for (GlyphEdge& edge : outline.Edges)
+	{
+		edge.A = edge.A * scale - glm::vec2((float)x0, (float)y0);
+		edge.B = edge.B * scale - glm::vec2((float)x0, (float)y0);
+	}
+	std::vector<unsigned char> field((size_t)width * height);
+	GenerateSDF(outline.Edges, width, height, (float)s_Spread, field.data());
+	m_Atlas.UpdateLayer(page, x, y, width, height, field.data());
+	m_Stats.GlyphsRasterized++;
+
+	float size = (float)m_Atlas.GetWidth();
+	cached.Page = page;
+	cached.U0 = x / size;
+	cached.V0 = y / size;
+	cached.U1 = (x + width) / size;
+	cached.V1 = (y + height) / size;
+	cached.Left = (float)x0 / s_PixelHeight;
+	cached.Bottom = (float)y0 / s_PixelHeight;
+	cached.Right = (float)(x0 + width) / s_PixelHeight;
+	cached.Top = (float)(y0 + height) / s_PixelHeight;
+
+	m_Pages[page].Keys.push_back(key);
+	TouchPage(page);
+	return &m_Glyphs.emplace(key, cached).first->second;
+}
+
+bool GlyphCache::Allocate(int width, int height, int& page, int& x, int& y)
+{
+	if (width > m_Atlas.GetWidth() || height > m_Atlas.GetHeight())
+		return false;
+
+	for (page = 0; page < (int)m_Pages.size(); page++)
+	{
+		if (PlaceOnPage(m_Pages[page], width, height, x, y))
+			return true;
+	}
+
+	/* every page is full, start over on the least recently used one not needed this frame */
+	int oldest = -1;
+	for (int i = 0; i < (int)m_Pages.size(); i++)
+	{
+		if (m_Pages[i].LastUsedFrame != m_Frame && (oldest < 0 || m_Pages[i].LastUsedFrame < m_Pages[oldest].LastUsedFrame))
+			oldest = i;
+	}
+	if (oldest < 0)
+		return false;
+
+	EvictPage(oldest);
+	page = oldest;
+	return PlaceOnPage(m_Pages[page], width, height, x, y);
+}
+
+bool GlyphCache::PlaceOnPage(Page& page, int width, int height, int& x, int& y) const
+{
+	/* shelves run left to right, a new one starts above the tallest glyph of the last */
+	if (page.ShelfX + width > m_Atlas.GetWidth())
+	{
+		page.ShelfY += page.ShelfHeight + s_Gutter;
+		page.ShelfX = 0;
+		page.ShelfHeight = 0;
+	}
+	if (page.ShelfY + height > m_Atlas.GetHeight())
+		return false;
+
+	x = page.ShelfX;
+	y = page.ShelfY;
+	page.ShelfX += width + s_Gutter;
+	page.ShelfHeight = std::max(page.ShelfHeight, height);
+	return true;
+}
+
+void GlyphCache::EvictPage(int index)
+{
+	Page& page = m_Pages[index];
+	for (unsigned long long key : page.Keys)
+		m_Glyphs.erase(key);
+	page.Keys.clear();
+	page.ShelfX = page.ShelfY = page.ShelfHeight = 0;
+	page.Epoch++;
+	m_Stats.PagesEvicted++;
+}
+
+GlyphCacheStats GlyphCache::GetStats() const
+{
+	GlyphCacheStats stats = m_Stats;
+	stats.Glyphs = (unsigned int)m_Glyphs.size();
+	stats.Pages = (unsigned int)m_Pages.size();
+	return stats;
+}
+
+void GlyphCache::GenerateSDF(const std::vector<GlyphEdge>& edges, int width, int height, float spread, unsigned char* pixels)
+{
+	std::vector<std::pair<float, int>> crossings;
+	for (int y = 0; y < height; y++)
+	{
+		float py = y + 0.5f;
+
+		/* where the row crosses the outline and which way, summed right of a pixel gives its winding number */
+		crossings.clear();
+		for (const GlyphEdge& edge : edges)
+		{
+			if ((edge.A.y <= py) != (edge.B.y <= py))
+			{
+				float t = (py - edge.A.y) / (edge.B.y - edge.A.y);
+				crossings.push_back({ edge.A.x + t * (edge.B.x - edge.A.x), edge.B.y > edge.A.y ? 1 : -1 });
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		for (int x = 0; x < width; x++)
+		{
+			glm::vec2 point(x + 0.5f, py);
+
+			int winding = 0;
+			for (const std::pair<float, int>& crossing : crossings)
+			{
+				if (crossing.first > point.x)
+					winding += crossing.second;
+			}
+
+			float nearest = spread * spread;
+			for (const GlyphEdge& edge : edges)
+			{
+				glm::vec2 direction = edge.B - edge.A;
+				float lengthSquared = glm::dot(direction, direction);
+				float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - edge.A, direction) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+				glm::vec2 offset = point - (edge.A + direction * t);
+				nearest = std::min(nearest, glm::dot(offset, offset));
+			}
+
+			float distance = std::sqrt(nearest) / spread;
+			if (winding == 0)
+				distance = -distance;
+			pixels[(size_t)y * width + x] = (unsigned char)glm::clamp(128.0f + distance * 127.0f, 0.0f, 255.0f);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "TextureArray.h"
+
+class TrueTypeFont;
+struct GlyphEdge;
+
+/*
+* Where a glyph sits in the cache and how to place it
+* Bounds and advance are in multiples of the pixel height the text is drawn
+* at, relative to the pen on the baseline, so one entry serves every size.
+*/
+struct CachedGlyph
+{
+	/* -1 for glyphs with nothing to draw, like the space */
+	int Page;
+	float U0, V0, U1, V1;
+	float Left, Bottom, Right, Top;
+	float Advance;
+};
+
+struct GlyphCacheStats
+{
+	unsigned int Glyphs;
+	unsigned int Pages;
+	unsigned long long GlyphsRasterized;
+	unsigned long long PagesEvicted;
+	/* glyphs that did not fit because every page was in use this frame */
+	unsigned long long Failed;
+};
+
+/*
+* Signed distance field glyphs packed into the layers of an R8 texture array
+* Glyphs are rasterized on first use at one fixed size, the distance field
+* keeps them sharp when drawn larger or smaller. Each layer is a page filled
+* shelf by shelf. When all pages are full the least recently used one is
+* cleared and refilled; pages used this frame are never taken so nothing
+* already queued for drawing loses its glyphs. Each page has an epoch that
+* changes when it is cleared, cached layouts check it to know they are stale.
+*/
+class GlyphCache
+{
+public:
+	/* glyphs are rasterized this many pixels from ascent to descent */
+	static const int s_PixelHeight = 32;
+	/* distance in pixels covered by the field on either side of the outline */
+	static const int s_Spread = 4;
+
+private:
+	struct Page
+	{
+		int ShelfX, ShelfY, ShelfHeight;
+		unsigned long long LastUsedFrame;
+		unsigned int Epoch;
+		/* glyph keys to forget when the page is cleared */
+		std::vector<unsigned long long> Keys;
+	};
+
+	TextureArray m_Atlas;
+	std::vector<Page> m_Pages;
+	std::unordered_map<unsigned long long, CachedGlyph> m_Glyphs;
+	unsigned long long m_Frame;
+	GlyphCacheStats m_Stats;
+public:
+	GlyphCache(int pageSize = 512, unsigned int pageCount = 4);
+
+	/* Rasterizes the glyph when it is not cached yet, null when there is no room this frame */
+	const CachedGlyph* GetGlyph(const TrueTypeFont& font, int glyph);
+
+	/* Marks a page used this frame so it is not evicted */
+	inline void TouchPage(int page) { m_Pages[page].LastUsedFrame = m_Frame; }
+	inline unsigned int GetPageEpoch(int page) const { return m_Pages[page].Epoch; }
+	inline unsigned int GetPageCount() const { return (unsigned int)m_Pages.size(); }
+	/* pages used before this call become candidates for eviction */
+	inline void NextFrame() { m_Frame++; }
+
+	inline void Bind(unsigned int slot = 0) const { m_Atlas.Bind(slot); }
+	GlyphCacheStats GetStats() const;
+
+	/*
+	* Writes a width * height distance field for edges already in pixel space,
+	* 128 is the outline, larger is inside. Inside follows the non-zero winding rule.
+	*/
+	static void GenerateSDF(const std::vector<GlyphEdge>& edges, int width, int height, float spread, unsigned char* pixels);
+
+private:
+	/* finds space on a page, evicting one if needed */
+	bool Allocate(int width, int height, int& page, int& x, int& y);
+	bool PlaceOnPage(Page& page, int width, int height, int& x, int& y) const;
+	void EvictPage(int page);
+};
@@ -0,0 +1,238 @@
+#include "GpuCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "VertexBufferLayout.h"
+#include "Mesh.h"
+
+static VertexBufferLayout MakeInstanceLayout()
+{
+	VertexBufferLayout layout;
+	layout.Push<float>(4);
+	layout.Push<float>(4);
+	return layout;
+}
+
+GpuCuller::GpuCuller(const Mesh& mesh, unsigned int capacity)
+	: m_Mesh(mesh), m_Capacity(std::max(capacity, 1u)),
+	m_CullShader("res/shaders/GpuCull.shader", "", { "v_PositionScale", "v_Color" }),
+	m_DrawShader("res/shaders/Mesh.shader", mesh.GetShaderDefines() + "#define INSTANCED\n"),
+	m_ProxyShader("res/shaders/Mesh.shader", MeshData::GetShaderDefines((unsigned int)MeshAttribute::Position)),
+	m_Box(new Mesh(MeshData::MakeCube())), m_Input(m_Capacity * (unsigned int)sizeof(GpuInstance)), m_InstanceLayout(MakeInstanceLayout()),
+	m_Current(0), m_Latency(false), m_Stats()
+{
+	m_CullArray.AddBuffer(m_Input, m_InstanceLayout);
+	for (int i = 0; i < 2; i++)
+	{
+		m_Outputs[i].reset(new VertexBuffer(m_Capacity * (unsigned int)sizeof(GpuInstance)));
+		/* the instance attributes are pointed at each group's range as it is drawn */
+		m_DrawArrays[i].AddBuffer(mesh.GetVertexBuffer(), MeshData::MakeLayout(mesh.GetAttributes()));
+		m_Written[i] = false;
+	}
+}
+
+GpuCuller::~GpuCuller()
+{
+	DeleteQueries();
+}
+
+void GpuCuller::SetInstances(const GpuInstance* instances, unsigned int count, const unsigned int* groupSizes, unsigned int groupCount)
+{
+	ASSERT(count <= m_Capacity);
+	count = std::min(count, m_Capacity);
+	if (count > 0)
+		m_Input.SetSubData(instances, 0, count * (unsigned int)sizeof(GpuInstance));
+
+	DeleteQueries();
+	m_Groups.clear();
+	glm::vec3 meshCenter = m_Mesh.GetBounds().GetCenter();
+	float meshRadius = m_Mesh.GetBoundingRadius();
+	for (unsigned int first = 0, group = 0; first < count; group++)
+	{
+		Group range = {};
+		range.First = first;
+		range.Count = groupSizes && group < groupCount ? std::min(groupSizes[group], count - first) : count - first;
+		if (range.Count == 0)
+			continue;
+
+		/* around every instance's bounding sphere, the same spheres the culling pass tests */
+		for (unsigned int i = first; i < first + range.Count; i++)
+		{
+			const GpuInstance& instance = instances[i];
+			glm::vec3 center = glm::vec3(instance.X, instance.Y, instance.Z) + meshCenter * instance.Scale;
+			AABB sphere(center - meshRadius * instance.Scale, center + meshRadius * instance.Scale);
+			range.Bounds = i == first ? sphere : AABB::Merge(range.Bounds, sphere);
+		}
+
+		GLCall(glGenQueries(2, range.CountQueries));
+		GLCall(glGenQueries(1, &range.OcclusionQuery));
+		m_Groups.push_back(range);
+		first += range.Count;
+	}
+
+	/* old results belong to the old instances */
+	m_Written[0] = m_Written[1] = false;
+	m_Stats.Instances = count;
+	m_Stats.Groups = (unsigned int)m_Groups.size();
+}
+
+void GpuCuller::Cull(const glm::mat4& viewProjection)
+{
+	m_Current = 1 - m_Current;
+	m_Written[m_Current] = true;
+	m_Stats.GroupsTested = 0;
+
+	Frustum frustum = Frustum::FromMatrix(viewProjection);
+	glm::vec3 meshCenter = m_Mesh.GetBounds().GetCenter();
+	m_CullShader.Bind();
+	m_CullShader.SetUniform4fv("u_Planes", 6, &frustum.Planes[0].x);
+	m_CullShader.SetUniform3f("u_Center", meshCenter.x, meshCenter.y, meshCenter.z);
+	m_CullShader.SetUniform1f("u_Radius", m_Mesh.GetBoundingRadius());
+	m_CullArray.Bind();
+
+	m_CullTimer.Begin();
+	GLCall(glEnable(GL_RASTERIZER_DISCARD));
+	for (Group& group : m_Groups)
+	{
+		group.Tested = false;
+		/* each group packs into its own range, its count comes from its own query */
+		m_Outputs[m_Current]->BindFeedback(0, group.First * (unsigned int)sizeof(GpuInstance), group.Count * (unsigned int)sizeof(GpuInstance));
+		GLCall(glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, group.CountQueries[m_Current]));
+		GLCall(glBeginTransformFeedback(GL_POINTS));
+		GLCall(glDrawArrays(GL_POINTS, group.First, group.Count));
+		GLCall(glEndTransformFeedback());
+		GLCall(glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN));
+		RENDER_STAT(DrawCalls, 1);
+	}
+	GLCall(glDisable(GL_RASTERIZER_DISCARD));
+	GLCall(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0));
+	m_CullTimer.End();
+}
+
+void GpuCuller::TestOcclusion(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection)
+{
+	PollOcclusion();
+
+	glm::mat4 viewProjection = projection * view;
+	glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+	/*
+	* The near plane clips a box the camera is in or close to, which would read
+	* as hidden. Those groups are drawn without a test. Perspective only, the
+	* near distance is -2fn / (f - n) over -2f / (f - n).
+	*/
+	float margin = projection[2][3] != 0.0f ? std::abs(projection[3][2] / (projection[2][2] - 1.0f)) : 0.0f;
+
+	m_ProxyShader.Bind();
+	GLCall(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+	GLCall(glDepthMask(GL_FALSE));
+	for (Group& group : m_Groups)
+	{
+		AABB grown(group.Bounds.Min - margin, group.Bounds.Max + margin);
+		if (grown.Contains(AABB(eye, eye)))
+			continue;
+
+		glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), group.Bounds.GetCenter()), group.Bounds.GetExtents());
+		m_ProxyShader.SetUniformMat4f("u_MVP", viewProjection * model);
+		GLCall(glBeginQuery(GL_ANY_SAMPLES_PASSED, group.OcclusionQuery));
+		renderer.Draw(m_Box->GetVertexArray(), m_Box->GetIndexBuffer(), m_ProxyShader);
+		GLCall(glEndQuery(GL_ANY_SAMPLES_PASSED));
+		/* a result still pending from last frame is replaced */
+		group.Tested = true;
+		group.ResultPending = true;
+		m_Stats.GroupsTested++;
+	}
+	GLCall(glDepthMask(GL_TRUE));
+	GLCall(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+}
+
+void GpuCuller::Draw(const Renderer& renderer, const glm::mat4& viewProjection, const glm::vec4& color)
+{
+	unsigned int buffer = m_Latency ? 1 - m_Current : m_Current;
+
+	auto start = std::chrono::steady_clock::now();
+	for (Group& group : m_Groups)
+	{
+		group.Visible[buffer] = 0;
+		if (m_Written[buffer])
+		{
+			/* waits until the culling pass has finished this group */
+			GLCall(glGetQueryObjectuiv(group.CountQueries[buffer], GL_QUERY_RESULT, &group.Visible[buffer]));
+		}
+	}
+	m_Stats.WaitMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	const MeshLod& lod = m_Mesh.GetLod(0);
+	m_DrawShader.Bind();
+	m_DrawShader.SetUniformMat4f("u_MVP", viewProjection);
+	m_DrawShader.SetUniform4f("u_Color", color.r, color.g, color.b, color.a);
+	m_Stats.Visible = 0;
+	for (const Group& group : m_Groups)
+	{
+		unsigned int visible = group.Visible[buffer];
+		if (visible == 0)
+			continue;
+
+		m_Stats.Visible += visible;
+		/* GL 3.3 has no base instance, the attributes start at the group's range instead */
+		m_DrawArrays[buffer].AddBuffer(*m_Outputs[buffer], m_InstanceLayout, 4, 1, group.First * (unsigned int)sizeof(GpuInstance));
+		/* the GPU waits for the query, the CPU does not */
+		if (group.Tested)
+		{
+			GLCall(glBeginConditionalRender(group.OcclusionQuery, GL_QUERY_WAIT));
+		}
+		renderer.DrawInstanced(m_DrawArrays[buffer], m_Mesh.GetIndexBuffer(), m_DrawShader, lod.IndexCount, visible, lod.FirstIndex);
+		if (group.Tested)
+		{
+			GLCall(glEndConditionalRender());
+		}
+	}
+}
+
+void GpuCuller::FinishTiming()
+{
+	m_CullTimer.Finish();
+}
+
+GpuCullingStats GpuCuller::GetStats() const
+{
+	GpuCullingStats stats = m_Stats;
+	stats.CullMilliseconds = m_CullTimer.GetAverageMilliseconds();
+	return stats;
+}
+
+void GpuCuller::PollOcclusion()
+{
+	unsigned int occluded = 0;
+	bool arrived = false;
+	for (Group& group : m_Groups)
+	{
+		if (!group.ResultPending)
+			continue;
+
+		int available = 0;
+		GLCall(glGetQueryObjectiv(group.OcclusionQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available)
+			continue;
+
+		unsigned int samplesPassed = 0;
+		GLCall(glGetQueryObjectuiv(group.OcclusionQuery, GL_QUERY_RESULT, &samplesPassed));
+		group.ResultPending = false;
+		occluded += samplesPassed ? 0 : 1;
+		arrived = true;
+	}
+	if (arrived)
+		m_Stats.GroupsOccluded = occluded;
+}
+
+void GpuCuller::DeleteQueries()
+{
+	for (Group& group : m_Groups)
+	{
+		GLCall(glDeleteQueries(2, group.CountQueries));
+		GLCall(glDeleteQueries(1, &group.OcclusionQuery));
+	}
+}
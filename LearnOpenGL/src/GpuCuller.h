@@ -0,0 +1,127 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "Bounds.h"
+#include "GpuTimer.h"
+
+class Mesh;
+
+/* One copy of the mesh: uniform scale, then moved to X, Y, Z, tinted by the color */
+struct GpuInstance
+{
+	float X, Y, Z;
+	float Scale;
+	float R, G, B, A;
+};
+
+struct GpuCullingStats
+{
+	unsigned int Instances;
+	unsigned int Groups;
+	/* instances that survived frustum culling in the results the last Draw used */
+	unsigned int Visible;
+	/* groups drawn under an occlusion query, and how many of them the last results that arrived said were hidden */
+	unsigned int GroupsTested;
+	unsigned int GroupsOccluded;
+	/* CPU time the last Draw spent waiting for the visible counts */
+	float WaitMilliseconds;
+	/* mean GPU time of the culling pass */
+	float CullMilliseconds;
+};
+
+/*
+* Frustum culls instances on the GPU and draws the survivors with one instanced draw per group
+* Cull runs every instance through a vertex and geometry program with
+* rasterizing off. The geometry stage emits only instances whose bounding
+* sphere touches the view, and transform feedback packs them into an output
+* buffer, each group into its own range. A primitives written query per
+* group counts them, and Draw reads those counts for its instance counts.
+* GL 3.3 has no way to hand a query result to a draw without the CPU, so
+* the read waits for the culling pass. Issuing Cull early in the frame
+* hides most of that, and SetLatency draws last frame's results instead,
+* never waiting but a frame behind the camera.
+*
+* Groups are contiguous instance ranges with a box around them. After the
+* big occluders are drawn, TestOcclusion draws each group's box into an
+* occlusion query with color and depth writes off, and Draw renders the
+* group under glBeginConditionalRender so the GPU skips hidden groups
+* without any CPU round trip.
+*/
+class GpuCuller
+{
+private:
+	struct Group
+	{
+		unsigned int First;
+		unsigned int Count;
+		AABB Bounds;
+		/* primitives written query per output buffer, and the count read from it */
+		unsigned int CountQueries[2];
+		unsigned int Visible[2];
+		unsigned int OcclusionQuery;
+		/* the occlusion query was issued this frame, and its result was not read for the stats yet */
+		bool Tested;
+		bool ResultPending;
+	};
+
+	const Mesh& m_Mesh;
+	unsigned int m_Capacity;
+	Shader m_CullShader;
+	Shader m_DrawShader;
+	Shader m_ProxyShader;
+	std::unique_ptr<Mesh> m_Box;
+
+	VertexBuffer m_Input;
+	/* position and scale then color, rebound at every group's range while drawing */
+	VertexBufferLayout m_InstanceLayout;
+	VertexArray m_CullArray;
+	/* culled instances, written and drawn in turn */
+	std::unique_ptr<VertexBuffer> m_Outputs[2];
+	VertexArray m_DrawArrays[2];
+	/* output the last Cull wrote, and whether that buffer was ever culled into */
+	unsigned int m_Current;
+	bool m_Written[2];
+	bool m_Latency;
+
+	std::vector<Group> m_Groups;
+	GpuTimer m_CullTimer;
+	GpuCullingStats m_Stats;
+public:
+	/* draws copies of mesh, which has to outlive the culler */
+	GpuCuller(const Mesh& mesh, unsigned int capacity);
+	~GpuCuller();
+
+	GpuCuller(const GpuCuller&) = delete;
+	GpuCuller& operator=(const GpuCuller&) = delete;
+
+	/*
+	* Uploads count instances and splits them into groups of groupSizes[i]
+	* consecutive instances. Without groupSizes all of them form one group.
+	*/
+	void SetInstances(const GpuInstance* instances, unsigned int count, const unsigned int* groupSizes = nullptr, unsigned int groupCount = 0);
+
+	/* frustum culls into the next output buffer */
+	void Cull(const glm::mat4& viewProjection);
+	/* queries each group's box against the depth already drawn, expects depth testing on */
+	void TestOcclusion(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+	/* draws the visible instances, groups tested this frame only when their box showed */
+	void Draw(const Renderer& renderer, const glm::mat4& viewProjection, const glm::vec4& color = glm::vec4(1.0f));
+
+	/* draw the previous Cull's results so Draw never waits on the GPU */
+	inline void SetLatency(bool enabled) { m_Latency = enabled; }
+
+	/* waits for the outstanding GPU timings so the stats cover every frame */
+	void FinishTiming();
+	GpuCullingStats GetStats() const;
+
+private:
+	/* reads the occlusion results that have arrived into the stats */
+	void PollOcclusion();
+	void DeleteQueries();
+};
@@ -0,0 +1,273 @@
+#include "GpuMemory.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include <GL/glew.h>
+
+#include "Renderer.h"
+
+std::mutex GpuMemory::s_Mutex;
+std::unordered_map<unsigned int, GpuMemory::Allocation> GpuMemory::s_Allocations;
+unsigned int GpuMemory::s_NextID = 1;
+unsigned long long GpuMemory::s_Live[(int)GpuMemoryCategory::Count];
+unsigned long long GpuMemory::s_Peak[(int)GpuMemoryCategory::Count];
+unsigned long long GpuMemory::s_TotalLive = 0;
+unsigned long long GpuMemory::s_TotalPeak = 0;
+unsigned long long GpuMemory::s_Budget = 0;
+bool GpuMemory::s_EvictOverBudget = false;
+GpuMemory::BudgetCallback GpuMemory::s_BudgetCallback;
+
+/* evict functions call Resize or Release, the eviction already running on this thread sees the new total */
+static thread_local bool s_Evicting = false;
+
+unsigned int GpuMemory::Track(GpuMemoryCategory category, unsigned long long bytes, const std::string& name,
+	int priority, const EvictFunction& evict)
+{
+	unsigned int id;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		id = s_NextID++;
+
+		Allocation& allocation = s_Allocations[id];
+		allocation.Info = { id, category, bytes, name, priority, (bool)evict };
+		allocation.Evict = evict;
+
+		int index = (int)category;
+		s_Live[index] += bytes;
+		s_Peak[index] = std::max(s_Peak[index], s_Live[index]);
+		s_TotalLive += bytes;
+		s_TotalPeak = std::max(s_TotalPeak, s_TotalLive);
+	}
+
+	CheckBudget();
+	return id;
+}
+
+void GpuMemory::Resize(unsigned int id, unsigned long long bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		auto it = s_Allocations.find(id);
+		ASSERT(it != s_Allocations.end());
+
+		GpuAllocationInfo& info = it->second.Info;
+		int index = (int)info.Category;
+		s_Live[index] = s_Live[index] - info.Bytes + bytes;
+		s_Peak[index] = std::max(s_Peak[index], s_Live[index]);
+		s_TotalLive = s_TotalLive - info.Bytes + bytes;
+		s_TotalPeak = std::max(s_TotalPeak, s_TotalLive);
+		info.Bytes = bytes;
+	}
+
+	CheckBudget();
+}
+
+void GpuMemory::Release(unsigned int id)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	auto it = s_Allocations.find(id);
+	if (it == s_Allocations.end())
+		return;
+
+	const GpuAllocationInfo& info = it->second.Info;
+	s_Live[(int)info.Category] -= info.Bytes;
+	s_TotalLive -= info.Bytes;
+	s_Allocations.erase(it);
+}
+
+unsigned long long GpuMemory::GetLiveBytes(GpuMemoryCategory category)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_Live[(int)category];
+}
+
+unsigned long long GpuMemory::GetPeakBytes(GpuMemoryCategory category)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_Peak[(int)category];
+}
+
+unsigned long long GpuMemory::GetTotalLiveBytes()
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_TotalLive;
+}
+
+unsigned long long GpuMemory::GetTotalPeakBytes()
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_TotalPeak;
+}
+
+std::vector<GpuAllocationInfo> GpuMemory::GetAllocations()
+{
+	std::vector<GpuAllocationInfo> allocations;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		allocations.reserve(s_Allocations.size());
+		for (const auto& pair : s_Allocations)
+			allocations.push_back(pair.second.Info);
+	}
+
+	std::sort(allocations.begin(), allocations.end(), [](const GpuAllocationInfo& a, const GpuAllocationInfo& b)
+	{
+		return a.Bytes != b.Bytes ? a.Bytes > b.Bytes : a.ID < b.ID;
+	});
+	return allocations;
+}
+
+void GpuMemory::SetBudget(unsigned long long bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Budget = bytes;
+	}
+	CheckBudget();
+}
+
+unsigned long long GpuMemory::GetBudget()
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	return s_Budget;
+}
+
+void GpuMemory::SetBudgetCallback(const BudgetCallback& callback)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_BudgetCallback = callback;
+}
+
+void GpuMemory::SetEvictOverBudget(bool evict)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_EvictOverBudget = evict;
+}
+
+void GpuMemory::CheckBudget()
+{
+	if (s_Evicting)
+		return;
+
+	BudgetCallback callback;
+	std::vector<std::pair<int, EvictFunction>> candidates;
+	unsigned long long used, budget;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (s_Budget == 0 || s_TotalLive <= s_Budget)
+			return;
+
+		used = s_TotalLive;
+		budget = s_Budget;
+		callback = s_BudgetCallback;
+
+		if (s_EvictOverBudget)
+		{
+			for (const auto& pair : s_Allocations)
+			{
+				if (pair.second.Evict)
+					candidates.push_back({ pair.second.Info.Priority, pair.second.Evict });
+			}
+		}
+	}
+
+	if (callback)
+		callback(used, budget);
+
+	/* stable so equal priorities go in the order they were found */
+	std::stable_sort(candidates.begin(), candidates.end(), [](const std::pair<int, EvictFunction>& a, const std::pair<int, EvictFunction>& b)
+	{
+		return a.first < b.first;
+	});
+
+	s_Evicting = true;
+	for (const auto& candidate : candidates)
+	{
+		if (GetTotalLiveBytes() <= budget)
+			break;
+		candidate.second();
+	}
+	s_Evicting = false;
+}
+
+GpuDriverMemoryInfo GpuMemory::QueryDriver()
+{
+	GpuDriverMemoryInfo info = { "none", 0, 0 };
+
+	/* both extensions report kilobytes */
+	if (GLEW_NVX_gpu_memory_info)
+	{
+		GLint total = 0, available = 0;
+		GLCall(glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total));
+		GLCall(glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available));
+		info.Source = "GL_NVX_gpu_memory_info";
+		info.TotalBytes = (unsigned long long)total * 1024;
+		info.AvailableBytes = (unsigned long long)available * 1024;
+	}
+	else if (GLEW_ATI_meminfo)
+	{
+		/* free total, largest free block, free auxiliary total, largest auxiliary block. No total size */
+		GLint values[4] = { 0, 0, 0, 0 };
+		GLCall(glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, values));
+		info.Source = "GL_ATI_meminfo";
+		info.AvailableBytes = (unsigned long long)values[0] * 1024;
+	}
+	return info;
+}
+
+void GpuMemory::PrintReport(std::ostream& stream)
+{
+	const double megabyte = 1024.0 * 1024.0;
+	stream << std::fixed << std::setprecision(2);
+	stream << "GPU memory: " << GetTotalLiveBytes() / megabyte << " MB live, " << GetTotalPeakBytes() / megabyte << " MB peak";
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (s_Budget)
+			stream << ", budget " << s_Budget / megabyte << " MB";
+	}
+	stream << std::endl;
+
+	for (int i = 0; i < (int)GpuMemoryCategory::Count; i++)
+	{
+		GpuMemoryCategory category = (GpuMemoryCategory)i;
+		stream << "  " << std::setw(14) << std::left << GetName(category) << std::right << GetLiveBytes(category) / megabyte
+			<< " MB live, " << GetPeakBytes(category) / megabyte << " MB peak" << std::endl;
+	}
+
+	for (const GpuAllocationInfo& info : GetAllocations())
+		stream << "    #" << info.ID << " " << GetName(info.Category) << " " << info.Bytes / 1024.0 << " KB " << info.Name << std::endl;
+
+	GpuDriverMemoryInfo driver = QueryDriver();
+	if (driver.AvailableBytes)
+		stream << "  Driver (" << driver.Source << "): " << driver.AvailableBytes / megabyte << " MB available of "
+			<< driver.TotalBytes / megabyte << " MB" << std::endl;
+	stream.unsetf(std::ios::floatfield);
+}
+
+unsigned long long GpuMemory::EstimateTextureBytes(int width, int height, int bytesPerPixel, bool mipmapped)
+{
+	unsigned long long bytes = 0;
+	while (true)
+	{
+		bytes += (unsigned long long)width * height * bytesPerPixel;
+		if (!mipmapped || (width == 1 && height == 1))
+			break;
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return bytes;
+}
+
+const char* GpuMemory::GetName(GpuMemoryCategory category)
+{
+	switch (category)
+	{
+		case GpuMemoryCategory::VertexBuffer: return "Vertex buffer";
+		case GpuMemoryCategory::IndexBuffer: return "Index buffer";
+		case GpuMemoryCategory::Texture: return "Texture";
+		case GpuMemoryCategory::RenderTarget: return "Render target";
+		case GpuMemoryCategory::Readback: return "Readback";
+		default: return "Other";
+	}
+}
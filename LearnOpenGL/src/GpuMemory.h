@@ -0,0 +1,96 @@
+#pragma once
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class GpuMemoryCategory
+{
+	VertexBuffer, IndexBuffer, Texture, RenderTarget, Readback, Other, Count
+};
+
+struct GpuAllocationInfo
+{
+	unsigned int ID;
+	GpuMemoryCategory Category;
+	unsigned long long Bytes;
+	std::string Name;
+	/* lower is evicted first, only allocations with an evict function can be evicted */
+	int Priority;
+	bool Evictable;
+};
+
+/* What the driver says about video memory, zero when neither extension exists */
+struct GpuDriverMemoryInfo
+{
+	const char* Source;
+	unsigned long long TotalBytes;
+	unsigned long long AvailableBytes;
+};
+
+/*
+* Records every GPU allocation the wrappers make
+* Sizes are what we asked for, the driver may pad or compress. A budget can
+* be set, going over it calls the budget callback and, when eviction is on,
+* evicts the lowest priority evictable allocations until back under budget.
+* Safe to call from any thread, callbacks run without the lock held on the
+* thread that went over, which for GL resources is the one with the context.
+*/
+class GpuMemory
+{
+public:
+	/* bytes in use and the budget that was exceeded */
+	typedef std::function<void(unsigned long long used, unsigned long long budget)> BudgetCallback;
+	/* must free the resource or the part of it that can go, which calls Release or Resize */
+	typedef std::function<void()> EvictFunction;
+
+private:
+	struct Allocation
+	{
+		GpuAllocationInfo Info;
+		EvictFunction Evict;
+	};
+
+	static std::mutex s_Mutex;
+	static std::unordered_map<unsigned int, Allocation> s_Allocations;
+	static unsigned int s_NextID;
+	static unsigned long long s_Live[(int)GpuMemoryCategory::Count];
+	static unsigned long long s_Peak[(int)GpuMemoryCategory::Count];
+	static unsigned long long s_TotalLive;
+	static unsigned long long s_TotalPeak;
+	static unsigned long long s_Budget;
+	static bool s_EvictOverBudget;
+	static BudgetCallback s_BudgetCallback;
+public:
+	/* Returns an id for Resize and Release */
+	static unsigned int Track(GpuMemoryCategory category, unsigned long long bytes, const std::string& name,
+		int priority = 0, const EvictFunction& evict = EvictFunction());
+	static void Resize(unsigned int id, unsigned long long bytes);
+	static void Release(unsigned int id);
+
+	static unsigned long long GetLiveBytes(GpuMemoryCategory category);
+	static unsigned long long GetPeakBytes(GpuMemoryCategory category);
+	static unsigned long long GetTotalLiveBytes();
+	static unsigned long long GetTotalPeakBytes();
+	/* every live allocation, largest first */
+	static std::vector<GpuAllocationInfo> GetAllocations();
+
+	/* 0 disables the budget */
+	static void SetBudget(unsigned long long bytes);
+	static unsigned long long GetBudget();
+	static void SetBudgetCallback(const BudgetCallback& callback);
+	static void SetEvictOverBudget(bool evict);
+
+	/* GL_NVX_gpu_memory_info or GL_ATI_meminfo, needs the GL context */
+	static GpuDriverMemoryInfo QueryDriver();
+	static void PrintReport(std::ostream& stream);
+
+	/* width * height * bytesPerPixel, a full mip chain adds about a third since each level is a quarter of the last */
+	static unsigned long long EstimateTextureBytes(int width, int height, int bytesPerPixel, bool mipmapped);
+	static const char* GetName(GpuMemoryCategory category);
+
+private:
+	static void CheckBudget();
+};
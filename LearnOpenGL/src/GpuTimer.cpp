@@ -0,0 +1,66 @@
+#include "GpuTimer.h"
+
+#include "Renderer.h"
+
+const unsigned int GpuTimer::s_QueryCount;
+
+GpuTimer::GpuTimer()
+	: m_Next(0), m_Pending(0), m_LastMilliseconds(0.0f), m_TotalMilliseconds(0.0), m_Samples(0)
+{
+	GLCall(glGenQueries(s_QueryCount, m_Queries));
+}
+
+GpuTimer::~GpuTimer()
+{
+	GLCall(glDeleteQueries(s_QueryCount, m_Queries));
+}
+
+void GpuTimer::Begin()
+{
+	Poll();
+	if (m_Pending == s_QueryCount)
+		ReadOldest(true);
+
+	GLCall(glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Next]));
+}
+
+void GpuTimer::End()
+{
+	GLCall(glEndQuery(GL_TIME_ELAPSED));
+	m_Next = (m_Next + 1) % s_QueryCount;
+	m_Pending++;
+}
+
+void GpuTimer::Poll()
+{
+	while (m_Pending > 0 && ReadOldest(false))
+		;
+}
+
+void GpuTimer::Finish()
+{
+	while (m_Pending > 0)
+		ReadOldest(true);
+}
+
+bool GpuTimer::ReadOldest(bool wait)
+{
+	unsigned int query = m_Queries[(m_Next + s_QueryCount - m_Pending) % s_QueryCount];
+	if (!wait)
+	{
+		int available = 0;
+		GLCall(glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available)
+			return false;
+	}
+
+	/* 64 bit result, nanoseconds overflow 32 bits after about four seconds */
+	GLuint64 nanoseconds = 0;
+	GLCall(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds));
+	m_Pending--;
+
+	m_LastMilliseconds = (float)(nanoseconds / 1.0e6);
+	m_TotalMilliseconds += m_LastMilliseconds;
+	m_Samples++;
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+* GPU time spent on the commands between Begin and End, from GL_TIME_ELAPSED queries
+* A result is only read once the GPU has it, a few frames later, so timing
+* never stalls the CPU. A ring of queries keeps that many measurements in
+* flight, Begin only waits when all of them are still pending. Time queries
+* cannot nest, two timers must not overlap.
+*/
+class GpuTimer
+{
+public:
+	static const unsigned int s_QueryCount = 4;
+
+private:
+	unsigned int m_Queries[s_QueryCount];
+	/* next query to issue, and how many issued ones are not read yet */
+	unsigned int m_Next;
+	unsigned int m_Pending;
+	float m_LastMilliseconds;
+	double m_TotalMilliseconds;
+	unsigned int m_Samples;
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	void Begin();
+	void End();
+
+	/* reads every result that has arrived, Finish waits for the rest */
+	void Poll();
+	void Finish();
+
+	/* the latest result that arrived, and the mean of all of them */
+	inline float GetLastMilliseconds() const { return m_LastMilliseconds; }
+	inline float GetAverageMilliseconds() const { return m_Samples ? (float)(m_TotalMilliseconds / m_Samples) : 0.0f; }
+	inline unsigned int GetSampleCount() const { return m_Samples; }
+
+private:
+	/* reads the oldest pending result, false when it is not there yet and wait is off */
+	bool ReadOldest(bool wait);
+};
@@ -0,0 +1,196 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+#include <cstring>
+
+#ifdef _WIN32
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext()
+	: m_Display(nullptr), m_Context(nullptr), m_Surface(nullptr), m_HiddenWindow(nullptr)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+#ifdef _WIN32
+
+bool HeadlessContext::Create()
+{
+	if (!glfwInit())
+		return false;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	m_HiddenWindow = glfwCreateWindow(1, 1, "Headless", NULL, NULL);
+	if (!m_HiddenWindow)
+	{
+		std::cout << "Failed to create hidden window for headless context" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_HiddenWindow);
+	return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+	if (!m_HiddenWindow)
+		return false;
+	glfwMakeContextCurrent(m_HiddenWindow);
+	return true;
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+	glfwMakeContextCurrent(NULL);
+}
+
+void HeadlessContext::Destroy()
+{
+	if (m_HiddenWindow)
+	{
+		glfwDestroyWindow(m_HiddenWindow);
+		glfwTerminate();
+		m_HiddenWindow = nullptr;
+	}
+}
+
+#else
+
+static bool HasExtension(const char* extensions, const char* name)
+{
+	if (!extensions)
+		return false;
+
+	/* match whole names only, one extension can be a prefix of another */
+	size_t length = strlen(name);
+	for (const char* start = strstr(extensions, name); start; start = strstr(start + 1, name))
+	{
+		if ((start == extensions || start[-1] == ' ') && (start[length] == ' ' || start[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+bool HeadlessContext::Create()
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	/* client extensions are queried without a display */
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "Failed to initialize EGL display" << std::endl;
+		return false;
+	}
+	m_Display = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "EGL does not support desktop OpenGL" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cout << "No suitable EGL config" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	/* same 3.3 core profile the windowed path asks GLFW for */
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create EGL context" << std::endl;
+		Destroy();
+		return false;
+	}
+	m_Context = context;
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+		m_Surface = surface;
+	}
+
+	if (!eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cout << "Failed to make EGL context current" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+	/* m_Surface stays null when surfaceless, which is EGL_NO_SURFACE */
+	return m_Display && eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context);
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+	if (m_Display)
+		eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!m_Display)
+		return;
+
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_Surface)
+		eglDestroySurface(m_Display, m_Surface);
+	if (m_Context)
+		eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+
+	m_Surface = nullptr;
+	m_Context = nullptr;
+	m_Display = nullptr;
+}
+
+#endif
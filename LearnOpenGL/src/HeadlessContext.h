@@ -0,0 +1,40 @@
+#pragma once
+
+struct GLFWwindow;
+
+/*
+* OpenGL 3.3 core context without a visible window
+* On Linux this goes through EGL, surfaceless when EGL_MESA_platform_surfaceless /
+* EGL_KHR_surfaceless_context are there (Mesa llvmpipe on render servers) and a
+* 1x1 pbuffer otherwise. Windows has no EGL, so a hidden GLFW window is used instead.
+* Rendering is expected to go into a Framebuffer, the default framebuffer is not used.
+*/
+class HeadlessContext
+{
+private:
+	void* m_Display;
+	void* m_Context;
+	void* m_Surface;
+	/* only used by the windows fallback */
+	GLFWwindow* m_HiddenWindow;
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	/* Creates the context and makes it current, prints why on failure */
+	bool Create();
+	void Destroy();
+
+	/*
+	* Moves the context between threads, the thread giving it up releases it
+	* first and the one taking it over makes it current
+	*/
+	bool MakeCurrent();
+	void ReleaseCurrent();
+
+	/* created through EGL rather than the hidden GLFW window */
+	inline bool IsEGL() const { return m_Display != nullptr; }
+};
@@ -0,0 +1,459 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace ImageWriter
+{
+	void EncodePPM(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out)
+	{
+		char header[32];
+		int headerLength = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+		out.resize(headerLength + (size_t)width * height * 3);
+		memcpy(out.data(), header, headerLength);
+
+		unsigned char* target = out.data() + headerLength;
+		for (int y = height - 1; y >= 0; y--)
+		{
+			const unsigned char* source = pixels + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+				target[0] = source[x * 4 + 0];
+				target[1] = source[x * 4 + 1];
+				target[2] = source[x * 4 + 2];
+				target += 3;
+			}
+		}
+	}
+
+	bool WritePPM(const std::string& path, const unsigned char* pixels, int width, int height)
+	{
+		std::vector<unsigned char> data;
+		EncodePPM(pixels, width, height, data);
+		return WriteFile(path, data);
+	}
+
+	bool WriteFile(const std::string& path, const std::vector<unsigned char>& data)
+	{
+		/* set before open, otherwise the file buffer allocates its own on every open */
+		char buffer[4096];
+		std::ofstream stream;
+		stream.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+		stream.open(path, std::ios::binary);
+		if (!stream)
+		{
+			std::cout << "Failed to open " << path << " for writing" << std::endl;
+			return false;
+		}
+		stream.write((const char*)data.data(), data.size());
+		stream.close();
+		return (bool)stream;
+	}
+
+	/* PNG */
+
+	static void PutBigEndian(std::vector<unsigned char>& out, unsigned int value)
+	{
+		out.push_back((unsigned char)(value >> 24));
+		out.push_back((unsigned char)(value >> 16));
+		out.push_back((unsigned char)(value >> 8));
+		out.push_back((unsigned char)value);
+	}
+
+	static unsigned int Crc32(const unsigned char* data, size_t length, unsigned int crc = 0)
+	{
+		static unsigned int table[256];
+		static bool initialized = false;
+		if (!initialized)
+		{
+			/* benign race, every thread writes the same values */
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				table[n] = c;
+			}
+			initialized = true;
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < length; i++)
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	static void PutChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t length)
+	{
+		PutBigEndian(out, (unsigned int)length);
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + length);
+		PutBigEndian(out, Crc32(&out[start], length + 4));
+	}
+
+	/* deflate writes bits least significant first */
+	class BitWriter
+	{
+	private:
+		std::vector<unsigned char>& m_Out;
+		unsigned int m_Buffer;
+		int m_Count;
+	public:
+		BitWriter(std::vector<unsigned char>& out)
+			: m_Out(out), m_Buffer(0), m_Count(0) {}
+
+		inline void Put(unsigned int bits, int count)
+		{
+			m_Buffer |= bits << m_Count;
+			m_Count += count;
+			while (m_Count >= 8)
+			{
+				m_Out.push_back((unsigned char)m_Buffer);
+				m_Buffer >>= 8;
+				m_Count -= 8;
+			}
+		}
+
+		/* huffman codes are defined most significant bit first */
+		inline void PutCode(unsigned int code, int length)
+		{
+			unsigned int reversed = 0;
+			for (int i = 0; i < length; i++)
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			Put(reversed, length);
+		}
+
+		inline void Flush()
+		{
+			if (m_Count > 0)
+				m_Out.push_back((unsigned char)m_Buffer);
+			m_Buffer = 0;
+			m_Count = 0;
+		}
+	};
+
+	static const unsigned short s_LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const unsigned char s_LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const unsigned short s_DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const unsigned char s_DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	static void PutLiteralLength(BitWriter& writer, unsigned int symbol)
+	{
+		/* fixed huffman table from RFC 1951 3.2.6 */
+		if (symbol < 144)
+			writer.PutCode(0x30 + symbol, 8);
+		else if (symbol < 256)
+			writer.PutCode(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			writer.PutCode(symbol - 256, 7);
+		else
+			writer.PutCode(0xc0 + symbol - 280, 8);
+	}
+
+	static void PutMatch(BitWriter& writer, unsigned int length, unsigned int distance)
+	{
+		int code = 28;
+		while (s_LengthBase[code] > length)
+			code--;
+		PutLiteralLength(writer, 257 + code);
+		writer.Put(length - s_LengthBase[code], s_LengthExtra[code]);
+
+		code = 29;
+		while (s_DistanceBase[code] > distance)
+			code--;
+		writer.PutCode(code, 5);
+		writer.Put(distance - s_DistanceBase[code], s_DistanceExtra[code]);
+	}
+
+	/* zlib stream, greedy LZ77 with one candidate per hash bucket */
+	static void Deflate(const unsigned char* data, size_t length, std::vector<int>& head, std::vector<unsigned char>& out)
+	{
+		const unsigned int windowSize = 32768;
+		const unsigned int hashBits = 15;
+		const unsigned int maxMatch = 258;
+
+		/* CMF/FLG: deflate, 32K window, fastest compression level */
+		out.push_back(0x78);
+		out.push_back(0x01);
+
+		BitWriter writer(out);
+		/* final block, fixed huffman */
+		writer.Put(1, 1);
+		writer.Put(1, 2);
+
+		head.assign((size_t)1 << hashBits, -1);
+		size_t i = 0;
+		while (i < length)
+		{
+			unsigned int bestLength = 0;
+			if (i + 3 <= length)
+			{
+				unsigned int hash = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u >> (32 - hashBits);
+				int candidate = head[hash];
+				head[hash] = (int)i;
+
+				if (candidate >= 0 && i - candidate <= windowSize)
+				{
+					size_t limit = std::min((size_t)maxMatch, length - i);
+					unsigned int matchLength = 0;
+					while (matchLength < limit && data[candidate + matchLength] == data[i + matchLength])
+						matchLength++;
+					if (matchLength >= 3)
+					{
+						bestLength = matchLength;
+						PutMatch(writer, matchLength, (unsigned int)(i - candidate));
+					}
+				}
+			}
+
+			if (bestLength == 0)
+			{
+				PutLiteralLength(writer, data[i]);
+				i++;
+			}
+			else
+			{
+				i += bestLength;
+			}
+		}
+		PutLiteralLength(writer, 256);
+		writer.Flush();
+
+		/* adler32 of the uncompressed data */
+		unsigned int a = 1, b = 0;
+		for (size_t n = 0; n < length; )
+		{
+			/* 5552 bytes is the most that can be summed before b may overflow */
+			size_t end = std::min(length, n + 5552);
+			for (; n < end; n++)
+			{
+				a += data[n];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		PutBigEndian(out, (b << 16) | a);
+	}
+
+	void EncodePNG(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out, PNGScratch& scratch)
+	{
+		/* every scanline gets the Sub filter, neighbouring pixels in renders are often equal */
+		size_t stride = (size_t)width * 4;
+		std::vector<unsigned char>& filtered = scratch.Filtered;
+		filtered.resize((stride + 1) * height);
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char* row = pixels + (size_t)(height - 1 - y) * stride;
+			unsigned char* target = &filtered[(stride + 1) * y];
+			target[0] = 1;
+			for (size_t x = 0; x < stride; x++)
+				target[x + 1] = (unsigned char)(row[x] - (x >= 4 ? row[x - 4] : 0));
+		}
+
+		/* fixed huffman codes are at most 9 bits a byte, reserving the worst case means a reused buffer never grows */
+		size_t worstCase = filtered.size() + filtered.size() / 8 + 16;
+		std::vector<unsigned char>& compressed = scratch.Compressed;
+		compressed.clear();
+		compressed.reserve(worstCase);
+		Deflate(filtered.data(), filtered.size(), scratch.HashHeads, compressed);
+
+		static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		out.clear();
+		out.reserve(8 + 25 + 12 + worstCase + 12);
+		out.insert(out.end(), signature, signature + 8);
+
+		/* 8 bit depth, RGBA, deflate, adaptive filtering, no interlace */
+		unsigned char header[13] = { 0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0 };
+		for (int i = 0; i < 4; i++)
+		{
+			header[i] = (unsigned char)(width >> (24 - i * 8));
+			header[4 + i] = (unsigned char)(height >> (24 - i * 8));
+		}
+		PutChunk(out, "IHDR", header, sizeof(header));
+		PutChunk(out, "IDAT", compressed.data(), compressed.size());
+		PutChunk(out, "IEND", nullptr, 0);
+	}
+
+	bool WritePNG(const std::string& path, const unsigned char* pixels, int width, int height)
+	{
+		std::vector<unsigned char> data;
+		PNGScratch scratch;
+		EncodePNG(pixels, width, height, data, scratch);
+		return WriteFile(path, data);
+	}
+
+	/* QOI, see qoiformat.org for the specification */
+
+	void EncodeQOI(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out)
+	{
+		/* worst case is a 5 byte op per pixel, reserving it means a reused buffer never grows */
+		out.clear();
+		out.reserve((size_t)width * height * 5 + 22);
+		out.push_back('q');
+		out.push_back('o');
+		out.push_back('i');
+		out.push_back('f');
+		PutBigEndian(out, width);
+		PutBigEndian(out, height);
+		/* RGBA, sRGB with linear alpha */
+		out.push_back(4);
+		out.push_back(0);
+
+		unsigned char index[64][4];
+		memset(index, 0, sizeof(index));
+		unsigned char previous[4] = { 0, 0, 0, 255 };
+		int run = 0;
+
+		for (int y = height - 1; y >= 0; y--)
+		{
+			const unsigned char* row = pixels + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+				const unsigned char* pixel = row + x * 4;
+				bool last = y == 0 && x == width - 1;
+
+				if (memcmp(pixel, previous, 4) == 0)
+				{
+					run++;
+					if (run == 62 || last)
+					{
+						out.push_back((unsigned char)(0xc0 | (run - 1)));
+						run = 0;
+					}
+					continue;
+				}
+
+				if (run > 0)
+				{
+					out.push_back((unsigned char)(0xc0 | (run - 1)));
+					run = 0;
+				}
+
+				int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+				if (memcmp(index[hash], pixel, 4) == 0)
+				{
+					out.push_back((unsigned char)hash);
+				}
+				else
+				{
+					memcpy(index[hash], pixel, 4);
+
+					if (pixel[3] == previous[3])
+					{
+						signed char dr = (signed char)(pixel[0] - previous[0]);
+						signed char dg = (signed char)(pixel[1] - previous[1]);
+						signed char db = (signed char)(pixel[2] - previous[2]);
+						signed char drg = (signed char)(dr - dg);
+						signed char dbg = (signed char)(db - dg);
+
+						if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+						{
+							out.push_back((unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+						}
+						else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7)
+						{
+							out.push_back((unsigned char)(0x80 | (dg + 32)));
+							out.push_back((unsigned char)((drg + 8) << 4 | (dbg + 8)));
+						}
+						else
+						{
+							out.push_back(0xfe);
+							out.insert(out.end(), pixel, pixel + 3);
+						}
+					}
+					else
+					{
+						out.push_back(0xff);
+						out.insert(out.end(), pixel, pixel + 4);
+					}
+				}
+				memcpy(previous, pixel, 4);
+			}
+		}
+
+		static const unsigned char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		out.insert(out.end(), padding, padding + 8);
+	}
+
+	bool WriteQOI(const std::string& path, const unsigned char* pixels, int width, int height)
+	{
+		std::vector<unsigned char> data;
+		EncodeQOI(pixels, width, height, data);
+		return WriteFile(path, data);
+	}
+
+	/* Y4M */
+
+	std::string GetY4MHeader(int width, int height, int frameRate)
+	{
+		return "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height)
+			+ " F" + std::to_string(frameRate) + ":1 Ip A1:1 C420jpeg\n";
+	}
+
+	void ConvertToYUV420(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out)
+	{
+		int chromaWidth = (width + 1) / 2;
+		int chromaHeight = (height + 1) / 2;
+		size_t lumaSize = (size_t)width * height;
+		size_t chromaSize = (size_t)chromaWidth * chromaHeight;
+		out.resize(lumaSize + chromaSize * 2);
+
+		unsigned char* lumaPlane = out.data();
+		unsigned char* cbPlane = lumaPlane + lumaSize;
+		unsigned char* crPlane = cbPlane + chromaSize;
+
+		/* 16.16 fixed point BT.601 full range coefficients */
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char* row = pixels + (size_t)(height - 1 - y) * width * 4;
+			unsigned char* luma = lumaPlane + (size_t)y * width;
+			for (int x = 0; x < width; x++)
+			{
+				const unsigned char* p = row + x * 4;
+				luma[x] = (unsigned char)((19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16);
+			}
+		}
+
+		for (int cy = 0; cy < chromaHeight; cy++)
+		{
+			for (int cx = 0; cx < chromaWidth; cx++)
+			{
+				int r = 0, g = 0, b = 0, count = 0;
+				for (int dy = 0; dy < 2; dy++)
+				{
+					int y = cy * 2 + dy;
+					if (y >= height)
+						continue;
+					const unsigned char* row = pixels + (size_t)(height - 1 - y) * width * 4;
+					for (int dx = 0; dx < 2; dx++)
+					{
+						int x = cx * 2 + dx;
+						if (x >= width)
+							continue;
+						r += row[x * 4 + 0];
+						g += row[x * 4 + 1];
+						b += row[x * 4 + 2];
+						count++;
+					}
+				}
+				r /= count;
+				g /= count;
+				b /= count;
+
+				int cb = (-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32768) >> 16;
+				int cr = (32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32768) >> 16;
+				cbPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)std::min(std::max(cb, 0), 255);
+				crPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)std::min(std::max(cr, 0), 255);
+			}
+		}
+	}
+}
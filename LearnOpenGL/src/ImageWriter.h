@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+* Writes RGBA8 pixel data to disk
+* Pixels come from glReadPixels, so rows are bottom first and get flipped on write.
+* The Encode functions only build the file contents in memory, so they can run
+* on any thread and the caller decides where the bytes go.
+*/
+namespace ImageWriter
+{
+	/* binary PPM (P6), alpha is dropped. No compression but nothing to get wrong */
+	void EncodePPM(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out);
+	bool WritePPM(const std::string& path, const unsigned char* pixels, int width, int height);
+
+	/* working memory of EncodePNG, keep one per thread so repeated encodes of one size do not allocate */
+	struct PNGScratch
+	{
+		std::vector<unsigned char> Filtered;
+		std::vector<unsigned char> Compressed;
+		std::vector<int> HashHeads;
+	};
+
+	/* PNG with a single fixed huffman deflate block, a fast greedy encoder rather than a small one */
+	void EncodePNG(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out, PNGScratch& scratch);
+	bool WritePNG(const std::string& path, const unsigned char* pixels, int width, int height);
+
+	/* "Quite OK Image" format, lossless and much faster to encode than PNG */
+	void EncodeQOI(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out);
+	bool WriteQOI(const std::string& path, const unsigned char* pixels, int width, int height);
+
+	/* Y4M stream header, frames follow as "FRAME\n" plus the planes from ConvertToYUV420 */
+	std::string GetY4MHeader(int width, int height, int frameRate);
+	/* full range BT.601 (C420jpeg) planar Y, Cb, Cr with chroma averaged over 2x2 blocks */
+	void ConvertToYUV420(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out);
+
+	/* the stream buffer lives on the stack, opening the file does not allocate one */
+	bool WriteFile(const std::string& path, const std::vector<unsigned char>& data);
+}
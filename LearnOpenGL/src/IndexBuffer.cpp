@@ -1,6 +1,7 @@
 #include "IndexBuffer.h"
 
 #include "Renderer.h"
+#include "GpuMemory.h"
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) 
     : m_Count(count)
@@ -13,15 +14,19 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
     /* Be careful, unsigned int may be different size on another platform */
     /* use sizeof(GLuint) if run into problem */
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    RENDER_STAT(BufferBytesUploaded, count * sizeof(unsigned int));
+    m_MemoryID = GpuMemory::Track(GpuMemoryCategory::IndexBuffer, count * sizeof(unsigned int), "Index buffer");
 }
 
 IndexBuffer::~IndexBuffer()
 {
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GpuMemory::Release(m_MemoryID);
 }
 
 void IndexBuffer::Bind() const
 {
+    RENDER_STAT(BufferBinds, 1);
     GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
 }
 
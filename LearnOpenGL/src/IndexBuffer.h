@@ -4,6 +4,8 @@ class IndexBuffer
 private: 
 	unsigned int m_RendererID;
 	unsigned int m_Count; 
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
 public: 
 	/* count means element count
 	* ex. drawing square requires 6 vertices (count) 
@@ -0,0 +1,264 @@
+#include "JobBenchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+/* compute bound case, enough work per element that memory bandwidth does not decide it */
+static const unsigned int s_ElementCount = 1 << 20;
+static const unsigned int s_IterationsPerElement = 64;
+/* scheduling bound case, each job does almost nothing */
+static const unsigned int s_TinyJobCount = 100000;
+/* chains of jobs that each wait for the one before */
+static const unsigned int s_ChainCount = 64;
+static const unsigned int s_ChainLength = 256;
+
+static inline float Work(float x)
+{
+	for (unsigned int i = 0; i < s_IterationsPerElement; i++)
+		x = x * x * 0.5f + 0.25f;
+	return x;
+}
+
+JobBenchmark::JobBenchmark(unsigned int repetitions)
+	: m_Repetitions(std::max(repetitions, 1u))
+{
+}
+
+bool JobBenchmark::RunScaling()
+{
+	unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	std::cout << "Job system scaling: " << cores << " hardware threads, best of " << m_Repetitions << " runs" << std::endl;
+
+	/* one thread runs every case serially, that is the baseline the speedup is against */
+	std::vector<unsigned int> threadCounts = { 1 };
+	for (unsigned int threads = 2; threads < cores; threads *= 2)
+		threadCounts.push_back(threads);
+	/* a single core still gets one oversubscribed run, so the job system's own overhead shows */
+	threadCounts.push_back(std::max(cores, 2u));
+
+	const char* names[] = { "parallel for", "tiny jobs", "dependencies" };
+	double single[3] = {};
+	double expected[3] = {};
+	bool correct = true;
+	for (unsigned int threads : threadCounts)
+	{
+		std::unique_ptr<JobSystem> jobs;
+		if (threads > 1)
+			jobs.reset(new JobSystem(threads - 1, true));
+
+		for (int test = 0; test < 3; test++)
+		{
+			double best = 0.0, result = 0.0;
+			for (unsigned int repetition = 0; repetition < m_Repetitions; repetition++)
+			{
+				double milliseconds = test == 0 ? TimeParallelFor(jobs.get(), threads, result)
+					: test == 1 ? TimeTinyJobs(jobs.get(), result) : TimeDependencies(jobs.get(), result);
+				best = repetition == 0 ? milliseconds : std::min(best, milliseconds);
+			}
+
+			if (threads == 1)
+			{
+				single[test] = best;
+				expected[test] = result;
+			}
+			bool same = result == expected[test];
+			correct = correct && same;
+
+			std::cout << "  " << names[test] << ", " << threads << (threads == 1 ? " thread: " : " threads: ") << best << " ms, "
+				<< single[test] / best << "x one thread" << (same ? "" : ", DIFFERENT RESULT") << std::endl;
+		}
+	}
+	return correct;
+}
+
+double JobBenchmark::TimeParallelFor(JobSystem* jobs, unsigned int threads, double& result)
+{
+	std::vector<float> values(s_ElementCount);
+	for (unsigned int i = 0; i < s_ElementCount; i++)
+		values[i] = (i % 1000) * 0.001f;
+	float* data = values.data();
+
+	auto start = std::chrono::steady_clock::now();
+	if (jobs)
+	{
+		JobCounter counter;
+		jobs->ParallelFor(s_ElementCount, [data](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				data[i] = Work(data[i]);
+		}, &counter, s_ElementCount / (threads * 16));
+		jobs->Wait(counter);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < s_ElementCount; i++)
+			data[i] = Work(data[i]);
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	result = 0.0;
+	for (float value : values)
+		result += value;
+	return milliseconds;
+}
+
+double JobBenchmark::TimeTinyJobs(JobSystem* jobs, double& result)
+{
+	std::vector<unsigned int> slots(s_TinyJobCount, 0);
+	unsigned int* data = slots.data();
+
+	auto start = std::chrono::steady_clock::now();
+	if (jobs)
+	{
+		JobCounter counter;
+		for (unsigned int i = 0; i < s_TinyJobCount; i++)
+			jobs->Execute([data, i]() { data[i] = i * 2; }, &counter);
+		jobs->Wait(counter);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < s_TinyJobCount; i++)
+			data[i] = i * 2;
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	result = 0.0;
+	for (unsigned int slot : slots)
+		result += slot;
+	return milliseconds;
+}
+
+double JobBenchmark::TimeDependencies(JobSystem* jobs, double& result)
+{
+	std::vector<float> values(s_ChainCount, 1.0f);
+	float* data = values.data();
+
+	auto start = std::chrono::steady_clock::now();
+	if (jobs)
+	{
+		/* a counter per link, each link waits for the one before it in the same chain */
+		std::unique_ptr<JobCounter[]> links(new JobCounter[s_ChainCount * s_ChainLength]);
+		for (unsigned int link = 0; link < s_ChainLength; link++)
+		{
+			for (unsigned int chain = 0; chain < s_ChainCount; chain++)
+			{
+				JobCounter* counter = &links[link * s_ChainCount + chain];
+				const JobCounter* previous = link > 0 ? &links[(link - 1) * s_ChainCount + chain] : nullptr;
+				jobs->Execute([data, chain]() { data[chain] = Work(data[chain]); }, counter, previous);
+			}
+		}
+		for (unsigned int chain = 0; chain < s_ChainCount; chain++)
+			jobs->Wait(links[(s_ChainLength - 1) * s_ChainCount + chain]);
+	}
+	else
+	{
+		for (unsigned int link = 0; link < s_ChainLength; link++)
+			for (unsigned int chain = 0; chain < s_ChainCount; chain++)
+				data[chain] = Work(data[chain]);
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	result = 0.0;
+	for (float value : values)
+		result += value;
+	return milliseconds;
+}
+
+bool JobBenchmark::RunStress(unsigned int rounds)
+{
+	unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	std::cout << "Job system stress test: " << rounds << " rounds, " << cores << " hardware threads" << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int round = 0; round < rounds; round++)
+	{
+		/* more workers than cores too, so threads get preempted in the middle of everything */
+		unsigned int workerCount = 1 + round % (cores + 2);
+		bool mainThreadParticipates = round % 2 == 0;
+		if (!StressRound(round, workerCount, mainThreadParticipates))
+			return false;
+	}
+	std::cout << "  passed in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+	return true;
+}
+
+bool JobBenchmark::StressRound(unsigned int round, unsigned int workerCount, bool mainThreadParticipates)
+{
+	const unsigned int flood = 10000, injected = 2000, nested = 64, nestedCount = 1000, producers = 256;
+	std::atomic<long long> sum(0);
+	long long expected = 0;
+
+	{
+		JobSystem jobs(workerCount, mainThreadParticipates);
+
+		/* more than a deque holds, the rest run inline on the scheduling thread */
+		JobCounter floodCounter;
+		for (unsigned int i = 0; i < flood; i++)
+		{
+			jobs.Execute([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, &floodCounter);
+			expected += i;
+		}
+
+		/* a thread without a deque schedules into the inject queue, it only steals while it waits */
+		std::thread outside([&jobs, &sum]()
+		{
+			JobCounter counter;
+			for (unsigned int i = 0; i < injected; i++)
+				jobs.Execute([&sum]() { sum.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			jobs.Wait(counter);
+		});
+		expected += injected;
+
+		/* jobs that fan out again and wait for their own children */
+		JobCounter nestedCounter;
+		for (unsigned int i = 0; i < nested; i++)
+		{
+			jobs.Execute([&jobs, &sum]()
+			{
+				JobCounter children;
+				jobs.ParallelFor(nestedCount, [&sum](unsigned int begin, unsigned int end)
+				{
+					sum.fetch_add(end - begin, std::memory_order_relaxed);
+				}, &children, 16);
+				jobs.Wait(children);
+			}, &nestedCounter);
+		}
+		expected += (long long)nested * nestedCount;
+
+		/*
+		* Consumers read plain ints the producers wrote, only the dependency orders them. They are
+		* pushed last, so the owner pops them first, before the producers ran, and parks them.
+		*/
+		std::vector<int> slots(producers, 0);
+		JobCounter produced, consumed;
+		for (unsigned int i = 0; i < producers; i++)
+			jobs.Execute([&slots, i]() { slots[i] = (int)i + 1; }, &produced);
+		for (unsigned int i = 0; i < producers; i++)
+		{
+			jobs.Execute([&slots, &sum, i]() { sum.fetch_add(slots[i], std::memory_order_relaxed); }, &consumed, &produced);
+			expected += i + 1;
+		}
+
+		jobs.Wait(floodCounter);
+		jobs.Wait(nestedCounter);
+		jobs.Wait(consumed);
+		outside.join();
+		/* the job system is destroyed right away, workers may still be stealing */
+	}
+
+	bool passed = sum.load() == expected;
+	if (!passed || round % 16 == 0)
+	{
+		std::cout << "  round " << round << ", " << workerCount << (workerCount == 1 ? " worker" : " workers")
+			<< (mainThreadParticipates ? " and the main thread: " : ": ") << (passed ? "ok" : "FAILED")
+			<< ", sum " << sum.load() << " of " << expected << std::endl;
+	}
+	return passed;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+class JobSystem;
+
+/*
+* Scaling benchmark and stress test for JobSystem, neither needs a GPU
+* RunScaling times a compute bound ParallelFor, a flood of tiny jobs and
+* chains of dependent jobs on 1, 2, 4 and so on up to every hardware thread
+* and prints the speedup over one thread. RunStress hammers every path at
+* once: jobs scheduled from workers and from outside threads, nested
+* ParallelFor with Wait inside jobs, dependencies that are picked up before
+* they are done, deques overflowing into inline runs, and job systems torn
+* down right after their last Wait. Build with LEARNOPENGL_SANITIZE_THREAD
+* and run it under ThreadSanitizer, it also checks every result itself.
+*/
+class JobBenchmark
+{
+private:
+	/* per run, the scaling benchmark repeats each case this often */
+	unsigned int m_Repetitions;
+public:
+	JobBenchmark(unsigned int repetitions = 5);
+
+	/* Prints a line per case and thread count, returns false if any run computed a different result */
+	bool RunScaling();
+	/* Prints a line per round, returns false on the first round that lost or repeated a job */
+	bool RunStress(unsigned int rounds);
+
+private:
+	bool StressRound(unsigned int round, unsigned int workerCount, bool mainThreadParticipates);
+	/* milliseconds for one repetition of a case, result is what it computed */
+	double TimeParallelFor(JobSystem* jobs, unsigned int threads, double& result);
+	double TimeTinyJobs(JobSystem* jobs, double& result);
+	double TimeDependencies(JobSystem* jobs, double& result);
+};
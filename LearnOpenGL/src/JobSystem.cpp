@@ -0,0 +1,416 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+/* windows.h min/max macros break std::min/std::max */
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* index of the worker owned by the current thread, -1 for threads without a deque */
+static thread_local int t_WorkerIndex = -1;
+static thread_local const JobSystem* t_JobSystem = nullptr;
+
+/* idle workers spin this many times looking for work before going to sleep */
+static const int s_SpinCount = 256;
+
+static void SetCurrentThreadName(const std::string& name)
+{
+#ifdef _WIN32
+	std::wstring wideName(name.begin(), name.end());
+	SetThreadDescription(GetCurrentThread(), wideName.c_str());
+#else
+	/* linux limits thread names to 15 characters */
+	pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
+
+static void PinCurrentThread(unsigned int core)
+{
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+WorkStealingDeque::WorkStealingDeque()
+	: m_Top(0), m_Bottom(0)
+{
+	for (unsigned int i = 0; i < s_Capacity; i++)
+		m_Buffer[i].store(nullptr, std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::Push(JobSlot* job)
+{
+	long long bottom = m_Bottom.load(std::memory_order_relaxed);
+	long long top = m_Top.load(std::memory_order_acquire);
+	if (bottom - top >= (long long)s_Capacity)
+		return false;
+
+	m_Buffer[bottom & s_Mask].store(job, std::memory_order_relaxed);
+	/* job must be visible before stealers can see the new bottom */
+	m_Bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+JobSlot* WorkStealingDeque::Pop()
+{
+	long long bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+	/* seq_cst so the bottom reservation is ordered before reading top, pairs with Steal */
+	m_Bottom.store(bottom, std::memory_order_seq_cst);
+	long long top = m_Top.load(std::memory_order_seq_cst);
+
+	if (top > bottom)
+	{
+		/* empty, undo the reservation */
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	JobSlot* job = m_Buffer[bottom & s_Mask].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		/* last job, race stealers for it */
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSlot* WorkStealingDeque::Steal()
+{
+	long long top = m_Top.load(std::memory_order_seq_cst);
+	long long bottom = m_Bottom.load(std::memory_order_seq_cst);
+	if (top >= bottom)
+		return nullptr;
+
+	JobSlot* job = m_Buffer[top & s_Mask].load(std::memory_order_relaxed);
+	/* lost to the owner or another thief */
+	if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int workerCount, bool mainThreadParticipates, bool pinThreads)
+	: m_MainThreadParticipates(mainThreadParticipates), m_Stop(false), m_ParkedCount(0), m_PendingJobs(0), m_SleepingWorkers(0)
+{
+	/* parking is rare, this keeps it from allocating once running */
+	m_Parked.reserve(256);
+
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	unsigned int total = workerCount + (mainThreadParticipates ? 1 : 0);
+	for (unsigned int i = 0; i < total; i++)
+	{
+		Worker* worker = new Worker();
+		/* twice the deque capacity, so a free slot is always close by */
+		worker->JobPool = std::vector<JobSlot>(8192);
+		worker->NextJob = 0;
+		worker->RangePool = std::vector<RangeFunction>(8192);
+		worker->NextRange = 0;
+		m_Workers.push_back(worker);
+	}
+
+	/* main thread owns worker 0 */
+	unsigned int first = 0;
+	if (mainThreadParticipates)
+	{
+		t_WorkerIndex = 0;
+		t_JobSystem = this;
+		SetCurrentThreadName("Main");
+		if (pinThreads)
+			PinCurrentThread(0);
+		first = 1;
+	}
+
+	for (unsigned int i = first; i < total; i++)
+		m_Workers[i]->Thread = std::thread(&JobSystem::WorkerLoop, this, i, pinThreads);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Stop = true;
+	}
+	m_WakeCondition.notify_all();
+
+	/* join everything before freeing, running workers may still be stealing from any deque */
+	for (Worker* worker : m_Workers)
+	{
+		if (worker->Thread.joinable())
+			worker->Thread.join();
+	}
+	for (Worker* worker : m_Workers)
+		delete worker;
+
+	if (t_JobSystem == this)
+	{
+		t_WorkerIndex = -1;
+		t_JobSystem = nullptr;
+	}
+}
+
+void JobSystem::BindCurrentThread(bool current)
+{
+	if (!m_MainThreadParticipates)
+		return;
+	t_WorkerIndex = current ? 0 : -1;
+	t_JobSystem = current ? this : nullptr;
+}
+
+void JobSystem::Execute(std::function<void()> function, JobCounter* counter, const JobCounter* dependency)
+{
+	if (counter)
+		counter->Value.fetch_add(1, std::memory_order_relaxed);
+
+	Push({ std::move(function), counter, dependency });
+}
+
+RangeFunction* JobSystem::AllocateRange(std::shared_ptr<RangeFunction>& owned)
+{
+	/*
+	* One copy the chunks share, so the caller does not have to keep function alive until the jobs
+	* finish. Threads with a deque keep it in their ring, each chunk then captures a plain pointer
+	* and fits in std::function's own storage, so a ParallelFor allocates nothing.
+	*/
+	int index = t_JobSystem == this ? t_WorkerIndex : -1;
+	if (index < 0)
+	{
+		owned = std::make_shared<RangeFunction>();
+		return owned.get();
+	}
+
+	/* a slot is busy until its last chunk ran, chunks can sit in a deque or in a preempted thief for a while */
+	Worker& worker = *m_Workers[index];
+	RangeFunction* range;
+	do
+	{
+		range = &worker.RangePool[worker.NextRange];
+		worker.NextRange = (worker.NextRange + 1) % worker.RangePool.size();
+	} while (range->IsBusy());
+	return range;
+}
+
+void JobSystem::ScheduleRanges(unsigned int count, RangeFunction* range, const std::shared_ptr<RangeFunction>& owned,
+	JobCounter* counter, unsigned int minChunkSize)
+{
+	/* roughly four chunks per thread leaves room for stealing to even out uneven chunks */
+	unsigned int chunkSize = count / (GetThreadCount() * 4);
+	chunkSize = std::max(chunkSize, std::max(minChunkSize, 1u));
+
+	if (!owned)
+		range->SetPendingChunks((count + chunkSize - 1) / chunkSize);
+	for (unsigned int begin = 0; begin < count; begin += chunkSize)
+	{
+		unsigned int end = std::min(begin + chunkSize, count);
+		if (owned)
+		{
+			Execute([owned, begin, end]() { (*owned)(begin, end); }, counter);
+		}
+		else
+		{
+			Execute([range, begin, end]()
+			{
+				(*range)(begin, end);
+				range->FinishChunk();
+			}, counter);
+		}
+	}
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+	int index = t_JobSystem == this ? t_WorkerIndex : -1;
+	while (!counter.IsDone())
+	{
+		if (!TryRunJob(index))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int index, bool pinThread)
+{
+	t_WorkerIndex = (int)index;
+	t_JobSystem = this;
+	SetCurrentThreadName("Worker " + std::to_string(index));
+	if (pinThread)
+		PinCurrentThread(index % std::max(std::thread::hardware_concurrency(), 1u));
+
+	int idleSpins = 0;
+	while (!m_Stop.load(std::memory_order_relaxed))
+	{
+		if (TryRunJob((int)index))
+		{
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < s_SpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_SleepingWorkers.fetch_add(1);
+		m_WakeCondition.wait(lock, [this]() { return m_Stop.load() || m_PendingJobs.load() > 0; });
+		m_SleepingWorkers.fetch_sub(1);
+		idleSpins = 0;
+	}
+}
+
+JobSlot* JobSystem::AllocateJob(Worker& worker)
+{
+	JobSlot* slot;
+	do
+	{
+		slot = &worker.JobPool[worker.NextJob];
+		worker.NextJob = (worker.NextJob + 1) % worker.JobPool.size();
+	} while (slot->Busy.load(std::memory_order_acquire));
+	slot->Busy.store(true, std::memory_order_relaxed);
+	return slot;
+}
+
+bool JobSystem::TryRunJob(int workerIndex)
+{
+	JobSlot* job = nullptr;
+	Job local;
+
+	/* own deque first, newest job is the most likely to be hot in cache */
+	if (workerIndex >= 0)
+		job = m_Workers[workerIndex]->Queue.Pop();
+
+	/* then steal, starting after ourselves so thieves spread over victims */
+	unsigned int workerCount = (unsigned int)m_Workers.size();
+	for (unsigned int i = 1; !job && i <= workerCount; i++)
+	{
+		unsigned int victim = (unsigned int)(workerIndex + (int)i) % workerCount;
+		if ((int)victim != workerIndex)
+			job = m_Workers[victim]->Queue.Steal();
+	}
+
+	if (job)
+	{
+		/* move out so the pool slot can be reused as soon as the job leaves the deque */
+		local = std::move(job->Work);
+		job->Busy.store(false, std::memory_order_release);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_InjectMutex);
+		if (m_InjectQueue.empty())
+			return false;
+		local = std::move(m_InjectQueue.front());
+		m_InjectQueue.pop_front();
+	}
+	m_PendingJobs.fetch_sub(1);
+
+	/* not ready yet, let the caller look for other work, the job is pushed again once it is */
+	if (local.Dependency && !local.Dependency->IsDone() && Park(local))
+		return false;
+
+	RunJob(local);
+	return true;
+}
+
+void JobSystem::RunJob(Job& job)
+{
+	job.Function();
+
+	/* seq_cst pairs with Park, either this sees the parked job or Park sees the counter done */
+	if (job.Counter && job.Counter->Value.fetch_sub(1, std::memory_order_seq_cst) == 1 && m_ParkedCount.load() > 0)
+		ReleaseParked();
+}
+
+void JobSystem::Push(Job&& job)
+{
+	int index = t_JobSystem == this ? t_WorkerIndex : -1;
+
+	m_PendingJobs.fetch_add(1);
+	if (index >= 0)
+	{
+		Worker& worker = *m_Workers[index];
+		JobSlot* slot = AllocateJob(worker);
+		slot->Work = std::move(job);
+		if (!worker.Queue.Push(slot))
+		{
+			/* deque is full, running inline is always correct and applies back pressure */
+			m_PendingJobs.fetch_sub(1);
+			Job local = std::move(slot->Work);
+			slot->Busy.store(false, std::memory_order_relaxed);
+			if (local.Dependency)
+				Wait(*local.Dependency);
+			RunJob(local);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_InjectMutex);
+		m_InjectQueue.push_back(std::move(job));
+	}
+
+	WakeWorkers();
+}
+
+void JobSystem::WakeWorkers()
+{
+	if (m_SleepingWorkers.load() > 0)
+	{
+		/* taking the lock orders this wake after a sleeper's predicate check */
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_one();
+	}
+}
+
+bool JobSystem::Park(Job& job)
+{
+	std::lock_guard<std::mutex> lock(m_ParkedMutex);
+	m_ParkedCount.fetch_add(1);
+	if (job.Dependency->Value.load() == 0)
+	{
+		m_ParkedCount.fetch_sub(1);
+		return false;
+	}
+	m_Parked.push_back(std::move(job));
+	return true;
+}
+
+void JobSystem::ReleaseParked()
+{
+	/* one at a time, Push can run a job inline and that can release more */
+	for (;;)
+	{
+		Job ready;
+		{
+			std::lock_guard<std::mutex> lock(m_ParkedMutex);
+			auto found = std::find_if(m_Parked.begin(), m_Parked.end(), [](const Job& job) { return job.Dependency->IsDone(); });
+			if (found == m_Parked.end())
+				return;
+			ready = std::move(*found);
+			if (found != m_Parked.end() - 1)
+				*found = std::move(m_Parked.back());
+			m_Parked.pop_back();
+			m_ParkedCount.fetch_sub(1);
+		}
+		Push(std::move(ready));
+	}
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct JobCounter;
+
+struct Job
+{
+	std::function<void()> Function;
+	JobCounter* Counter;
+	/* job is not started until this counter reaches zero, may be null */
+	const JobCounter* Dependency;
+};
+
+/*
+* Tracks a group of jobs. Incremented when a job is scheduled against it and
+* decremented when that job finishes, so zero means the whole group is done.
+*/
+struct JobCounter
+{
+	std::atomic<int> Value;
+
+	JobCounter()
+		: Value(0) {}
+
+	inline bool IsDone() const { return Value.load(std::memory_order_acquire) == 0; }
+};
+
+/*
+* Fixed size home for a ParallelFor function. The function is built in place,
+* so capturing more than fits is a compile error instead of a heap allocation.
+*/
+class RangeFunction
+{
+private:
+	static const size_t s_Capacity = 64;
+
+	alignas(std::max_align_t) unsigned char m_Storage[s_Capacity];
+	void (*m_Invoke)(void* function, unsigned int begin, unsigned int end);
+	void (*m_Destroy)(void* function);
+	/* chunks not finished yet, the slot is not reused before this is back to zero */
+	std::atomic<unsigned int> m_PendingChunks;
+public:
+	RangeFunction()
+		: m_Invoke(nullptr), m_Destroy(nullptr), m_PendingChunks(0) {}
+	~RangeFunction() { Reset(); }
+
+	RangeFunction(const RangeFunction&) = delete;
+	RangeFunction& operator=(const RangeFunction&) = delete;
+
+	template<typename Function>
+	void Assign(Function&& function)
+	{
+		typedef typename std::decay<Function>::type Stored;
+		static_assert(sizeof(Stored) <= s_Capacity, "ParallelFor function captures too much, capture a pointer to the state instead");
+		static_assert(alignof(Stored) <= alignof(std::max_align_t), "ParallelFor function is over aligned");
+
+		Reset();
+		new (m_Storage) Stored(std::forward<Function>(function));
+		m_Invoke = [](void* stored, unsigned int begin, unsigned int end) { (*(Stored*)stored)(begin, end); };
+		m_Destroy = [](void* stored) { ((Stored*)stored)->~Stored(); };
+	}
+
+	inline void Reset()
+	{
+		if (m_Destroy)
+			m_Destroy(m_Storage);
+		m_Invoke = nullptr;
+		m_Destroy = nullptr;
+	}
+
+	inline void operator()(unsigned int begin, unsigned int end) { m_Invoke(m_Storage, begin, end); }
+
+	inline void SetPendingChunks(unsigned int count) { m_PendingChunks.store(count, std::memory_order_relaxed); }
+	inline void FinishChunk() { m_PendingChunks.fetch_sub(1, std::memory_order_release); }
+	inline bool IsBusy() const { return m_PendingChunks.load(std::memory_order_acquire) != 0; }
+};
+
+/*
+* Pool storage for a queued job. Busy from allocation until whoever runs the
+* job has moved it out, a thief can be preempted between taking the job off
+* a deque and moving it, so the ring skips slots instead of assuming they are free.
+*/
+struct JobSlot
+{
+	Job Work;
+	std::atomic<bool> Busy;
+
+	JobSlot()
+		: Busy(false) {}
+};
+
+/*
+* Chase-Lev work-stealing deque
+* The owning worker pushes and pops at the bottom (LIFO, cache friendly),
+* other workers steal from the top (FIFO). Fixed capacity, Push fails when full.
+*/
+class WorkStealingDeque
+{
+private:
+	static const unsigned int s_Capacity = 4096;
+	static const unsigned int s_Mask = s_Capacity - 1;
+
+	/* padded onto separate cache lines, thieves hammer top while the owner hammers bottom */
+	std::atomic<long long> m_Top;
+	char m_Padding[64 - sizeof(std::atomic<long long>)];
+	std::atomic<long long> m_Bottom;
+	std::atomic<JobSlot*> m_Buffer[s_Capacity];
+public:
+	WorkStealingDeque();
+
+	bool Push(JobSlot* job);
+	JobSlot* Pop();
+	JobSlot* Steal();
+
+	inline bool Empty() const { return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed); }
+};
+
+class JobSystem
+{
+private:
+	struct Worker
+	{
+		WorkStealingDeque Queue;
+		/* ring of job storage owned by this worker, jobs are only allocated by the owning thread */
+		std::vector<JobSlot> JobPool;
+		unsigned int NextJob;
+		/* ring of ParallelFor functions, the chunk jobs point in here instead of sharing a heap copy */
+		std::vector<RangeFunction> RangePool;
+		unsigned int NextRange;
+		std::thread Thread;
+	};
+
+	std::vector<Worker*> m_Workers;
+	bool m_MainThreadParticipates;
+	std::atomic<bool> m_Stop;
+
+	/* jobs scheduled from threads that do not own a deque */
+	std::mutex m_InjectMutex;
+	std::deque<Job> m_InjectQueue;
+
+	/*
+	* Jobs picked up before their dependency was done. They wait here instead of going back
+	* on a deque, where the owner would pop the same job again straight away, and are pushed
+	* again when a counter reaches zero. The count is checked without the lock on that path.
+	*/
+	std::mutex m_ParkedMutex;
+	std::vector<Job> m_Parked;
+	std::atomic<int> m_ParkedCount;
+
+	/* idle workers sleep here instead of spinning */
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeCondition;
+	std::atomic<int> m_PendingJobs;
+	std::atomic<int> m_SleepingWorkers;
+public:
+	/*
+	* @param workerCount - background threads to create, 0 picks hardware_concurrency - 1
+	* @param mainThreadParticipates - creating thread gets a deque and runs jobs inside Wait
+	* @param pinThreads - set each worker's affinity to a single core
+	*/
+	JobSystem(unsigned int workerCount = 0, bool mainThreadParticipates = true, bool pinThreads = false);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void Execute(std::function<void()> function, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+
+	/*
+	* Splits [0, count) into chunks and runs function(begin, end) on each.
+	* Chunk size is picked so every thread gets a few chunks to balance load,
+	* but never smaller than minChunkSize so tiny chunks do not drown in overhead.
+	*/
+	template<typename Function>
+	void ParallelFor(unsigned int count, Function&& function, JobCounter* counter, unsigned int minChunkSize = 64)
+	{
+		if (count == 0)
+			return;
+
+		std::shared_ptr<RangeFunction> owned;
+		RangeFunction* range = AllocateRange(owned);
+		range->Assign(std::forward<Function>(function));
+		ScheduleRanges(count, range, owned, counter, minChunkSize);
+	}
+
+	/* Blocks until counter is zero. Threads with a deque run jobs while they wait. */
+	void Wait(const JobCounter& counter);
+
+	/*
+	* Hands the main thread's deque to another thread, like a RenderThread taking over the
+	* frame's work. Call with false on the thread giving it up before the other one calls it
+	* with true, and never from both at once. Does nothing unless the main thread participates.
+	*/
+	void BindCurrentThread(bool current);
+
+	/* number of threads executing jobs, including the main thread when it participates */
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size(); }
+
+private:
+	void WorkerLoop(unsigned int index, bool pinThread);
+	JobSlot* AllocateJob(Worker& worker);
+	/* slot in the calling thread's ring, threads without a deque get a shared copy in owned instead */
+	RangeFunction* AllocateRange(std::shared_ptr<RangeFunction>& owned);
+	void ScheduleRanges(unsigned int count, RangeFunction* range, const std::shared_ptr<RangeFunction>& owned,
+		JobCounter* counter, unsigned int minChunkSize);
+	bool TryRunJob(int workerIndex);
+	void RunJob(Job& job);
+	void Push(Job&& job);
+	void WakeWorkers();
+	/* true when the job went into m_Parked, false when its dependency finished meanwhile */
+	bool Park(Job& job);
+	void ReleaseParked();
+};
@@ -0,0 +1,314 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+/* recursive descent over the whole text, depth is limited so bad input cannot blow the stack */
+class JsonParser
+{
+private:
+	static const int s_MaxDepth = 256;
+
+	const char* m_Text;
+	const char* m_End;
+	const char* m_Position;
+	std::string& m_Error;
+public:
+	JsonParser(const char* text, size_t length, std::string& error)
+		: m_Text(text), m_End(text + length), m_Position(text), m_Error(error) {}
+
+	bool ParseDocument(JsonValue& value)
+	{
+		if (!ParseValue(value, 0))
+			return false;
+		SkipWhitespace();
+		if (m_Position != m_End)
+			return Fail("unexpected data after the document");
+		return true;
+	}
+
+private:
+	bool Fail(const char* message)
+	{
+		m_Error = std::string(message) + " at byte " + std::to_string(m_Position - m_Text);
+		return false;
+	}
+
+	void SkipWhitespace()
+	{
+		while (m_Position < m_End && (*m_Position == ' ' || *m_Position == '\t' || *m_Position == '\n' || *m_Position == '\r'))
+			m_Position++;
+	}
+
+	bool Expect(const char* word)
+	{
+		size_t length = strlen(word);
+		if ((size_t)(m_End - m_Position) < length || memcmp(m_Position, word, length) != 0)
+			return Fail("invalid literal");
+		m_Position += length;
+		return true;
+	}
+
+	bool ParseValue(JsonValue& value, int depth)
+	{
+		if (depth > s_MaxDepth)
+			return Fail("nesting too deep");
+
+		SkipWhitespace();
+		if (m_Position == m_End)
+			return Fail("unexpected end");
+
+		switch (*m_Position)
+		{
+		case '{': return ParseObject(value, depth);
+		case '[': return ParseArray(value, depth);
+		case '"':
+			value.Type = JsonType::String;
+			return ParseString(value.String);
+		case 't':
+			value.Type = JsonType::Bool;
+			value.Bool = true;
+			return Expect("true");
+		case 'f':
+			value.Type = JsonType::Bool;
+			value.Bool = false;
+			return Expect("false");
+		case 'n':
+			value.Type = JsonType::Null;
+			return Expect("null");
+		default:
+			return ParseNumber(value);
+		}
+	}
+
+	bool ParseObject(JsonValue& value, int depth)
+	{
+		value.Type = JsonType::Object;
+		m_Position++;
+		SkipWhitespace();
+		if (m_Position < m_End && *m_Position == '}')
+		{
+			m_Position++;
+			return true;
+		}
+
+		while (true)
+		{
+			SkipWhitespace();
+			if (m_Position == m_End || *m_Position != '"')
+				return Fail("expected a key");
+			value.Keys.emplace_back();
+			if (!ParseString(value.Keys.back()))
+				return false;
+
+			SkipWhitespace();
+			if (m_Position == m_End || *m_Position != ':')
+				return Fail("expected ':'");
+			m_Position++;
+
+			value.Elements.emplace_back();
+			if (!ParseValue(value.Elements.back(), depth + 1))
+				return false;
+
+			SkipWhitespace();
+			if (m_Position < m_End && *m_Position == ',')
+			{
+				m_Position++;
+				continue;
+			}
+			if (m_Position < m_End && *m_Position == '}')
+			{
+				m_Position++;
+				return true;
+			}
+			return Fail("expected ',' or '}'");
+		}
+	}
+
+	bool ParseArray(JsonValue& value, int depth)
+	{
+		value.Type = JsonType::Array;
+		m_Position++;
+		SkipWhitespace();
+		if (m_Position < m_End && *m_Position == ']')
+		{
+			m_Position++;
+			return true;
+		}
+
+		while (true)
+		{
+			value.Elements.emplace_back();
+			if (!ParseValue(value.Elements.back(), depth + 1))
+				return false;
+
+			SkipWhitespace();
+			if (m_Position < m_End && *m_Position == ',')
+			{
+				m_Position++;
+				continue;
+			}
+			if (m_Position < m_End && *m_Position == ']')
+			{
+				m_Position++;
+				return true;
+			}
+			return Fail("expected ',' or ']'");
+		}
+	}
+
+	bool ParseHex(unsigned int& codepoint)
+	{
+		if (m_End - m_Position < 4)
+			return Fail("short unicode escape");
+
+		codepoint = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			char c = *m_Position++;
+			codepoint <<= 4;
+			if (c >= '0' && c <= '9')
+				codepoint |= c - '0';
+			else if (c >= 'a' && c <= 'f')
+				codepoint |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				codepoint |= c - 'A' + 10;
+			else
+				return Fail("invalid unicode escape");
+		}
+		return true;
+	}
+
+	static void AppendUTF8(std::string& out, unsigned int codepoint)
+	{
+		if (codepoint < 0x80)
+		{
+			out += (char)codepoint;
+		}
+		else if (codepoint < 0x800)
+		{
+			out += (char)(0xc0 | codepoint >> 6);
+			out += (char)(0x80 | (codepoint & 0x3f));
+		}
+		else if (codepoint < 0x10000)
+		{
+			out += (char)(0xe0 | codepoint >> 12);
+			out += (char)(0x80 | (codepoint >> 6 & 0x3f));
+			out += (char)(0x80 | (codepoint & 0x3f));
+		}
+		else
+		{
+			out += (char)(0xf0 | codepoint >> 18);
+			out += (char)(0x80 | (codepoint >> 12 & 0x3f));
+			out += (char)(0x80 | (codepoint >> 6 & 0x3f));
+			out += (char)(0x80 | (codepoint & 0x3f));
+		}
+	}
+
+	bool ParseString(std::string& out)
+	{
+		m_Position++;
+		while (m_Position < m_End)
+		{
+			/* copy runs without escapes in one go, most strings have none */
+			const char* start = m_Position;
+			while (m_Position < m_End && *m_Position != '"' && *m_Position != '\\')
+				m_Position++;
+			out.append(start, m_Position);
+			if (m_Position == m_End)
+				break;
+
+			if (*m_Position++ == '"')
+				return true;
+
+			if (m_Position == m_End)
+				break;
+			char escape = *m_Position++;
+			switch (escape)
+			{
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+			{
+				unsigned int codepoint = 0;
+				if (!ParseHex(codepoint))
+					return false;
+				/* surrogate pair for codepoints above the basic plane */
+				if (codepoint >= 0xd800 && codepoint < 0xdc00 && m_End - m_Position >= 6 && m_Position[0] == '\\' && m_Position[1] == 'u')
+				{
+					m_Position += 2;
+					unsigned int low = 0;
+					if (!ParseHex(low))
+						return false;
+					codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+				}
+				AppendUTF8(out, codepoint);
+				break;
+			}
+			default:
+				return Fail("invalid escape");
+			}
+		}
+		return Fail("unterminated string");
+	}
+
+	bool ParseNumber(JsonValue& value)
+	{
+		/* strtod needs a terminated string, numbers are short so copy the candidate characters */
+		char buffer[64];
+		size_t length = 0;
+		while (m_Position + length < m_End && length < sizeof(buffer) - 1 && strchr("+-0123456789.eE", m_Position[length]))
+			length++;
+		if (length == 0)
+			return Fail("unexpected character");
+
+		memcpy(buffer, m_Position, length);
+		buffer[length] = '\0';
+		char* end;
+		value.Type = JsonType::Number;
+		value.Number = strtod(buffer, &end);
+		if (end != buffer + length)
+			return Fail("invalid number");
+		m_Position += length;
+		return true;
+	}
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& value, std::string& error)
+{
+	value = JsonValue();
+	JsonParser parser(text, length, error);
+	return parser.ParseDocument(value);
+}
+
+const JsonValue* JsonValue::Find(const char* key) const
+{
+	if (Type != JsonType::Object)
+		return nullptr;
+
+	for (size_t i = 0; i < Keys.size(); i++)
+	{
+		if (Keys[i] == key)
+			return &Elements[i];
+	}
+	return nullptr;
+}
+
+double JsonValue::GetNumber(const char* key, double fallback) const
+{
+	const JsonValue* member = Find(key);
+	return member && member->Type == JsonType::Number ? member->Number : fallback;
+}
+
+const std::string& JsonValue::GetString(const char* key) const
+{
+	static const std::string s_Empty;
+	const JsonValue* member = Find(key);
+	return member && member->Type == JsonType::String ? member->String : s_Empty;
+}
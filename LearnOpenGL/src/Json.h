@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+
+enum class JsonType
+{
+	Null, Bool, Number, String, Array, Object
+};
+
+/*
+* Parsed JSON document, each value owns its children
+* Objects keep their keys in Keys and the matching values in Elements, in
+* file order. Lookups are linear, fine for asset headers like glTF where
+* objects have a handful of members.
+*/
+struct JsonValue
+{
+	JsonType Type;
+	bool Bool;
+	double Number;
+	std::string String;
+	std::vector<JsonValue> Elements;
+	std::vector<std::string> Keys;
+
+	JsonValue()
+		: Type(JsonType::Null), Bool(false), Number(0.0) {}
+
+	/* member of an object, null when missing or this is not an object */
+	const JsonValue* Find(const char* key) const;
+	/* number member or fallback when missing */
+	double GetNumber(const char* key, double fallback) const;
+	/* string member or an empty string when missing */
+	const std::string& GetString(const char* key) const;
+
+	inline unsigned int GetSize() const { return (unsigned int)Elements.size(); }
+	inline const JsonValue& operator[](unsigned int index) const { return Elements[index]; }
+
+	/* Returns false and describes the problem with its byte offset in error */
+	static bool Parse(const char* text, size_t length, JsonValue& value, std::string& error);
+};
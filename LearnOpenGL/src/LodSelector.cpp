@@ -0,0 +1,50 @@
+#include "LodSelector.h"
+
+#include <cfloat>
+
+LodSelector::LodSelector(float pixelError, float hysteresis)
+	: m_PixelError(pixelError), m_Hysteresis(hysteresis), m_Stats()
+{
+}
+
+void LodSelector::BeginFrame()
+{
+	m_Stats = LodStats();
+}
+
+unsigned int LodSelector::Select(const Mesh& mesh, float screenRadius, unsigned int& level)
+{
+	unsigned int lodCount = mesh.GetLodCount();
+	unsigned int current = level < lodCount ? level : 0;
+
+	unsigned int selected = 0;
+	for (unsigned int candidate = lodCount - 1; candidate > 0; candidate--)
+	{
+		float threshold = m_PixelError;
+		if (candidate > current)
+			threshold *= 1.0f - m_Hysteresis;
+		if (mesh.GetLod(candidate).Error * screenRadius <= threshold)
+		{
+			selected = candidate;
+			break;
+		}
+	}
+
+	if (selected != level)
+		m_Stats.Switches++;
+	level = selected;
+
+	m_Stats.Objects++;
+	m_Stats.TrianglesDrawn += mesh.GetLod(selected).IndexCount / 3;
+	m_Stats.TrianglesFull += mesh.GetLod(0).IndexCount / 3;
+	return selected;
+}
+
+float LodSelector::GetScreenRadius(const glm::vec3& center, float radius, const glm::mat4& projection, int viewportHeight)
+{
+	float distance = glm::length(center);
+	if (distance <= radius)
+		return FLT_MAX;
+	/* projection[1][1] is cot(fovy / 2), half the viewport height covers one unit at distance one */
+	return radius * projection[1][1] * viewportHeight * 0.5f / distance;
+}
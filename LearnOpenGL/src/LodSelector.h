@@ -0,0 +1,50 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include "Mesh.h"
+
+/* Counts for the frame since the last BeginFrame */
+struct LodStats
+{
+	unsigned int Objects;
+	/* objects that changed level */
+	unsigned int Switches;
+	unsigned long long TrianglesDrawn;
+	/* what the same objects would have cost at level 0 */
+	unsigned long long TrianglesFull;
+};
+
+/*
+* Picks a level of detail per object from the projected size of its bounding sphere
+* A level is good enough while its error, relative to the sphere radius,
+* covers at most pixelError pixels on screen, the coarsest good level wins.
+* Moving to a coarser level needs the error to fit with hysteresis to spare,
+* so an object sitting on a threshold does not flip levels every frame.
+*/
+class LodSelector
+{
+private:
+	float m_PixelError;
+	float m_Hysteresis;
+	LodStats m_Stats;
+public:
+	/* hysteresis is a fraction below 1, 0.2 switches coarser once the error is 20% under the threshold */
+	LodSelector(float pixelError = 1.0f, float hysteresis = 0.2f);
+
+	void BeginFrame();
+
+	/*
+	* Level of mesh to draw this frame. level holds the object's level from the
+	* previous frame and is updated, screenRadius is in pixels.
+	*/
+	unsigned int Select(const Mesh& mesh, float screenRadius, unsigned int& level);
+
+	inline void SetPixelError(float pixelError) { m_PixelError = pixelError; }
+	inline const LodStats& GetStats() const { return m_Stats; }
+
+	/*
+	* Radius in pixels of a sphere seen through a perspective projection
+	* center is in view space, viewportHeight in pixels. Huge when the camera is inside.
+	*/
+	static float GetScreenRadius(const glm::vec3& center, float radius, const glm::mat4& projection, int viewportHeight);
+};
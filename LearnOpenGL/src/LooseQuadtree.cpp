@@ -0,0 +1,161 @@
+#include "LooseQuadtree.h"
+
+#include "Renderer.h"
+
+const int LooseQuadtree::s_NotInserted;
+const int LooseQuadtree::s_Overflow;
+
+LooseQuadtree::LooseQuadtree(const AABB& worldBounds, int depth)
+	: m_Depth(depth), m_WorldMin(worldBounds.Min), m_WorldSize(glm::vec2(worldBounds.Max - worldBounds.Min)),
+	m_MinZ(worldBounds.Min.z), m_MaxZ(worldBounds.Max.z)
+{
+	ASSERT(depth > 0 && depth <= 12);
+
+	m_Levels.resize(depth);
+	for (int level = 0; level < depth; level++)
+	{
+		unsigned int side = 1u << level;
+		m_Levels[level].resize(side * side);
+		for (Cell& cell : m_Levels[level])
+			cell.SubtreeCount = 0;
+	}
+}
+
+LooseQuadtree::Location LooseQuadtree::FindLocation(const AABB& box) const
+{
+	glm::vec2 center = glm::vec2(box.GetCenter()) - m_WorldMin;
+	glm::vec2 extents = glm::vec2(box.GetExtents());
+
+	if (center.x < 0.0f || center.y < 0.0f || center.x > m_WorldSize.x || center.y > m_WorldSize.y)
+		return { s_Overflow, 0, 0 };
+
+	/*
+	* With looseness 2 the loose cell reaches half a cell past each edge, so any
+	* object whose extents are at most half a cell fits wherever its center lands.
+	* Pick the deepest level where that holds.
+	*/
+	int level = 0;
+	while (level + 1 < m_Depth)
+	{
+		glm::vec2 cellSize = m_WorldSize / (float)(1u << (level + 1));
+		if (extents.x > cellSize.x * 0.5f || extents.y > cellSize.y * 0.5f)
+			break;
+		level++;
+	}
+
+	unsigned int side = 1u << level;
+	glm::vec2 cellSize = m_WorldSize / (float)side;
+	unsigned int x = std::min((unsigned int)(center.x / cellSize.x), side - 1);
+	unsigned int y = std::min((unsigned int)(center.y / cellSize.y), side - 1);
+
+	return { level, y * side + x, 0 };
+}
+
+AABB LooseQuadtree::GetLooseBounds(int level, unsigned int x, unsigned int y) const
+{
+	glm::vec2 cellSize = m_WorldSize / (float)(1u << level);
+	glm::vec2 min = m_WorldMin + glm::vec2((float)x, (float)y) * cellSize - cellSize * 0.5f;
+	glm::vec2 max = min + cellSize * 2.0f;
+	return AABB(glm::vec3(min, m_MinZ), glm::vec3(max, m_MaxZ));
+}
+
+void LooseQuadtree::AdjustSubtreeCounts(int level, unsigned int cell, int delta)
+{
+	unsigned int side = 1u << level;
+	unsigned int x = cell % side;
+	unsigned int y = cell / side;
+	for (; level >= 0; level--)
+	{
+		side = 1u << level;
+		m_Levels[level][y * side + x].SubtreeCount += delta;
+		x >>= 1;
+		y >>= 1;
+	}
+}
+
+void LooseQuadtree::Insert(unsigned int object, const AABB& box)
+{
+	if (object >= m_Locations.size())
+		m_Locations.resize(object + 1, { s_NotInserted, 0, 0 });
+	ASSERT(m_Locations[object].Level == s_NotInserted);
+
+	Location location = FindLocation(box);
+	if (location.Level == s_Overflow)
+	{
+		location.Index = (unsigned int)m_Overflow.size();
+		m_Overflow.push_back(object);
+	}
+	else
+	{
+		std::vector<unsigned int>& objects = m_Levels[location.Level][location.Cell].Objects;
+		location.Index = (unsigned int)objects.size();
+		objects.push_back(object);
+		AdjustSubtreeCounts(location.Level, location.Cell, 1);
+	}
+	m_Locations[object] = location;
+}
+
+void LooseQuadtree::Update(unsigned int object, const AABB& box)
+{
+	const Location& current = m_Locations[object];
+	Location location = FindLocation(box);
+	/* still in the same cell, the common case for small movements */
+	if (location.Level == current.Level && location.Cell == current.Cell)
+		return;
+
+	Remove(object);
+	Insert(object, box);
+}
+
+void LooseQuadtree::Remove(unsigned int object)
+{
+	Location& location = m_Locations[object];
+	ASSERT(location.Level != s_NotInserted);
+
+	std::vector<unsigned int>& objects = location.Level == s_Overflow
+		? m_Overflow : m_Levels[location.Level][location.Cell].Objects;
+
+	/* swap with the last object so removal is O(1) */
+	unsigned int moved = objects.back();
+	objects[location.Index] = moved;
+	m_Locations[moved].Index = location.Index;
+	objects.pop_back();
+
+	if (location.Level != s_Overflow)
+		AdjustSubtreeCounts(location.Level, location.Cell, -1);
+
+	location.Level = s_NotInserted;
+}
+
+void LooseQuadtree::Query(const Frustum& frustum, std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const
+{
+	intersecting.insert(intersecting.end(), m_Overflow.begin(), m_Overflow.end());
+	QueryCell(frustum, 0, 0, 0, false, inside, intersecting);
+}
+
+void LooseQuadtree::QueryCell(const Frustum& frustum, int level, unsigned int x, unsigned int y, bool fullyInside,
+	std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const
+{
+	unsigned int side = 1u << level;
+	const Cell& cell = m_Levels[level][y * side + x];
+	if (cell.SubtreeCount == 0)
+		return;
+
+	/* once a cell is fully inside every cell below it is too, no more plane tests */
+	if (!fullyInside)
+	{
+		FrustumTest test = frustum.Test(GetLooseBounds(level, x, y));
+		if (test == FrustumTest::Outside)
+			return;
+		fullyInside = test == FrustumTest::Inside;
+	}
+
+	std::vector<unsigned int>& out = fullyInside ? inside : intersecting;
+	out.insert(out.end(), cell.Objects.begin(), cell.Objects.end());
+
+	if (level + 1 < m_Depth)
+	{
+		for (unsigned int child = 0; child < 4; child++)
+			QueryCell(frustum, level + 1, x * 2 + (child & 1), y * 2 + (child >> 1), fullyInside, inside, intersecting);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+
+#include "Bounds.h"
+
+/*
+* Loose quadtree over the xy plane for 2D scenes
+* Each cell's bounds are doubled (looseness 2), so an object only has to pick a
+* cell by its center and a level by its size. Moving an object is O(1) unless it
+* crosses into another cell, and nothing ever has to be split or merged.
+*/
+class LooseQuadtree
+{
+private:
+	struct Cell
+	{
+		std::vector<unsigned int> Objects;
+		/* objects in this cell and all cells below, empty subtrees are skipped by queries */
+		unsigned int SubtreeCount;
+	};
+
+	struct Location
+	{
+		int Level;
+		unsigned int Cell;
+		unsigned int Index;
+	};
+
+	static const int s_NotInserted = -1;
+	static const int s_Overflow = -2;
+
+	int m_Depth;
+	glm::vec2 m_WorldMin;
+	glm::vec2 m_WorldSize;
+	float m_MinZ, m_MaxZ;
+
+	/* m_Levels[level] holds (2^level)^2 cells, row major */
+	std::vector<std::vector<Cell>> m_Levels;
+	/* objects whose center is outside the world bounds, always treated as intersecting */
+	std::vector<unsigned int> m_Overflow;
+	/* indexed by object id */
+	std::vector<Location> m_Locations;
+public:
+	LooseQuadtree(const AABB& worldBounds, int depth = 8);
+
+	void Insert(unsigned int object, const AABB& box);
+	void Update(unsigned int object, const AABB& box);
+	void Remove(unsigned int object);
+
+	/* objects in cells fully inside go to inside, objects in partially covered cells to intersecting */
+	void Query(const Frustum& frustum, std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const;
+
+private:
+	Location FindLocation(const AABB& box) const;
+	AABB GetLooseBounds(int level, unsigned int x, unsigned int y) const;
+	void AdjustSubtreeCounts(int level, unsigned int cell, int delta);
+	void QueryCell(const Frustum& frustum, int level, unsigned int x, unsigned int y, bool fullyInside,
+		std::vector<unsigned int>& inside, std::vector<unsigned int>& intersecting) const;
+};
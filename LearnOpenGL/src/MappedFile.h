@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+/*
+* Read only view of a whole file through the OS memory mapping
+* Pages are read from disk the first time they are touched and shared with
+* the file cache, so nothing is copied until the data is actually used.
+*/
+class MappedFile
+{
+private:
+	const unsigned char* m_Data;
+	unsigned long long m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#endif
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/* false when the file is missing or empty */
+	bool Open(const std::string& path);
+	void Close();
+
+	inline const unsigned char* GetData() const { return m_Data; }
+	inline unsigned long long GetSize() const { return m_Size; }
+	inline bool IsOpen() const { return m_Data != nullptr; }
+
+	/* size and modification time, false when the file does not exist. Caches keep their source's to notice edits */
+	static bool GetStamp(const std::string& path, unsigned long long& size, unsigned long long& time);
+};
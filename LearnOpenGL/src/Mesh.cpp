@@ -0,0 +1,167 @@
+#include "Mesh.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "VertexBufferLayout.h"
+
+static const MeshAttribute s_Attributes[] = { MeshAttribute::Position, MeshAttribute::Normal, MeshAttribute::TexCoord, MeshAttribute::Color };
+static const char* s_AttributeNames[] = { "POSITION", "NORMAL", "TEXCOORD", "COLOR" };
+
+unsigned int MeshData::GetComponentCount(MeshAttribute attribute)
+{
+	switch (attribute)
+	{
+	case MeshAttribute::Position: return 3;
+	case MeshAttribute::Normal: return 3;
+	case MeshAttribute::TexCoord: return 2;
+	case MeshAttribute::Color: return 4;
+	}
+	return 0;
+}
+
+unsigned int MeshData::GetFloatsPerVertex(unsigned int attributes)
+{
+	unsigned int floats = 0;
+	for (MeshAttribute attribute : s_Attributes)
+	{
+		if (attributes & (unsigned int)attribute)
+			floats += GetComponentCount(attribute);
+	}
+	return floats;
+}
+
+unsigned int MeshData::GetOffset(unsigned int attributes, MeshAttribute attribute)
+{
+	/* attributes before this one in the fixed order */
+	return GetFloatsPerVertex(attributes & ((unsigned int)attribute - 1));
+}
+
+VertexBufferLayout MeshData::MakeLayout(unsigned int attributes)
+{
+	VertexBufferLayout layout;
+	for (MeshAttribute attribute : s_Attributes)
+	{
+		if (attributes & (unsigned int)attribute)
+			layout.Push<float>(GetComponentCount(attribute));
+	}
+	return layout;
+}
+
+std::string MeshData::GetShaderDefines(unsigned int attributes)
+{
+	std::string defines;
+	int location = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		if (!(attributes & (unsigned int)s_Attributes[i]))
+			continue;
+		defines += std::string("#define HAS_") + s_AttributeNames[i] + "\n";
+		defines += std::string("#define ") + s_AttributeNames[i] + "_LOCATION " + std::to_string(location++) + "\n";
+	}
+	return defines;
+}
+
+MeshData MeshData::MakeCube()
+{
+	MeshData cube;
+	cube.Attributes = (unsigned int)MeshAttribute::Position;
+	for (int i = 0; i < 8; i++)
+	{
+		cube.Vertices.push_back(i & 1 ? 1.0f : -1.0f);
+		cube.Vertices.push_back(i & 2 ? 1.0f : -1.0f);
+		cube.Vertices.push_back(i & 4 ? 1.0f : -1.0f);
+	}
+	/* two counter clockwise triangles per face seen from outside, vertex bits are x, y, z */
+	cube.Indices = {
+		0, 4, 6, 0, 6, 2,  1, 3, 7, 1, 7, 5,
+		0, 1, 5, 0, 5, 4,  2, 6, 7, 2, 7, 3,
+		0, 2, 3, 0, 3, 1,  4, 5, 7, 4, 7, 6
+	};
+	cube.Bounds = AABB(glm::vec3(-1.0f), glm::vec3(1.0f));
+	return cube;
+}
+
+void MeshData::ComputeBounds()
+{
+	unsigned int stride = GetFloatsPerVertex(Attributes);
+	if (!Has(MeshAttribute::Position) || Vertices.empty())
+	{
+		Bounds = AABB();
+		return;
+	}
+
+	unsigned int offset = GetOffset(Attributes, MeshAttribute::Position);
+	glm::vec3 min(Vertices[offset], Vertices[offset + 1], Vertices[offset + 2]);
+	glm::vec3 max = min;
+	for (size_t i = offset; i < Vertices.size(); i += stride)
+	{
+		glm::vec3 position(Vertices[i], Vertices[i + 1], Vertices[i + 2]);
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+	Bounds = AABB(min, max);
+}
+
+unsigned int MeshData::RemoveDuplicateVertices()
+{
+	unsigned int stride = GetFloatsPerVertex(Attributes);
+	unsigned int vertexCount = GetVertexCount();
+	size_t vertexBytes = stride * sizeof(float);
+
+	/* FNV-1a over the raw bytes, equal bits hash equal so -0 and 0 stay apart like they should for exact welding */
+	auto hash = [&](unsigned int vertex)
+	{
+		const unsigned char* bytes = (const unsigned char*)&Vertices[(size_t)vertex * stride];
+		size_t value = 14695981039346656037ull;
+		for (size_t i = 0; i < vertexBytes; i++)
+			value = (value ^ bytes[i]) * 1099511628211ull;
+		return value;
+	};
+	auto equal = [&](unsigned int a, unsigned int b)
+	{
+		return memcmp(&Vertices[(size_t)a * stride], &Vertices[(size_t)b * stride], vertexBytes) == 0;
+	};
+
+	std::unordered_map<unsigned int, unsigned int, decltype(hash), decltype(equal)> unique(vertexCount, hash, equal);
+	std::vector<unsigned int> remap(vertexCount);
+	unsigned int kept = 0;
+	for (unsigned int vertex = 0; vertex < vertexCount; vertex++)
+	{
+		/*
+		* Keys are slots of the compacted array. The candidate is moved into the
+		* first free slot before the lookup, if it turns out to be new it stays
+		*/
+		if (kept != vertex)
+			memcpy(&Vertices[(size_t)kept * stride], &Vertices[(size_t)vertex * stride], vertexBytes);
+		auto inserted = unique.emplace(kept, kept);
+		if (inserted.second)
+			kept++;
+		remap[vertex] = inserted.first->second;
+	}
+
+	for (unsigned int& index : Indices)
+		index = remap[index];
+	Vertices.resize((size_t)kept * stride);
+	return vertexCount - kept;
+}
+
+Mesh::Mesh(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+	unsigned int attributes, const AABB& bounds, const MeshLod* lods, unsigned int lodCount)
+	: m_Attributes(attributes), m_VertexCount(vertexCount), m_Bounds(bounds)
+{
+	if (lodCount > 0)
+		m_Lods.assign(lods, lods + lodCount);
+	else
+		m_Lods.push_back({ 0, indexCount, 0.0f });
+
+	m_VertexBuffer.reset(new VertexBuffer(vertices, vertexCount * MeshData::GetFloatsPerVertex(attributes) * (unsigned int)sizeof(float)));
+	m_VertexArray.AddBuffer(*m_VertexBuffer, MeshData::MakeLayout(attributes));
+	m_IndexBuffer.reset(new IndexBuffer(indices, indexCount));
+}
+
+Mesh::Mesh(const MeshData& data)
+	: Mesh(data.Vertices.data(), data.GetVertexCount(), data.Indices.data(), (unsigned int)data.Indices.size(), data.Attributes, data.Bounds,
+		data.Lods.data(), (unsigned int)data.Lods.size())
+{
+}
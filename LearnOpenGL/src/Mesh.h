@@ -0,0 +1,116 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "Bounds.h"
+
+class VertexBufferLayout;
+
+/* Vertex attributes a mesh can have, interleaved in this order with the missing ones left out */
+enum class MeshAttribute : unsigned int
+{
+	/* 3 floats */
+	Position = 1 << 0,
+	/* 3 floats */
+	Normal = 1 << 1,
+	/* 2 floats, v grows upwards like OpenGL texture coordinates */
+	TexCoord = 1 << 2,
+	/* 4 floats */
+	Color = 1 << 3
+};
+
+/* One level of detail, a range of the index buffer over the shared vertices */
+struct MeshLod
+{
+	unsigned int FirstIndex;
+	unsigned int IndexCount;
+	/* geometric error relative to the bounding sphere radius, 0 for the full mesh */
+	float Error;
+};
+
+/*
+* Geometry on the CPU, what importers produce and the mesh cache stores
+* Attributes is a mask of MeshAttribute, Vertices holds the present ones
+* interleaved. Triangles only, three indices each. Lods is either empty or
+* starts with the full mesh, coarser levels follow it in Indices.
+*/
+struct MeshData
+{
+	unsigned int Attributes;
+	std::vector<float> Vertices;
+	std::vector<unsigned int> Indices;
+	std::vector<MeshLod> Lods;
+	AABB Bounds;
+
+	MeshData()
+		: Attributes(0) {}
+
+	inline bool Has(MeshAttribute attribute) const { return (Attributes & (unsigned int)attribute) != 0; }
+	inline unsigned int GetVertexCount() const { return (unsigned int)(Vertices.size() / GetFloatsPerVertex(Attributes)); }
+
+	/* Bounds of every position */
+	void ComputeBounds();
+	/* Merges vertices whose attributes are bit for bit equal and remaps the indices, returns how many were removed */
+	unsigned int RemoveDuplicateVertices();
+
+	static unsigned int GetComponentCount(MeshAttribute attribute);
+	static unsigned int GetFloatsPerVertex(unsigned int attributes);
+	/* float offset of attribute inside a vertex, the attribute must be present */
+	static unsigned int GetOffset(unsigned int attributes, MeshAttribute attribute);
+	/* one float element per present attribute, locations 0, 1, ... in attribute order */
+	static VertexBufferLayout MakeLayout(unsigned int attributes);
+	/*
+	* #define lines naming each present attribute and its location, for example
+	* HAS_NORMAL and NORMAL_LOCATION 1, so one shader file fits every layout
+	*/
+	static std::string GetShaderDefines(unsigned int attributes);
+
+	/* positions only box from -1 to 1 on every axis, 8 vertices */
+	static MeshData MakeCube();
+};
+
+/*
+* Geometry uploaded for drawing: vertex array, interleaved vertex buffer and index buffer
+* The vertex layout matches the attributes the source actually had. Every
+* level of detail is a range of the one index buffer, level 0 is the full mesh.
+*/
+class Mesh
+{
+private:
+	VertexArray m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	unsigned int m_Attributes;
+	unsigned int m_VertexCount;
+	std::vector<MeshLod> m_Lods;
+	AABB m_Bounds;
+public:
+	/*
+	* Uploads straight from the given memory, which may be a mapped cache file
+	* Without lods the whole index buffer is the only level.
+	*/
+	Mesh(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+		unsigned int attributes, const AABB& bounds, const MeshLod* lods = nullptr, unsigned int lodCount = 0);
+	Mesh(const MeshData& data);
+
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+	/* for vertex arrays that add per instance buffers to the mesh's vertices */
+	inline const VertexBuffer& GetVertexBuffer() const { return *m_VertexBuffer; }
+	inline const IndexBuffer& GetIndexBuffer() const { return *m_IndexBuffer; }
+	inline unsigned int GetAttributes() const { return m_Attributes; }
+	inline unsigned int GetVertexCount() const { return m_VertexCount; }
+	/* every level together */
+	inline unsigned int GetIndexCount() const { return m_IndexBuffer->GetCount(); }
+	inline unsigned int GetLodCount() const { return (unsigned int)m_Lods.size(); }
+	inline const MeshLod& GetLod(unsigned int level) const { return m_Lods[level]; }
+	/* radius of the sphere around the bounds, what LOD errors are relative to */
+	inline float GetBoundingRadius() const { return glm::length(m_Bounds.GetExtents()); }
+	inline const AABB& GetBounds() const { return m_Bounds; }
+	inline std::string GetShaderDefines() const { return MeshData::GetShaderDefines(m_Attributes); }
+};
@@ -0,0 +1,1132 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Json.h"
+#include "MeshSimplifier.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+const unsigned int MeshImporter::s_CacheVersion;
+
+/* OBJ files smaller than this are parsed on the calling thread, splitting them costs more than it saves */
+static const unsigned long long s_MinParallelBytes = 256 * 1024;
+
+/* Cache file: this header, the interleaved vertices, the indices, the MeshLods, then the LOD target errors */
+struct MeshCacheHeader
+{
+	char Magic[4];
+	unsigned int Version;
+	unsigned int Attributes;
+	unsigned int VertexCount;
+	unsigned int IndexCount;
+	float BoundsMin[3];
+	float BoundsMax[3];
+	unsigned int LodCount;
+	unsigned int LodErrorCount;
+	/* keeps the 64 bit fields aligned */
+	unsigned int Padding;
+	unsigned long long SourceSize;
+	unsigned long long SourceTime;
+};
+
+static const char s_CacheMagic[4] = { 'M', 'E', 'S', 'H' };
+
+static float ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Text parsing */
+
+static const double s_PowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsDigit(char c)
+{
+	return (unsigned int)(c - '0') < 10;
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+	return p;
+}
+
+/*
+* Decimal float without strtod's locale lookups and allocation, null when
+* there is no number. Up to 19 significant digits are kept in an integer and
+* scaled by a power of ten in double precision. That is not correctly rounded
+* for every input like strtod, but it is exact to float precision for the
+* coordinates exporters write.
+*/
+static const char* ParseFloat(const char* p, const char* end, float& value)
+{
+	p = SkipSpaces(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	unsigned long long mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any = false;
+	for (; p < end && IsDigit(*p); p++, any = true)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && IsDigit(*p); p++, any = true)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if (!any)
+		return nullptr;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+'))
+			negativeExponent = *e++ == '-';
+		if (e < end && IsDigit(*e))
+		{
+			int power = 0;
+			for (; e < end && IsDigit(*e); e++)
+				power = std::min(power * 10 + (*e - '0'), 9999);
+			exponent += negativeExponent ? -power : power;
+			p = e;
+		}
+	}
+
+	double result = (double)mantissa;
+	if (result != 0.0)
+	{
+		for (; exponent > 22; exponent -= 22)
+			result *= 1e22;
+		for (; exponent < -22; exponent += 22)
+			result /= 1e22;
+		result = exponent < 0 ? result / s_PowersOfTen[-exponent] : result * s_PowersOfTen[exponent];
+	}
+	value = (float)(negative ? -result : result);
+	return p;
+}
+
+static const char* ParseInt(const char* p, const char* end, int& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+	if (p == end || !IsDigit(*p))
+		return nullptr;
+
+	long long result = 0;
+	for (; p < end && IsDigit(*p); p++)
+		result = std::min(result * 10 + (*p - '0'), 0x7fffffffll);
+	value = (int)(negative ? -result : result);
+	return p;
+}
+
+/* OBJ */
+
+/* indices of one face corner, -1 when the corner does not reference the element */
+struct ObjCorner
+{
+	int Position, TexCoord, Normal;
+
+	inline bool operator==(const ObjCorner& other) const
+	{
+		return Position == other.Position && TexCoord == other.TexCoord && Normal == other.Normal;
+	}
+};
+
+/* a piece of the file starting and ending on a line boundary */
+struct ObjChunk
+{
+	const char* Begin;
+	const char* End;
+	/* elements declared in this chunk, then the elements declared before it */
+	unsigned int Positions, TexCoords, Normals;
+	unsigned int PositionBase, TexCoordBase, NormalBase;
+	/* three per triangle, polygons are split into fans */
+	std::vector<ObjCorner> Corners;
+	bool HasTexCoords, HasNormals;
+	/* first malformed line, empty when the chunk parsed cleanly */
+	std::string Error;
+};
+
+enum class ObjLine
+{
+	Other, Position, TexCoord, Normal, Face
+};
+
+/* the keyword of a line, p is moved past it */
+static ObjLine ClassifyObjLine(const char*& p, const char* end)
+{
+	p = SkipSpaces(p, end);
+	if (end - p < 2)
+		return ObjLine::Other;
+
+	char first = p[0], second = p[1];
+	bool secondSpace = second == ' ' || second == '\t';
+	if (first == 'v')
+	{
+		if (secondSpace)
+		{
+			p += 1;
+			return ObjLine::Position;
+		}
+		if (end - p >= 3 && (p[2] == ' ' || p[2] == '\t'))
+		{
+			p += 2;
+			return second == 't' ? ObjLine::TexCoord : second == 'n' ? ObjLine::Normal : ObjLine::Other;
+		}
+	}
+	else if (first == 'f' && secondSpace)
+	{
+		p += 1;
+		return ObjLine::Face;
+	}
+	return ObjLine::Other;
+}
+
+static const char* FindLineEnd(const char* p, const char* end)
+{
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	return newline ? newline : end;
+}
+
+static void CountObjChunk(ObjChunk& chunk)
+{
+	chunk.Positions = chunk.TexCoords = chunk.Normals = 0;
+	for (const char* line = chunk.Begin; line < chunk.End; )
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.End);
+		const char* p = line;
+		switch (ClassifyObjLine(p, lineEnd))
+		{
+		case ObjLine::Position: chunk.Positions++; break;
+		case ObjLine::TexCoord: chunk.TexCoords++; break;
+		case ObjLine::Normal: chunk.Normals++; break;
+		default: break;
+		}
+		line = lineEnd + 1;
+	}
+}
+
+/* 1 based index, negative counts back from the elements declared so far. -1 for invalid */
+static inline int ResolveObjIndex(int index, unsigned int declared)
+{
+	if (index > 0)
+		return index - 1;
+	if (index < 0 && (unsigned int)-index <= declared)
+		return (int)declared + index;
+	return -1;
+}
+
+static void ParseObjChunk(ObjChunk& chunk, float* positions, float* texCoords, float* normals)
+{
+	unsigned int position = chunk.PositionBase, texCoord = chunk.TexCoordBase, normal = chunk.NormalBase;
+	chunk.HasTexCoords = chunk.HasNormals = false;
+	std::vector<ObjCorner> polygon;
+
+	for (const char* line = chunk.Begin; line < chunk.End; )
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.End);
+		const char* p = line;
+		bool valid = true;
+
+		switch (ClassifyObjLine(p, lineEnd))
+		{
+		case ObjLine::Position:
+		{
+			float* out = positions + (size_t)position++ * 3;
+			for (int i = 0; i < 3 && valid; i++)
+				valid = (p = ParseFloat(p, lineEnd, out[i])) != nullptr;
+			break;
+		}
+		case ObjLine::TexCoord:
+		{
+			float* out = texCoords + (size_t)texCoord++ * 2;
+			valid = (p = ParseFloat(p, lineEnd, out[0])) != nullptr;
+			/* v may be left out for 1D textures */
+			if (valid && !ParseFloat(p, lineEnd, out[1]))
+				out[1] = 0.0f;
+			break;
+		}
+		case ObjLine::Normal:
+		{
+			float* out = normals + (size_t)normal++ * 3;
+			for (int i = 0; i < 3 && valid; i++)
+				valid = (p = ParseFloat(p, lineEnd, out[i])) != nullptr;
+			break;
+		}
+		case ObjLine::Face:
+		{
+			/* corners are v, v/vt, v//vn or v/vt/vn */
+			polygon.clear();
+			while ((p = SkipSpaces(p, lineEnd)) < lineEnd && valid)
+			{
+				ObjCorner corner = { -1, -1, -1 };
+				int index;
+				valid = (p = ParseInt(p, lineEnd, index)) != nullptr && (corner.Position = ResolveObjIndex(index, position)) >= 0;
+				if (valid && p < lineEnd && *p == '/')
+				{
+					p++;
+					if (p < lineEnd && *p != '/')
+					{
+						valid = (p = ParseInt(p, lineEnd, index)) != nullptr && (corner.TexCoord = ResolveObjIndex(index, texCoord)) >= 0;
+						chunk.HasTexCoords = true;
+					}
+					if (valid && p < lineEnd && *p == '/')
+					{
+						p++;
+						valid = (p = ParseInt(p, lineEnd, index)) != nullptr && (corner.Normal = ResolveObjIndex(index, normal)) >= 0;
+						chunk.HasNormals = true;
+					}
+				}
+				polygon.push_back(corner);
+			}
+
+			valid = valid && polygon.size() >= 3;
+			for (size_t i = 2; valid && i < polygon.size(); i++)
+			{
+				chunk.Corners.push_back(polygon[0]);
+				chunk.Corners.push_back(polygon[i - 1]);
+				chunk.Corners.push_back(polygon[i]);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+
+		if (!valid)
+		{
+			chunk.Error = "malformed line \"" + std::string(line, lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd) + "\"";
+			return;
+		}
+		line = lineEnd + 1;
+	}
+}
+
+bool MeshImporter::ImportOBJ(const std::string& path, MeshData& mesh)
+{
+	auto start = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		std::cout << "Failed to open " << path << std::endl;
+		return false;
+	}
+
+	/* chunks end after a newline so no line is split between two of them */
+	const char* text = (const char*)file.GetData();
+	const char* textEnd = text + file.GetSize();
+	unsigned int chunkCount = m_Jobs && file.GetSize() >= s_MinParallelBytes ? m_Jobs->GetThreadCount() * 4 : 1;
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* chunkBegin = text;
+	for (unsigned int i = 0; i < chunkCount; i++)
+	{
+		const char* chunkEnd = i + 1 == chunkCount ? textEnd : std::max(chunkBegin, text + file.GetSize() / chunkCount * (i + 1));
+		if (chunkEnd < textEnd)
+			chunkEnd = std::min(textEnd, FindLineEnd(chunkEnd, textEnd) + 1);
+		chunks[i].Begin = chunkBegin;
+		chunks[i].End = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	auto forEachChunk = [&](const std::function<void(ObjChunk&)>& function)
+	{
+		if (chunkCount == 1)
+		{
+			function(chunks[0]);
+			return;
+		}
+		JobCounter counter;
+		m_Jobs->ParallelFor(chunkCount, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				function(chunks[i]);
+		}, &counter, 1);
+		m_Jobs->Wait(counter);
+	};
+
+	/* first pass counts elements so the second can write straight to their final place */
+	forEachChunk(CountObjChunk);
+	unsigned int positionCount = 0, texCoordCount = 0, normalCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.PositionBase = positionCount;
+		chunk.TexCoordBase = texCoordCount;
+		chunk.NormalBase = normalCount;
+		positionCount += chunk.Positions;
+		texCoordCount += chunk.TexCoords;
+		normalCount += chunk.Normals;
+	}
+
+	std::vector<float> positions((size_t)positionCount * 3), texCoords((size_t)texCoordCount * 2), normals((size_t)normalCount * 3);
+	forEachChunk([&](ObjChunk& chunk) { ParseObjChunk(chunk, positions.data(), texCoords.data(), normals.data()); });
+
+	bool hasTexCoords = false, hasNormals = false;
+	size_t cornerCount = 0;
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.Error.empty())
+		{
+			std::cout << "Failed to import " << path << ": " << chunk.Error << std::endl;
+			return false;
+		}
+		hasTexCoords = hasTexCoords || chunk.HasTexCoords;
+		hasNormals = hasNormals || chunk.HasNormals;
+		cornerCount += chunk.Corners.size();
+	}
+
+	mesh.Attributes = (unsigned int)MeshAttribute::Position;
+	if (hasNormals)
+		mesh.Attributes |= (unsigned int)MeshAttribute::Normal;
+	if (hasTexCoords)
+		mesh.Attributes |= (unsigned int)MeshAttribute::TexCoord;
+	unsigned int stride = MeshData::GetFloatsPerVertex(mesh.Attributes);
+
+	/* open addressing on the index triple, each distinct corner becomes one vertex */
+	size_t tableSize = 16;
+	while (tableSize < cornerCount * 2)
+		tableSize *= 2;
+	std::vector<unsigned int> table(tableSize, ~0u);
+	std::vector<ObjCorner> unique;
+	unique.reserve(cornerCount / 4);
+	mesh.Indices.clear();
+	mesh.Indices.reserve(cornerCount);
+
+	for (const ObjChunk& chunk : chunks)
+	{
+		for (const ObjCorner& corner : chunk.Corners)
+		{
+			if ((unsigned int)corner.Position >= positionCount || (corner.TexCoord >= 0 && (unsigned int)corner.TexCoord >= texCoordCount)
+				|| (corner.Normal >= 0 && (unsigned int)corner.Normal >= normalCount))
+			{
+				std::cout << "Failed to import " << path << ": face index out of range" << std::endl;
+				return false;
+			}
+
+			size_t slot = ((size_t)corner.Position * 73856093u ^ (size_t)(corner.TexCoord + 1) * 19349663u ^ (size_t)(corner.Normal + 1) * 83492791u) & (tableSize - 1);
+			while (table[slot] != ~0u && !(unique[table[slot]] == corner))
+				slot = (slot + 1) & (tableSize - 1);
+			if (table[slot] == ~0u)
+			{
+				table[slot] = (unsigned int)unique.size();
+				unique.push_back(corner);
+			}
+			mesh.Indices.push_back(table[slot]);
+		}
+	}
+
+	mesh.Vertices.resize(unique.size() * stride);
+	float* out = mesh.Vertices.data();
+	for (const ObjCorner& corner : unique)
+	{
+		memcpy(out, &positions[(size_t)corner.Position * 3], 3 * sizeof(float));
+		out += 3;
+		if (hasNormals)
+		{
+			if (corner.Normal >= 0)
+				memcpy(out, &normals[(size_t)corner.Normal * 3], 3 * sizeof(float));
+			else
+				out[0] = out[1] = out[2] = 0.0f;
+			out += 3;
+		}
+		if (hasTexCoords)
+		{
+			if (corner.TexCoord >= 0)
+				memcpy(out, &texCoords[(size_t)corner.TexCoord * 2], 2 * sizeof(float));
+			else
+				out[0] = out[1] = 0.0f;
+			out += 2;
+		}
+	}
+	mesh.ComputeBounds();
+
+	m_Stats.Vertices = mesh.GetVertexCount();
+	m_Stats.Triangles = (unsigned int)(mesh.Indices.size() / 3);
+	m_Stats.DuplicatesRemoved = (unsigned int)(cornerCount - unique.size());
+	m_Stats.LoadMilliseconds = ElapsedMilliseconds(start);
+	return true;
+}
+
+/* glTF */
+
+/* bytes of one glTF buffer, mapped from a file or decoded from a data uri */
+struct GltfBuffer
+{
+	const unsigned char* Data;
+	unsigned long long Size;
+};
+
+struct GltfDocument
+{
+	JsonValue Json;
+	std::vector<GltfBuffer> Buffers;
+	/* storage behind Buffers */
+	std::vector<std::unique_ptr<MappedFile>> Files;
+	std::vector<std::vector<unsigned char>> Decoded;
+};
+
+/* typed view of an accessor's elements, Data is null for accessors without a buffer view which read as zero */
+struct GltfAccessor
+{
+	const unsigned char* Data;
+	unsigned int Count;
+	unsigned int Components;
+	unsigned int ComponentType;
+	unsigned int Stride;
+	bool Normalized;
+};
+
+static bool DecodeBase64(const char* text, size_t length, std::vector<unsigned char>& out)
+{
+	out.clear();
+	out.reserve(length / 4 * 3);
+	unsigned int bits = 0;
+	int bitCount = 0;
+	for (size_t i = 0; i < length && text[i] != '='; i++)
+	{
+		char c = text[i];
+		int value = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52
+			: c == '+' ? 62 : c == '/' ? 63 : -1;
+		if (value < 0)
+			return false;
+		bits = bits << 6 | (unsigned int)value;
+		bitCount += 6;
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			out.push_back((unsigned char)(bits >> bitCount));
+		}
+	}
+	return true;
+}
+
+static unsigned int GetComponentSize(unsigned int componentType)
+{
+	switch (componentType)
+	{
+	case 5120: case 5121: return 1;
+	case 5122: case 5123: return 2;
+	case 5125: case 5126: return 4;
+	}
+	return 0;
+}
+
+static bool GetAccessor(const GltfDocument& document, const JsonValue* index, GltfAccessor& accessor, std::string& error)
+{
+	const JsonValue* accessors = document.Json.Find("accessors");
+	if (!index || index->Type != JsonType::Number || !accessors || index->Number < 0 || index->Number >= accessors->GetSize())
+	{
+		error = "invalid accessor index";
+		return false;
+	}
+	const JsonValue& json = (*accessors)[(unsigned int)index->Number];
+
+	const std::string& type = json.GetString("type");
+	accessor.Components = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+	accessor.ComponentType = (unsigned int)json.GetNumber("componentType", 0);
+	accessor.Count = (unsigned int)json.GetNumber("count", 0);
+	const JsonValue* normalized = json.Find("normalized");
+	accessor.Normalized = normalized && normalized->Type == JsonType::Bool && normalized->Bool;
+	unsigned int elementSize = accessor.Components * GetComponentSize(accessor.ComponentType);
+	if (elementSize == 0)
+	{
+		error = "unsupported accessor type " + type;
+		return false;
+	}
+	if (json.Find("sparse"))
+	{
+		error = "sparse accessors are not supported";
+		return false;
+	}
+
+	const JsonValue* viewIndex = json.Find("bufferView");
+	const JsonValue* views = document.Json.Find("bufferViews");
+	accessor.Data = nullptr;
+	accessor.Stride = elementSize;
+	if (!viewIndex)
+		return true;
+	if (!views || viewIndex->Number < 0 || viewIndex->Number >= views->GetSize())
+	{
+		error = "invalid buffer view index";
+		return false;
+	}
+
+	const JsonValue& view = (*views)[(unsigned int)viewIndex->Number];
+	double bufferIndex = view.GetNumber("buffer", -1);
+	if (bufferIndex < 0 || bufferIndex >= document.Buffers.size())
+	{
+		error = "invalid buffer index";
+		return false;
+	}
+	const GltfBuffer& buffer = document.Buffers[(size_t)bufferIndex];
+
+	unsigned long long viewOffset = (unsigned long long)view.GetNumber("byteOffset", 0);
+	unsigned long long viewLength = (unsigned long long)view.GetNumber("byteLength", 0);
+	unsigned long long offset = (unsigned long long)json.GetNumber("byteOffset", 0);
+	accessor.Stride = (unsigned int)view.GetNumber("byteStride", elementSize);
+	unsigned long long needed = accessor.Count ? offset + (unsigned long long)accessor.Stride * (accessor.Count - 1) + elementSize : 0;
+	if (viewOffset + viewLength > buffer.Size || needed > viewLength || accessor.Stride < elementSize)
+	{
+		error = "accessor reads outside its buffer";
+		return false;
+	}
+
+	accessor.Data = buffer.Data + viewOffset + offset;
+	return true;
+}
+
+static inline float ReadComponent(const unsigned char* p, unsigned int componentType, bool normalized)
+{
+	switch (componentType)
+	{
+	case 5126:
+	{
+		float value;
+		memcpy(&value, p, 4);
+		return value;
+	}
+	case 5121: return normalized ? *p / 255.0f : (float)*p;
+	case 5120: return normalized ? std::max(*(const signed char*)p / 127.0f, -1.0f) : (float)*(const signed char*)p;
+	case 5123:
+	{
+		unsigned short value;
+		memcpy(&value, p, 2);
+		return normalized ? value / 65535.0f : (float)value;
+	}
+	case 5122:
+	{
+		short value;
+		memcpy(&value, p, 2);
+		return normalized ? std::max(value / 32767.0f, -1.0f) : (float)value;
+	}
+	case 5125:
+	{
+		unsigned int value;
+		memcpy(&value, p, 4);
+		return (float)value;
+	}
+	}
+	return 0.0f;
+}
+
+/* components beyond the accessor's keep what out already holds */
+static inline void ReadElement(const GltfAccessor& accessor, unsigned int element, float* out, unsigned int components)
+{
+	unsigned int count = std::min(components, accessor.Components);
+	if (!accessor.Data)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			out[i] = 0.0f;
+		return;
+	}
+
+	const unsigned char* p = accessor.Data + (size_t)element * accessor.Stride;
+	unsigned int size = GetComponentSize(accessor.ComponentType);
+	for (unsigned int i = 0; i < count; i++)
+		out[i] = ReadComponent(p + i * size, accessor.ComponentType, accessor.Normalized);
+}
+
+static inline unsigned int ReadIndex(const GltfAccessor& accessor, unsigned int element)
+{
+	const unsigned char* p = accessor.Data + (size_t)element * accessor.Stride;
+	switch (accessor.ComponentType)
+	{
+	case 5121: return *p;
+	case 5123:
+	{
+		unsigned short value;
+		memcpy(&value, p, 2);
+		return value;
+	}
+	default:
+	{
+		unsigned int value;
+		memcpy(&value, p, 4);
+		return value;
+	}
+	}
+}
+
+static bool LoadGltfDocument(const std::string& path, GltfDocument& document, std::string& error)
+{
+	std::unique_ptr<MappedFile> file(new MappedFile());
+	if (!file->Open(path))
+	{
+		error = "cannot open file";
+		return false;
+	}
+
+	const unsigned char* data = file->GetData();
+	unsigned long long size = file->GetSize();
+	const char* json = (const char*)data;
+	unsigned long long jsonLength = size;
+	GltfBuffer binary = { nullptr, 0 };
+
+	/* GLB: 12 byte header, a JSON chunk, then an optional binary chunk */
+	if (size >= 12 && memcmp(data, "glTF", 4) == 0)
+	{
+		unsigned int header[3];
+		memcpy(header, data, sizeof(header));
+		unsigned long long offset = 12;
+		json = nullptr;
+		while (offset + 8 <= size && offset + 8 <= header[2])
+		{
+			unsigned int chunk[2];
+			memcpy(chunk, data + offset, sizeof(chunk));
+			if (offset + 8 + chunk[0] > size)
+				break;
+			if (chunk[1] == 0x4e4f534a && !json)
+			{
+				json = (const char*)data + offset + 8;
+				jsonLength = chunk[0];
+			}
+			else if (chunk[1] == 0x004e4942 && !binary.Data)
+			{
+				binary = { data + offset + 8, chunk[0] };
+			}
+			offset += 8 + ((chunk[0] + 3) & ~3u);
+		}
+		if (header[1] != 2 || !json)
+		{
+			error = "not a glTF 2.0 binary";
+			return false;
+		}
+	}
+
+	if (!JsonValue::Parse(json, (size_t)jsonLength, document.Json, error))
+		return false;
+	document.Files.push_back(std::move(file));
+
+	std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+	const JsonValue* buffers = document.Json.Find("buffers");
+	for (unsigned int i = 0; buffers && i < buffers->GetSize(); i++)
+	{
+		const JsonValue& buffer = (*buffers)[i];
+		const std::string& uri = buffer.GetString("uri");
+		unsigned long long byteLength = (unsigned long long)buffer.GetNumber("byteLength", 0);
+
+		GltfBuffer source = { nullptr, 0 };
+		if (uri.empty())
+		{
+			/* the GLB binary chunk, only the first buffer may use it */
+			source = i == 0 ? binary : source;
+		}
+		else if (uri.compare(0, 5, "data:") == 0)
+		{
+			size_t comma = uri.find(";base64,");
+			document.Decoded.emplace_back();
+			if (comma == std::string::npos || !DecodeBase64(uri.c_str() + comma + 8, uri.size() - comma - 8, document.Decoded.back()))
+			{
+				error = "unsupported data uri in buffer " + std::to_string(i);
+				return false;
+			}
+			source = { document.Decoded.back().data(), document.Decoded.back().size() };
+		}
+		else
+		{
+			std::unique_ptr<MappedFile> external(new MappedFile());
+			if (!external->Open(directory + uri))
+			{
+				error = "cannot open buffer " + uri;
+				return false;
+			}
+			source = { external->GetData(), external->GetSize() };
+			document.Files.push_back(std::move(external));
+		}
+
+		if (!source.Data || source.Size < byteLength)
+		{
+			error = "buffer " + std::to_string(i) + " is missing or too short";
+			return false;
+		}
+		document.Buffers.push_back(source);
+	}
+	return true;
+}
+
+static glm::mat4 GetNodeTransform(const JsonValue& node)
+{
+	glm::mat4 transform(1.0f);
+	const JsonValue* matrix = node.Find("matrix");
+	if (matrix && matrix->GetSize() == 16)
+	{
+		/* column major like glm */
+		float* values = glm::value_ptr(transform);
+		for (unsigned int i = 0; i < 16; i++)
+			values[i] = (float)(*matrix)[i].Number;
+		return transform;
+	}
+
+	const JsonValue* translation = node.Find("translation");
+	const JsonValue* rotation = node.Find("rotation");
+	const JsonValue* scale = node.Find("scale");
+	if (translation && translation->GetSize() == 3)
+		transform = glm::translate(transform, glm::vec3((float)(*translation)[0].Number, (float)(*translation)[1].Number, (float)(*translation)[2].Number));
+	if (rotation && rotation->GetSize() == 4)
+	{
+		glm::quat quaternion;
+		quaternion.x = (float)(*rotation)[0].Number;
+		quaternion.y = (float)(*rotation)[1].Number;
+		quaternion.z = (float)(*rotation)[2].Number;
+		quaternion.w = (float)(*rotation)[3].Number;
+		transform = transform * glm::mat4_cast(quaternion);
+	}
+	if (scale && scale->GetSize() == 3)
+		transform = glm::scale(transform, glm::vec3((float)(*scale)[0].Number, (float)(*scale)[1].Number, (float)(*scale)[2].Number));
+	return transform;
+}
+
+/* a mesh placed by a node */
+struct GltfInstance
+{
+	const JsonValue* Mesh;
+	glm::mat4 Transform;
+};
+
+static void CollectGltfNodes(const JsonValue& json, unsigned int nodeIndex, const glm::mat4& parent, int depth, std::vector<GltfInstance>& instances)
+{
+	const JsonValue* nodes = json.Find("nodes");
+	const JsonValue* meshes = json.Find("meshes");
+	/* depth limit guards against cycles in broken files */
+	if (!nodes || nodeIndex >= nodes->GetSize() || depth > 64)
+		return;
+
+	const JsonValue& node = (*nodes)[nodeIndex];
+	glm::mat4 transform = parent * GetNodeTransform(node);
+	double mesh = node.GetNumber("mesh", -1);
+	if (meshes && mesh >= 0 && mesh < meshes->GetSize())
+		instances.push_back({ &(*meshes)[(unsigned int)mesh], transform });
+
+	const JsonValue* children = node.Find("children");
+	for (unsigned int i = 0; children && i < children->GetSize(); i++)
+		CollectGltfNodes(json, (unsigned int)(*children)[i].Number, transform, depth + 1, instances);
+}
+
+bool MeshImporter::ImportGLTF(const std::string& path, MeshData& mesh)
+{
+	auto start = std::chrono::steady_clock::now();
+	GltfDocument document;
+	std::string error;
+	if (!LoadGltfDocument(path, document, error))
+	{
+		std::cout << "Failed to import " << path << ": " << error << std::endl;
+		return false;
+	}
+	const JsonValue& json = document.Json;
+
+	/* the default scene's node trees, or every mesh untransformed when there are no scenes */
+	std::vector<GltfInstance> instances;
+	const JsonValue* scenes = json.Find("scenes");
+	if (scenes && scenes->GetSize() > 0)
+	{
+		double sceneIndex = std::min(std::max(json.GetNumber("scene", 0), 0.0), (double)scenes->GetSize() - 1);
+		const JsonValue* roots = (*scenes)[(unsigned int)sceneIndex].Find("nodes");
+		for (unsigned int i = 0; roots && i < roots->GetSize(); i++)
+			CollectGltfNodes(json, (unsigned int)(*roots)[i].Number, glm::mat4(1.0f), 0, instances);
+	}
+	else if (const JsonValue* meshes = json.Find("meshes"))
+	{
+		for (unsigned int i = 0; i < meshes->GetSize(); i++)
+			instances.push_back({ &(*meshes)[i], glm::mat4(1.0f) });
+	}
+
+	/* first pass settles the attribute set, primitives missing one get a default */
+	struct Primitive
+	{
+		const JsonValue* Json;
+		const glm::mat4* Transform;
+	};
+	std::vector<Primitive> primitives;
+	mesh.Attributes = (unsigned int)MeshAttribute::Position;
+	unsigned int skipped = 0;
+	for (const GltfInstance& instance : instances)
+	{
+		const JsonValue* list = instance.Mesh->Find("primitives");
+		for (unsigned int i = 0; list && i < list->GetSize(); i++)
+		{
+			const JsonValue& primitive = (*list)[i];
+			const JsonValue* attributes = primitive.Find("attributes");
+			if (primitive.GetNumber("mode", 4) != 4 || !attributes || !attributes->Find("POSITION"))
+			{
+				skipped++;
+				continue;
+			}
+			if (attributes->Find("NORMAL"))
+				mesh.Attributes |= (unsigned int)MeshAttribute::Normal;
+			if (attributes->Find("TEXCOORD_0"))
+				mesh.Attributes |= (unsigned int)MeshAttribute::TexCoord;
+			if (attributes->Find("COLOR_0"))
+				mesh.Attributes |= (unsigned int)MeshAttribute::Color;
+			primitives.push_back({ &primitive, &instance.Transform });
+		}
+	}
+	if (skipped)
+		std::cout << "Skipped " << skipped << " glTF primitives that are not triangle lists in " << path << std::endl;
+
+	unsigned int stride = MeshData::GetFloatsPerVertex(mesh.Attributes);
+	unsigned int normalOffset = mesh.Has(MeshAttribute::Normal) ? MeshData::GetOffset(mesh.Attributes, MeshAttribute::Normal) : 0;
+	unsigned int texCoordOffset = mesh.Has(MeshAttribute::TexCoord) ? MeshData::GetOffset(mesh.Attributes, MeshAttribute::TexCoord) : 0;
+	unsigned int colorOffset = mesh.Has(MeshAttribute::Color) ? MeshData::GetOffset(mesh.Attributes, MeshAttribute::Color) : 0;
+	mesh.Vertices.clear();
+	mesh.Indices.clear();
+
+	for (const Primitive& primitive : primitives)
+	{
+		const JsonValue& attributes = *primitive.Json->Find("attributes");
+		GltfAccessor positions, normals = {}, texCoords = {}, colors = {}, indices = {};
+		bool valid = GetAccessor(document, attributes.Find("POSITION"), positions, error) && positions.Components == 3;
+		bool hasNormals = valid && attributes.Find("NORMAL");
+		bool hasTexCoords = valid && attributes.Find("TEXCOORD_0");
+		bool hasColors = valid && attributes.Find("COLOR_0");
+		bool hasIndices = valid && primitive.Json->Find("indices");
+		valid = valid && (!hasNormals || GetAccessor(document, attributes.Find("NORMAL"), normals, error))
+			&& (!hasTexCoords || GetAccessor(document, attributes.Find("TEXCOORD_0"), texCoords, error))
+			&& (!hasColors || GetAccessor(document, attributes.Find("COLOR_0"), colors, error))
+			&& (!hasIndices || GetAccessor(document, primitive.Json->Find("indices"), indices, error));
+		/* every attribute needs an element per vertex */
+		valid = valid && (!hasNormals || normals.Count >= positions.Count) && (!hasTexCoords || texCoords.Count >= positions.Count)
+			&& (!hasColors || colors.Count >= positions.Count) && (!hasIndices || indices.Data);
+		if (!valid)
+		{
+			std::cout << "Failed to import " << path << ": " << (error.empty() ? "attribute counts do not match" : error) << std::endl;
+			return false;
+		}
+
+		const glm::mat4& transform = *primitive.Transform;
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		unsigned int base = mesh.GetVertexCount();
+		mesh.Vertices.resize((size_t)(base + positions.Count) * stride);
+
+		for (unsigned int vertex = 0; vertex < positions.Count; vertex++)
+		{
+			float* out = &mesh.Vertices[(size_t)(base + vertex) * stride];
+			glm::vec3 position;
+			ReadElement(positions, vertex, &position.x, 3);
+			position = glm::vec3(transform * glm::vec4(position, 1.0f));
+			out[0] = position.x;
+			out[1] = position.y;
+			out[2] = position.z;
+
+			if (mesh.Has(MeshAttribute::Normal))
+			{
+				glm::vec3 normal(0.0f);
+				if (hasNormals)
+				{
+					ReadElement(normals, vertex, &normal.x, 3);
+					normal = normalMatrix * normal;
+					float length = glm::length(normal);
+					if (length > 0.0f)
+						normal /= length;
+				}
+				memcpy(out + normalOffset, &normal.x, 3 * sizeof(float));
+			}
+			if (mesh.Has(MeshAttribute::TexCoord))
+			{
+				/* glTF puts v = 0 at the top of the image */
+				float texCoord[2] = { 0.0f, 0.0f };
+				if (hasTexCoords)
+					ReadElement(texCoords, vertex, texCoord, 2);
+				out[texCoordOffset] = texCoord[0];
+				out[texCoordOffset + 1] = 1.0f - texCoord[1];
+			}
+			if (mesh.Has(MeshAttribute::Color))
+			{
+				float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+				if (hasColors)
+					ReadElement(colors, vertex, color, 4);
+				memcpy(out + colorOffset, color, 4 * sizeof(float));
+			}
+		}
+
+		/* a mirroring transform turns the triangles inside out, swap two corners to keep them front facing */
+		bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+		unsigned int indexCount = hasIndices ? indices.Count : positions.Count;
+		indexCount -= indexCount % 3;
+		size_t firstIndex = mesh.Indices.size();
+		mesh.Indices.resize(firstIndex + indexCount);
+		for (unsigned int i = 0; i < indexCount; i++)
+		{
+			unsigned int index = hasIndices ? ReadIndex(indices, i) : i;
+			if (index >= positions.Count)
+			{
+				std::cout << "Failed to import " << path << ": index out of range" << std::endl;
+				return false;
+			}
+			unsigned int corner = !mirrored || i % 3 == 0 ? i : i % 3 == 1 ? i + 1 : i - 1;
+			mesh.Indices[firstIndex + corner] = base + index;
+		}
+	}
+
+	unsigned int duplicates = mesh.RemoveDuplicateVertices();
+	mesh.ComputeBounds();
+
+	m_Stats.Vertices = mesh.GetVertexCount();
+	m_Stats.Triangles = (unsigned int)(mesh.Indices.size() / 3);
+	m_Stats.DuplicatesRemoved = duplicates;
+	m_Stats.LoadMilliseconds = ElapsedMilliseconds(start);
+	return true;
+}
+
+/* MeshImporter */
+
+MeshImporter::MeshImporter(JobSystem* jobs)
+	: m_Jobs(jobs), m_Stats()
+{
+}
+
+bool MeshImporter::Import(const std::string& path, MeshData& mesh)
+{
+	std::string extension = path.substr(path.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+
+	if (extension == "obj")
+		return ImportOBJ(path, mesh);
+	if (extension == "gltf" || extension == "glb")
+		return ImportGLTF(path, mesh);
+
+	std::cout << "Unknown mesh format " << path << std::endl;
+	return false;
+}
+
+bool MeshImporter::WriteCache(const std::string& cachePath, const MeshData& mesh, const std::vector<float>& lodErrors,
+	unsigned long long sourceSize, unsigned long long sourceTime)
+{
+	std::ofstream stream(cachePath, std::ios::binary);
+	if (!stream)
+	{
+		std::cout << "Failed to open " << cachePath << " for writing" << std::endl;
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	memcpy(header.Magic, s_CacheMagic, 4);
+	header.Version = s_CacheVersion;
+	header.Attributes = mesh.Attributes;
+	header.VertexCount = mesh.GetVertexCount();
+	header.IndexCount = (unsigned int)mesh.Indices.size();
+	memcpy(header.BoundsMin, &mesh.Bounds.Min.x, sizeof(header.BoundsMin));
+	memcpy(header.BoundsMax, &mesh.Bounds.Max.x, sizeof(header.BoundsMax));
+	header.LodCount = (unsigned int)mesh.Lods.size();
+	header.LodErrorCount = (unsigned int)lodErrors.size();
+	header.SourceSize = sourceSize;
+	header.SourceTime = sourceTime;
+
+	stream.write((const char*)&header, sizeof(header));
+	stream.write((const char*)mesh.Vertices.data(), mesh.Vertices.size() * sizeof(float));
+	stream.write((const char*)mesh.Indices.data(), mesh.Indices.size() * sizeof(unsigned int));
+	stream.write((const char*)mesh.Lods.data(), mesh.Lods.size() * sizeof(MeshLod));
+	stream.write((const char*)lodErrors.data(), lodErrors.size() * sizeof(float));
+	return (bool)stream;
+}
+
+std::unique_ptr<Mesh> MeshImporter::Load(const std::string& path)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_Stats = MeshImportStats();
+
+	std::string cachePath = path + ".mesh";
+	unsigned long long sourceSize = 0, sourceTime = 0;
+	bool hasSource = MappedFile::GetStamp(path, sourceSize, sourceTime);
+
+	/* a cache without its source is still used, so a build can ship caches only */
+	MappedFile cache;
+	if (cache.Open(cachePath) && cache.GetSize() >= sizeof(MeshCacheHeader))
+	{
+		MeshCacheHeader header;
+		memcpy(&header, cache.GetData(), sizeof(header));
+		unsigned long long floats = (unsigned long long)header.VertexCount * MeshData::GetFloatsPerVertex(header.Attributes);
+		unsigned long long size = sizeof(header) + floats * sizeof(float) + (unsigned long long)header.IndexCount * sizeof(unsigned int)
+			+ (unsigned long long)header.LodCount * sizeof(MeshLod) + (unsigned long long)header.LodErrorCount * sizeof(float);
+		bool current = memcmp(header.Magic, s_CacheMagic, 4) == 0 && header.Version == s_CacheVersion && cache.GetSize() == size
+			&& (!hasSource || (header.SourceSize == sourceSize && header.SourceTime == sourceTime));
+
+		/* levels built for other errors are rebuilt as long as the source is there to build them from */
+		if (current && hasSource)
+		{
+			const float* lodErrors = (const float*)(cache.GetData() + (size - header.LodErrorCount * sizeof(float)));
+			current = header.LodErrorCount == m_LodErrors.size()
+				&& (m_LodErrors.empty() || memcmp(lodErrors, m_LodErrors.data(), m_LodErrors.size() * sizeof(float)) == 0);
+		}
+
+		if (current)
+		{
+			const float* vertices = (const float*)(cache.GetData() + sizeof(header));
+			const unsigned int* indices = (const unsigned int*)(vertices + floats);
+			const MeshLod* lods = (const MeshLod*)(indices + header.IndexCount);
+			AABB bounds(glm::vec3(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]),
+				glm::vec3(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2]));
+			m_Stats.LoadMilliseconds = ElapsedMilliseconds(start);
+
+			auto upload = std::chrono::steady_clock::now();
+			std::unique_ptr<Mesh> mesh(new Mesh(vertices, header.VertexCount, indices, header.IndexCount, header.Attributes, bounds,
+				lods, header.LodCount));
+			m_Stats.UploadMilliseconds = ElapsedMilliseconds(upload);
+			m_Stats.FromCache = true;
+			m_Stats.Vertices = header.VertexCount;
+			m_Stats.Triangles = mesh->GetLod(0).IndexCount / 3;
+			m_Stats.LodCount = mesh->GetLodCount();
+			return mesh;
+		}
+		cache.Close();
+	}
+
+	if (!hasSource)
+	{
+		std::cout << "Mesh " << path << " not found" << std::endl;
+		return nullptr;
+	}
+
+	MeshData data;
+	if (!Import(path, data))
+		return nullptr;
+
+	if (!m_LodErrors.empty())
+	{
+		auto simplify = std::chrono::steady_clock::now();
+		MeshSimplifier::BuildLods(data, m_LodErrors);
+		m_Stats.LodMilliseconds = ElapsedMilliseconds(simplify);
+	}
+	m_Stats.LodCount = data.Lods.empty() ? 1 : (unsigned int)data.Lods.size();
+	WriteCache(cachePath, data, m_LodErrors, sourceSize, sourceTime);
+
+	auto upload = std::chrono::steady_clock::now();
+	std::unique_ptr<Mesh> mesh(new Mesh(data));
+	m_Stats.UploadMilliseconds = ElapsedMilliseconds(upload);
+	return mesh;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+class JobSystem;
+
+/* What the last Load or Import call did */
+struct MeshImportStats
+{
+	bool FromCache;
+	unsigned int Vertices;
+	unsigned int Triangles;
+	/* vertices merged away because they were exact duplicates */
+	unsigned int DuplicatesRemoved;
+	/* reading and parsing the source, or mapping the cache */
+	float LoadMilliseconds;
+	/* creating the GL buffers */
+	float UploadMilliseconds;
+	/* levels of detail including the full mesh, and the time spent simplifying when they were built */
+	unsigned int LodCount;
+	float LodMilliseconds;
+};
+
+/*
+* Imports OBJ and glTF 2.0 (.gltf and .glb) into one mesh per file
+* Every triangle of the file is merged into a single MeshData, node
+* transforms of glTF scenes are applied. Materials are not imported.
+*
+* OBJ files are split into chunks parsed in parallel on the job system. A
+* first pass counts the v, vt and vn lines of each chunk so every chunk knows
+* where its elements land, relative indices included, and writes straight
+* into the shared arrays. Corners are deduplicated on their index triple.
+*
+* glTF buffers are memory mapped, accessors are read from the mapped bytes
+* into the interleaved vertices without intermediate copies. Equal vertices
+* of different primitives are welded by hashing.
+*
+* Load keeps a binary cache next to the source, path + ".mesh". When the
+* cache's version and the source's size and modification time match it is
+* memory mapped and uploaded straight into the GL buffers. With LOD errors
+* set, Load builds the levels of detail after importing and caches them too,
+* a cache built for other errors is rebuilt.
+*/
+class MeshImporter
+{
+public:
+	static const unsigned int s_CacheVersion = 2;
+
+private:
+	JobSystem* m_Jobs;
+	std::vector<float> m_LodErrors;
+	MeshImportStats m_Stats;
+public:
+	/* jobs may be null, OBJ files are then parsed on the calling thread */
+	MeshImporter(JobSystem* jobs = nullptr);
+
+	/* GL thread. Null when neither the cache nor the source can be loaded */
+	std::unique_ptr<Mesh> Load(const std::string& path);
+
+	/* Picks the format from the extension, any thread */
+	bool Import(const std::string& path, MeshData& mesh);
+	bool ImportOBJ(const std::string& path, MeshData& mesh);
+	bool ImportGLTF(const std::string& path, MeshData& mesh);
+
+	/* target errors of the levels Load builds, see MeshSimplifier, empty for none */
+	inline void SetLodErrors(const std::vector<float>& errors) { m_LodErrors = errors; }
+	inline const MeshImportStats& GetStats() const { return m_Stats; }
+
+	/* lodErrors are the targets the levels in mesh were built for */
+	static bool WriteCache(const std::string& cachePath, const MeshData& mesh, const std::vector<float>& lodErrors,
+		unsigned long long sourceSize, unsigned long long sourceTime);
+};
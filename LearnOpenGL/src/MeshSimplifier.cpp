@@ -0,0 +1,467 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+/* open edges weigh more than faces so borders and seams hold their shape */
+static const float s_BorderWeight = 10.0f;
+
+/*
+* Whether an edge between two kinds is shared by two triangles, in position
+* space for seams. Such edges show up twice and are only picked once.
+* Order: Manifold, Border, Seam, Locked
+*/
+static const bool s_HasOpposite[4][4] = {
+	{ true, true, true, true },
+	{ true, false, true, false },
+	{ true, true, true, true },
+	{ true, false, true, false }
+};
+
+static size_t HashPosition(const glm::vec3& position)
+{
+	unsigned int bits[3];
+	for (int i = 0; i < 3; i++)
+	{
+		/* -0 and 0 compare equal, so they have to hash equal */
+		float component = position[i] == 0.0f ? 0.0f : position[i];
+		memcpy(&bits[i], &component, sizeof(float));
+	}
+	return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+}
+
+MeshSimplifier::MeshSimplifier(const MeshData& mesh)
+	: m_VertexCount(mesh.GetVertexCount()), m_Indices(mesh.Indices), m_Error(0.0f)
+{
+	unsigned int stride = MeshData::GetFloatsPerVertex(mesh.Attributes);
+	unsigned int offset = MeshData::GetOffset(mesh.Attributes, MeshAttribute::Position);
+	glm::vec3 center = mesh.Bounds.GetCenter();
+	float radius = glm::length(mesh.Bounds.GetExtents());
+	float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+
+	m_Positions.resize(m_VertexCount);
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+	{
+		const float* position = &mesh.Vertices[(size_t)vertex * stride + offset];
+		m_Positions[vertex] = (glm::vec3(position[0], position[1], position[2]) - center) * scale;
+	}
+
+	std::vector<bool> openCorners;
+	BuildPositionRemap();
+	ClassifyVertices(openCorners);
+	ComputeQuadrics(openCorners);
+}
+
+void MeshSimplifier::BuildPositionRemap()
+{
+	auto hash = [&](unsigned int vertex) { return HashPosition(m_Positions[vertex]); };
+	auto equal = [&](unsigned int a, unsigned int b) { return m_Positions[a] == m_Positions[b]; };
+	std::unordered_map<unsigned int, unsigned int, decltype(hash), decltype(equal)> first(m_VertexCount, hash, equal);
+
+	m_Remap.resize(m_VertexCount);
+	m_Wedge.resize(m_VertexCount);
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+	{
+		unsigned int remap = first.emplace(vertex, vertex).first->second;
+		m_Remap[vertex] = remap;
+		/* link into the ring of the first vertex */
+		m_Wedge[vertex] = vertex;
+		if (remap != vertex)
+		{
+			m_Wedge[vertex] = m_Wedge[remap];
+			m_Wedge[remap] = vertex;
+		}
+	}
+}
+
+void MeshSimplifier::ClassifyVertices(std::vector<bool>& openCorners)
+{
+	/* outgoing half edges of every vertex */
+	std::vector<unsigned int> offsets(m_VertexCount + 1, 0);
+	std::vector<unsigned int> targets(m_Indices.size());
+	for (unsigned int index : m_Indices)
+		offsets[index + 1]++;
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+		offsets[vertex + 1] += offsets[vertex];
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t corner = 0; corner < m_Indices.size(); corner++)
+	{
+		size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+		targets[fill[m_Indices[corner]]++] = m_Indices[next];
+	}
+
+	auto hasEdge = [&](unsigned int from, unsigned int to)
+	{
+		for (unsigned int i = offsets[from]; i < offsets[from + 1]; i++)
+		{
+			if (targets[i] == to)
+				return true;
+		}
+		return false;
+	};
+
+	/* a vertex with more than one open edge either way points at itself */
+	m_Loop.assign(m_VertexCount, ~0u);
+	m_LoopBack.assign(m_VertexCount, ~0u);
+	openCorners.assign(m_Indices.size(), false);
+	for (size_t corner = 0; corner < m_Indices.size(); corner++)
+	{
+		unsigned int from = m_Indices[corner];
+		unsigned int to = m_Indices[corner % 3 == 2 ? corner - 2 : corner + 1];
+		if (hasEdge(to, from))
+			continue;
+
+		openCorners[corner] = true;
+		m_Loop[from] = m_Loop[from] == ~0u ? to : from;
+		m_LoopBack[to] = m_LoopBack[to] == ~0u ? from : to;
+	}
+
+	m_Kinds.assign(m_VertexCount, VertexKind::Locked);
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+	{
+		if (m_Remap[vertex] != vertex)
+			continue;
+
+		VertexKind kind = VertexKind::Locked;
+		unsigned int wedge = m_Wedge[vertex];
+		if (wedge == vertex)
+		{
+			unsigned int in = m_LoopBack[vertex], out = m_Loop[vertex];
+			if (in == ~0u && out == ~0u)
+				kind = VertexKind::Manifold;
+			else if (in != ~0u && out != ~0u && in != vertex && out != vertex)
+				kind = VertexKind::Border;
+		}
+		else if (m_Wedge[wedge] == vertex)
+		{
+			/* two wedges whose open edges run along the same positions in opposite directions */
+			unsigned int in = m_LoopBack[vertex], out = m_Loop[vertex];
+			unsigned int otherIn = m_LoopBack[wedge], otherOut = m_Loop[wedge];
+			bool single = in != ~0u && out != ~0u && in != vertex && out != vertex
+				&& otherIn != ~0u && otherOut != ~0u && otherIn != wedge && otherOut != wedge;
+			if (single && m_Remap[in] == m_Remap[otherOut] && m_Remap[out] == m_Remap[otherIn] && m_Remap[in] != m_Remap[out])
+				kind = VertexKind::Seam;
+		}
+
+		unsigned int each = vertex;
+		do
+		{
+			m_Kinds[each] = kind;
+			each = m_Wedge[each];
+		} while (each != vertex);
+	}
+}
+
+void MeshSimplifier::ComputeQuadrics(const std::vector<bool>& openCorners)
+{
+	m_Quadrics.assign(m_VertexCount, Quadric());
+	for (size_t triangle = 0; triangle < m_Indices.size() / 3; triangle++)
+	{
+		const unsigned int* corners = &m_Indices[triangle * 3];
+		const glm::vec3& p0 = m_Positions[corners[0]];
+		const glm::vec3& p1 = m_Positions[corners[1]];
+		const glm::vec3& p2 = m_Positions[corners[2]];
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+		normal /= length;
+
+		Quadric face = MakePlaneQuadric(normal, -glm::dot(normal, p0), length * 0.5f);
+		for (int corner = 0; corner < 3; corner++)
+			AddQuadric(m_Quadrics[m_Remap[corners[corner]]], face);
+
+		/* a plane through each open edge standing up from the face keeps the edge from sliding sideways */
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (!openCorners[triangle * 3 + corner])
+				continue;
+
+			unsigned int from = corners[corner], to = corners[(corner + 1) % 3];
+			glm::vec3 edge = m_Positions[to] - m_Positions[from];
+			float edgeLength = glm::length(edge);
+			if (edgeLength == 0.0f)
+				continue;
+
+			glm::vec3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+			Quadric border = MakePlaneQuadric(edgeNormal, -glm::dot(edgeNormal, m_Positions[from]), edgeLength * edgeLength * s_BorderWeight);
+			AddQuadric(m_Quadrics[m_Remap[from]], border);
+			AddQuadric(m_Quadrics[m_Remap[to]], border);
+		}
+	}
+}
+
+void MeshSimplifier::BuildTriangleAdjacency()
+{
+	m_TriangleOffsets.assign(m_VertexCount + 1, 0);
+	m_Triangles.resize(m_Indices.size());
+	for (unsigned int index : m_Indices)
+		m_TriangleOffsets[index + 1]++;
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+		m_TriangleOffsets[vertex + 1] += m_TriangleOffsets[vertex];
+
+	std::vector<unsigned int> fill(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+	for (size_t corner = 0; corner < m_Indices.size(); corner++)
+		m_Triangles[fill[m_Indices[corner]]++] = (unsigned int)(corner / 3);
+}
+
+bool MeshSimplifier::CanCollapse(unsigned int from, unsigned int to) const
+{
+	VertexKind target = m_Kinds[to];
+	bool alongLoop = m_Loop[from] == to || m_LoopBack[from] == to;
+	switch (m_Kinds[from])
+	{
+	case VertexKind::Manifold:
+		return true;
+	case VertexKind::Border:
+		return alongLoop && (target == VertexKind::Border || target == VertexKind::Locked);
+	case VertexKind::Seam:
+		return alongLoop && (target == VertexKind::Seam || target == VertexKind::Locked);
+	default:
+		return false;
+	}
+}
+
+float MeshSimplifier::GetCollapseError(unsigned int from, unsigned int to) const
+{
+	Quadric quadric = m_Quadrics[m_Remap[from]];
+	AddQuadric(quadric, m_Quadrics[m_Remap[to]]);
+	if (quadric.W <= 0.0f)
+		return 0.0f;
+	/* the weights are areas, dividing by them gives a mean squared distance */
+	return std::sqrt(EvaluateQuadric(quadric, m_Positions[to]) / quadric.W);
+}
+
+bool MeshSimplifier::HasTriangleFlips(unsigned int from, unsigned int to, const std::vector<unsigned int>& collapseRemap) const
+{
+	unsigned int fromPosition = m_Remap[from], toPosition = m_Remap[to];
+	const glm::vec3& target = m_Positions[to];
+
+	/* every wedge of the position moves, both sides of a seam */
+	unsigned int wedge = from;
+	do
+	{
+		for (unsigned int i = m_TriangleOffsets[wedge]; i < m_TriangleOffsets[wedge + 1]; i++)
+		{
+			const unsigned int* corners = &m_Indices[(size_t)m_Triangles[i] * 3];
+			glm::vec3 before[3], after[3];
+			bool removed = false;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = collapseRemap[corners[corner]];
+				removed = removed || m_Remap[vertex] == toPosition;
+				before[corner] = m_Positions[vertex];
+				after[corner] = m_Remap[vertex] == fromPosition ? target : before[corner];
+			}
+			/* triangles on the collapsed edge go away */
+			if (removed)
+				continue;
+
+			glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			/* turning more than about 75 degrees counts too, that is where slivers come from */
+			if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+				return true;
+		}
+		wedge = m_Wedge[wedge];
+	} while (wedge != from);
+
+	return false;
+}
+
+void MeshSimplifier::PickCollapses(std::vector<Collapse>& collapses, float targetError) const
+{
+	collapses.clear();
+	for (size_t corner = 0; corner < m_Indices.size(); corner++)
+	{
+		unsigned int a = m_Indices[corner];
+		unsigned int b = m_Indices[corner % 3 == 2 ? corner - 2 : corner + 1];
+
+		bool forward = CanCollapse(a, b), backward = CanCollapse(b, a);
+		if (!forward && !backward)
+			continue;
+		if (s_HasOpposite[(int)m_Kinds[a]][(int)m_Kinds[b]] && m_Remap[b] > m_Remap[a])
+			continue;
+
+		Collapse collapse = { a, b, 0.0f };
+		if (forward && backward)
+		{
+			float there = GetCollapseError(a, b), back = GetCollapseError(b, a);
+			collapse = there <= back ? Collapse{ a, b, there } : Collapse{ b, a, back };
+		}
+		else
+		{
+			collapse = forward ? Collapse{ a, b, 0.0f } : Collapse{ b, a, 0.0f };
+			collapse.Error = GetCollapseError(collapse.From, collapse.To);
+		}
+
+		if (collapse.Error <= targetError)
+			collapses.push_back(collapse);
+	}
+}
+
+unsigned int MeshSimplifier::PerformCollapses(std::vector<Collapse>& collapses, float targetError)
+{
+	if (collapses.empty())
+		return 0;
+
+	std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Error < b.Error; });
+	/* a pass takes the cheap end of the list so the error grows evenly over the surface */
+	float passLimit = std::min(collapses[collapses.size() / 3].Error * 1.5f, targetError);
+
+	std::vector<unsigned int> collapseRemap(m_VertexCount);
+	for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+		collapseRemap[vertex] = vertex;
+	/* by position, both ends of a collapse wait for the next pass */
+	std::vector<bool> locked(m_VertexCount, false);
+
+	unsigned int performed = 0;
+	for (const Collapse& collapse : collapses)
+	{
+		/* past the limit only while nothing cheaper went through, so flips cannot stall the pass */
+		if (collapse.Error > passLimit && performed > 0)
+			break;
+
+		unsigned int fromPosition = m_Remap[collapse.From], toPosition = m_Remap[collapse.To];
+		if (locked[fromPosition] || locked[toPosition])
+			continue;
+		if (HasTriangleFlips(collapse.From, collapse.To, collapseRemap))
+			continue;
+
+		if (m_Kinds[collapse.From] == VertexKind::Seam)
+		{
+			/* the other side of the seam follows the same edge in the opposite direction */
+			unsigned int side = m_Wedge[collapse.From];
+			unsigned int sideTarget = m_Loop[collapse.From] == collapse.To ? m_LoopBack[side] : m_Loop[side];
+			if (sideTarget == ~0u || m_Remap[sideTarget] != toPosition)
+				continue;
+			collapseRemap[side] = sideTarget;
+		}
+		collapseRemap[collapse.From] = collapse.To;
+
+		AddQuadric(m_Quadrics[toPosition], m_Quadrics[fromPosition]);
+		locked[fromPosition] = true;
+		locked[toPosition] = true;
+		m_Error = std::max(m_Error, collapse.Error);
+		performed++;
+	}
+
+	/* collapsed edges leave degenerate triangles behind */
+	size_t kept = 0;
+	for (size_t triangle = 0; triangle < m_Indices.size() / 3; triangle++)
+	{
+		unsigned int a = collapseRemap[m_Indices[triangle * 3 + 0]];
+		unsigned int b = collapseRemap[m_Indices[triangle * 3 + 1]];
+		unsigned int c = collapseRemap[m_Indices[triangle * 3 + 2]];
+		if (m_Remap[a] == m_Remap[b] || m_Remap[b] == m_Remap[c] || m_Remap[c] == m_Remap[a])
+			continue;
+		m_Indices[kept++] = a;
+		m_Indices[kept++] = b;
+		m_Indices[kept++] = c;
+	}
+	m_Indices.resize(kept);
+
+	/* loops that ran into a collapsed vertex continue at its target, or past it when the target is the vertex itself */
+	for (std::vector<unsigned int>* loop : { &m_Loop, &m_LoopBack })
+	{
+		std::vector<unsigned int>& next = *loop;
+		for (unsigned int vertex = 0; vertex < m_VertexCount; vertex++)
+		{
+			if (next[vertex] == ~0u)
+				continue;
+			unsigned int target = next[vertex];
+			unsigned int remapped = collapseRemap[target];
+			next[vertex] = remapped == vertex ? next[target] : remapped;
+		}
+	}
+
+	return performed;
+}
+
+void MeshSimplifier::Simplify(float targetError, std::vector<unsigned int>& indices)
+{
+	std::vector<Collapse> collapses;
+	for (;;)
+	{
+		BuildTriangleAdjacency();
+		PickCollapses(collapses, targetError);
+		if (PerformCollapses(collapses, targetError) == 0)
+			break;
+	}
+	indices = m_Indices;
+}
+
+unsigned int MeshSimplifier::BuildLods(MeshData& mesh, const std::vector<float>& targetErrors)
+{
+	/* start over from the full mesh */
+	if (!mesh.Lods.empty())
+		mesh.Indices.resize(mesh.Lods[0].IndexCount);
+	mesh.Lods.clear();
+	mesh.Lods.push_back({ 0, (unsigned int)mesh.Indices.size(), 0.0f });
+	if (!mesh.Has(MeshAttribute::Position) || mesh.Indices.empty())
+		return 1;
+
+	std::vector<float> targets = targetErrors;
+	std::sort(targets.begin(), targets.end());
+
+	MeshSimplifier simplifier(mesh);
+	std::vector<unsigned int> indices;
+	for (float target : targets)
+	{
+		simplifier.Simplify(target, indices);
+		if (indices.empty())
+			break;
+		if (indices.size() * 6 > (size_t)mesh.Lods.back().IndexCount * 5)
+			continue;
+
+		mesh.Lods.push_back({ (unsigned int)mesh.Indices.size(), (unsigned int)indices.size(), simplifier.GetError() });
+		mesh.Indices.insert(mesh.Indices.end(), indices.begin(), indices.end());
+	}
+	return (unsigned int)mesh.Lods.size();
+}
+
+MeshSimplifier::Quadric MeshSimplifier::MakePlaneQuadric(const glm::vec3& normal, float distance, float weight)
+{
+	Quadric quadric;
+	quadric.A00 = normal.x * normal.x * weight;
+	quadric.A11 = normal.y * normal.y * weight;
+	quadric.A22 = normal.z * normal.z * weight;
+	quadric.A10 = normal.y * normal.x * weight;
+	quadric.A20 = normal.z * normal.x * weight;
+	quadric.A21 = normal.z * normal.y * weight;
+	quadric.B0 = normal.x * distance * weight;
+	quadric.B1 = normal.y * distance * weight;
+	quadric.B2 = normal.z * distance * weight;
+	quadric.C = distance * distance * weight;
+	quadric.W = weight;
+	return quadric;
+}
+
+void MeshSimplifier::AddQuadric(Quadric& target, const Quadric& source)
+{
+	target.A00 += source.A00;
+	target.A11 += source.A11;
+	target.A22 += source.A22;
+	target.A10 += source.A10;
+	target.A20 += source.A20;
+	target.A21 += source.A21;
+	target.B0 += source.B0;
+	target.B1 += source.B1;
+	target.B2 += source.B2;
+	target.C += source.C;
+	target.W += source.W;
+}
+
+float MeshSimplifier::EvaluateQuadric(const Quadric& quadric, const glm::vec3& position)
+{
+	float x = position.x, y = position.y, z = position.z;
+	float rx = quadric.A00 * x + quadric.A10 * y + quadric.A20 * z;
+	float ry = quadric.A10 * x + quadric.A11 * y + quadric.A21 * z;
+	float rz = quadric.A20 * x + quadric.A21 * y + quadric.A22 * z;
+	float error = rx * x + ry * y + rz * z + 2.0f * (quadric.B0 * x + quadric.B1 * y + quadric.B2 * z) + quadric.C;
+	/* rounding can take a sum of squares slightly below zero */
+	return std::abs(error);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Mesh.h"
+
+/*
+* Quadric error metric edge collapse (Garland and Heckbert)
+* A collapse moves one end of an edge onto the other, no vertex is ever
+* created or moved, so every level indexes the original vertices and keeps
+* their attributes exact. Vertices sharing a position but differing in other
+* attributes form a seam: seam and open border vertices only collapse along
+* their seam or border onto another vertex of it, so UV islands and hard
+* normal edges keep their outline, everything else is locked.
+*
+* Errors are distances relative to the bounding sphere radius of the mesh,
+* 0.01 means one percent of the radius.
+*/
+class MeshSimplifier
+{
+private:
+	enum class VertexKind : unsigned char
+	{
+		/* closed fan, no seams */
+		Manifold,
+		/* on an open edge of the surface */
+		Border,
+		/* one of two vertices sharing a position along an attribute seam */
+		Seam,
+		/* corners, seam crossings and anything non manifold */
+		Locked
+	};
+
+	/* symmetric 4x4 quadric and the weight it was built with */
+	struct Quadric
+	{
+		float A00, A11, A22, A10, A20, A21;
+		float B0, B1, B2;
+		float C;
+		float W;
+	};
+
+	struct Collapse
+	{
+		unsigned int From, To;
+		float Error;
+	};
+
+	unsigned int m_VertexCount;
+	/* moved and scaled so the bounding sphere is the unit sphere */
+	std::vector<glm::vec3> m_Positions;
+	/* first vertex with the same position */
+	std::vector<unsigned int> m_Remap;
+	/* next vertex with the same position, a ring */
+	std::vector<unsigned int> m_Wedge;
+	std::vector<VertexKind> m_Kinds;
+	/* the open edge leaving and entering each border or seam vertex, ~0 when there is none */
+	std::vector<unsigned int> m_Loop;
+	std::vector<unsigned int> m_LoopBack;
+	/* indexed by m_Remap, one per position */
+	std::vector<Quadric> m_Quadrics;
+	std::vector<unsigned int> m_Indices;
+	/* triangles around each vertex, rebuilt every pass */
+	std::vector<unsigned int> m_TriangleOffsets;
+	std::vector<unsigned int> m_Triangles;
+	float m_Error;
+public:
+	MeshSimplifier(const MeshData& mesh);
+
+	/*
+	* Collapses edges until every remaining collapse would cost more than
+	* targetError and writes the remaining triangles to indices. The state is
+	* kept, a following call with a larger error continues from here.
+	*/
+	void Simplify(float targetError, std::vector<unsigned int>& indices);
+
+	/* largest error of any collapse so far */
+	inline float GetError() const { return m_Error; }
+
+	/*
+	* Replaces mesh.Lods with the full mesh followed by one level per target
+	* error, each appended to mesh.Indices. Levels that remove less than
+	* a sixth of the previous level's triangles are skipped, returns the level count.
+	*/
+	static unsigned int BuildLods(MeshData& mesh, const std::vector<float>& targetErrors);
+
+private:
+	void BuildPositionRemap();
+	/* openCorners gets one flag per index, set when the edge to the next corner has no twin */
+	void ClassifyVertices(std::vector<bool>& openCorners);
+	void ComputeQuadrics(const std::vector<bool>& openCorners);
+	void BuildTriangleAdjacency();
+
+	bool CanCollapse(unsigned int from, unsigned int to) const;
+	float GetCollapseError(unsigned int from, unsigned int to) const;
+	/* whether moving from onto to turns any remaining triangle around, collapses of this pass included */
+	bool HasTriangleFlips(unsigned int from, unsigned int to, const std::vector<unsigned int>& collapseRemap) const;
+	void PickCollapses(std::vector<Collapse>& collapses, float targetError) const;
+	/* returns how many edges were collapsed */
+	unsigned int PerformCollapses(std::vector<Collapse>& collapses, float targetError);
+
+	static Quadric MakePlaneQuadric(const glm::vec3& normal, float distance, float weight);
+	static void AddQuadric(Quadric& target, const Quadric& source);
+	static float EvaluateQuadric(const Quadric& quadric, const glm::vec3& position);
+};
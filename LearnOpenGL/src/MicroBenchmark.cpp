@@ -0,0 +1,325 @@
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "stb_image/stb_image.h"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "Shader.h"
+#include "MipChain.h"
+#include "NullDevice.h"
+
+static const char* s_ImagePath = "res/textures/Emily_D&P_NoBG.png";
+static const char* s_ShaderPath = "res/shaders/Basic.shader";
+
+/* results are added in here so the compiler has to compute them */
+static volatile float s_Sink = 0.0f;
+
+static void Consume(float value)
+{
+	s_Sink = s_Sink + value;
+}
+
+static void Consume(const glm::mat4& matrix)
+{
+	float sum = 0.0f;
+	for (int column = 0; column < 4; column++)
+		sum += matrix[column][0] + matrix[column][1] + matrix[column][2] + matrix[column][3];
+	Consume(sum);
+}
+
+/* two stages of uniforms each used once, about 450 KB with 4096, like a big generated uber shader */
+static std::string MakeLargeShader(unsigned int uniforms)
+{
+	std::stringstream source;
+	const char* stages[] = { "vertex", "fragment" };
+	for (const char* stage : stages)
+	{
+		source << "#shader " << stage << "\n#version 330 core\n\n";
+		for (unsigned int i = 0; i < uniforms; i++)
+			source << "uniform vec4 u_Value" << i << ";\n";
+		source << "\nvoid main()\n{\n    vec4 sum = vec4(0.0);\n";
+		for (unsigned int i = 0; i < uniforms; i++)
+			source << "    sum += u_Value" << i << " * " << i << ".0;\n";
+		source << "    gl_" << (stage[0] == 'v' ? "Position" : "FragDepth") << " = sum" << (stage[0] == 'v' ? "" : ".x") << ";\n}\n";
+	}
+	return source.str();
+}
+
+MicroBenchmark::MicroBenchmark()
+	: m_MinMilliseconds(20.0), m_Repetitions(5)
+{
+}
+
+void MicroBenchmark::Add(const std::string& name, Body body, unsigned long long bytes)
+{
+	if (m_Filter.empty() || name.find(m_Filter) != std::string::npos)
+		m_Cases.push_back({ name, body, bytes });
+}
+
+bool MicroBenchmark::Run(const std::string& reportPath)
+{
+	NullDevice::Install();
+	m_Cases.clear();
+
+	Shader shader(s_ShaderPath);
+	shader.Bind();
+
+	Add("Shader/GetUniformLocation/hit", [&shader](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+			Consume((float)shader.GetUniformLocation("u_Color"));
+	});
+
+	/* every name is new until the cache is emptied again, the clear is spread over the lookups */
+	std::vector<std::string> names;
+	for (int i = 0; i < 1024; i++)
+		names.push_back("u_Uniform" + std::to_string(i));
+	Add("Shader/GetUniformLocation/miss", [&shader, &names](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			size_t index = (size_t)(i % names.size());
+			if (index == 0)
+				shader.m_UniformLocationCache.clear();
+			Consume((float)shader.GetUniformLocation(names[index]));
+		}
+	});
+
+	/* next to the report, removed again at the end */
+	std::string largeShaderPath = reportPath + ".shader";
+	std::string largeShader = MakeLargeShader(4096);
+	std::ofstream(largeShaderPath, std::ios::binary) << largeShader;
+	Add("Shader/ParseShader/large", [&shader, &largeShaderPath](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+			Consume((float)shader.ParseShader(largeShaderPath).FragmentSource.size());
+	}, largeShader.size());
+
+	/* the layout of a mesh vertex, position, texture coordinate, normal and a packed color */
+	Add("VertexBufferLayout/Push", [](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(3);
+			layout.Push<float>(2);
+			layout.Push<float>(3);
+			layout.Push<unsigned char>(4);
+			Consume((float)layout.GetStride());
+		}
+	});
+
+	VertexBufferLayout meshLayout;
+	meshLayout.Push<float>(3);
+	meshLayout.Push<float>(2);
+	meshLayout.Push<float>(3);
+	meshLayout.Push<unsigned char>(4);
+	VertexBuffer vb(nullptr, 36 * 4);
+	VertexArray va;
+	Add("VertexArray/AddBuffer", [&va, &vb, &meshLayout](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+			va.AddBuffer(vb, meshLayout);
+	});
+
+	unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+	IndexBuffer ib(indices, 6);
+	Renderer renderer;
+	Add("Renderer/Draw", [&renderer, &va, &ib, &shader](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+			renderer.Draw(va, ib, shader);
+	});
+
+	/* the same call with and without the glGetError checks around it */
+	Add("GLCall/bare", [](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+			glUseProgram(1);
+	});
+	Add("GLCall/checked", [](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			GLCall(glUseProgram(1));
+		}
+	});
+
+	/* decoding against reading the raw pixels TextureStreamer bakes */
+	std::ifstream imageFile(s_ImagePath, std::ios::binary);
+	std::vector<unsigned char> imageBytes((std::istreambuf_iterator<char>(imageFile)), std::istreambuf_iterator<char>());
+	int width = 0, height = 0, channels = 0;
+	stbi_info_from_memory(imageBytes.data(), (int)imageBytes.size(), &width, &height, &channels);
+	unsigned long long imageSize = (unsigned long long)width * height * 4;
+	std::string mipPath = std::string(s_ImagePath) + ".mips";
+	MipChain chain;
+	if (!MipChain::IsCurrent(mipPath, s_ImagePath))
+		MipChain::Bake(s_ImagePath, mipPath);
+	chain.Open(mipPath);
+
+	if (!imageBytes.empty())
+	{
+		Add("Image/stbi_load", [](unsigned long long iterations) {
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				int w, h, c;
+				stbi_set_flip_vertically_on_load(1);
+				unsigned char* pixels = stbi_load(s_ImagePath, &w, &h, &c, 4);
+				Consume(pixels ? (float)pixels[0] : 0.0f);
+				stbi_image_free(pixels);
+			}
+		}, imageSize);
+		Add("Image/stbi_load_from_memory", [&imageBytes](unsigned long long iterations) {
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				int w, h, c;
+				stbi_set_flip_vertically_on_load(1);
+				unsigned char* pixels = stbi_load_from_memory(imageBytes.data(), (int)imageBytes.size(), &w, &h, &c, 4);
+				Consume(pixels ? (float)pixels[0] : 0.0f);
+				stbi_image_free(pixels);
+			}
+		}, imageSize);
+	}
+	if (chain.GetLevelCount() > 0)
+	{
+		Add("Image/MipChain::ReadLevel", [&chain](unsigned long long iterations) {
+			std::vector<unsigned char> pixels;
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				chain.ReadLevel(0, pixels);
+				Consume((float)pixels[0]);
+			}
+		}, chain.GetLevelSize(0));
+	}
+
+	/* the model moves every iteration so nothing can be hoisted out of the loop */
+	glm::mat4 proj = glm::ortho(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-100.0f, 0.0f, 0.0f));
+	Add("glm/MVP", [&proj, &view](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float)(i & 255), 200.0f, 0.0f));
+			Consume(proj * view * model);
+		}
+	});
+	/* what the demo does per frame, projection and view included */
+	Add("glm/MVP/from_scratch", [](unsigned long long iterations) {
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			glm::mat4 proj = glm::ortho(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+			glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-100.0f, 0.0f, 0.0f));
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float)(i & 255), 200.0f, 0.0f));
+			Consume(proj * view * model);
+		}
+	});
+
+	std::cout << "Micro benchmarks against the null device, median of " << m_Repetitions << " runs of at least "
+		<< m_MinMilliseconds << " ms each" << std::endl;
+	std::vector<MicroBenchmarkResult> results;
+	for (const Case& benchmark : m_Cases)
+	{
+		MicroBenchmarkResult result = Measure(benchmark);
+		std::cout << "  " << std::left << std::setw(34) << result.Name << std::right << std::setw(14) << std::fixed << std::setprecision(1)
+			<< result.Nanoseconds << " ns" << std::setw(14) << result.Iterations << " iterations";
+		if (result.Bytes)
+			std::cout << "  " << std::setprecision(1) << result.Bytes / result.Nanoseconds * 1.0e9 / (1024.0 * 1024.0) << " MB/s";
+		std::cout << std::defaultfloat << std::endl;
+		results.push_back(result);
+	}
+	std::remove(largeShaderPath.c_str());
+	std::cout << "  " << NullDevice::GetCallCount() << " calls reached the null device" << std::endl;
+
+	std::ofstream report(reportPath);
+	if (!report)
+	{
+		std::cout << "Could not write " << reportPath << std::endl;
+		return false;
+	}
+	WriteReport(report, results);
+	std::cout << "Report written to " << reportPath << std::endl;
+	return true;
+}
+
+MicroBenchmarkResult MicroBenchmark::Measure(const Case& benchmark) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto time = [&benchmark](unsigned long long iterations) {
+		Clock::time_point start = Clock::now();
+		benchmark.Run(iterations);
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	};
+
+	/* doubles until a run is long enough for the clock, which also warms the caches */
+	double minNanoseconds = m_MinMilliseconds * 1.0e6;
+	unsigned long long iterations = 1;
+	while (time(iterations) < minNanoseconds && iterations < (1ull << 40))
+		iterations *= 2;
+
+	std::vector<double> samples;
+	for (unsigned int i = 0; i < m_Repetitions; i++)
+		samples.push_back(time(iterations) / iterations);
+	std::sort(samples.begin(), samples.end());
+
+	MicroBenchmarkResult result;
+	result.Name = benchmark.Name;
+	result.Iterations = iterations;
+	result.Nanoseconds = samples[samples.size() / 2];
+	result.MinNanoseconds = samples.front();
+	result.MaxNanoseconds = samples.back();
+	result.Bytes = benchmark.Bytes;
+	return result;
+}
+
+/*
+* The layout Google Benchmark writes with --benchmark_format=json, so its
+* compare.py can diff two reports. Nothing here blocks or runs on other
+* threads, so wall time stands in for CPU time.
+*/
+void MicroBenchmark::WriteReport(std::ostream& stream, const std::vector<MicroBenchmarkResult>& results)
+{
+	char date[32];
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+	stream << std::setprecision(10);
+	stream << "{\n";
+	stream << "  \"context\": {\n";
+	stream << "    \"date\": \"" << date << "\",\n";
+	stream << "    \"executable\": \"LearnOpenGL --micro-bench\",\n";
+	stream << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+	stream << "    \"library_build_type\": \"release\",\n";
+#else
+	stream << "    \"library_build_type\": \"debug\",\n";
+#endif
+	stream << "    \"device\": \"null\"\n";
+	stream << "  },\n";
+	stream << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const MicroBenchmarkResult& result = results[i];
+		stream << "    {\n";
+		stream << "      \"name\": \"" << result.Name << "\",\n";
+		stream << "      \"run_name\": \"" << result.Name << "\",\n";
+		stream << "      \"run_type\": \"iteration\",\n";
+		stream << "      \"iterations\": " << result.Iterations << ",\n";
+		stream << "      \"real_time\": " << result.Nanoseconds << ",\n";
+		stream << "      \"cpu_time\": " << result.Nanoseconds << ",\n";
+		stream << "      \"time_unit\": \"ns\",\n";
+		if (result.Bytes)
+			stream << "      \"bytes_per_second\": " << result.Bytes / result.Nanoseconds * 1.0e9 << ",\n";
+		stream << "      \"min_time\": " << result.MinNanoseconds << ",\n";
+		stream << "      \"max_time\": " << result.MaxNanoseconds << "\n";
+		stream << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	stream << "  ]\n";
+	stream << "}\n";
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct MicroBenchmarkResult
+{
+	std::string Name;
+	/* per repetition */
+	unsigned long long Iterations;
+	/* median, fastest and slowest repetition */
+	double Nanoseconds;
+	double MinNanoseconds;
+	double MaxNanoseconds;
+	/* bytes an iteration processes, 0 when throughput means nothing for it */
+	unsigned long long Bytes;
+};
+
+/*
+* Times the CPU cost of the renderer's hot paths, one small case at a time
+* Uniform location lookups with and without a cache hit, shader parsing of
+* a large generated source, layout building and vertex array setup, draw
+* submission, GLCall's error checking, image loading with stb_image against
+* reading a baked MipChain, and the per frame MVP math. GL goes to the
+* NullDevice, so it runs without a GPU or a context and only the wrappers
+* are measured.
+*
+* Each case doubles its iteration count until one run takes long enough to
+* time, then is repeated and the median kept. The report is in Google
+* Benchmark's JSON layout, so its compare tools can diff two runs.
+*/
+class MicroBenchmark
+{
+public:
+	/* runs the case iterations times */
+	typedef std::function<void(unsigned long long iterations)> Body;
+
+private:
+	struct Case
+	{
+		std::string Name;
+		Body Run;
+		unsigned long long Bytes;
+	};
+
+	std::vector<Case> m_Cases;
+	/* only cases whose name contains this run */
+	std::string m_Filter;
+	double m_MinMilliseconds;
+	unsigned int m_Repetitions;
+public:
+	MicroBenchmark();
+
+	inline void SetFilter(const std::string& filter) { m_Filter = filter; }
+	inline void SetRepetitions(unsigned int repetitions) { m_Repetitions = repetitions > 0 ? repetitions : 1; }
+
+	/* Installs the NullDevice, runs the cases, prints a line each and writes the report. False when it cannot be written */
+	bool Run(const std::string& reportPath);
+
+private:
+	void Add(const std::string& name, Body body, unsigned long long bytes = 0);
+	MicroBenchmarkResult Measure(const Case& benchmark) const;
+	static void WriteReport(std::ostream& stream, const std::vector<MicroBenchmarkResult>& results);
+};
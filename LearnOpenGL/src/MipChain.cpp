@@ -0,0 +1,158 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "MappedFile.h"
+#include "stb_image/stb_image.h"
+
+const unsigned int MipChain::s_Version;
+
+static const char s_Magic[4] = { 'M', 'I', 'P', 'S' };
+
+/* version, width, height and level count, then the source stamp */
+static bool ReadHeader(std::ifstream& stream, unsigned int header[4], unsigned long long source[2])
+{
+	char magic[4];
+	stream.read(magic, 4);
+	stream.read((char*)header, sizeof(unsigned int) * 4);
+	stream.read((char*)source, sizeof(unsigned long long) * 2);
+	return stream && memcmp(magic, s_Magic, 4) == 0 && header[0] == MipChain::s_Version;
+}
+
+MipChain::MipChain()
+	: m_SourceSize(0), m_SourceTime(0)
+{
+}
+
+bool MipChain::Open(const std::string& path)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		return false;
+
+	unsigned int header[4];
+	unsigned long long source[2];
+	if (!ReadHeader(stream, header, source))
+	{
+		std::cout << "Invalid mip chain file " << path << std::endl;
+		return false;
+	}
+	m_SourceSize = source[0];
+	m_SourceTime = source[1];
+
+	unsigned int levelCount = header[3];
+	m_Levels.resize(levelCount);
+	int width = (int)header[1], height = (int)header[2];
+	for (unsigned int i = 0; i < levelCount; i++)
+	{
+		unsigned long long entry[2];
+		stream.read((char*)entry, sizeof(entry));
+		m_Levels[i] = { width, height, entry[0], entry[1] };
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	m_FilePath = path;
+	return (bool)stream;
+}
+
+bool MipChain::ReadLevel(int level, std::vector<unsigned char>& pixels) const
+{
+	const Level& info = m_Levels[level];
+
+	/* a stream per read, several levels may load at once on different threads */
+	std::ifstream stream(m_FilePath, std::ios::binary);
+	stream.seekg((std::streamoff)info.Offset);
+	pixels.resize((size_t)info.Size);
+	stream.read((char*)pixels.data(), (std::streamsize)info.Size);
+	return (bool)stream;
+}
+
+bool MipChain::Bake(const std::string& imagePath, const std::string& mipPath)
+{
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* image = stbi_load(imagePath.c_str(), &width, &height, &channels, 4);
+	if (!image)
+	{
+		std::cout << "Failed to load " << imagePath << " for mip baking" << std::endl;
+		return false;
+	}
+
+	unsigned long long source[2] = { 0, 0 };
+	MappedFile::GetStamp(imagePath, source[0], source[1]);
+
+	std::vector<std::vector<unsigned char>> levels;
+	levels.emplace_back(image, image + (size_t)width * height * 4);
+	stbi_image_free(image);
+
+	/* 2x2 box filter, odd edges reuse the last row or column */
+	int levelWidth = width, levelHeight = height;
+	while (levelWidth > 1 || levelHeight > 1)
+	{
+		int nextWidth = std::max(1, levelWidth / 2);
+		int nextHeight = std::max(1, levelHeight / 2);
+		const std::vector<unsigned char>& source = levels.back();
+		std::vector<unsigned char> next((size_t)nextWidth * nextHeight * 4);
+
+		for (int y = 0; y < nextHeight; y++)
+		{
+			int y0 = std::min(y * 2, levelHeight - 1), y1 = std::min(y * 2 + 1, levelHeight - 1);
+			for (int x = 0; x < nextWidth; x++)
+			{
+				int x0 = std::min(x * 2, levelWidth - 1), x1 = std::min(x * 2 + 1, levelWidth - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = source[((size_t)y0 * levelWidth + x0) * 4 + c] + source[((size_t)y0 * levelWidth + x1) * 4 + c]
+						+ source[((size_t)y1 * levelWidth + x0) * 4 + c] + source[((size_t)y1 * levelWidth + x1) * 4 + c];
+					next[((size_t)y * nextWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		levels.push_back(std::move(next));
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+
+	std::ofstream stream(mipPath, std::ios::binary);
+	if (!stream)
+	{
+		std::cout << "Failed to open " << mipPath << " for writing" << std::endl;
+		return false;
+	}
+
+	unsigned int header[4] = { s_Version, (unsigned int)width, (unsigned int)height, (unsigned int)levels.size() };
+	stream.write(s_Magic, 4);
+	stream.write((const char*)header, sizeof(header));
+	stream.write((const char*)source, sizeof(source));
+
+	unsigned long long offset = 4 + sizeof(header) + sizeof(source) + levels.size() * sizeof(unsigned long long) * 2;
+	for (const std::vector<unsigned char>& level : levels)
+	{
+		unsigned long long entry[2] = { offset, level.size() };
+		stream.write((const char*)entry, sizeof(entry));
+		offset += level.size();
+	}
+	for (const std::vector<unsigned char>& level : levels)
+		stream.write((const char*)level.data(), level.size());
+
+	return (bool)stream;
+}
+
+bool MipChain::IsCurrent(const std::string& mipPath, const std::string& imagePath)
+{
+	std::ifstream stream(mipPath, std::ios::binary);
+	unsigned int header[4];
+	unsigned long long source[2];
+	if (!stream || !ReadHeader(stream, header, source))
+		return false;
+
+	unsigned long long size, time;
+	if (!MappedFile::GetStamp(imagePath, size, time))
+		return true;
+	return source[0] == size && source[1] == time;
+}
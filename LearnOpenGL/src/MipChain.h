@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+* Baked mip chain file, every level stored as raw RGBA8 so a level can be
+* read on its own without decoding the image again
+* Layout: "MIPS", version, width, height, level count, the size and
+* modification time of the source image, then an offset and size per level
+* (level 0 is full size) followed by the level data, bottom row first like
+* OpenGL expects.
+*/
+class MipChain
+{
+private:
+	struct Level
+	{
+		int Width, Height;
+		unsigned long long Offset;
+		unsigned long long Size;
+	};
+
+	std::string m_FilePath;
+	std::vector<Level> m_Levels;
+	unsigned long long m_SourceSize, m_SourceTime;
+public:
+	static const unsigned int s_Version = 2;
+
+	MipChain();
+
+	/* Reads the header and level table, the pixel data stays on disk */
+	bool Open(const std::string& path);
+	/* Reads one level, only touches the file so it is safe to call from any thread */
+	bool ReadLevel(int level, std::vector<unsigned char>& pixels) const;
+
+	inline int GetLevelCount() const { return (int)m_Levels.size(); }
+	inline int GetWidth(int level) const { return m_Levels[level].Width; }
+	inline int GetHeight(int level) const { return m_Levels[level].Height; }
+	inline unsigned long long GetLevelSize(int level) const { return m_Levels[level].Size; }
+
+	/* Loads an image with stb_image and writes its full box filtered mip chain */
+	static bool Bake(const std::string& imagePath, const std::string& mipPath);
+	/*
+	* True when mipPath was baked from imagePath as it is now, same size and
+	* modification time. Like mesh caches, a chain whose image is gone is
+	* still current so builds can ship chains only.
+	*/
+	static bool IsCurrent(const std::string& mipPath, const std::string& imagePath);
+};
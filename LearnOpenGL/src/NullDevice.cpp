@@ -0,0 +1,83 @@
+#include "NullDevice.h"
+
+#include <GL/glew.h>
+
+static unsigned long long s_Calls = 0;
+static GLuint s_NextName = 1;
+static GLint s_NextLocation = 0;
+
+static void GLAPIENTRY GenNames(GLsizei n, GLuint* names)
+{
+	s_Calls++;
+	for (GLsizei i = 0; i < n; i++)
+		names[i] = s_NextName++;
+}
+static void GLAPIENTRY DeleteNames(GLsizei, const GLuint*) { s_Calls++; }
+static GLuint GLAPIENTRY CreateProgram() { s_Calls++; return s_NextName++; }
+static GLuint GLAPIENTRY CreateShader(GLenum) { s_Calls++; return s_NextName++; }
+static void GLAPIENTRY ShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) { s_Calls++; }
+/* every status query passes, compiling and linking always succeed */
+static void GLAPIENTRY GetShaderiv(GLuint, GLenum, GLint* param) { s_Calls++; *param = GL_TRUE; }
+static void GLAPIENTRY Name(GLuint) { s_Calls++; }
+static void GLAPIENTRY NamePair(GLuint, GLuint) { s_Calls++; }
+static void GLAPIENTRY Target(GLenum) { s_Calls++; }
+static void GLAPIENTRY Bind(GLenum, GLuint) { s_Calls++; }
+static GLint GLAPIENTRY GetUniformLocation(GLuint, const GLchar*) { s_Calls++; return s_NextLocation++; }
+static void GLAPIENTRY Uniform1i(GLint, GLint) { s_Calls++; }
+static void GLAPIENTRY Uniform1f(GLint, GLfloat) { s_Calls++; }
+static void GLAPIENTRY Uniform2f(GLint, GLfloat, GLfloat) { s_Calls++; }
+static void GLAPIENTRY Uniform3f(GLint, GLfloat, GLfloat, GLfloat) { s_Calls++; }
+static void GLAPIENTRY Uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { s_Calls++; }
+static void GLAPIENTRY Uniform4fv(GLint, GLsizei, const GLfloat*) { s_Calls++; }
+static void GLAPIENTRY UniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { s_Calls++; }
+static void GLAPIENTRY BufferData(GLenum, GLsizeiptr, const void*, GLenum) { s_Calls++; }
+static void GLAPIENTRY BufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) { s_Calls++; }
+static void GLAPIENTRY VertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { s_Calls++; }
+static void GLAPIENTRY DrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) { s_Calls++; }
+static void GLAPIENTRY DrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei) { s_Calls++; }
+
+namespace NullDevice
+{
+	void Install()
+	{
+		__glewGenBuffers = GenNames;
+		__glewGenVertexArrays = GenNames;
+		__glewDeleteBuffers = DeleteNames;
+		__glewDeleteVertexArrays = DeleteNames;
+		__glewCreateProgram = CreateProgram;
+		__glewCreateShader = CreateShader;
+		__glewShaderSource = ShaderSource;
+		__glewCompileShader = Name;
+		__glewGetShaderiv = GetShaderiv;
+		__glewAttachShader = NamePair;
+		__glewLinkProgram = Name;
+		__glewValidateProgram = Name;
+		__glewDeleteShader = Name;
+		__glewDeleteProgram = Name;
+		__glewUseProgram = Name;
+		__glewGetUniformLocation = GetUniformLocation;
+		__glewUniform1i = Uniform1i;
+		__glewUniform1f = Uniform1f;
+		__glewUniform2f = Uniform2f;
+		__glewUniform3f = Uniform3f;
+		__glewUniform4f = Uniform4f;
+		__glewUniform4fv = Uniform4fv;
+		__glewUniformMatrix4fv = UniformMatrix4fv;
+		__glewBindBuffer = Bind;
+		__glewBufferData = BufferData;
+		__glewBufferSubData = BufferSubData;
+		__glewBindVertexArray = Name;
+		__glewEnableVertexAttribArray = Name;
+		__glewVertexAttribPointer = VertexAttribPointer;
+		__glewVertexAttribDivisor = NamePair;
+		__glewDrawElementsInstanced = DrawElementsInstanced;
+		__glewDrawArraysInstanced = DrawArraysInstanced;
+		__glewActiveTexture = Target;
+		s_Calls = 0;
+	}
+
+	unsigned long long GetCallCount()
+	{
+		return s_Calls;
+	}
+}
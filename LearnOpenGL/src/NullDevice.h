@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+* GL without a GPU, for timing the wrappers' own CPU cost
+* Install points the GLEW entry points that shaders, buffers, vertex arrays
+* and draws go through at stubs that do nothing but hand out names and
+* report success, so none of it needs a context. GL 1.1 functions like
+* glDrawElements and glGetError are exported by the system GL library
+* instead of loaded by GLEW, with no context current they are that
+* library's own no-ops. Call it before any GL object is made and never
+* together with a real context, it replaces what glewInit loaded.
+*/
+namespace NullDevice
+{
+	void Install();
+	/* stub calls since Install, so a benchmark can show it reached the device */
+	unsigned long long GetCallCount();
+}
@@ -0,0 +1,417 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define OCCLUSION_USE_SSE 1
+#endif
+
+#include "JobSystem.h"
+#include "Culler.h"
+#include "Mesh.h"
+
+const int OcclusionBuffer::s_TileSize;
+
+OcclusionBuffer::OcclusionBuffer(int width, int height, JobSystem* jobs)
+	: m_Jobs(jobs), m_ViewProjection(1.0f), m_Binned(nullptr), m_Stats()
+{
+	m_TilesX = std::max((width + s_TileSize - 1) / s_TileSize, 1);
+	m_TilesY = std::max((height + s_TileSize - 1) / s_TileSize, 1);
+	m_Width = m_TilesX * s_TileSize;
+	m_Height = m_TilesY * s_TileSize;
+	m_BinStarts.resize(m_TilesX * m_TilesY + 1);
+	m_BinCursors.resize(m_TilesX * m_TilesY);
+
+	int levelWidth = m_Width, levelHeight = m_Height;
+	while (true)
+	{
+		Level level;
+		level.Width = levelWidth;
+		level.Height = levelHeight;
+		level.Min.assign(levelWidth * levelHeight, 1.0f);
+		level.Max.assign(levelWidth * levelHeight, 1.0f);
+		m_Levels.push_back(level);
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+void OcclusionBuffer::Begin(const glm::mat4& viewProjection)
+{
+	m_ViewProjection = viewProjection;
+	m_Triangles.clear();
+	m_Stats = OcclusionStats();
+}
+
+void OcclusionBuffer::AddOccluder(const MeshData& mesh, const glm::mat4& model)
+{
+	if (!mesh.Has(MeshAttribute::Position))
+		return;
+
+	unsigned int stride = MeshData::GetFloatsPerVertex(mesh.Attributes);
+	unsigned int offset = MeshData::GetOffset(mesh.Attributes, MeshAttribute::Position);
+	unsigned int vertexCount = mesh.GetVertexCount();
+	glm::mat4 matrix = m_ViewProjection * model;
+	m_ClipPositions.resize(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		const float* position = &mesh.Vertices[i * stride + offset];
+		m_ClipPositions[i] = matrix * glm::vec4(position[0], position[1], position[2], 1.0f);
+	}
+
+	/* room for every triangle clipping into two, so the capacity only depends on the occluders and not the view */
+	size_t worstCase = m_Triangles.size() + mesh.Indices.size() / 3 * 2;
+	if (m_Triangles.capacity() < worstCase)
+		m_Triangles.reserve(std::max(worstCase, m_Triangles.capacity() * 2));
+	for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+		AddTriangle(m_ClipPositions[mesh.Indices[i]], m_ClipPositions[mesh.Indices[i + 1]], m_ClipPositions[mesh.Indices[i + 2]]);
+	m_Stats.Occluders++;
+}
+
+void OcclusionBuffer::AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	/* distance to the near plane z = -w, positive in front of it */
+	const glm::vec4* input[3] = { &a, &b, &c };
+	float distances[3] = { a.z + a.w, b.z + b.w, c.z + c.w };
+	if (distances[0] >= 0.0f && distances[1] >= 0.0f && distances[2] >= 0.0f)
+	{
+		SetupTriangle(a, b, c);
+		return;
+	}
+
+	/* one corner behind leaves a quad, two leave a triangle */
+	glm::vec4 clipped[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		if (distances[i] >= 0.0f)
+			clipped[count++] = *input[i];
+		if ((distances[i] >= 0.0f) != (distances[next] >= 0.0f))
+		{
+			float t = distances[i] / (distances[i] - distances[next]);
+			clipped[count++] = *input[i] + (*input[next] - *input[i]) * t;
+		}
+	}
+	for (int i = 1; i + 1 < count; i++)
+		SetupTriangle(clipped[0], clipped[i], clipped[i + 1]);
+}
+
+void OcclusionBuffer::SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const glm::vec4* clip[3] = { &a, &b, &c };
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; i++)
+	{
+		float inverseW = 1.0f / clip[i]->w;
+		x[i] = (clip[i]->x * inverseW * 0.5f + 0.5f) * m_Width;
+		y[i] = (clip[i]->y * inverseW * 0.5f + 0.5f) * m_Height;
+		z[i] = clip[i]->z * inverseW * 0.5f + 0.5f;
+	}
+
+	/* counter clockwise on screen is front facing, closed occluders only need their front */
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area <= 0.0f)
+		return;
+
+	Triangle triangle;
+	triangle.MinX = std::min(x[0], std::min(x[1], x[2]));
+	triangle.MinY = std::min(y[0], std::min(y[1], y[2]));
+	triangle.MaxX = std::max(x[0], std::max(x[1], x[2]));
+	triangle.MaxY = std::max(y[0], std::max(y[1], y[2]));
+	if (triangle.MaxX < 0.0f || triangle.MaxY < 0.0f || triangle.MinX >= m_Width || triangle.MinY >= m_Height)
+		return;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		/* cross product of the edge and the point, A * x + B * y + C */
+		triangle.EdgeA[i] = y[i] - y[next];
+		triangle.EdgeB[i] = x[next] - x[i];
+		triangle.EdgeC[i] = -(triangle.EdgeA[i] * x[i] + triangle.EdgeB[i] * y[i]);
+	}
+
+	/* z / w is linear in screen space, a plane through the three corners */
+	triangle.DepthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle.DepthY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	triangle.DepthBase = z[0] - triangle.DepthX * x[0] - triangle.DepthY * y[0];
+	m_Triangles.push_back(triangle);
+}
+
+void OcclusionBuffer::Rasterize(std::pmr::memory_resource* scratch)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	/* counted first so the bins can be laid out back to back, then filled in triangle order */
+	unsigned int tileCount = (unsigned int)m_BinCursors.size();
+	std::fill(m_BinStarts.begin(), m_BinStarts.end(), 0);
+	unsigned int* binned = nullptr;
+	std::size_t binnedBytes = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (unsigned int i = 0; i < (unsigned int)m_Triangles.size(); i++)
+		{
+			const Triangle& triangle = m_Triangles[i];
+			int firstX = std::max((int)triangle.MinX / s_TileSize, 0);
+			int firstY = std::max((int)triangle.MinY / s_TileSize, 0);
+			int lastX = std::min((int)triangle.MaxX / s_TileSize, m_TilesX - 1);
+			int lastY = std::min((int)triangle.MaxY / s_TileSize, m_TilesY - 1);
+			for (int tileY = firstY; tileY <= lastY; tileY++)
+			{
+				for (int tileX = firstX; tileX <= lastX; tileX++)
+				{
+					unsigned int tile = tileY * m_TilesX + tileX;
+					if (pass == 0)
+						m_BinStarts[tile + 1]++;
+					else
+						binned[m_BinCursors[tile]++] = i;
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (unsigned int tile = 0; tile < tileCount; tile++)
+			{
+				m_BinStarts[tile + 1] += m_BinStarts[tile];
+				m_BinCursors[tile] = m_BinStarts[tile];
+			}
+			binnedBytes = std::max(m_BinStarts[tileCount], 1u) * sizeof(unsigned int);
+			binned = (unsigned int*)scratch->allocate(binnedBytes, alignof(unsigned int));
+		}
+	}
+	m_Binned = binned;
+
+	/* tiles share no pixels, each job owns its own */
+	if (m_Jobs)
+	{
+		JobCounter counter;
+		m_Jobs->ParallelFor(tileCount, [this](unsigned int begin, unsigned int end) {
+			for (unsigned int tile = begin; tile < end; tile++)
+				RasterizeTile(tile);
+		}, &counter, 1);
+		m_Jobs->Wait(counter);
+	}
+	else
+	{
+		for (unsigned int tile = 0; tile < tileCount; tile++)
+			RasterizeTile(tile);
+	}
+	scratch->deallocate(binned, binnedBytes, alignof(unsigned int));
+	m_Binned = nullptr;
+
+	BuildPyramid();
+
+	m_Stats.OccluderTriangles = (unsigned int)m_Triangles.size();
+	m_Stats.RasterizeMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionBuffer::RasterizeTile(unsigned int tile)
+{
+	int tileX = (int)tile % m_TilesX * s_TileSize;
+	int tileY = (int)tile / m_TilesX * s_TileSize;
+	float* depth = m_Levels[0].Max.data();
+	for (int y = tileY; y < tileY + s_TileSize; y++)
+		std::fill(depth + y * m_Width + tileX, depth + y * m_Width + tileX + s_TileSize, 1.0f);
+
+	for (unsigned int entry = m_BinStarts[tile]; entry < m_BinStarts[tile + 1]; entry++)
+	{
+		const Triangle& triangle = m_Triangles[m_Binned[entry]];
+		/* pixels whose centers the bounds can reach, x in whole groups of four */
+		int minX = std::max((int)std::floor(triangle.MinX), tileX) & ~3;
+		int minY = std::max((int)std::floor(triangle.MinY), tileY);
+		int maxX = std::min((int)std::ceil(triangle.MaxX), tileX + s_TileSize - 1);
+		int maxY = std::min((int)std::ceil(triangle.MaxY), tileY + s_TileSize - 1);
+
+#ifdef OCCLUSION_USE_SSE
+		const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		__m128 edgeA[3];
+		for (int i = 0; i < 3; i++)
+			edgeA[i] = _mm_set1_ps(triangle.EdgeA[i]);
+		__m128 depthX = _mm_set1_ps(triangle.DepthX);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float centerY = y + 0.5f;
+			__m128 rowEdge[3];
+			for (int i = 0; i < 3; i++)
+				rowEdge[i] = _mm_set1_ps(triangle.EdgeB[i] * centerY + triangle.EdgeC[i]);
+			__m128 rowDepth = _mm_set1_ps(triangle.DepthBase + triangle.DepthY * centerY);
+			float* row = depth + y * m_Width;
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), centers);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], centerX), rowEdge[0]), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], centerX), rowEdge[1]), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], centerX), rowEdge[2]), zero));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 old = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(depthX, centerX), rowDepth));
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+			}
+		}
+#else
+		for (int y = minY; y <= maxY; y++)
+		{
+			float centerY = y + 0.5f;
+			float* row = depth + y * m_Width;
+			for (int x = minX; x <= maxX; x++)
+			{
+				float centerX = x + 0.5f;
+				bool inside = true;
+				for (int i = 0; i < 3; i++)
+					inside = inside && triangle.EdgeA[i] * centerX + triangle.EdgeB[i] * centerY + triangle.EdgeC[i] >= 0.0f;
+				if (inside)
+					row[x] = std::min(row[x], triangle.DepthBase + triangle.DepthX * centerX + triangle.DepthY * centerY);
+			}
+		}
+#endif
+	}
+}
+
+void OcclusionBuffer::BuildPyramid()
+{
+	m_Levels[0].Min = m_Levels[0].Max;
+	for (size_t level = 1; level < m_Levels.size(); level++)
+	{
+		const Level& fine = m_Levels[level - 1];
+		Level& coarse = m_Levels[level];
+		for (int y = 0; y < coarse.Height; y++)
+		{
+			for (int x = 0; x < coarse.Width; x++)
+			{
+				/* odd sizes repeat the last row or column */
+				int x0 = 2 * x, x1 = std::min(2 * x + 1, fine.Width - 1);
+				int y0 = 2 * y, y1 = std::min(2 * y + 1, fine.Height - 1);
+				int indices[4] = { y0 * fine.Width + x0, y0 * fine.Width + x1, y1 * fine.Width + x0, y1 * fine.Width + x1 };
+				float nearest = fine.Min[indices[0]], farthest = fine.Max[indices[0]];
+				for (int i = 1; i < 4; i++)
+				{
+					nearest = std::min(nearest, fine.Min[indices[i]]);
+					farthest = std::max(farthest, fine.Max[indices[i]]);
+				}
+				coarse.Min[y * coarse.Width + x] = nearest;
+				coarse.Max[y * coarse.Width + x] = farthest;
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& box) const
+{
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner(i & 1 ? box.Max.x : box.Min.x, i & 2 ? box.Max.y : box.Min.y, i & 4 ? box.Max.z : box.Min.z);
+		glm::vec4 clip = m_ViewProjection * glm::vec4(corner, 1.0f);
+		/* reaches the near plane, its rectangle is unbounded */
+		if (clip.z < -clip.w)
+			return true;
+
+		float inverseW = 1.0f / clip.w;
+		float x = (clip.x * inverseW * 0.5f + 0.5f) * m_Width;
+		float y = (clip.y * inverseW * 0.5f + 0.5f) * m_Height;
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * inverseW * 0.5f + 0.5f);
+	}
+
+	int x0 = std::max((int)std::floor(minX), 0), y0 = std::max((int)std::floor(minY), 0);
+	int x1 = std::min((int)std::floor(maxX), m_Width - 1), y1 = std::min((int)std::floor(maxY), m_Height - 1);
+	if (x0 > x1 || y0 > y1 || nearest > 1.0f)
+		return false;
+
+	/* the level where the rectangle spans about two texels each way */
+	unsigned int level = 0;
+	int size = std::max(x1 - x0, y1 - y0) + 1;
+	while ((size >> level) > 2 && level + 1 < m_Levels.size())
+		level++;
+
+	for (int y = y0 >> level; y <= y1 >> level; y++)
+		for (int x = x0 >> level; x <= x1 >> level; x++)
+			if (!IsOccluded(level, x, y, x0, y0, x1, y1, nearest))
+				return true;
+	return false;
+}
+
+bool OcclusionBuffer::IsOccluded(unsigned int level, int x, int y, int minX, int minY, int maxX, int maxY, float depth) const
+{
+	const Level& texels = m_Levels[level];
+	int index = y * texels.Width + x;
+	if (depth > texels.Max[index])
+		return true;
+	if (level == 0 || depth <= texels.Min[index])
+		return false;
+
+	const Level& children = m_Levels[level - 1];
+	unsigned int shift = level - 1;
+	for (int childY = 2 * y; childY <= 2 * y + 1 && childY < children.Height; childY++)
+	{
+		if ((childY << shift) > maxY || ((childY + 1) << shift) - 1 < minY)
+			continue;
+		for (int childX = 2 * x; childX <= 2 * x + 1 && childX < children.Width; childX++)
+		{
+			if ((childX << shift) > maxX || ((childX + 1) << shift) - 1 < minX)
+				continue;
+			if (!IsOccluded(level - 1, childX, childY, minX, minY, maxX, maxY, depth))
+				return false;
+		}
+	}
+	return true;
+}
+
+unsigned int OcclusionBuffer::Filter(const Culler& culler, std::vector<unsigned int>& objects)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	size_t kept = 0;
+	for (unsigned int object : objects)
+	{
+		if (IsVisible(culler.GetBounds(object)))
+			objects[kept++] = object;
+	}
+	unsigned int removed = (unsigned int)(objects.size() - kept);
+	m_Stats.Tested += (unsigned int)objects.size();
+	m_Stats.Occluded += removed;
+	objects.resize(kept);
+
+	m_Stats.TestMilliseconds += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return removed;
+}
+
+void OcclusionBuffer::GetDebugImage(std::vector<unsigned char>& pixels) const
+{
+	const std::vector<float>& depth = m_Levels[0].Max;
+	/* stretch the occupied depth range, z / w bunches up near 1 */
+	float nearest = 1.0f, farthest = 0.0f;
+	for (float value : depth)
+	{
+		if (value >= 1.0f)
+			continue;
+		nearest = std::min(nearest, value);
+		farthest = std::max(farthest, value);
+	}
+	float scale = farthest > nearest ? 1.0f / (farthest - nearest) : 0.0f;
+
+	pixels.resize(depth.size() * 4);
+	for (size_t i = 0; i < depth.size(); i++)
+	{
+		unsigned char shade = depth[i] >= 1.0f ? 0 : (unsigned char)(255.0f - 200.0f * (depth[i] - nearest) * scale);
+		pixels[i * 4 + 0] = shade;
+		pixels[i * 4 + 1] = shade;
+		pixels[i * 4 + 2] = shade;
+		pixels[i * 4 + 3] = 255;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Bounds.h"
+
+class JobSystem;
+class Culler;
+struct MeshData;
+
+struct OcclusionStats
+{
+	unsigned int Occluders;
+	/* front facing triangles after near clipping */
+	unsigned int OccluderTriangles;
+	/* binning, rasterizing on the job system and building the pyramid */
+	float RasterizeMilliseconds;
+	unsigned int Tested;
+	unsigned int Occluded;
+	float TestMilliseconds;
+};
+
+/*
+* Small CPU depth buffer of a few big occluders, for rejecting hidden objects before they are drawn
+* Begin sets the camera, AddOccluder transforms, near clips and back face
+* culls a mesh's triangles and Rasterize bins them into tiles of s_TileSize
+* pixels, counting first so all bins share one exactly sized array, that
+* the job system then fills in parallel, four pixels at a time with
+* SSE. A pyramid of min and max depth is then built on top of it.
+*
+* A box is tested with its screen rectangle and nearest depth, starting at
+* the pyramid level where the rectangle covers about two texels. A texel
+* whose farthest occluder is nearer than the box hides that part of it, a
+* texel whose nearest depth is behind the box shows it, anything in between
+* is refined one level down. Depth is z / w mapped to [0, 1], cleared to 1.
+* Pixels count as covered by their centers, so occluders should be a bit
+* smaller than what they stand for.
+*/
+class OcclusionBuffer
+{
+public:
+	static const int s_TileSize = 32;
+
+private:
+	/* screen space occluder triangle, edge functions are >= 0 inside */
+	struct Triangle
+	{
+		float EdgeA[3], EdgeB[3], EdgeC[3];
+		/* depth = DepthBase + DepthX * x + DepthY * y */
+		float DepthBase, DepthX, DepthY;
+		float MinX, MinY, MaxX, MaxY;
+	};
+
+	struct Level
+	{
+		int Width, Height;
+		std::vector<float> Min;
+		std::vector<float> Max;
+	};
+
+	JobSystem* m_Jobs;
+	int m_Width, m_Height;
+	int m_TilesX, m_TilesY;
+	glm::mat4 m_ViewProjection;
+	/* scratch for the occluder being added */
+	std::vector<glm::vec4> m_ClipPositions;
+	std::vector<Triangle> m_Triangles;
+	/* triangles touching each tile are m_Binned[m_BinStarts[tile]] up to the next tile's start */
+	std::vector<unsigned int> m_BinStarts;
+	std::vector<unsigned int> m_BinCursors;
+	/* only while Rasterize runs, on its scratch memory */
+	const unsigned int* m_Binned;
+	/* level 0 is the depth buffer itself, each next one half the size */
+	std::vector<Level> m_Levels;
+	OcclusionStats m_Stats;
+public:
+	/* width and height are rounded up to whole tiles, jobs may be null */
+	OcclusionBuffer(int width, int height, JobSystem* jobs);
+
+	/* forgets last frame's occluders */
+	void Begin(const glm::mat4& viewProjection);
+	/* mesh needs positions, model places it in the world */
+	void AddOccluder(const MeshData& mesh, const glm::mat4& model);
+	/* the binned triangle lists are taken from scratch, usually the frame arena */
+	void Rasterize(std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+	/* false only when every part of the world space box is behind an occluder */
+	bool IsVisible(const AABB& box) const;
+	/* removes the hidden objects from a list culler produced, timed for the stats. Returns how many were removed */
+	unsigned int Filter(const Culler& culler, std::vector<unsigned int>& objects);
+
+	/* RGBA8 view of the depth buffer bottom row first, near occluders bright and empty pixels black */
+	void GetDebugImage(std::vector<unsigned char>& pixels) const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline const OcclusionStats& GetStats() const { return m_Stats; }
+
+private:
+	/* clip space triangle, clipped against the near plane */
+	void AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	/* entirely in front of the near plane */
+	void SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	void RasterizeTile(unsigned int tile);
+	void BuildPyramid();
+	/* whether the texel of level hides every pixel of the rectangle it overlaps */
+	bool IsOccluded(unsigned int level, int x, int y, int minX, int minY, int maxX, int maxY, float depth) const;
+};
@@ -0,0 +1,81 @@
+#include "ParticleBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "CpuParticleSystem.h"
+#include "JobSystem.h"
+
+ParticleBenchmark::ParticleBenchmark(unsigned int particleCount, unsigned int frames)
+	: m_ParticleCount(particleCount), m_Frames(std::max(frames, 1u))
+{
+}
+
+bool ParticleBenchmark::Run()
+{
+	unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	std::cout << "Particle benchmark: " << m_ParticleCount << " CPU particles, " << m_Frames << " frames, SIMD "
+		<< CpuParticleSystem::s_SimdWidth << " wide, " << cores << " hardware threads" << std::endl;
+
+	std::vector<ParticleBenchmarkResult> results;
+	results.push_back(RunOnce(1, false));
+	for (unsigned int threads = 1; threads < cores; threads *= 2)
+		results.push_back(RunOnce(threads, true));
+	results.push_back(RunOnce(cores, true));
+
+	bool correct = true;
+	float single = results[1].MillisecondsPerFrame;
+	for (const ParticleBenchmarkResult& result : results)
+	{
+		bool same = result.Alive == results[0].Alive && result.Checksum == results[0].Checksum;
+		std::cout << "  " << (result.Simd ? "SIMD" : "scalar") << ", " << result.Threads << (result.Threads == 1 ? " thread: " : " threads: ")
+			<< result.MillisecondsPerFrame << " ms per frame, " << m_ParticleCount / (result.MillisecondsPerFrame * 1000.0f)
+			<< " M particles per second, " << single / result.MillisecondsPerFrame << "x one SIMD thread, "
+			<< result.Alive << " alive" << (same ? "" : ", DIFFERENT PARTICLES") << std::endl;
+		correct = correct && same;
+	}
+	return correct;
+}
+
+ParticleBenchmarkResult ParticleBenchmark::RunOnce(unsigned int threads, bool simd)
+{
+	/* the calling thread runs jobs while it waits, so one thread needs no job system at all */
+	std::unique_ptr<JobSystem> jobs;
+	if (threads > 1)
+		jobs.reset(new JobSystem(threads - 1, true));
+
+	CpuParticleSystem particles(m_ParticleCount, jobs.get());
+	particles.SetSimd(simd);
+	particles.SetDrag(0.3f);
+	particles.SetGround(-1.0f, 0.5f);
+	/* lifetimes average 2.5 seconds, at this rate the pool stays about full */
+	ParticleEmitter fountain = { glm::vec3(0.0f, -1.0f, 0.0f), 0.05f, glm::vec3(0.0f, 6.0f, 0.0f), 1.5f,
+		m_ParticleCount / 2.5f, 2.0f, 3.0f };
+
+	/* a few large steps reach the steady state where as many die as are born */
+	for (int step = 0; step < 40; step++)
+	{
+		particles.Emit(fountain, 0.1f);
+		particles.Update(0.1f);
+	}
+
+	const float deltaTime = 1.0f / 60.0f;
+	double milliseconds = 0.0;
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		particles.Emit(fountain, deltaTime);
+		auto start = std::chrono::steady_clock::now();
+		particles.Update(deltaTime);
+		milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	const ParticlePool& pool = particles.GetPool();
+	double checksum = 0.0;
+	for (unsigned int i = 0; i < particles.GetCount(); i++)
+		checksum += pool.PositionY[i];
+	return { threads, simd, (float)(milliseconds / m_Frames), particles.GetCount(), checksum };
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+struct ParticleBenchmarkResult
+{
+	unsigned int Threads;
+	bool Simd;
+	float MillisecondsPerFrame;
+	/* live particles at the end and the sum of their heights, to compare runs */
+	unsigned int Alive;
+	double Checksum;
+};
+
+/*
+* Measures CpuParticleSystem updates of a full pool
+* The pool is filled to a steady state first, then every frame emits what
+* died and updates everything, including writing the instance buffer. Runs
+* the scalar loops on one thread, then the SIMD kernels on 1, 2, 4 and so on
+* up to every hardware thread. Compaction keeps order, so every run must end
+* with the same particles. Needs a current GL context.
+*/
+class ParticleBenchmark
+{
+private:
+	unsigned int m_ParticleCount;
+	unsigned int m_Frames;
+public:
+	ParticleBenchmark(unsigned int particleCount = 1000000, unsigned int frames = 120);
+
+	/* Prints a line per run, returns false if any ended with different particles */
+	bool Run();
+
+private:
+	ParticleBenchmarkResult RunOnce(unsigned int threads, bool simd);
+};
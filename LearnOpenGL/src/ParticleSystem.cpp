@@ -0,0 +1,163 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "VertexBufferLayout.h"
+
+const unsigned int ParticleSystem::s_ColorKeyCount;
+
+/* one quad per instance as a triangle strip, corners in units of the particle size */
+static const float s_Corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+/* same generator as the perf suite, top 24 bits into [0, 1) */
+static float NextRandom(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+static glm::vec3 RandomInSphere(unsigned int& state, float radius)
+{
+	if (radius <= 0.0f)
+		return glm::vec3(0.0f);
+
+	glm::vec3 point;
+	do
+	{
+		point = glm::vec3(NextRandom(state), NextRandom(state), NextRandom(state)) * 2.0f - 1.0f;
+	} while (glm::dot(point, point) > 1.0f);
+	return point * radius;
+}
+
+void ParticleEmitter::Spawn(unsigned int& randomState, glm::vec3& position, glm::vec3& velocity, float& lifetime) const
+{
+	position = Position + RandomInSphere(randomState, Radius);
+	velocity = Velocity + RandomInSphere(randomState, Spread);
+	lifetime = MinLifetime + (MaxLifetime - MinLifetime) * NextRandom(randomState);
+}
+
+ParticleSystem::ParticleSystem(unsigned int capacity)
+	: m_Capacity(std::max(capacity, 1u)),
+	m_UpdateShader("res/shaders/ParticleUpdate.shader", "", { "v_PositionAge", "v_VelocityLifetime" }),
+	m_DrawShader("res/shaders/Particle.shader"), m_Corners(s_Corners, sizeof(s_Corners)), m_Current(0),
+	m_EmitCursor(0), m_EmitRemainder(0.0f), m_RandomState(1), m_Gravity(0.0f, -9.81f, 0.0f), m_Drag(0.0f),
+	m_StartSize(0.05f), m_EndSize(0.02f), m_Stats()
+{
+	/* all zero is all dead, an age of 0 has reached a lifetime of 0 */
+	std::vector<Particle> dead(m_Capacity, Particle());
+	VertexBufferLayout particleLayout;
+	particleLayout.Push<float>(4);
+	particleLayout.Push<float>(4);
+	VertexBufferLayout cornerLayout;
+	cornerLayout.Push<float>(2);
+
+	for (int i = 0; i < 2; i++)
+	{
+		m_Buffers[i].reset(new VertexBuffer(m_Capacity * (unsigned int)sizeof(Particle)));
+		m_Buffers[i]->SetSubData(dead.data(), 0, m_Capacity * (unsigned int)sizeof(Particle));
+		m_UpdateArrays[i].AddBuffer(*m_Buffers[i], particleLayout);
+		m_DrawArrays[i].AddBuffer(m_Corners, cornerLayout);
+		m_DrawArrays[i].AddBuffer(*m_Buffers[i], particleLayout, 1, 1);
+	}
+
+	glm::vec4 colors[s_ColorKeyCount] = {
+		glm::vec4(1.0f, 0.9f, 0.6f, 1.0f), glm::vec4(1.0f, 0.5f, 0.1f, 0.8f),
+		glm::vec4(0.6f, 0.1f, 0.05f, 0.5f), glm::vec4(0.1f, 0.1f, 0.1f, 0.0f)
+	};
+	SetColorOverLife(colors);
+	m_Stats.Capacity = m_Capacity;
+}
+
+void ParticleSystem::SetColorOverLife(const glm::vec4* colors)
+{
+	std::copy(colors, colors + s_ColorKeyCount, m_Colors);
+}
+
+void ParticleSystem::Emit(const ParticleEmitter& emitter, float deltaTime)
+{
+	float count = emitter.Rate * deltaTime + m_EmitRemainder;
+	unsigned int whole = (unsigned int)count;
+	m_EmitRemainder = count - whole;
+
+	/* more than the whole ring in one frame would only overwrite itself */
+	whole = std::min(whole, m_Capacity - std::min((unsigned int)m_Emitted.size(), m_Capacity));
+	for (unsigned int i = 0; i < whole; i++)
+	{
+		glm::vec3 position, velocity;
+		float lifetime;
+		emitter.Spawn(m_RandomState, position, velocity, lifetime);
+		m_Emitted.push_back({ position.x, position.y, position.z, 0.0f, velocity.x, velocity.y, velocity.z, lifetime });
+	}
+}
+
+void ParticleSystem::Update(float deltaTime)
+{
+	VertexBuffer& source = *m_Buffers[m_Current];
+	VertexBuffer& target = *m_Buffers[1 - m_Current];
+
+	/* new particles go into the next slots of the ring, in two pieces when it wraps */
+	unsigned int emitted = (unsigned int)m_Emitted.size();
+	unsigned int first = std::min(emitted, m_Capacity - m_EmitCursor);
+	if (first > 0)
+		source.SetSubData(m_Emitted.data(), m_EmitCursor * (unsigned int)sizeof(Particle), first * (unsigned int)sizeof(Particle));
+	if (emitted > first)
+		source.SetSubData(m_Emitted.data() + first, 0, (emitted - first) * (unsigned int)sizeof(Particle));
+	m_EmitCursor = (m_EmitCursor + emitted) % m_Capacity;
+	m_Emitted.clear();
+	m_Stats.EmittedLastFrame = emitted;
+	m_Stats.Emitted += emitted;
+
+	m_SimulateTimer.Begin();
+	m_UpdateShader.Bind();
+	m_UpdateShader.SetUniform1f("u_DeltaTime", deltaTime);
+	m_UpdateShader.SetUniform3f("u_Gravity", m_Gravity.x, m_Gravity.y, m_Gravity.z);
+	/* per frame factor that loses m_Drag of the velocity over a second whatever the frame rate */
+	m_UpdateShader.SetUniform1f("u_Damping", std::pow(std::max(1.0f - m_Drag, 0.0f), deltaTime));
+	m_UpdateArrays[m_Current].Bind();
+	target.BindFeedback(0);
+
+	GLCall(glEnable(GL_RASTERIZER_DISCARD));
+	GLCall(glBeginTransformFeedback(GL_POINTS));
+	GLCall(glDrawArrays(GL_POINTS, 0, m_Capacity));
+	GLCall(glEndTransformFeedback());
+	GLCall(glDisable(GL_RASTERIZER_DISCARD));
+	GLCall(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0));
+	RENDER_STAT(DrawCalls, 1);
+	m_SimulateTimer.End();
+
+	m_Current = 1 - m_Current;
+}
+
+void ParticleSystem::Draw(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection)
+{
+	m_DrawTimer.Begin();
+	m_DrawShader.Bind();
+	m_DrawShader.SetUniformMat4f("u_View", view);
+	m_DrawShader.SetUniformMat4f("u_Projection", projection);
+	m_DrawShader.SetUniform2f("u_Size", m_StartSize, m_EndSize);
+	m_DrawShader.SetUniform4fv("u_Colors", s_ColorKeyCount, &m_Colors[0].x);
+
+	/* additive needs no sorting, the order particles land in the ring does not matter */
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
+	GLCall(glDepthMask(GL_FALSE));
+	renderer.DrawArraysInstanced(m_DrawArrays[m_Current], m_DrawShader, GL_TRIANGLE_STRIP, 0, 4, m_Capacity);
+	GLCall(glDepthMask(GL_TRUE));
+	/* back to the blending everything else uses */
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	m_DrawTimer.End();
+}
+
+void ParticleSystem::FinishTiming()
+{
+	m_SimulateTimer.Finish();
+	m_DrawTimer.Finish();
+}
+
+ParticleStats ParticleSystem::GetStats() const
+{
+	ParticleStats stats = m_Stats;
+	stats.SimulateMilliseconds = m_SimulateTimer.GetAverageMilliseconds();
+	stats.DrawMilliseconds = m_DrawTimer.GetAverageMilliseconds();
+	return stats;
+}
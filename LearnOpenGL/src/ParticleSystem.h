@@ -0,0 +1,118 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "GpuTimer.h"
+
+/* State of one particle in the GPU buffers, dead once Age reaches Lifetime */
+struct Particle
+{
+	float X, Y, Z;
+	float Age;
+	float VelocityX, VelocityY, VelocityZ;
+	float Lifetime;
+};
+
+/* Where particles are born and how they start out */
+struct ParticleEmitter
+{
+	glm::vec3 Position;
+	/* particles start anywhere inside a sphere of this radius */
+	float Radius;
+	glm::vec3 Velocity;
+	/* random velocity inside a sphere of this radius is added */
+	float Spread;
+	/* particles per second */
+	float Rate;
+	/* seconds, picked uniformly in between */
+	float MinLifetime;
+	float MaxLifetime;
+
+	/* start of one particle, randomState is advanced */
+	void Spawn(unsigned int& randomState, glm::vec3& position, glm::vec3& velocity, float& lifetime) const;
+};
+
+struct ParticleStats
+{
+	unsigned int Capacity;
+	unsigned int EmittedLastFrame;
+	unsigned long long Emitted;
+	/* mean GPU time per frame over every measured frame */
+	float SimulateMilliseconds;
+	float DrawMilliseconds;
+};
+
+/*
+* Particles simulated on the GPU with transform feedback, state never returns to the CPU
+* Two buffers hold every particle and trade places each frame: a vertex only
+* program reads one, integrates gravity and drag and writes the other with
+* rasterizing off. Emitting writes the new particles into a ring of slots
+* of the buffer about to be read, the only upload per frame. Drawing reads
+* the same buffer per instance and expands each particle into a camera
+* facing quad, sized and colored by its age.
+*
+* Every slot is simulated every frame, dead or not, which keeps the GPU
+* work fixed and needs no counts read back. When Rate times MaxLifetime
+* exceeds the capacity the oldest particles are replaced early.
+*/
+class ParticleSystem
+{
+public:
+	/* colors over life are evenly spaced keys, birth to death */
+	static const unsigned int s_ColorKeyCount = 4;
+
+private:
+	unsigned int m_Capacity;
+	Shader m_UpdateShader;
+	Shader m_DrawShader;
+	std::unique_ptr<VertexBuffer> m_Buffers[2];
+	/* reading buffer i, for updating and for drawing */
+	VertexArray m_UpdateArrays[2];
+	VertexArray m_DrawArrays[2];
+	VertexBuffer m_Corners;
+	/* buffer with the latest state */
+	unsigned int m_Current;
+
+	std::vector<Particle> m_Emitted;
+	unsigned int m_EmitCursor;
+	/* fraction of a particle carried over to the next frame */
+	float m_EmitRemainder;
+	unsigned int m_RandomState;
+
+	glm::vec3 m_Gravity;
+	float m_Drag;
+	glm::vec4 m_Colors[s_ColorKeyCount];
+	float m_StartSize;
+	float m_EndSize;
+
+	GpuTimer m_SimulateTimer;
+	GpuTimer m_DrawTimer;
+	ParticleStats m_Stats;
+public:
+	ParticleSystem(unsigned int capacity);
+
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+	/* queues the particles emitter gives off over deltaTime, they start at the next Update */
+	void Emit(const ParticleEmitter& emitter, float deltaTime);
+	/* uploads the queued particles and advances every particle by deltaTime */
+	void Update(float deltaTime);
+	/* additive blending, depth is left unwritten */
+	void Draw(const Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+
+	inline void SetGravity(const glm::vec3& gravity) { m_Gravity = gravity; }
+	/* fraction of velocity lost per second */
+	inline void SetDrag(float drag) { m_Drag = drag; }
+	/* world units, the quad's half size at birth and at death */
+	inline void SetSize(float startSize, float endSize) { m_StartSize = startSize; m_EndSize = endSize; }
+	void SetColorOverLife(const glm::vec4* colors);
+
+	/* waits for the outstanding GPU timings so the stats cover every frame */
+	void FinishTiming();
+	ParticleStats GetStats() const;
+};
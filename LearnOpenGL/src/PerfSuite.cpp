@@ -0,0 +1,612 @@
+#include "PerfSuite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "Framebuffer.h"
+#include "DebugDraw.h"
+#include "ImageWriter.h"
+
+#include "stb_image/stb_image.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PERFSUITE_USE_SSE 1
+#endif
+
+/* Scenes */
+
+/* unit quad with texture coordinates, every sprite scene draws it scaled and moved */
+class SuiteQuad
+{
+private:
+	VertexArray m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+public:
+	SuiteQuad(float size)
+	{
+		float positions[] = {
+			0.0f, 0.0f, 0.0f, 0.0f,
+			size, 0.0f, 1.0f, 0.0f,
+			size, size, 1.0f, 1.0f,
+			0.0f, size, 0.0f, 1.0f
+		};
+		unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+
+		m_VertexBuffer.reset(new VertexBuffer(positions, sizeof(positions)));
+		VertexBufferLayout layout;
+		layout.Push<float>(2);
+		layout.Push<float>(2);
+		m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer.reset(new IndexBuffer(indices, 6));
+	}
+
+	inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+	inline const IndexBuffer& GetIndexBuffer() const { return *m_IndexBuffer; }
+};
+
+class SuiteScene
+{
+public:
+	virtual ~SuiteScene() {}
+	virtual const char* GetName() const = 0;
+	virtual void Draw(const Renderer& renderer) = 0;
+};
+
+/* fixed seed so every run and every machine draws the same thing */
+static unsigned int NextRandom(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+static const int s_CheckerSize = 32;
+
+static std::vector<unsigned char> MakeCheckerPixels(unsigned int seed)
+{
+	const int size = s_CheckerSize;
+	unsigned char tint[3] = { (unsigned char)(64 + seed * 37 % 192), (unsigned char)(64 + seed * 91 % 192), (unsigned char)(64 + seed * 53 % 192) };
+	std::vector<unsigned char> pixels(size * size * 4);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned char* pixel = &pixels[(y * size + x) * 4];
+			bool light = ((x / 8) + (y / 8)) % 2 == 0;
+			for (int c = 0; c < 3; c++)
+				pixel[c] = light ? tint[c] : tint[c] / 2;
+			pixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+static std::unique_ptr<Texture> MakeCheckerTexture(unsigned int seed)
+{
+	std::vector<unsigned char> pixels = MakeCheckerPixels(seed);
+	return std::unique_ptr<Texture>(new Texture(s_CheckerSize, s_CheckerSize, pixels.data()));
+}
+
+/* the quad the application draws, same shader, texture and matrices */
+class TexturedQuadScene : public SuiteScene
+{
+private:
+	SuiteQuad m_Quad;
+	Shader m_Shader;
+	Texture m_Texture;
+public:
+	TexturedQuadScene()
+		: m_Quad(100.0f), m_Shader("res/shaders/Basic.shader"), m_Texture("res/textures/Emily_D&P_NoBG.png")
+	{
+		glm::mat4 proj = glm::ortho(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+		glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-100, 0, 0));
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(300, 300, 0));
+
+		m_Shader.Bind();
+		m_Shader.SetUniformMat4f("u_MVP", proj * view * model);
+		m_Shader.SetUniform1i("u_Texture", 0);
+	}
+
+	const char* GetName() const override { return "textured_quad"; }
+
+	void Draw(const Renderer& renderer) override
+	{
+		m_Texture.Bind();
+		m_Shader.Bind();
+		m_Shader.SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
+		renderer.Draw(m_Quad.GetVertexArray(), m_Quad.GetIndexBuffer(), m_Shader);
+	}
+};
+
+/*
+* Sprites with their own matrix and color, one draw each. textureCount and
+* shaderCount above one rotate through that many textures or programs so the
+* cost of switching them shows up against the plain sprite scene.
+*/
+class SpriteScene : public SuiteScene
+{
+private:
+	struct Sprite
+	{
+		glm::mat4 MVP;
+		glm::vec4 Color;
+	};
+
+	const char* m_Name;
+	SuiteQuad m_Quad;
+	std::vector<std::unique_ptr<Texture>> m_Textures;
+	std::vector<std::unique_ptr<Shader>> m_Shaders;
+	std::vector<Sprite> m_Sprites;
+public:
+	SpriteScene(const char* name, int width, int height, unsigned int spriteCount, unsigned int textureCount, unsigned int shaderCount)
+		: m_Name(name), m_Quad(32.0f)
+	{
+		for (unsigned int i = 0; i < textureCount; i++)
+			m_Textures.push_back(MakeCheckerTexture(i));
+
+		for (unsigned int i = 0; i < shaderCount; i++)
+		{
+			std::string defines = shaderCount > 1 ? "#define VARIANT " + std::to_string(i) : "";
+			m_Shaders.emplace_back(new Shader("res/shaders/Sprite.shader", defines));
+			m_Shaders.back()->Bind();
+			m_Shaders.back()->SetUniform1i("u_Texture", 0);
+		}
+
+		glm::mat4 proj = glm::ortho(0.0f, (float)width, 0.0f, (float)height, -1.0f, 1.0f);
+		unsigned int seed = 1;
+		for (unsigned int i = 0; i < spriteCount; i++)
+		{
+			float x = (float)(NextRandom(seed) % (unsigned int)std::max(1, width - 32));
+			float y = (float)(NextRandom(seed) % (unsigned int)std::max(1, height - 32));
+			/* one statement each, argument evaluation order differs between compilers */
+			float r = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			float g = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			float b = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			m_Sprites.push_back({ proj * glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)), glm::vec4(r, g, b, 1.0f) });
+		}
+	}
+
+	const char* GetName() const override { return m_Name; }
+
+	void Draw(const Renderer& renderer) override
+	{
+		for (size_t i = 0; i < m_Sprites.size(); i++)
+		{
+			const Sprite& sprite = m_Sprites[i];
+			Shader& shader = *m_Shaders[i % m_Shaders.size()];
+			/* only rebinds when the texture actually changes, like a renderer sorting by material would */
+			if (i == 0 || m_Textures.size() > 1)
+				m_Textures[i % m_Textures.size()]->Bind();
+
+			shader.Bind();
+			shader.SetUniformMat4f("u_MVP", sprite.MVP);
+			shader.SetUniform4f("u_Color", sprite.Color.r, sprite.Color.g, sprite.Color.b, sprite.Color.a);
+			renderer.Draw(m_Quad.GetVertexArray(), m_Quad.GetIndexBuffer(), shader);
+		}
+	}
+};
+
+/*
+* Same sprites, colors and textures as the textures scene but every texture is
+* a layer of one texture array, so all sprites go into one vertex buffer and
+* draw with a single bind and a single draw call.
+*/
+class TextureArrayScene : public SuiteScene
+{
+private:
+	VertexArray m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	Shader m_Shader;
+	TextureArray m_Textures;
+public:
+	TextureArrayScene(int width, int height, unsigned int spriteCount, unsigned int textureCount)
+		: m_Shader("res/shaders/SpriteArray.shader"), m_Textures(s_CheckerSize, s_CheckerSize, textureCount)
+	{
+		for (unsigned int i = 0; i < textureCount; i++)
+			m_Textures.AddLayer(s_CheckerSize, s_CheckerSize, MakeCheckerPixels(i).data());
+
+		/* x, y, u, v, layer, r, g, b, a */
+		const float size = 32.0f;
+		const float corners[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		vertices.reserve(spriteCount * 4 * 9);
+		indices.reserve(spriteCount * 6);
+
+		/* same random sequence as SpriteScene so the image matches the textures golden */
+		unsigned int seed = 1;
+		for (unsigned int i = 0; i < spriteCount; i++)
+		{
+			float x = (float)(NextRandom(seed) % (unsigned int)std::max(1, width - 32));
+			float y = (float)(NextRandom(seed) % (unsigned int)std::max(1, height - 32));
+			float r = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			float g = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			float b = 0.5f + (NextRandom(seed) % 128) / 255.0f;
+			float layer = (float)(i % textureCount);
+
+			unsigned int first = i * 4;
+			for (int corner = 0; corner < 4; corner++)
+			{
+				float vertex[9] = { x + corners[corner][0] * size, y + corners[corner][1] * size,
+					corners[corner][0], corners[corner][1], layer, r, g, b, 1.0f };
+				vertices.insert(vertices.end(), vertex, vertex + 9);
+			}
+			unsigned int quad[6] = { first, first + 1, first + 2, first + 2, first + 3, first };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+
+		m_VertexBuffer.reset(new VertexBuffer(vertices.data(), (unsigned int)(vertices.size() * sizeof(float))));
+		VertexBufferLayout layout;
+		layout.Push<float>(2);
+		layout.Push<float>(3);
+		layout.Push<float>(4);
+		m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+		m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+		m_Shader.Bind();
+		m_Shader.SetUniform1i("u_Textures", 0);
+		m_Shader.SetUniformMat4f("u_MVP", glm::ortho(0.0f, (float)width, 0.0f, (float)height, -1.0f, 1.0f));
+	}
+
+	const char* GetName() const override { return "texture_array"; }
+
+	void Draw(const Renderer& renderer) override
+	{
+		m_Textures.Bind();
+		renderer.Draw(m_VertexArray, *m_IndexBuffer, m_Shader);
+	}
+};
+
+/* full screen layers blended on top of each other, fill rate bound */
+class OverdrawScene : public SuiteScene
+{
+private:
+	SuiteQuad m_Quad;
+	Shader m_Shader;
+	std::unique_ptr<Texture> m_Texture;
+	unsigned int m_Layers;
+	glm::mat4 m_MVP;
+public:
+	OverdrawScene(int width, int height, unsigned int layers)
+		: m_Quad(1.0f), m_Shader("res/shaders/Sprite.shader"), m_Texture(MakeCheckerTexture(7)), m_Layers(layers)
+	{
+		/* the unit quad scaled to cover the viewport in pixels, like the sprite scenes */
+		m_MVP = glm::ortho(0.0f, (float)width, 0.0f, (float)height, -1.0f, 1.0f)
+			* glm::scale(glm::mat4(1.0f), glm::vec3((float)width, (float)height, 1.0f));
+		m_Shader.Bind();
+		m_Shader.SetUniform1i("u_Texture", 0);
+		m_Shader.SetUniformMat4f("u_MVP", m_MVP);
+	}
+
+	const char* GetName() const override { return "overdraw"; }
+
+	void Draw(const Renderer& renderer) override
+	{
+		m_Texture->Bind();
+		m_Shader.Bind();
+		for (unsigned int i = 0; i < m_Layers; i++)
+		{
+			float shade = (float)(i + 1) / m_Layers;
+			m_Shader.SetUniform4f("u_Color", shade, 1.0f - shade, 0.5f, 0.1f);
+			renderer.Draw(m_Quad.GetVertexArray(), m_Quad.GetIndexBuffer(), m_Shader);
+		}
+	}
+};
+
+/*
+* A million short debug lines queued and drawn every frame, the load DebugDraw
+* is sized for, with one of each shape on top in both depth modes
+*/
+class DebugLinesScene : public SuiteScene
+{
+private:
+	DebugDraw m_DebugDraw;
+	glm::mat4 m_ViewProjection;
+	int m_Width, m_Height;
+	unsigned int m_LineCount;
+public:
+	DebugLinesScene(int width, int height, unsigned int lineCount)
+		: m_DebugDraw(width, height), m_Width(width), m_Height(height), m_LineCount(lineCount)
+	{
+		m_ViewProjection = glm::ortho(0.0f, (float)width, 0.0f, (float)height, -1.0f, 1.0f);
+	}
+
+	const char* GetName() const override { return "debug_lines"; }
+
+	void Draw(const Renderer& renderer) override
+	{
+		unsigned int seed = 1;
+		for (unsigned int i = 0; i < m_LineCount; i++)
+		{
+			glm::vec3 from((float)(NextRandom(seed) % (unsigned int)m_Width), (float)(NextRandom(seed) % (unsigned int)m_Height), 0.0f);
+			glm::vec3 to = from + glm::vec3((float)(NextRandom(seed) % 9) - 4.0f, (float)(NextRandom(seed) % 9) - 4.0f, 0.0f);
+			/* colored by the cell of an 8 x 8 grid the line starts in */
+			glm::vec4 color((int)(from.x * 8 / m_Width) / 8.0f, (int)(from.y * 8 / m_Height) / 8.0f, 0.5f, 1.0f);
+			m_DebugDraw.Line(from, to, color);
+		}
+
+		glm::vec3 center(m_Width * 0.5f, m_Height * 0.5f, 0.0f);
+		m_DebugDraw.Grid(center - glm::vec3(200.0f, 200.0f, 0.0f), glm::vec3(40.0f, 0.0f, 0.0f), glm::vec3(0.0f, 40.0f, 0.0f), 10, 10, glm::vec4(1.0f));
+		m_DebugDraw.Box(AABB(center - glm::vec3(100.0f, 60.0f, 0.0f), center + glm::vec3(100.0f, 60.0f, 0.0f)), glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+		m_DebugDraw.Circle(center, glm::vec3(0.0f, 0.0f, 1.0f), 150.0f, glm::vec4(0.0f, 1.0f, 1.0f, 1.0f), 64);
+		m_DebugDraw.Arrow(center, center + glm::vec3(180.0f, 120.0f, 0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), 24.0f, 0.0f, DebugDepth::Overlay);
+		glm::vec3 zigzag[5] = { center + glm::vec3(-220.0f, -150.0f, 0.0f), center + glm::vec3(-110.0f, -90.0f, 0.0f),
+			center + glm::vec3(0.0f, -150.0f, 0.0f), center + glm::vec3(110.0f, -90.0f, 0.0f), center + glm::vec3(220.0f, -150.0f, 0.0f) };
+		m_DebugDraw.Polyline(zigzag, 5, glm::vec4(0.2f, 1.0f, 0.2f, 1.0f), 6.0f, false, 0.0f, DebugDepth::Overlay);
+
+		m_DebugDraw.Draw(renderer, m_ViewProjection, 1.0f / 60.0f);
+	}
+};
+
+/* PerfSuite */
+
+PerfSuite::PerfSuite(const std::string& directory, int width, int height)
+	: m_Directory(directory), m_Width(width), m_Height(height), m_WarmupFrames(5), m_MeasuredFrames(30),
+	m_PixelTolerance(2), m_MaxDifferentPixels(0.001f), m_TimingThreshold(0.25f), m_UpdateBaseline(false)
+{
+}
+
+bool PerfSuite::Run(const std::string& reportPath)
+{
+	std::string baseline;
+	if (!m_UpdateBaseline)
+	{
+		std::ifstream stream(m_Directory + "/baseline.json");
+		std::stringstream ss;
+		ss << stream.rdbuf();
+		baseline = ss.str();
+		if (baseline.empty())
+			std::cout << "No baseline in " << m_Directory << ", timings are not checked" << std::endl;
+	}
+
+	GLCall(glEnable(GL_BLEND));
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+	Framebuffer framebuffer(m_Width, m_Height);
+	Renderer renderer;
+	std::vector<SceneResult> results;
+	bool passed = true;
+
+	for (int sceneIndex = 0; ; sceneIndex++)
+	{
+		/* scenes are built one at a time so each only pays for its own resources */
+		std::unique_ptr<SuiteScene> scene;
+		switch (sceneIndex)
+		{
+		case 0: scene.reset(new TexturedQuadScene()); break;
+		case 1: scene.reset(new SpriteScene("sprites", m_Width, m_Height, 1000, 1, 1)); break;
+		case 2: scene.reset(new SpriteScene("textures", m_Width, m_Height, 1000, 256, 1)); break;
+		case 3: scene.reset(new SpriteScene("shaders", m_Width, m_Height, 1000, 1, 64)); break;
+		case 4: scene.reset(new TextureArrayScene(m_Width, m_Height, 1000, 256)); break;
+		case 5: scene.reset(new OverdrawScene(m_Width, m_Height, 16)); break;
+		case 6: scene.reset(new DebugLinesScene(m_Width, m_Height, 1000000)); break;
+		}
+		if (!scene)
+			break;
+
+		SceneResult result = {};
+		result.Name = scene->GetName();
+		result.BaselineCpuMilliseconds = -1.0f;
+		result.Passed = true;
+
+		std::vector<float> cpuTimes;
+		double frameTime = 0.0;
+		for (unsigned int frame = 0; frame < m_WarmupFrames + m_MeasuredFrames; frame++)
+		{
+			framebuffer.Bind();
+			/* drops the bind and last frame's glFinish so only the scene is counted */
+			RenderStats::EndFrame();
+
+			auto start = std::chrono::steady_clock::now();
+			renderer.Clear();
+			scene->Draw(renderer);
+			auto submitted = std::chrono::steady_clock::now();
+			RenderStats::EndFrame();
+			RenderStatsFrame counters = RenderStats::GetLastFrame();
+			GLCall(glFinish());
+			auto finished = std::chrono::steady_clock::now();
+
+			if (frame < m_WarmupFrames)
+				continue;
+
+			cpuTimes.push_back(std::chrono::duration<float, std::milli>(submitted - start).count());
+			frameTime += std::chrono::duration<double, std::milli>(finished - start).count();
+			result.GLCalls = counters.Get(RenderCounter::GLCalls);
+			result.DrawCalls = counters.Get(RenderCounter::DrawCalls);
+			result.Triangles = counters.Get(RenderCounter::Triangles);
+			result.StateChanges = counters.GetStateChanges();
+			result.UniformUploads = counters.Get(RenderCounter::UniformUploads);
+		}
+
+		std::sort(cpuTimes.begin(), cpuTimes.end());
+		result.CpuMilliseconds = cpuTimes[cpuTimes.size() / 2];
+		result.CpuP95Milliseconds = cpuTimes[std::min(cpuTimes.size() - 1, cpuTimes.size() * 95 / 100)];
+		result.FrameMilliseconds = (float)(frameTime / m_MeasuredFrames);
+
+		std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+		GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+		GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		CheckImage(result, pixels);
+
+		if (!baseline.empty() && FindBaseline(baseline, result.Name, result.BaselineCpuMilliseconds))
+		{
+			/* small absolute slack so scenes that take microseconds do not fail on noise */
+			float limit = result.BaselineCpuMilliseconds * (1.0f + m_TimingThreshold) + 0.05f;
+			if (result.CpuMilliseconds > limit)
+			{
+				result.Passed = false;
+				result.Failure += "cpu time regressed; ";
+			}
+		}
+
+		std::cout << (result.Passed ? "[PASS] " : "[FAIL] ") << result.Name << " cpu " << result.CpuMilliseconds
+			<< " ms (baseline " << result.BaselineCpuMilliseconds << "), frame " << result.FrameMilliseconds
+			<< " ms, " << result.DrawCalls << " draws, " << result.StateChanges << " state changes, "
+			<< result.GLCalls << " gl calls, " << result.DifferentPixels << " different pixels " << result.Failure << std::endl;
+
+		passed = passed && result.Passed;
+		results.push_back(result);
+	}
+	framebuffer.UnBind();
+
+	std::ofstream report(reportPath);
+	WriteReport(report, results, m_Width, m_Height, m_MeasuredFrames);
+	if (m_UpdateBaseline)
+	{
+		std::ofstream stream(m_Directory + "/baseline.json");
+		WriteReport(stream, results, m_Width, m_Height, m_MeasuredFrames);
+	}
+
+	return passed;
+}
+
+void PerfSuite::CheckImage(SceneResult& result, const std::vector<unsigned char>& pixels) const
+{
+	std::string goldenPath = m_Directory + "/golden/" + result.Name + ".png";
+	if (m_UpdateBaseline)
+	{
+		ImageWriter::WritePNG(goldenPath, pixels.data(), m_Width, m_Height);
+		return;
+	}
+
+	/* goldens are stored top row first, flipping on load matches glReadPixels */
+	stbi_set_flip_vertically_on_load(1);
+	int width, height, channels;
+	unsigned char* golden = stbi_load(goldenPath.c_str(), &width, &height, &channels, 4);
+	if (!golden)
+	{
+		result.Passed = false;
+		result.Failure += "missing golden image; ";
+		return;
+	}
+
+	if (width != m_Width || height != m_Height)
+	{
+		result.Passed = false;
+		result.Failure += "golden image size differs; ";
+	}
+	else
+	{
+		result.DifferentPixels = CompareImages(pixels.data(), golden, (size_t)width * height, m_PixelTolerance, result.MaxDifference);
+		if (result.DifferentPixels > (unsigned long long)(m_MaxDifferentPixels * width * height))
+		{
+			result.Passed = false;
+			result.Failure += "image differs; ";
+		}
+	}
+	stbi_image_free(golden);
+}
+
+unsigned long long PerfSuite::CompareImages(const unsigned char* a, const unsigned char* b, size_t pixelCount,
+	int tolerance, int& maxDifference)
+{
+	unsigned long long different = 0;
+	size_t i = 0;
+	maxDifference = 0;
+
+#ifdef PERFSUITE_USE_SSE
+	/* four RGBA pixels per iteration */
+	__m128i threshold = _mm_set1_epi8((char)tolerance);
+	__m128i zero = _mm_setzero_si128();
+	__m128i maximum = zero;
+	for (; i + 4 <= pixelCount; i += 4)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i * 4));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + i * 4));
+		/* |a - b| with saturating subtraction both ways */
+		__m128i difference = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+		maximum = _mm_max_epu8(maximum, difference);
+
+		/* bytes past the tolerance are non zero after subtracting it */
+		int withinTolerance = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(difference, threshold), zero));
+		if (withinTolerance == 0xffff)
+			continue;
+		for (int pixel = 0; pixel < 4; pixel++)
+			different += ((withinTolerance >> (pixel * 4)) & 0xf) != 0xf;
+	}
+
+	unsigned char lanes[16];
+	_mm_storeu_si128((__m128i*)lanes, maximum);
+	for (int lane = 0; lane < 16; lane++)
+		maxDifference = std::max(maxDifference, (int)lanes[lane]);
+#endif
+
+	for (; i < pixelCount; i++)
+	{
+		bool differs = false;
+		for (int c = 0; c < 4; c++)
+		{
+			int difference = std::abs((int)a[i * 4 + c] - (int)b[i * 4 + c]);
+			maxDifference = std::max(maxDifference, difference);
+			differs = differs || difference > tolerance;
+		}
+		different += differs;
+	}
+	return different;
+}
+
+void PerfSuite::WriteReport(std::ostream& stream, const std::vector<SceneResult>& results, int width, int height, unsigned int frames)
+{
+	bool passed = true;
+	for (const SceneResult& result : results)
+		passed = passed && result.Passed;
+
+	stream << "{\n";
+	stream << "  \"width\": " << width << ",\n";
+	stream << "  \"height\": " << height << ",\n";
+	stream << "  \"frames\": " << frames << ",\n";
+	stream << "  \"passed\": " << (passed ? "true" : "false") << ",\n";
+	stream << "  \"scenes\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const SceneResult& result = results[i];
+		stream << "    {\n";
+		stream << "      \"name\": \"" << result.Name << "\",\n";
+		stream << "      \"cpu_ms\": " << result.CpuMilliseconds << ",\n";
+		stream << "      \"cpu_p95_ms\": " << result.CpuP95Milliseconds << ",\n";
+		stream << "      \"frame_ms\": " << result.FrameMilliseconds << ",\n";
+		stream << "      \"gl_calls\": " << result.GLCalls << ",\n";
+		stream << "      \"draw_calls\": " << result.DrawCalls << ",\n";
+		stream << "      \"triangles\": " << result.Triangles << ",\n";
+		stream << "      \"state_changes\": " << result.StateChanges << ",\n";
+		stream << "      \"uniform_uploads\": " << result.UniformUploads << ",\n";
+		stream << "      \"different_pixels\": " << result.DifferentPixels << ",\n";
+		stream << "      \"max_difference\": " << result.MaxDifference << ",\n";
+		stream << "      \"baseline_cpu_ms\": " << result.BaselineCpuMilliseconds << ",\n";
+		stream << "      \"passed\": " << (result.Passed ? "true" : "false") << ",\n";
+		stream << "      \"failure\": \"" << result.Failure << "\"\n";
+		stream << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	stream << "  ]\n";
+	stream << "}\n";
+}
+
+bool PerfSuite::FindBaseline(const std::string& json, const std::string& scene, float& cpuMilliseconds)
+{
+	/* only reads reports written by WriteReport, not a general JSON parser */
+	size_t position = json.find("\"name\": \"" + scene + "\"");
+	if (position == std::string::npos)
+		return false;
+
+	const std::string key = "\"cpu_ms\": ";
+	position = json.find(key, position);
+	if (position == std::string::npos)
+		return false;
+
+	cpuMilliseconds = std::stof(json.substr(position + key.size(), 32));
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/* Measurements and checks for one scene, written to the JSON report */
+struct SceneResult
+{
+	std::string Name;
+	/* submission time on the CPU, median and 95th percentile over the measured frames */
+	float CpuMilliseconds;
+	float CpuP95Milliseconds;
+	/* submission plus glFinish, the whole frame on a software rasterizer */
+	float FrameMilliseconds;
+	/* per frame */
+	unsigned long long GLCalls;
+	unsigned long long DrawCalls;
+	unsigned long long Triangles;
+	unsigned long long StateChanges;
+	unsigned long long UniformUploads;
+
+	unsigned long long DifferentPixels;
+	int MaxDifference;
+	/* negative when the baseline has no entry for this scene */
+	float BaselineCpuMilliseconds;
+	bool Passed;
+	std::string Failure;
+};
+
+/*
+* Scripted scenes rendered headless for performance and image regressions
+* Each scene is drawn for a few warm up frames and then measured. The last
+* frame is compared against golden/<scene>.png and the median CPU time
+* against baseline.json, both inside the suite directory. Goldens and the
+* baseline are made on Mesa llvmpipe with SetUpdateBaseline and checked in.
+*/
+class PerfSuite
+{
+private:
+	std::string m_Directory;
+	int m_Width, m_Height;
+	unsigned int m_WarmupFrames;
+	unsigned int m_MeasuredFrames;
+	/* largest per channel difference that still counts as equal */
+	int m_PixelTolerance;
+	/* fraction of pixels allowed past the tolerance */
+	float m_MaxDifferentPixels;
+	/* allowed slowdown against the baseline, 0.25 is 25% */
+	float m_TimingThreshold;
+	bool m_UpdateBaseline;
+public:
+	PerfSuite(const std::string& directory, int width, int height);
+
+	inline void SetUpdateBaseline(bool update) { m_UpdateBaseline = update; }
+	inline void SetTimingThreshold(float threshold) { m_TimingThreshold = threshold; }
+	inline void SetPixelTolerance(int tolerance) { m_PixelTolerance = tolerance; }
+
+	/* Runs every scene, writes the report and returns true when nothing regressed. Needs a current GL context */
+	bool Run(const std::string& reportPath);
+
+	/* Counts pixels where any channel differs by more than tolerance, SSE2 when available */
+	static unsigned long long CompareImages(const unsigned char* a, const unsigned char* b, size_t pixelCount,
+		int tolerance, int& maxDifference);
+
+private:
+	void CheckImage(SceneResult& result, const std::vector<unsigned char>& pixels) const;
+	static void WriteReport(std::ostream& stream, const std::vector<SceneResult>& results, int width, int height, unsigned int frames);
+	static bool FindBaseline(const std::string& json, const std::string& scene, float& cpuMilliseconds);
+};
@@ -0,0 +1,87 @@
+#include "PoolAllocator.h"
+
+#include <algorithm>
+
+/* every block keeps the alignment operator new would give */
+static const std::size_t s_BlockAlignment = alignof(std::max_align_t);
+
+static std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+PoolAllocator::PoolAllocator(std::size_t blockSize, std::size_t blocksPerChunk, std::pmr::memory_resource* upstream)
+	: m_BlockSize(AlignUp(std::max(blockSize, sizeof(FreeBlock)), s_BlockAlignment)), m_BlocksPerChunk(std::max<std::size_t>(blocksPerChunk, 1)),
+	m_Upstream(upstream), m_Free(nullptr), m_Chunks(nullptr), m_Stats()
+{
+	m_Stats.BlockSize = m_BlockSize;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	std::size_t chunkBytes = s_BlockAlignment + m_BlockSize * m_BlocksPerChunk;
+	while (m_Chunks)
+	{
+		Chunk* next = m_Chunks->Next;
+		m_Upstream->deallocate(m_Chunks, chunkBytes, s_BlockAlignment);
+		m_Chunks = next;
+	}
+}
+
+void* PoolAllocator::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	if (bytes > m_BlockSize || alignment > s_BlockAlignment)
+	{
+		m_Stats.Oversized++;
+		return m_Upstream->allocate(bytes, alignment);
+	}
+
+	if (!m_Free)
+		AddChunk();
+	FreeBlock* block = m_Free;
+	m_Free = block->Next;
+
+	m_Stats.BlocksInUse++;
+	m_Stats.PeakBlocksInUse = std::max(m_Stats.PeakBlocksInUse, m_Stats.BlocksInUse);
+	return block;
+}
+
+void PoolAllocator::do_deallocate(void* memory, std::size_t bytes, std::size_t alignment)
+{
+	if (bytes > m_BlockSize || alignment > s_BlockAlignment)
+	{
+		m_Upstream->deallocate(memory, bytes, alignment);
+		return;
+	}
+
+	FreeBlock* block = (FreeBlock*)memory;
+	block->Next = m_Free;
+	m_Free = block;
+	m_Stats.BlocksInUse--;
+}
+
+bool PoolAllocator::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+void PoolAllocator::AddChunk()
+{
+	/* the chain link takes the first aligned slot, the blocks follow */
+	unsigned char* memory = (unsigned char*)m_Upstream->allocate(s_BlockAlignment + m_BlockSize * m_BlocksPerChunk, s_BlockAlignment);
+	Chunk* chunk = (Chunk*)memory;
+	chunk->Next = m_Chunks;
+	m_Chunks = chunk;
+
+	/* threaded back to front so blocks come out in address order */
+	unsigned char* blocks = memory + s_BlockAlignment;
+	for (std::size_t i = m_BlocksPerChunk; i-- > 0;)
+	{
+		FreeBlock* block = (FreeBlock*)(blocks + i * m_BlockSize);
+		block->Next = m_Free;
+		m_Free = block;
+	}
+
+	m_Stats.Blocks += m_BlocksPerChunk;
+	m_Stats.Chunks++;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+struct PoolAllocatorStats
+{
+	std::size_t BlockSize;
+	/* blocks in every chunk taken so far, free or not */
+	std::size_t Blocks;
+	std::size_t BlocksInUse;
+	std::size_t PeakBlocksInUse;
+	unsigned int Chunks;
+	/* requests larger than a block, passed on to the upstream resource */
+	unsigned long long Oversized;
+};
+
+/*
+* Fixed size block allocator for objects that come and go
+* Blocks are carved from chunks taken from the upstream resource and kept
+* on an intrusive free list, so allocating and freeing are a pointer swap
+* and a freed block is reused by the next allocation, usually still in
+* cache. Chunks are only returned when the pool is destroyed. It is a pmr
+* memory resource, node based containers such as std::pmr::unordered_map
+* use it for their nodes, whose size never changes. Anything bigger than a
+* block, like a hash table's bucket array, goes to upstream. Not thread safe.
+* Only Shader's uniform location cache uses it, the buffers, vertex arrays
+* and textures are made while loading and never churn inside a frame.
+*/
+class PoolAllocator : public std::pmr::memory_resource
+{
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+	struct Chunk
+	{
+		Chunk* Next;
+	};
+
+	std::size_t m_BlockSize;
+	std::size_t m_BlocksPerChunk;
+	std::pmr::memory_resource* m_Upstream;
+	FreeBlock* m_Free;
+	Chunk* m_Chunks;
+	PoolAllocatorStats m_Stats;
+public:
+	PoolAllocator(std::size_t blockSize, std::size_t blocksPerChunk = 64,
+		std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+	~PoolAllocator();
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	inline const PoolAllocatorStats& GetStats() const { return m_Stats; }
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	void AddChunk();
+};
@@ -0,0 +1,68 @@
+#include "RenderStats.h"
+
+const unsigned int RenderStats::s_HistorySize;
+std::atomic<unsigned long long> RenderStats::s_Current[(int)RenderCounter::Count];
+RenderStatsFrame RenderStats::s_Completed[2];
+std::atomic<int> RenderStats::s_CompletedIndex(0);
+RenderStats::Clock::time_point RenderStats::s_FrameStart = RenderStats::Clock::now();
+unsigned long long RenderStats::s_FrameIndex = 0;
+float RenderStats::s_History[RenderStats::s_HistorySize];
+unsigned int RenderStats::s_HistoryNext = 0;
+
+unsigned long long RenderStatsFrame::GetStateChanges() const
+{
+	return Get(RenderCounter::ProgramBinds) + Get(RenderCounter::VertexArrayBinds) + Get(RenderCounter::BufferBinds)
+		+ Get(RenderCounter::TextureBinds) + Get(RenderCounter::FramebufferBinds);
+}
+
+void RenderStats::EndFrame()
+{
+	Clock::time_point now = Clock::now();
+
+	/* write into the block readers are not looking at, then publish it */
+	int target = 1 - s_CompletedIndex.load(std::memory_order_relaxed);
+	RenderStatsFrame& frame = s_Completed[target];
+	for (int i = 0; i < (int)RenderCounter::Count; i++)
+		frame.Values[i] = s_Current[i].exchange(0, std::memory_order_relaxed);
+	frame.FrameMilliseconds = std::chrono::duration<float, std::milli>(now - s_FrameStart).count();
+	frame.FrameIndex = s_FrameIndex++;
+	s_CompletedIndex.store(target, std::memory_order_release);
+
+	s_History[s_HistoryNext % s_HistorySize] = frame.FrameMilliseconds;
+	s_HistoryNext++;
+	s_FrameStart = now;
+}
+
+RenderStatsFrame RenderStats::GetLastFrame()
+{
+	return s_Completed[s_CompletedIndex.load(std::memory_order_acquire)];
+}
+
+unsigned int RenderStats::GetFrameHistory(float* milliseconds)
+{
+	unsigned int count = s_HistoryNext < s_HistorySize ? s_HistoryNext : s_HistorySize;
+	unsigned int first = s_HistoryNext - count;
+	for (unsigned int i = 0; i < count; i++)
+		milliseconds[i] = s_History[(first + i) % s_HistorySize];
+	return count;
+}
+
+const char* RenderStats::GetName(RenderCounter counter)
+{
+	switch (counter)
+	{
+		case RenderCounter::DrawCalls: return "DRAWS";
+		case RenderCounter::Triangles: return "TRIS";
+		case RenderCounter::ProgramBinds: return "PROGRAMS";
+		case RenderCounter::VertexArrayBinds: return "VAOS";
+		case RenderCounter::BufferBinds: return "BUFFERS";
+		case RenderCounter::TextureBinds: return "TEXTURES";
+		case RenderCounter::FramebufferBinds: return "FBOS";
+		case RenderCounter::UniformUploads: return "UNIFORMS";
+		case RenderCounter::BufferBytesUploaded: return "BUF BYTES";
+		case RenderCounter::TextureBytesUploaded: return "TEX BYTES";
+		case RenderCounter::GLCalls: return "GL CALLS";
+		case RenderCounter::GLErrorChecks: return "GETERROR";
+		default: return "";
+	}
+}
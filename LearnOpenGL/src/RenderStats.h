@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+/*
+* Set to 0 to compile every RENDER_STAT out, RenderStats then only tracks
+* frame times and all counters read as zero.
+*/
+#ifndef RENDER_STATS_ENABLED
+#define RENDER_STATS_ENABLED 1
+#endif
+
+enum class RenderCounter
+{
+	DrawCalls,
+	Triangles,
+	ProgramBinds,
+	VertexArrayBinds,
+	BufferBinds,
+	TextureBinds,
+	FramebufferBinds,
+	UniformUploads,
+	BufferBytesUploaded,
+	TextureBytesUploaded,
+	GLCalls,
+	GLErrorChecks,
+	Count
+};
+
+/* One finished frame worth of counters */
+struct RenderStatsFrame
+{
+	unsigned long long Values[(int)RenderCounter::Count];
+	/* CPU time between the EndFrame calls that bracket this frame */
+	float FrameMilliseconds;
+	unsigned long long FrameIndex;
+
+	inline unsigned long long Get(RenderCounter counter) const { return Values[(int)counter]; }
+	/* every kind of bind added together */
+	unsigned long long GetStateChanges() const;
+};
+
+/*
+* Per frame counters every GL wrapper adds to
+* Counting is a relaxed atomic add, so any thread may count without locks.
+* EndFrame swaps the running block out into one of two completed frames, the
+* last complete frame can then be read while the next one is being counted.
+*/
+class RenderStats
+{
+public:
+	static const unsigned int s_HistorySize = 128;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static std::atomic<unsigned long long> s_Current[(int)RenderCounter::Count];
+	static RenderStatsFrame s_Completed[2];
+	/* index into s_Completed of the last finished frame */
+	static std::atomic<int> s_CompletedIndex;
+	static Clock::time_point s_FrameStart;
+	static unsigned long long s_FrameIndex;
+
+	static float s_History[s_HistorySize];
+	static unsigned int s_HistoryNext;
+public:
+	static inline void Add(RenderCounter counter, unsigned long long amount = 1)
+	{
+		s_Current[(int)counter].fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	/* Closes the frame being counted, call once per frame from the render thread */
+	static void EndFrame();
+	/* The last complete frame, a copy so it stays valid */
+	static RenderStatsFrame GetLastFrame();
+	/* Frame times oldest first, count is at most s_HistorySize */
+	static unsigned int GetFrameHistory(float* milliseconds);
+
+	static const char* GetName(RenderCounter counter);
+};
+
+#if RENDER_STATS_ENABLED
+#define RENDER_STAT(counter, amount) RenderStats::Add(RenderCounter::counter, amount)
+#else
+#define RENDER_STAT(counter, amount) ((void)0)
+#endif
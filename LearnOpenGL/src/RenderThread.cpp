@@ -0,0 +1,131 @@
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+static double GetMilliseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+const unsigned int RenderThread::s_MaxPackets;
+
+RenderThread::RenderThread(unsigned int packetCount, ContextFunction bindContext, RenderFunction render)
+	: m_BindContext(bindContext), m_Render(render), m_Packets(std::min(std::max(packetCount, 2u), s_MaxPackets)),
+	m_Writing(nullptr), m_Stop(false), m_WaitMilliseconds(0.0), m_SubmittedCount(0), m_RenderedCount(0), m_Frames(0), m_RenderMilliseconds(0.0), m_IdleMilliseconds(0.0)
+{
+	for (FramePacket& packet : m_Packets)
+		m_Free.Push(&packet);
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+void RenderThread::Start()
+{
+	if (m_Thread.joinable())
+		return;
+	m_Stop.store(false);
+	m_Thread = std::thread(&RenderThread::Run, this);
+}
+
+void RenderThread::Stop()
+{
+	if (!m_Thread.joinable())
+		return;
+	/* after the last submit, so the render thread sees every packet before it sees the flag */
+	m_Stop.store(true, std::memory_order_release);
+	Wake(m_PacketSubmitted);
+	m_Thread.join();
+}
+
+FramePacket& RenderThread::BeginPacket()
+{
+	if (!m_Writing)
+	{
+		Clock::time_point start = Clock::now();
+		if (!m_Free.Pop(m_Writing))
+		{
+			/* the render thread is a whole frame behind, sleep until it hands a packet back */
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_PacketFreed.wait(lock, [this]() { return m_Free.Pop(m_Writing); });
+		}
+		m_WaitMilliseconds += GetMilliseconds(start, Clock::now());
+	}
+	return *m_Writing;
+}
+
+void RenderThread::SubmitPacket()
+{
+	if (!m_Writing)
+		return;
+	/* every packet is either free, being written or submitted, so there is always room */
+	m_Submitted.Push(m_Writing);
+	m_Writing = nullptr;
+	m_SubmittedCount++;
+	Wake(m_PacketSubmitted);
+}
+
+void RenderThread::Flush()
+{
+	if (!m_Thread.joinable())
+		return;
+	std::unique_lock<std::mutex> lock(m_WakeMutex);
+	m_PacketFreed.wait(lock, [this]() { return m_RenderedCount.load(std::memory_order_acquire) == m_SubmittedCount; });
+}
+
+RenderThreadStats RenderThread::GetStats() const
+{
+	RenderThreadStats stats;
+	stats.Frames = m_Frames;
+	stats.WaitMilliseconds = m_WaitMilliseconds;
+	stats.RenderMilliseconds = m_RenderMilliseconds;
+	stats.IdleMilliseconds = m_IdleMilliseconds;
+	return stats;
+}
+
+void RenderThread::Wake(std::condition_variable& condition)
+{
+	/* taking the lock orders the push before the sleeper's check, so the wake cannot fall in between */
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+	}
+	condition.notify_one();
+}
+
+void RenderThread::Run()
+{
+	m_BindContext(true);
+
+	Clock::time_point idleStart = Clock::now();
+	for (;;)
+	{
+		/* read before popping, once it is set an empty queue means everything was rendered */
+		bool stopping = m_Stop.load(std::memory_order_acquire);
+		FramePacket* packet;
+		if (!m_Submitted.Pop(packet))
+		{
+			if (stopping)
+				break;
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_PacketSubmitted.wait(lock, [this]() { return !m_Submitted.Empty() || m_Stop.load(std::memory_order_acquire); });
+			continue;
+		}
+
+		Clock::time_point start = Clock::now();
+		m_IdleMilliseconds += GetMilliseconds(idleStart, start);
+		m_Render(*packet);
+		idleStart = Clock::now();
+		m_RenderMilliseconds += GetMilliseconds(start, idleStart);
+		m_Frames++;
+		m_Free.Push(packet);
+		m_RenderedCount.fetch_add(1, std::memory_order_release);
+		Wake(m_PacketFreed);
+	}
+
+	m_BindContext(false);
+}
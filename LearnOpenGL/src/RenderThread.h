@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "SpscQueue.h"
+
+/* Everything the render thread needs for one frame, written by the main thread */
+struct FramePacket
+{
+	unsigned long long Frame;
+	/* seconds of simulation this frame covers */
+	float DeltaTime;
+	glm::mat4 View;
+	glm::mat4 Projection;
+	/* per sprite position and a 0 to 1 value picking its color */
+	std::vector<glm::vec4> Sprites;
+
+	/* the demo's animated state, its quad, the mesh or field of mesh copies and the city camera */
+	glm::vec4 QuadColor;
+	bool QuadVisible;
+	glm::mat4 MeshView;
+	glm::mat4 MeshProjection;
+	/* per copy, the level of detail picked for it */
+	std::vector<glm::mat4> MeshModels;
+	std::vector<unsigned int> MeshLevels;
+	glm::mat4 CityView;
+	glm::mat4 CityProjection;
+};
+
+struct RenderThreadStats
+{
+	unsigned long long Frames;
+	/* main thread time spent in BeginPacket waiting for a free packet, the render thread being behind */
+	double WaitMilliseconds;
+	/* render thread time spent rendering and waiting for packets */
+	double RenderMilliseconds;
+	double IdleMilliseconds;
+};
+
+/*
+* Thread that owns the GL context and renders frame packets
+* The main thread fills a packet, submits it and goes on to the next frame
+* while this thread renders the last one, so simulation of frame N + 1
+* overlaps rendering of frame N. Packets go round through two SpscQueues,
+* submitted ones to the render thread and rendered ones back. With two
+* packets the main thread is at most one frame ahead, with three it can
+* absorb a slow frame on either side. A side with nothing to do sleeps on a
+* condition variable, so it never takes CPU time from the other one. Event
+* handling stays with the caller, GLFW needs it on the main thread.
+*
+* bindContext(true) runs on the render thread before the first packet and
+* bindContext(false) after the last, the caller releases the context before
+* Start and makes it current again after Stop.
+*/
+class RenderThread
+{
+public:
+	static const unsigned int s_MaxPackets = 4;
+
+	typedef std::function<void(bool current)> ContextFunction;
+	/* renders and presents one packet, on the render thread */
+	typedef std::function<void(const FramePacket& packet)> RenderFunction;
+
+private:
+	ContextFunction m_BindContext;
+	RenderFunction m_Render;
+	std::vector<FramePacket> m_Packets;
+	/* main thread to render thread */
+	SpscQueue<FramePacket*, s_MaxPackets> m_Submitted;
+	/* render thread back to main thread */
+	SpscQueue<FramePacket*, s_MaxPackets> m_Free;
+	FramePacket* m_Writing;
+	std::thread m_Thread;
+	std::atomic<bool> m_Stop;
+
+	/* only taken to sleep and to wake the sleeper, the queues themselves are lock free */
+	std::mutex m_WakeMutex;
+	std::condition_variable m_PacketSubmitted;
+	std::condition_variable m_PacketFreed;
+
+	double m_WaitMilliseconds;
+	/* packets handed over by the main thread and rendered by the render thread, Flush waits for them to meet */
+	unsigned long long m_SubmittedCount;
+	std::atomic<unsigned long long> m_RenderedCount;
+	/* written by the render thread, read after it is joined */
+	unsigned long long m_Frames;
+	double m_RenderMilliseconds;
+	double m_IdleMilliseconds;
+public:
+	/* packetCount of 2 double buffers, 3 triple buffers */
+	RenderThread(unsigned int packetCount, ContextFunction bindContext, RenderFunction render);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	void Start();
+	/* renders what was submitted, then releases the context and joins */
+	void Stop();
+
+	/* main thread, the next packet to fill. Waits while every packet is queued or being rendered */
+	FramePacket& BeginPacket();
+	/* main thread, hands the packet from BeginPacket over */
+	void SubmitPacket();
+	/* main thread, waits until every submitted packet has been rendered and presented */
+	void Flush();
+
+	/* complete once stopped */
+	RenderThreadStats GetStats() const;
+
+private:
+	void Run();
+	/* after a push, wakes the other side if it is sleeping on condition */
+	void Wake(std::condition_variable& condition);
+};
@@ -0,0 +1,257 @@
+#include "RenderThreadBenchmark.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "VertexBufferLayout.h"
+#include "Framebuffer.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double GetMilliseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static const float s_Corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+static const unsigned int s_AttractorCount = 64;
+/* fixed step so every mode simulates exactly the same frames */
+static const float s_DeltaTime = 1.0f / 60.0f;
+/* speed in pixels per second that gets the last color */
+static const float s_MaxSpeed = 400.0f;
+
+RenderThreadBenchmark::RenderThreadBenchmark(int width, int height, unsigned int frames, unsigned int spriteCount)
+	: m_Width(width), m_Height(height), m_Frames(std::max(frames, 1u)), m_SpriteCount(std::max(spriteCount, 1u)), m_Time(0.0f),
+	m_Shader("res/shaders/Particle.shader", "#define LIFE_FRACTION"), m_Corners(s_Corners, sizeof(s_Corners)),
+	m_Instances(m_SpriteCount * (unsigned int)sizeof(glm::vec4)), m_Window(nullptr)
+{
+	VertexBufferLayout cornerLayout;
+	cornerLayout.Push<float>(2);
+	VertexBufferLayout instanceLayout;
+	instanceLayout.Push<float>(4);
+	m_VertexArray.AddBuffer(m_Corners, cornerLayout);
+	m_VertexArray.AddBuffer(m_Instances, instanceLayout, 1, 1);
+}
+
+RenderThreadBenchmark::~RenderThreadBenchmark()
+{
+}
+
+void RenderThreadBenchmark::Reset()
+{
+	m_Positions.resize(m_SpriteCount);
+	m_Velocities.assign(m_SpriteCount, glm::vec2(0.0f));
+	unsigned int random = 1;
+	auto nextRandom = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) * (1.0f / 16777216.0f);
+	};
+	for (glm::vec2& position : m_Positions)
+		position = glm::vec2(nextRandom() * m_Width, nextRandom() * m_Height);
+	m_Time = 0.0f;
+}
+
+void RenderThreadBenchmark::Simulate(float deltaTime, FramePacket& packet)
+{
+	/* attractors circle the screen on their own Lissajous curves */
+	glm::vec2 attractors[s_AttractorCount];
+	glm::vec2 center(m_Width * 0.5f, m_Height * 0.5f);
+	for (unsigned int a = 0; a < s_AttractorCount; a++)
+	{
+		float phase = m_Time * (0.3f + 0.05f * a) + a;
+		attractors[a] = center + glm::vec2(std::cos(phase * 1.3f) * m_Width * 0.4f, std::sin(phase) * m_Height * 0.4f);
+	}
+
+	const float strength = 4.0e5f / s_AttractorCount;
+	const float softening = 400.0f;
+	const float damping = std::pow(0.6f, deltaTime);
+	packet.Sprites.resize(m_SpriteCount);
+	for (unsigned int i = 0; i < m_SpriteCount; i++)
+	{
+		glm::vec2 position = m_Positions[i];
+		glm::vec2 acceleration(0.0f);
+		for (unsigned int a = 0; a < s_AttractorCount; a++)
+		{
+			glm::vec2 toAttractor = attractors[a] - position;
+			float distanceSquared = glm::dot(toAttractor, toAttractor) + softening;
+			acceleration += toAttractor * (strength / (distanceSquared * std::sqrt(distanceSquared)));
+		}
+
+		glm::vec2 velocity = (m_Velocities[i] + acceleration * deltaTime) * damping;
+		position += velocity * deltaTime;
+		/* bounce off the screen edges */
+		if (position.x < 0.0f || position.x > m_Width)
+			velocity.x = -velocity.x;
+		if (position.y < 0.0f || position.y > m_Height)
+			velocity.y = -velocity.y;
+		position = glm::clamp(position, glm::vec2(0.0f), glm::vec2((float)m_Width, (float)m_Height));
+
+		m_Positions[i] = position;
+		m_Velocities[i] = velocity;
+		float speed = std::min(glm::length(velocity) / s_MaxSpeed, 0.99f);
+		packet.Sprites[i] = glm::vec4(position, 0.0f, speed);
+	}
+	m_Time += deltaTime;
+}
+
+void RenderThreadBenchmark::Render(const FramePacket& packet)
+{
+	if (m_Framebuffer)
+		m_Framebuffer->Bind();
+	m_Renderer.Clear();
+
+	m_Instances.SetData(packet.Sprites.data(), (unsigned int)(packet.Sprites.size() * sizeof(glm::vec4)));
+	const glm::vec4 colors[] = {
+		glm::vec4(0.3f, 0.5f, 1.0f, 0.6f), glm::vec4(0.4f, 1.0f, 0.6f, 0.6f),
+		glm::vec4(1.0f, 0.8f, 0.3f, 0.7f), glm::vec4(1.0f, 0.3f, 0.2f, 0.8f)
+	};
+	m_Shader.Bind();
+	m_Shader.SetUniformMat4f("u_View", packet.View);
+	m_Shader.SetUniformMat4f("u_Projection", packet.Projection);
+	m_Shader.SetUniform2f("u_Size", 3.0f, 3.0f);
+	m_Shader.SetUniform4fv("u_Colors", 4, &colors[0].x);
+
+	GLCall(glEnable(GL_BLEND));
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
+	m_Renderer.DrawArraysInstanced(m_VertexArray, m_Shader, GL_TRIANGLE_STRIP, 0, 4, (unsigned int)packet.Sprites.size());
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+	if (m_Window)
+	{
+		GLCall(glfwSwapBuffers(m_Window));
+	}
+	else
+	{
+		GLCall(glFinish());
+	}
+}
+
+RenderThreadBenchmarkResult RenderThreadBenchmark::RunMode(unsigned int packets, const RenderThread::ContextFunction& bindContext)
+{
+	Reset();
+	glm::mat4 projection = glm::ortho(0.0f, (float)m_Width, 0.0f, (float)m_Height, -1.0f, 1.0f);
+
+	RenderThreadBenchmarkResult result = {};
+	result.Packets = packets;
+	double simulate = 0.0, render = 0.0;
+
+	/* the main thread keeps a packet of its own when it renders itself */
+	FramePacket ownPacket;
+	std::unique_ptr<RenderThread> renderThread;
+	if (packets > 0)
+	{
+		renderThread.reset(new RenderThread(packets, bindContext, [this](const FramePacket& packet) { Render(packet); }));
+		bindContext(false);
+		renderThread->Start();
+	}
+
+	Clock::time_point start = Clock::now();
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		if (m_Window)
+		{
+			glfwPollEvents();
+			if (glfwWindowShouldClose(m_Window))
+				break;
+		}
+
+		FramePacket& packet = renderThread ? renderThread->BeginPacket() : ownPacket;
+		Clock::time_point simulateStart = Clock::now();
+		packet.Frame = frame;
+		packet.DeltaTime = s_DeltaTime;
+		packet.View = glm::mat4(1.0f);
+		packet.Projection = projection;
+		Simulate(s_DeltaTime, packet);
+		Clock::time_point simulateEnd = Clock::now();
+		simulate += GetMilliseconds(simulateStart, simulateEnd);
+
+		if (renderThread)
+		{
+			renderThread->SubmitPacket();
+		}
+		else
+		{
+			Render(packet);
+			render += GetMilliseconds(simulateEnd, Clock::now());
+		}
+		result.Frames++;
+	}
+
+	if (renderThread)
+	{
+		/* the last frames are still being rendered, they count towards the time */
+		renderThread->Stop();
+		bindContext(true);
+		RenderThreadStats stats = renderThread->GetStats();
+		render = stats.RenderMilliseconds;
+		result.WaitMilliseconds = stats.WaitMilliseconds / std::max(result.Frames, 1u);
+	}
+	double total = GetMilliseconds(start, Clock::now());
+
+	unsigned int frames = std::max(result.Frames, 1u);
+	result.FrameMilliseconds = total / frames;
+	result.SimulateMilliseconds = simulate / frames;
+	result.RenderMilliseconds = render / frames;
+	return result;
+}
+
+bool RenderThreadBenchmark::Run(GLFWwindow* window, const RenderThread::ContextFunction& bindContext)
+{
+	m_Window = window;
+	if (window)
+	{
+		/* uncapped, vsync would make every mode take a refresh per frame */
+		glfwSwapInterval(0);
+	}
+	else
+	{
+		m_Framebuffer.reset(new Framebuffer(m_Width, m_Height));
+	}
+
+	std::cout << "Render thread: " << m_SpriteCount << " sprites against " << s_AttractorCount << " attractors, "
+		<< m_Width << " x " << m_Height << ", " << m_Frames << " frames, " << std::thread::hardware_concurrency()
+		<< " hardware threads" << std::endl;
+
+	/* one warm up frame so shader compilation and first uploads are not measured */
+	unsigned int frames = m_Frames;
+	m_Frames = 1;
+	RunMode(0, bindContext);
+	m_Frames = frames;
+
+	double sequential = 0.0;
+	bool complete = true;
+	const unsigned int modes[] = { 0, 2, 3 };
+	for (unsigned int packets : modes)
+	{
+		RenderThreadBenchmarkResult result = RunMode(packets, bindContext);
+		complete = complete && result.Frames == m_Frames;
+		if (packets == 0)
+			sequential = result.FrameMilliseconds;
+
+		std::cout << "  " << (packets == 0 ? "main thread only:  " : packets == 2 ? "double buffered:   " : "triple buffered:   ")
+			<< result.FrameMilliseconds << " ms per frame (simulate " << result.SimulateMilliseconds << " ms, render "
+			<< result.RenderMilliseconds << " ms";
+		if (packets > 0)
+		{
+			std::cout << ", main thread waited " << result.WaitMilliseconds << " ms), "
+				<< sequential / std::max(result.FrameMilliseconds, 1.0e-6) << "x the main thread only rate";
+		}
+		else
+		{
+			std::cout << ")";
+		}
+		std::cout << std::endl;
+	}
+
+	if (m_Framebuffer)
+	{
+		m_Framebuffer->UnBind();
+		m_Framebuffer.reset();
+	}
+	return complete;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "RenderThread.h"
+
+struct GLFWwindow;
+class Framebuffer;
+
+struct RenderThreadBenchmarkResult
+{
+	/* 0 when simulation and rendering ran one after the other on the main thread */
+	unsigned int Packets;
+	/* fewer than asked for when the window was closed */
+	unsigned int Frames;
+	/* wall clock per frame */
+	double FrameMilliseconds;
+	/* per frame, simulation on the main thread and rendering wherever the context was */
+	double SimulateMilliseconds;
+	double RenderMilliseconds;
+	/* per frame, the main thread waiting for a free packet */
+	double WaitMilliseconds;
+};
+
+/*
+* Measures what moving rendering onto a RenderThread gains
+* A CPU heavy scene: sprites pulled around by moving attractors, every
+* sprite against every attractor each frame, drawn instanced. It runs with
+* simulation and rendering one after the other on the main thread, then
+* with the render thread and two and three packets. Rendering presents with
+* a swap when there is a window and glFinish into a Framebuffer otherwise,
+* so the GPU's share of the frame is part of the render thread's work.
+* Events are polled on the main thread in every mode. Needs a current GL
+* context, the render thread borrows it through bindContext.
+*/
+class RenderThreadBenchmark
+{
+private:
+	int m_Width, m_Height;
+	unsigned int m_Frames;
+	unsigned int m_SpriteCount;
+
+	/* simulation state, main thread only */
+	std::vector<glm::vec2> m_Positions;
+	std::vector<glm::vec2> m_Velocities;
+	float m_Time;
+
+	/* GL objects, used by whichever thread holds the context */
+	Shader m_Shader;
+	VertexBuffer m_Corners;
+	VertexBuffer m_Instances;
+	VertexArray m_VertexArray;
+	Renderer m_Renderer;
+	std::unique_ptr<Framebuffer> m_Framebuffer;
+	GLFWwindow* m_Window;
+public:
+	RenderThreadBenchmark(int width, int height, unsigned int frames, unsigned int spriteCount);
+	~RenderThreadBenchmark();
+
+	/*
+	* window is null when headless. bindContext(true) makes the context current
+	* on the calling thread and bindContext(false) releases it. Prints a line
+	* per mode, false when the window was closed before the end.
+	*/
+	bool Run(GLFWwindow* window, const RenderThread::ContextFunction& bindContext);
+
+private:
+	void Reset();
+	/* advances the sprites by deltaTime and writes them into packet */
+	void Simulate(float deltaTime, FramePacket& packet);
+	void Render(const FramePacket& packet);
+	/* packets 0 renders on the main thread */
+	RenderThreadBenchmarkResult RunMode(unsigned int packets, const RenderThread::ContextFunction& bindContext);
+};
@@ -3,11 +3,15 @@
 
 void GLClearError()
 {
-    while (glGetError() != GL_NO_ERROR);
+    RENDER_STAT(GLCalls, 1);
+    RENDER_STAT(GLErrorChecks, 1);
+    while (glGetError() != GL_NO_ERROR)
+        RENDER_STAT(GLErrorChecks, 1);
 }
 
 bool GLLogCall(const char* function, const char* file, int line)
 {
+    RENDER_STAT(GLErrorChecks, 1);
     /* while error does not equal 0 */
     while (GLenum error = glGetError())
     {
@@ -19,20 +23,67 @@ bool GLLogCall(const char* function, const char* file, int line)
 
 void Renderer::Clear() const
 {
-    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+    /* depth as well, depth tested drawing like DebugDraw would otherwise test against last frame */
+    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
+{
+    Draw(va, ib, shader, ib.GetCount());
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount, unsigned int firstIndex) const
 {
     shader.Bind();
     va.Bind();
     ib.Bind();
 
-    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+    /* with an index buffer bound the pointer is a byte offset into it */
+    GLCall(glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)((size_t)firstIndex * sizeof(unsigned int))));
+    RENDER_STAT(DrawCalls, 1);
+    RENDER_STAT(Triangles, indexCount / 3);
 
     /* 
     * Not calling unbind as it is not really necessary
     * Unbinding is a waste of performance because before 
     * next thing is drawn we will be binding everything again
     */
-}
\ No newline at end of file
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount,
+    unsigned int instanceCount, unsigned int firstIndex) const
+{
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)((size_t)firstIndex * sizeof(unsigned int)),
+        instanceCount));
+    RENDER_STAT(DrawCalls, 1);
+    RENDER_STAT(Triangles, (unsigned long long)indexCount / 3 * instanceCount);
+}
+
+void Renderer::DrawArrays(const VertexArray& va, const Shader& shader, unsigned int mode, unsigned int first, unsigned int count) const
+{
+    shader.Bind();
+    va.Bind();
+
+    GLCall(glDrawArrays(mode, first, count));
+    RENDER_STAT(DrawCalls, 1);
+    if (mode == GL_TRIANGLES)
+        RENDER_STAT(Triangles, count / 3);
+}
+
+void Renderer::DrawArraysInstanced(const VertexArray& va, const Shader& shader, unsigned int mode, unsigned int first, unsigned int count,
+    unsigned int instanceCount) const
+{
+    shader.Bind();
+    va.Bind();
+
+    GLCall(glDrawArraysInstanced(mode, first, count, instanceCount));
+    RENDER_STAT(DrawCalls, 1);
+    if (mode == GL_TRIANGLES)
+        RENDER_STAT(Triangles, (unsigned long long)count / 3 * instanceCount);
+    else if (mode == GL_TRIANGLE_STRIP && count >= 3)
+        RENDER_STAT(Triangles, (unsigned long long)(count - 2) * instanceCount);
+}
@@ -1,12 +1,18 @@
 #pragma once
 #include <GL/glew.h>
+#include "GLTrace.h"
 
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "RenderStats.h"
 
-/* using msvc compiler specific func debug break */
+/* using msvc compiler specific func debug break, the GCC and Clang builtin elsewhere */
+#ifdef _MSC_VER
 #define ASSERT(x) if (!(x)) __debugbreak();
+#else
+#define ASSERT(x) if (!(x)) __builtin_trap();
+#endif
 
 /* # converts int to string, __FILE__ & __LINE__ are intrinsics, should work on all compilers */
 #define GLCall(x) GLClearError();\
@@ -29,6 +35,19 @@ class Renderer
 public:
 	void Clear() const;
 	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	/*
+	* draws only indexCount indices from firstIndex, for buffers that are filled a different
+	* amount each frame or hold several meshes or levels of detail
+	*/
+	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount, unsigned int firstIndex = 0) const;
+	/* non indexed draw of count vertices from first, mode is GL_TRIANGLES, GL_LINES and so on */
+	void DrawArrays(const VertexArray& va, const Shader& shader, unsigned int mode, unsigned int first, unsigned int count) const;
+	/* indexCount indices from firstIndex, instanceCount times */
+	void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount, unsigned int instanceCount,
+		unsigned int firstIndex = 0) const;
+	/* instanceCount copies of the same vertices, per instance attributes come from buffers with a divisor */
+	void DrawArraysInstanced(const VertexArray& va, const Shader& shader, unsigned int mode, unsigned int first, unsigned int count,
+		unsigned int instanceCount) const;
 
 };
 
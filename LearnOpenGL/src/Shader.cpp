@@ -3,36 +3,52 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream>
 
 #include "Renderer.h"
 
+/* an unordered_map node, its key and value and up to two links, whichever the library uses */
+static const std::size_t s_UniformNodeSize = sizeof(std::pair<const std::string, int>) + 2 * sizeof(void*);
 
 Shader::Shader(const std::string& filepath)
-	: m_FilePath(filepath), m_RendererID(0)
+	: m_FilePath(filepath), m_RendererID(0), m_UniformNodes(s_UniformNodeSize, 16), m_UniformLocationCache(&m_UniformNodes)
 {
     ShaderProgramSource source = ParseShader(filepath);
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource, source.GeometrySource);
 	
 }
 
+Shader::Shader(const std::string& filepath, const std::string& defines)
+	: m_FilePath(filepath), m_RendererID(0), m_UniformNodes(s_UniformNodeSize, 16), m_UniformLocationCache(&m_UniformNodes)
+{
+    ShaderProgramSource source = ParseShader(filepath, defines);
+    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource, source.GeometrySource);
+}
+
+Shader::Shader(const std::string& filepath, const std::string& defines, const std::vector<std::string>& feedbackVaryings)
+	: m_FilePath(filepath), m_RendererID(0), m_UniformNodes(s_UniformNodeSize, 16), m_UniformLocationCache(&m_UniformNodes)
+{
+    ShaderProgramSource source = ParseShader(filepath, defines);
+    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource, source.GeometrySource, feedbackVaryings);
+}
+
 Shader::~Shader()
 {
     GLCall(glDeleteProgram(m_RendererID));
 }
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+ShaderProgramSource Shader::ParseShader(const std::string& filepath, const std::string& defines)
 {
     std::fstream stream(filepath);
 
     /* Using type to act as index into correct array */
     enum class ShaderType
     {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
+        NONE = -1, VERTEX = 0, FRAGMENT = 1, GEOMETRY = 2
     };
 
     std::string line;
-    std::stringstream ss[2];
+    /* appended to directly, a stringstream per stage costs more than the parsing itself */
+    std::string sources[3];
     ShaderType type = ShaderType::NONE;
 
     while (getline(stream, line))
@@ -43,15 +59,26 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath)
                 type = ShaderType::VERTEX;
             else if (line.find("fragment") != std::string::npos)
                 type = ShaderType::FRAGMENT;
+            else if (line.find("geometry") != std::string::npos)
+                type = ShaderType::GEOMETRY;
 
         }
         else
         {
-            ss[(int)type] << line << '\n';
+            std::string& source = sources[(int)type];
+            source += line;
+            source += '\n';
+
+            /* #version has to stay the first line, defines go right after it */
+            if (!defines.empty() && line.find("#version") != std::string::npos)
+            {
+                source += defines;
+                source += '\n';
+            }
         }
     }
 
-    return { ss[0].str(), ss[1].str() };
+    return { std::move(sources[0]), std::move(sources[1]), std::move(sources[2]) };
 
 }
 
@@ -76,7 +103,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
         char* message = (char*)alloca(length * sizeof(char));
         GLCall(glGetShaderInfoLog(id, length, &length, message));
 
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
+        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : type == GL_GEOMETRY_SHADER ? "geometry" : "fragment")
+            << " shader!" << std::endl;
         std::cout << message << std::endl;
 
         GLCall(glDeleteShader(id));
@@ -87,28 +115,56 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 }
 
 /* Need to provide OpenGL with srings source code to read in shaders */
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader,
+    const std::vector<std::string>& feedbackVaryings)
 {
     // can use GLUint as well as unsigned int to store id 
     GLCall(unsigned int program = glCreateProgram());
     unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    /* transform feedback programs may have no fragment stage at all */
+    unsigned int fs = fragmentShader.empty() ? 0 : CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    unsigned int gs = geometryShader.empty() ? 0 : CompileShader(GL_GEOMETRY_SHADER, geometryShader);
 
     GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
+    if (fs)
+    {
+        GLCall(glAttachShader(program, fs));
+    }
+    if (gs)
+    {
+        GLCall(glAttachShader(program, gs));
+    }
+
+    /* which outputs get captured is part of linking, so it has to be set before */
+    if (!feedbackVaryings.empty())
+    {
+        std::vector<const char*> names;
+        for (const std::string& name : feedbackVaryings)
+            names.push_back(name.c_str());
+        GLCall(glTransformFeedbackVaryings(program, (int)names.size(), names.data(), GL_INTERLEAVED_ATTRIBS));
+    }
+
     // Consult docs
     GLCall(glLinkProgram(program));
     GLCall(glValidateProgram(program));
 
     // delete after being linked into program (stored in program), think deleting intermediates 
     GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+    if (fs)
+    {
+        GLCall(glDeleteShader(fs));
+    }
+    if (gs)
+    {
+        GLCall(glDeleteShader(gs));
+    }
 
     return program;
 }
 
 void Shader::Bind() const
 {
+    RENDER_STAT(ProgramBinds, 1);
     GLCall(glUseProgram(m_RendererID));
 }
 
@@ -117,22 +173,43 @@ void Shader::UnBind() const
     GLCall(glUseProgram(0));
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::SetUniform1i(std::string_view name, int value)
 {
+    RENDER_STAT(UniformUploads, 1);
     GLCall(glUniform1i(GetUniformLocation(name), value));
 }
 
-void Shader::SetUniform1f(const std::string& name, int value)
+void Shader::SetUniform1f(std::string_view name, float value)
 {
+    RENDER_STAT(UniformUploads, 1);
     GLCall(glUniform1f(GetUniformLocation(name), value));
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
+void Shader::SetUniform2f(std::string_view name, float v0, float v1)
 {
+    RENDER_STAT(UniformUploads, 1);
+    GLCall(glUniform2f(GetUniformLocation(name), v0, v1));
+}
+
+void Shader::SetUniform3f(std::string_view name, float v0, float v1, float v2)
+{
+    RENDER_STAT(UniformUploads, 1);
+    GLCall(glUniform3f(GetUniformLocation(name), v0, v1, v2));
+}
+
+void Shader::SetUniform4f(std::string_view name, float v0, float v1, float v2, float v3)
+{
+    RENDER_STAT(UniformUploads, 1);
     GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
+void Shader::SetUniform4fv(std::string_view name, unsigned int count, const float* values)
+{
+    RENDER_STAT(UniformUploads, 1);
+    GLCall(glUniform4fv(GetUniformLocation(name), count, values));
+}
+
+void Shader::SetUniformMat4f(std::string_view name, const glm::mat4& matrix)
 {
     /*
     * @param location - uniorm location 
@@ -142,22 +219,30 @@ void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
     * We do not need to transpose b/c GLM stores its matrix elements in column major. 
     * @param value - pointer to value array
     */
+    RENDER_STAT(UniformUploads, 1);
     GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0])); 
 }
 
 
 
-int Shader::GetUniformLocation(const std::string& name)
+int Shader::GetUniformLocation(std::string_view name)
 {
     /* 
     * If uniform location is found do not have to retrieve again, saves on performance
     * when there are a lot of uniforms. 
     */
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-        return m_UniformLocationCache[name];
+    m_LookupName.assign(name.data(), name.size());
+    /*
+    * One hash and one bucket walk for hits and misses alike. find followed by emplace
+    * hashed and searched twice on a miss, and emplace builds its node, key copy
+    * included, before it even looks.
+    */
+    auto cached = m_UniformLocationCache.try_emplace(m_LookupName, -1);
+    if (!cached.second)
+        return cached.first->second;
 
     /* Shader must be binded before setting uniform as below */
-    GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+    GLCall(int location = glGetUniformLocation(m_RendererID, m_LookupName.c_str()));
     
     /* 
     * Not using assert as -1 could be a possible location if uniform is not used
@@ -167,6 +252,6 @@ int Shader::GetUniformLocation(const std::string& name)
     if (location == -1)
         std::cout << "Warning: uniform " << name << " doesn't exist!" << std::endl;
     //save in cache 
-    m_UniformLocationCache[name] = location;
+    cached.first->second = location;
     return location;
 }
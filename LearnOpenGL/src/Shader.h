@@ -1,15 +1,23 @@
 #pragma once
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "glm/glm.hpp"
 
+#include "PoolAllocator.h"
+
 
 struct ShaderProgramSource
 {
 	std::string VertexSource;
 
 	std::string FragmentSource;
+
+	/* empty unless the file has a #shader geometry stage */
+	std::string GeometrySource;
 };
 
 class Shader
@@ -17,11 +25,30 @@ class Shader
 private:
 	std::string m_FilePath; 
 	unsigned int m_RendererID; 
-	//caching for uniforms
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+	/* names are copied in here to look them up, its capacity is kept so lookups do not allocate */
+	std::string m_LookupName;
+	//caching for uniforms, the nodes come from a pool of their own, pmr string keys measured slower
+	PoolAllocator m_UniformNodes;
+	std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+		std::pmr::polymorphic_allocator<std::pair<const std::string, int>>> m_UniformLocationCache;
+
+	/* times the private lookup and parsing directly */
+	friend class MicroBenchmark;
 
 public: 
 	Shader(const std::string& filepath);
+	/* 
+	* Compiles the file with extra lines (usually #defines) placed after each
+	* stage's #version line, one source file can then build several variants
+	*/
+	Shader(const std::string& filepath, const std::string& defines);
+	/*
+	* Program whose vertex outputs named in feedbackVaryings are captured by
+	* transform feedback, interleaved in that order into one buffer. With a
+	* geometry stage its outputs are captured instead, and only what it emits.
+	* The file may leave out the fragment stage, rasterizing is usually off for these.
+	*/
+	Shader(const std::string& filepath, const std::string& defines, const std::vector<std::string>& feedbackVaryings);
 	~Shader();
 
 	void Bind() const; 
@@ -33,17 +60,23 @@ public:
 	* type a uniform variable was 
 	*/
 
+	/* names are string views, literals and std::strings both pass without a copy */
 	//Set uniforms 
-	void SetUniform1i(const std::string& name, int value); 
-	void SetUniform1f(const std::string& name, int value);
-	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
-	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	void SetUniform1i(std::string_view name, int value); 
+	void SetUniform1f(std::string_view name, float value);
+	void SetUniform2f(std::string_view name, float v0, float v1);
+	void SetUniform3f(std::string_view name, float v0, float v1, float v2);
+	void SetUniform4f(std::string_view name, float v0, float v1, float v2, float v3);
+	/* count vec4s into a uniform array, name is the array itself */
+	void SetUniform4fv(std::string_view name, unsigned int count, const float* values);
+	void SetUniformMat4f(std::string_view name, const glm::mat4& matrix);
 
 
 private:
-	ShaderProgramSource ParseShader(const std::string& filepath);
+	ShaderProgramSource ParseShader(const std::string& filepath, const std::string& defines = "");
 	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	int GetUniformLocation(const std::string& name);
+	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "",
+		const std::vector<std::string>& feedbackVaryings = std::vector<std::string>());
+	int GetUniformLocation(std::string_view name);
 };
 
@@ -0,0 +1,214 @@
+#include "SoftwareRasterBenchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Framebuffer.h"
+#include "ImageWriter.h"
+#include "JobSystem.h"
+#include "SoftwareRenderer.h"
+
+/* the demo's quad, a 2D position and a texture coordinate per corner */
+static const float s_QuadVertices[] = {
+	100.0f, 100.0f, 0.0f, 0.0f,
+	200.0f, 100.0f, 1.0f, 0.0f,
+	200.0f, 200.0f, 1.0f, 1.0f,
+	100.0f, 200.0f, 0.0f, 1.0f
+};
+static const unsigned int s_QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+static const char* s_QuadTexture = "res/textures/Emily_D&P_NoBG.png";
+
+/* the demo's projection, camera and quad position */
+static glm::mat4 GetQuadMVP()
+{
+	glm::mat4 proj = glm::ortho(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-100.0f, 0.0f, 0.0f));
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(200.0f, 200.0f, 0.0f));
+	return proj * view * model;
+}
+
+/*
+* Basic.shader as C++, with the texture times u_Color it was written for
+* rather than the constant white it currently ends with. Sprite.shader
+* computes the same on the GL side.
+*/
+static SoftwareProgram MakeBasicProgram(const glm::mat4& mvp, const SoftwareTexture& texture, const glm::vec4& color)
+{
+	SoftwareProgram program;
+	program.VaryingCount = 2;
+	program.Vertex = [mvp](const float* attributes, float* varyings) {
+		varyings[0] = attributes[2];
+		varyings[1] = attributes[3];
+		return mvp * glm::vec4(attributes[0], attributes[1], 0.0f, 1.0f);
+	};
+	program.Fragment = [&texture, color](const float* varyings) {
+		return texture.Sample(glm::vec2(varyings[0], varyings[1])) * color;
+	};
+	return program;
+}
+
+/* the vertex color as is */
+static SoftwareProgram MakeColorProgram(const glm::mat4& mvp)
+{
+	SoftwareProgram program;
+	program.VaryingCount = 4;
+	program.Vertex = [mvp](const float* attributes, float* varyings) {
+		std::copy(attributes + 2, attributes + 6, varyings);
+		return mvp * glm::vec4(attributes[0], attributes[1], 0.0f, 1.0f);
+	};
+	program.Fragment = [](const float* varyings) {
+		return glm::vec4(varyings[0], varyings[1], varyings[2], varyings[3]);
+	};
+	return program;
+}
+
+SoftwareRasterBenchmark::SoftwareRasterBenchmark(int width, int height, unsigned int frames)
+	: m_Width(width), m_Height(height), m_Frames(std::max(frames, 1u))
+{
+}
+
+void SoftwareRasterBenchmark::Run(const std::string& imagePath)
+{
+	JobSystem jobs;
+	SoftwareTexture texture(s_QuadTexture);
+	std::cout << "Software rasterizer: " << m_Width << " x " << m_Height << ", " << m_Frames << " frames, tiles of "
+		<< SoftwareRenderer::s_TileSize << " pixels, " << jobs.GetThreadCount() << " threads" << std::endl;
+
+	{
+		SoftwareRenderer renderer(m_Width, m_Height, &jobs);
+		renderer.Clear();
+		renderer.SetBlend(true);
+		renderer.Draw(s_QuadVertices, 4, 4, s_QuadIndices, 6, MakeBasicProgram(GetQuadMVP(), texture, glm::vec4(1.0f)));
+		m_Scene = renderer.GetPixels();
+		if (!imagePath.empty())
+			ImageWriter::WritePNG(imagePath, m_Scene.data(), m_Width, m_Height);
+	}
+
+	/* full screen quads of the same texture, blended over each other */
+	const unsigned int layers = 4;
+	float w = (float)m_Width, h = (float)m_Height;
+	const float fillVertices[] = {
+		0.0f, 0.0f, 0.0f, 0.0f,
+		w, 0.0f, 1.0f, 0.0f,
+		w, h, 1.0f, 1.0f,
+		0.0f, h, 0.0f, 1.0f
+	};
+	glm::mat4 screen = glm::ortho(0.0f, w, 0.0f, h, -1.0f, 1.0f);
+	SoftwareProgram fill = MakeBasicProgram(screen, texture, glm::vec4(1.0f));
+
+	/* two triangles per 4 x 4 pixel cell, random colors */
+	const int cell = 4;
+	int columns = m_Width / cell, rows = m_Height / cell;
+	std::vector<float> gridVertices;
+	std::vector<unsigned int> gridIndices;
+	unsigned int random = 1;
+	auto nextRandom = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) * (1.0f / 16777216.0f);
+	};
+	for (int y = 0; y <= rows; y++)
+	{
+		for (int x = 0; x <= columns; x++)
+		{
+			float vertex[] = { (float)(x * cell), (float)(y * cell), nextRandom(), nextRandom(), nextRandom(), 1.0f };
+			gridVertices.insert(gridVertices.end(), vertex, vertex + 6);
+		}
+	}
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < columns; x++)
+		{
+			unsigned int corner = y * (columns + 1) + x;
+			unsigned int cellIndices[] = { corner, corner + 1, corner + columns + 2, corner + columns + 2, corner + columns + 1, corner };
+			gridIndices.insert(gridIndices.end(), cellIndices, cellIndices + 6);
+		}
+	}
+	SoftwareProgram color = MakeColorProgram(screen);
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		SoftwareRenderer renderer(m_Width, m_Height, pass == 0 ? nullptr : &jobs);
+		unsigned int threads = pass == 0 ? 1 : jobs.GetThreadCount();
+
+		renderer.SetBlend(true);
+		for (unsigned int frame = 0; frame < m_Frames; frame++)
+		{
+			renderer.Clear();
+			for (unsigned int layer = 0; layer < layers; layer++)
+				renderer.Draw(fillVertices, 4, 4, s_QuadIndices, 6, fill);
+		}
+		SoftwareRasterStats fillStats = renderer.GetStats();
+
+		renderer.ResetStats();
+		renderer.SetBlend(false);
+		for (unsigned int frame = 0; frame < m_Frames; frame++)
+		{
+			renderer.Clear();
+			renderer.Draw(gridVertices.data(), (unsigned int)(gridVertices.size() / 6), 6, gridIndices.data(), (unsigned int)gridIndices.size(), color);
+		}
+		SoftwareRasterStats gridStats = renderer.GetStats();
+
+		std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ") << "fill "
+			<< fillStats.Fragments / (fillStats.Milliseconds * 1000.0) << " Mpixels/s textured and blended, "
+			<< gridStats.Triangles / (gridStats.Milliseconds * 1000.0) << " M triangles/s of " << cell * cell / 2 << " pixels, "
+			<< gridStats.Fragments / (gridStats.Milliseconds * 1000.0) << " Mpixels/s" << std::endl;
+	}
+}
+
+bool SoftwareRasterBenchmark::CompareWithGL(int tolerance)
+{
+	std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+	{
+		Framebuffer framebuffer(m_Width, m_Height);
+		framebuffer.Bind();
+		GLCall(glEnable(GL_BLEND));
+		GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+		VertexArray va;
+		VertexBuffer vb(s_QuadVertices, sizeof(s_QuadVertices));
+		VertexBufferLayout layout;
+		layout.Push<float>(2);
+		layout.Push<float>(2);
+		va.AddBuffer(vb, layout);
+		IndexBuffer ib(s_QuadIndices, 6);
+
+		Texture texture(s_QuadTexture);
+		texture.Bind();
+		Shader shader("res/shaders/Sprite.shader");
+		shader.Bind();
+		shader.SetUniformMat4f("u_MVP", GetQuadMVP());
+		shader.SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+		shader.SetUniform1i("u_Texture", 0);
+
+		Renderer renderer;
+		renderer.Clear();
+		renderer.Draw(va, ib, shader);
+		GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		framebuffer.UnBind();
+	}
+
+	int largest = 0;
+	unsigned int differing = 0, covered = 0;
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		int difference = 0;
+		for (int c = 0; c < 4; c++)
+			difference = std::max(difference, std::abs(pixels[i + c] - m_Scene[i + c]));
+		largest = std::max(largest, difference);
+		differing += difference > tolerance ? 1 : 0;
+		covered += pixels[i + 3] || m_Scene[i + 3] ? 1 : 0;
+	}
+	std::cout << "  Compared with GL: " << covered << " pixels drawn, largest difference " << largest << ", "
+		<< differing << " pixels over " << tolerance << std::endl;
+	return differing == 0;
+}
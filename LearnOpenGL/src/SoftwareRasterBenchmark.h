@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+* Checks and measures SoftwareRenderer
+* Run draws the demo's textured quad on the CPU, then measures fill rate with
+* full screen blended textured quads and triangle rate with a dense grid of
+* small colored triangles, first on the calling thread and then on the job
+* system. CompareWithGL draws the same quad through Renderer into a
+* Framebuffer and compares every pixel with the CPU image. Only it needs a
+* GL context, so Run works on machines without a GPU.
+*/
+class SoftwareRasterBenchmark
+{
+private:
+	int m_Width, m_Height;
+	unsigned int m_Frames;
+	/* Run's CPU image of the quad scene */
+	std::vector<unsigned char> m_Scene;
+public:
+	SoftwareRasterBenchmark(int width, int height, unsigned int frames);
+
+	/* writes the CPU image of the quad scene to imagePath as PNG when it is not empty */
+	void Run(const std::string& imagePath);
+	/* after Run. False when any channel of any pixel differs by more than tolerance */
+	bool CompareWithGL(int tolerance);
+};
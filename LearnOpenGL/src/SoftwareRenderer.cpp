@@ -0,0 +1,374 @@
+#include "SoftwareRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SOFTWARE_USE_SSE 1
+#endif
+
+#include "stb_image/stb_image.h"
+
+#include "JobSystem.h"
+
+const int SoftwareRenderer::s_TileSize;
+const unsigned int SoftwareRenderer::s_MaxVaryings;
+
+SoftwareTexture::SoftwareTexture(int width, int height, const unsigned char* pixels)
+	: m_Width(width), m_Height(height), m_Pixels(pixels, pixels + (size_t)width * height * 4)
+{
+}
+
+SoftwareTexture::SoftwareTexture(const std::string& path)
+	: m_Width(0), m_Height(0)
+{
+	/* bottom row first, the same as Texture */
+	stbi_set_flip_vertically_on_load(1);
+	int channels = 0;
+	unsigned char* pixels = stbi_load(path.c_str(), &m_Width, &m_Height, &channels, 4);
+	if (!pixels)
+	{
+		m_Width = m_Height = 0;
+		return;
+	}
+	m_Pixels.assign(pixels, pixels + (size_t)m_Width * m_Height * 4);
+	stbi_image_free(pixels);
+}
+
+glm::vec4 SoftwareTexture::Sample(const glm::vec2& uv) const
+{
+	/* what GL returns for an incomplete texture */
+	if (m_Pixels.empty())
+		return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	/* texel centers are at half coordinates, clamped first so the integer conversion stays in range */
+	float u = std::min(std::max(uv.x * m_Width - 0.5f, -1.0f), (float)m_Width);
+	float v = std::min(std::max(uv.y * m_Height - 0.5f, -1.0f), (float)m_Height);
+	/* floor for anything from -1 up, without a libm call */
+	int left = (int)(u + 1.0f) - 1, bottom = (int)(v + 1.0f) - 1;
+	float fractionU = u - left, fractionV = v - bottom;
+	int x0 = std::min(std::max(left, 0), m_Width - 1), x1 = std::min(left + 1, m_Width - 1);
+	int y0 = std::min(std::max(bottom, 0), m_Height - 1), y1 = std::min(bottom + 1, m_Height - 1);
+
+	const unsigned char* row0 = &m_Pixels[(size_t)y0 * m_Width * 4];
+	const unsigned char* row1 = &m_Pixels[(size_t)y1 * m_Width * 4];
+	float color[4];
+	for (int c = 0; c < 4; c++)
+	{
+		float lower = row0[x0 * 4 + c] + (row0[x1 * 4 + c] - row0[x0 * 4 + c]) * fractionU;
+		float upper = row1[x0 * 4 + c] + (row1[x1 * 4 + c] - row1[x0 * 4 + c]) * fractionU;
+		color[c] = (lower + (upper - lower) * fractionV) * (1.0f / 255.0f);
+	}
+	return glm::vec4(color[0], color[1], color[2], color[3]);
+}
+
+/* a value over the triangle as Base + X * x + Y * y, through the three corners */
+static void MakePlane(const float* x, const float* y, float area, float v0, float v1, float v2, float* plane)
+{
+	plane[1] = ((v1 - v0) * (y[2] - y[0]) - (v2 - v0) * (y[1] - y[0])) / area;
+	plane[2] = ((v2 - v0) * (x[1] - x[0]) - (v1 - v0) * (x[2] - x[0])) / area;
+	plane[0] = v0 - plane[1] * x[0] - plane[2] * y[0];
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, JobSystem* jobs)
+	: m_Jobs(jobs), m_Width(std::max(width, 1)), m_Height(std::max(height, 1)), m_Blend(false), m_Stats()
+{
+	m_TilesX = (m_Width + s_TileSize - 1) / s_TileSize;
+	m_TilesY = (m_Height + s_TileSize - 1) / s_TileSize;
+	m_Bins.resize(m_TilesX * m_TilesY);
+	m_Color.assign((size_t)m_Width * m_Height * 4, 0);
+}
+
+void SoftwareRenderer::Clear(const glm::vec4& color)
+{
+	unsigned char clear[4];
+	for (int i = 0; i < 4; i++)
+		clear[i] = (unsigned char)(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+	for (size_t i = 0; i < m_Color.size(); i += 4)
+		std::copy(clear, clear + 4, &m_Color[i]);
+}
+
+void SoftwareRenderer::Draw(const float* vertices, unsigned int vertexCount, unsigned int stride, const unsigned int* indices, unsigned int indexCount,
+	const SoftwareProgram& program)
+{
+	auto start = std::chrono::steady_clock::now();
+	unsigned int varyingCount = std::min(program.VaryingCount, s_MaxVaryings);
+
+	/* vertex stage */
+	m_Positions.resize(vertexCount);
+	m_Varyings.resize((size_t)vertexCount * varyingCount + 1);
+	auto shadeVertices = [&](unsigned int begin, unsigned int end) {
+		float scratch[s_MaxVaryings];
+		for (unsigned int i = begin; i < end; i++)
+		{
+			m_Positions[i] = program.Vertex(vertices + (size_t)i * stride, scratch);
+			std::copy(scratch, scratch + varyingCount, &m_Varyings[(size_t)i * varyingCount]);
+		}
+	};
+	if (m_Jobs)
+	{
+		JobCounter counter;
+		m_Jobs->ParallelFor(vertexCount, shadeVertices, &counter, 4096);
+		m_Jobs->Wait(counter);
+	}
+	else
+	{
+		shadeVertices(0, vertexCount);
+	}
+
+	/* clipping and setup keep submission order, the bins inherit it */
+	m_Triangles.clear();
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount)
+			continue;
+
+		ClipVertex corners[3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* source = &m_Varyings[(size_t)indices[i + corner] * varyingCount];
+			corners[corner].Position = m_Positions[indices[i + corner]];
+			std::copy(source, source + varyingCount, corners[corner].Varyings);
+		}
+		ClipTriangle(corners[0], corners[1], corners[2], varyingCount);
+	}
+
+	for (std::vector<unsigned int>& bin : m_Bins)
+		bin.clear();
+	for (unsigned int i = 0; i < (unsigned int)m_Triangles.size(); i++)
+	{
+		const Triangle& triangle = m_Triangles[i];
+		for (int tileY = triangle.MinY / s_TileSize; tileY <= triangle.MaxY / s_TileSize; tileY++)
+			for (int tileX = triangle.MinX / s_TileSize; tileX <= triangle.MaxX / s_TileSize; tileX++)
+				m_Bins[tileY * m_TilesX + tileX].push_back(i);
+	}
+
+	/* tiles share no pixels, each job owns its own */
+	unsigned int tileCount = (unsigned int)m_Bins.size();
+	m_TileFragments.assign(tileCount, 0);
+	auto rasterizeTiles = [&](unsigned int begin, unsigned int end) {
+		for (unsigned int tile = begin; tile < end; tile++)
+			RasterizeTile(tile, program);
+	};
+	if (m_Jobs)
+	{
+		JobCounter counter;
+		m_Jobs->ParallelFor(tileCount, rasterizeTiles, &counter, 1);
+		m_Jobs->Wait(counter);
+	}
+	else
+	{
+		rasterizeTiles(0, tileCount);
+	}
+
+	m_Stats.Triangles += m_Triangles.size();
+	for (unsigned long long fragments : m_TileFragments)
+		m_Stats.Fragments += fragments;
+	m_Stats.Milliseconds += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SoftwareRenderer::ClipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int varyingCount)
+{
+	/* distance to the near plane z = -w and the far plane z = w, positive inside */
+	auto distance = [](int plane, const glm::vec4& position) {
+		return plane == 0 ? position.z + position.w : position.w - position.z;
+	};
+
+	bool inside = true;
+	for (int plane = 0; plane < 2; plane++)
+		inside = inside && distance(plane, a.Position) >= 0.0f && distance(plane, b.Position) >= 0.0f && distance(plane, c.Position) >= 0.0f;
+	if (inside)
+	{
+		SetupTriangle(a, b, c, varyingCount);
+		return;
+	}
+
+	/* each plane can add a corner, so at most five */
+	ClipVertex polygons[2][5] = { { a, b, c } };
+	int count = 3;
+	for (int plane = 0; plane < 2; plane++)
+	{
+		const ClipVertex* input = polygons[plane];
+		ClipVertex* output = polygons[1 - plane];
+		int outputCount = 0;
+		for (int i = 0; i < count; i++)
+		{
+			const ClipVertex& current = input[i];
+			const ClipVertex& next = input[(i + 1) % count];
+			float currentDistance = distance(plane, current.Position);
+			float nextDistance = distance(plane, next.Position);
+			if (currentDistance >= 0.0f)
+				output[outputCount++] = current;
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				float t = currentDistance / (currentDistance - nextDistance);
+				ClipVertex& crossing = output[outputCount++];
+				crossing.Position = current.Position + (next.Position - current.Position) * t;
+				for (unsigned int v = 0; v < varyingCount; v++)
+					crossing.Varyings[v] = current.Varyings[v] + (next.Varyings[v] - current.Varyings[v]) * t;
+			}
+		}
+		count = outputCount;
+		if (count < 3)
+			return;
+	}
+
+	for (int i = 1; i + 1 < count; i++)
+		SetupTriangle(polygons[0][0], polygons[0][i], polygons[0][i + 1], varyingCount);
+}
+
+void SoftwareRenderer::SetupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int varyingCount)
+{
+	const ClipVertex* corners[3] = { &a, &b, &c };
+	float x[3], y[3], inverseW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		inverseW[i] = 1.0f / corners[i]->Position.w;
+		x[i] = (corners[i]->Position.x * inverseW[i] * 0.5f + 0.5f) * m_Width;
+		y[i] = (corners[i]->Position.y * inverseW[i] * 0.5f + 0.5f) * m_Height;
+	}
+
+	/* no face culling, clockwise triangles are turned around so inside is always positive */
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(std::abs(area) > 0.0f))
+		return;
+	if (area < 0.0f)
+	{
+		std::swap(corners[1], corners[2]);
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(inverseW[1], inverseW[2]);
+		area = -area;
+	}
+
+	/* pixels whose centers the bounds can reach */
+	float minX = std::min(x[0], std::min(x[1], x[2])), maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2])), maxY = std::max(y[0], std::max(y[1], y[2]));
+	Triangle triangle;
+	triangle.MinX = (int)std::floor(std::max(minX, 0.0f));
+	triangle.MinY = (int)std::floor(std::max(minY, 0.0f));
+	triangle.MaxX = (int)std::ceil(std::min(maxX, (float)m_Width)) - 1;
+	triangle.MaxY = (int)std::ceil(std::min(maxY, (float)m_Height)) - 1;
+	if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		return;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		/* cross product of the edge and the point, A * x + B * y + C */
+		triangle.EdgeA[i] = y[i] - y[next];
+		triangle.EdgeB[i] = x[next] - x[i];
+		triangle.EdgeC[i] = -(triangle.EdgeA[i] * x[i] + triangle.EdgeB[i] * y[i]);
+		/* counter clockwise with y up, left edges run down and top edges run left */
+		triangle.TopLeft[i] = y[next] < y[i] || (y[next] == y[i] && x[next] < x[i]);
+	}
+
+	MakePlane(x, y, area, inverseW[0], inverseW[1], inverseW[2], triangle.InverseW);
+	for (unsigned int v = 0; v < varyingCount; v++)
+	{
+		MakePlane(x, y, area, corners[0]->Varyings[v] * inverseW[0], corners[1]->Varyings[v] * inverseW[1],
+			corners[2]->Varyings[v] * inverseW[2], triangle.Varyings[v]);
+	}
+	m_Triangles.push_back(triangle);
+}
+
+void SoftwareRenderer::RasterizeTile(unsigned int tile, const SoftwareProgram& program)
+{
+	int tileX = (int)tile % m_TilesX * s_TileSize;
+	int tileY = (int)tile / m_TilesX * s_TileSize;
+	int lastX = std::min(tileX + s_TileSize, m_Width) - 1;
+	int lastY = std::min(tileY + s_TileSize, m_Height) - 1;
+	unsigned int varyingCount = std::min(program.VaryingCount, s_MaxVaryings);
+	float varyings[s_MaxVaryings];
+	unsigned long long fragments = 0;
+
+	for (unsigned int index : m_Bins[tile])
+	{
+		const Triangle& triangle = m_Triangles[index];
+		/* x in whole groups of four, tiles start on a multiple of four */
+		int minX = std::max(triangle.MinX, tileX) & ~3;
+		int minY = std::max(triangle.MinY, tileY);
+		int maxX = std::min(triangle.MaxX, lastX);
+		int maxY = std::min(triangle.MaxY, lastY);
+
+#ifdef SOFTWARE_USE_SSE
+		const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		/* lanes past the tile belong to another job */
+		const __m128 limit = _mm_set1_ps((float)(lastX + 1));
+		__m128 edgeA[3], topLeft[3];
+		for (int i = 0; i < 3; i++)
+		{
+			edgeA[i] = _mm_set1_ps(triangle.EdgeA[i]);
+			topLeft[i] = triangle.TopLeft[i] ? _mm_cmpeq_ps(zero, zero) : zero;
+		}
+#endif
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float centerY = y + 0.5f;
+			float rowEdge[3];
+			for (int i = 0; i < 3; i++)
+				rowEdge[i] = triangle.EdgeB[i] * centerY + triangle.EdgeC[i];
+			unsigned char* row = &m_Color[(size_t)y * m_Width * 4];
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+#ifdef SOFTWARE_USE_SSE
+				__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), centers);
+				__m128 inside = _mm_cmplt_ps(centerX, limit);
+				for (int i = 0; i < 3; i++)
+				{
+					__m128 edge = _mm_add_ps(_mm_mul_ps(edgeA[i], centerX), _mm_set1_ps(rowEdge[i]));
+					__m128 covered = _mm_or_ps(_mm_cmpgt_ps(edge, zero), _mm_and_ps(_mm_cmpeq_ps(edge, zero), topLeft[i]));
+					inside = _mm_and_ps(inside, covered);
+				}
+				int mask = _mm_movemask_ps(inside);
+#else
+				int mask = 0;
+				for (int lane = 0; lane < 4 && x + lane <= lastX; lane++)
+				{
+					float centerX = x + lane + 0.5f;
+					bool covered = true;
+					for (int i = 0; i < 3; i++)
+					{
+						float edge = triangle.EdgeA[i] * centerX + rowEdge[i];
+						covered = covered && (edge > 0.0f || (edge == 0.0f && triangle.TopLeft[i]));
+					}
+					mask |= covered ? 1 << lane : 0;
+				}
+#endif
+				if (mask == 0)
+					continue;
+
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (!(mask & (1 << lane)))
+						continue;
+
+					/* perspective correct, the planes hold value / w and 1 / w */
+					float centerX = x + lane + 0.5f;
+					float w = 1.0f / (triangle.InverseW[0] + triangle.InverseW[1] * centerX + triangle.InverseW[2] * centerY);
+					for (unsigned int v = 0; v < varyingCount; v++)
+						varyings[v] = (triangle.Varyings[v][0] + triangle.Varyings[v][1] * centerX + triangle.Varyings[v][2] * centerY) * w;
+
+					/* unsigned normalized target, the color is clamped before blending like GL does */
+					glm::vec4 color = glm::clamp(program.Fragment(varyings), 0.0f, 1.0f);
+					unsigned char* pixel = row + (x + lane) * 4;
+					if (m_Blend)
+					{
+						glm::vec4 destination(pixel[0], pixel[1], pixel[2], pixel[3]);
+						color = color * color.a + destination * (1.0f / 255.0f) * (1.0f - color.a);
+					}
+					for (int i = 0; i < 4; i++)
+						pixel[i] = (unsigned char)(color[i] * 255.0f + 0.5f);
+					fragments++;
+				}
+			}
+		}
+	}
+	m_TileFragments[tile] = fragments;
+}
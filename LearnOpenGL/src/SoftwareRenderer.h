@@ -0,0 +1,123 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class JobSystem;
+
+/* RGBA8 image sampled on the CPU, bottom row first like Texture */
+class SoftwareTexture
+{
+private:
+	int m_Width, m_Height;
+	std::vector<unsigned char> m_Pixels;
+public:
+	SoftwareTexture(int width, int height, const unsigned char* pixels);
+	/* loads with stb_image, empty when the file cannot be read */
+	SoftwareTexture(const std::string& path);
+
+	/* GL_LINEAR and GL_CLAMP_TO_EDGE, the sampling Texture sets up. No mip levels */
+	glm::vec4 Sample(const glm::vec2& uv) const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
+
+/*
+* The two programmable stages as C++ callables
+* Vertex gets a vertex's floats and returns its clip space position, writing
+* VaryingCount floats that are interpolated perspective correct for
+* Fragment, which returns the color.
+*/
+struct SoftwareProgram
+{
+	unsigned int VaryingCount;
+	std::function<glm::vec4(const float* attributes, float* varyings)> Vertex;
+	std::function<glm::vec4(const float* varyings)> Fragment;
+};
+
+struct SoftwareRasterStats
+{
+	/* after clipping, zero area ones dropped */
+	unsigned long long Triangles;
+	/* pixels the fragment stage ran for */
+	unsigned long long Fragments;
+	float Milliseconds;
+};
+
+/*
+* Draws indexed triangles into an RGBA8 color buffer without a GPU or driver
+* Each Draw runs the vertex stage over the vertices, clips triangles to the
+* near and far planes and bins them into tiles of s_TileSize pixels. Tiles
+* are then filled in parallel on the job system, each tile in submission
+* order so blending matches GL. Edge functions are evaluated four pixels at
+* a time with SSE and follow the top left fill rule, so neighbouring
+* triangles never cover a pixel twice. No depth buffer and no face culling,
+* the same state the 2D demo draws with.
+*/
+class SoftwareRenderer
+{
+public:
+	static const int s_TileSize = 64;
+	static const unsigned int s_MaxVaryings = 8;
+
+private:
+	struct ClipVertex
+	{
+		glm::vec4 Position;
+		float Varyings[s_MaxVaryings];
+	};
+
+	/* screen space triangle, every value is a plane Base + X * x + Y * y */
+	struct Triangle
+	{
+		float EdgeA[3], EdgeB[3], EdgeC[3];
+		/* pixel centers exactly on the edge count as inside */
+		bool TopLeft[3];
+		float InverseW[3];
+		/* varyings divided by w */
+		float Varyings[s_MaxVaryings][3];
+		int MinX, MinY, MaxX, MaxY;
+	};
+
+	JobSystem* m_Jobs;
+	int m_Width, m_Height;
+	int m_TilesX, m_TilesY;
+	bool m_Blend;
+	std::vector<unsigned char> m_Color;
+
+	/* the current draw's post transform vertices, triangles and bins */
+	std::vector<glm::vec4> m_Positions;
+	std::vector<float> m_Varyings;
+	std::vector<Triangle> m_Triangles;
+	std::vector<std::vector<unsigned int>> m_Bins;
+	std::vector<unsigned long long> m_TileFragments;
+	SoftwareRasterStats m_Stats;
+public:
+	/* jobs may be null to run everything on the calling thread */
+	SoftwareRenderer(int width, int height, JobSystem* jobs);
+
+	void Clear(const glm::vec4& color = glm::vec4(0.0f));
+	/* GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA when on */
+	inline void SetBlend(bool enabled) { m_Blend = enabled; }
+
+	/* vertexCount vertices of stride floats each, every three indices make a triangle */
+	void Draw(const float* vertices, unsigned int vertexCount, unsigned int stride, const unsigned int* indices, unsigned int indexCount,
+		const SoftwareProgram& program);
+
+	/* RGBA8, bottom row first like glReadPixels */
+	inline const std::vector<unsigned char>& GetPixels() const { return m_Color; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+
+	inline const SoftwareRasterStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = SoftwareRasterStats(); }
+
+private:
+	void ClipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int varyingCount);
+	void SetupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int varyingCount);
+	/* shades the current draw's triangles in the tile, counting into m_TileFragments */
+	void RasterizeTile(unsigned int tile, const SoftwareProgram& program);
+};
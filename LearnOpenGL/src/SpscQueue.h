@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+
+/*
+* Lock-free ring for exactly one producer thread and one consumer thread
+* Head and tail only ever grow and wrap on their own, the slot is the low
+* bits, so all Capacity slots can be used. The producer publishes an item
+* with a release store of the tail and the consumer hands the slot back
+* with a release store of the head, no other synchronization is needed.
+*/
+template<typename T, unsigned int Capacity>
+class SpscQueue
+{
+private:
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+	static const unsigned int s_Mask = Capacity - 1;
+
+	/* padded onto separate cache lines, each side writes only its own index */
+	std::atomic<unsigned int> m_Head;
+	char m_Padding[64 - sizeof(std::atomic<unsigned int>)];
+	std::atomic<unsigned int> m_Tail;
+	T m_Items[Capacity];
+public:
+	SpscQueue()
+		: m_Head(0), m_Tail(0) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/* producer only, false when full */
+	bool Push(const T& item)
+	{
+		unsigned int tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_Head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		m_Items[tail & s_Mask] = item;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* consumer only, false when empty */
+	bool Pop(T& item)
+	{
+		unsigned int head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_Tail.load(std::memory_order_acquire))
+			return false;
+		item = m_Items[head & s_Mask];
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool Empty() const { return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,137 @@
+#include "StatsOverlay.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "VertexBufferLayout.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+const unsigned int StatsOverlay::s_MaxQuads;
+
+/* 3x5 glyphs for ' ' to 'Z', 15 bits each with the top left pixel in bit 14 */
+static const unsigned short s_Font[59] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x01c0, 0x0002, 0x12a4, 0x7b6f, 0x2c97, 0x73e7, 0x72cf,
+	0x5bc9, 0x79cf, 0x79ef, 0x7292, 0x7bef, 0x7bcf, 0x0410, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x2bed, 0x6bae, 0x3923, 0x6b6e, 0x79a7, 0x79a4, 0x396b,
+	0x5bed, 0x7497, 0x126a, 0x5bad, 0x4927, 0x5fed, 0x6b6d, 0x2b6a, 0x6ba4, 0x2b73,
+	0x6bad, 0x388e, 0x7492, 0x5b6f, 0x5b6a, 0x5bfd, 0x5aad, 0x5a92, 0x72a7,
+};
+
+static const float s_Background[4] = { 0.0f, 0.0f, 0.0f, 0.6f };
+static const float s_Label[4] = { 0.7f, 0.7f, 0.7f, 1.0f };
+static const float s_Value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+static const float s_GraphGood[4] = { 0.2f, 0.9f, 0.3f, 1.0f };
+static const float s_GraphSlow[4] = { 0.95f, 0.3f, 0.2f, 1.0f };
+static const float s_GraphTarget[4] = { 1.0f, 1.0f, 1.0f, 0.5f };
+
+StatsOverlay::StatsOverlay(int width, int height)
+	: m_Width(width), m_Height(height), m_Shader("res/shaders/Overlay.shader"),
+	m_VertexBuffer(s_MaxQuads * 4 * sizeof(Vertex))
+{
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(4);
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+
+	/* every quad uses the same index pattern, so the index buffer never changes */
+	std::vector<unsigned int> indices(s_MaxQuads * 6);
+	for (unsigned int i = 0; i < s_MaxQuads; i++)
+	{
+		unsigned int first = i * 4;
+		unsigned int* quad = &indices[i * 6];
+		quad[0] = first; quad[1] = first + 1; quad[2] = first + 2;
+		quad[3] = first + 2; quad[4] = first + 3; quad[5] = first;
+	}
+	m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+	m_Shader.Bind();
+	m_Shader.SetUniformMat4f("u_Projection", glm::ortho(0.0f, (float)width, 0.0f, (float)height, -1.0f, 1.0f));
+
+	m_Vertices.reserve(s_MaxQuads * 4);
+}
+
+void StatsOverlay::AddQuad(float x, float y, float width, float height, const float* color)
+{
+	if (m_Vertices.size() >= s_MaxQuads * 4)
+		return;
+
+	Vertex corner = { x, y, color[0], color[1], color[2], color[3] };
+	m_Vertices.push_back(corner);
+	corner.X = x + width;
+	m_Vertices.push_back(corner);
+	corner.Y = y + height;
+	m_Vertices.push_back(corner);
+	corner.X = x;
+	m_Vertices.push_back(corner);
+}
+
+float StatsOverlay::AddText(float x, float y, const char* text, float pixelSize, const float* color)
+{
+	for (; *text; text++)
+	{
+		int character = *text;
+		if (character >= 'a' && character <= 'z')
+			character -= 'a' - 'A';
+
+		if (character >= ' ' && character <= 'Z')
+		{
+			unsigned short glyph = s_Font[character - ' '];
+			for (int row = 0; row < 5; row++)
+			{
+				for (int column = 0; column < 3; column++)
+				{
+					if (glyph & (1 << (14 - (row * 3 + column))))
+						AddQuad(x + column * pixelSize, y + (4 - row) * pixelSize, pixelSize, pixelSize, color);
+				}
+			}
+		}
+		x += pixelSize * 4;
+	}
+	return x;
+}
+
+void StatsOverlay::Draw(const Renderer& renderer, const RenderStatsFrame& stats)
+{
+	const float pixel = 2.0f;
+	const float lineHeight = pixel * 7;
+	const float panelWidth = 260.0f;
+	const float graphHeight = 60.0f;
+	const int counterCount = (int)RenderCounter::Count;
+
+	m_Vertices.clear();
+
+	float panelHeight = lineHeight * (counterCount + 1) + graphHeight + pixel * 6;
+	float top = (float)m_Height - pixel * 2;
+	float left = pixel * 2;
+	AddQuad(left, top - panelHeight, panelWidth, panelHeight, s_Background);
+
+	char value[32];
+	float y = top - lineHeight;
+	snprintf(value, sizeof(value), "%.2f MS", stats.FrameMilliseconds);
+	AddText(AddText(left + pixel * 2, y, "FRAME ", pixel, s_Label), y, value, pixel, s_Value);
+
+	for (int i = 0; i < counterCount; i++)
+	{
+		y -= lineHeight;
+		snprintf(value, sizeof(value), "%llu", stats.Values[i]);
+		AddText(left + pixel * 2, y, RenderStats::GetName((RenderCounter)i), pixel, s_Label);
+		AddText(left + pixel * 2 + 12 * 4 * pixel, y, value, pixel, s_Value);
+	}
+
+	/* frame time graph, full height is 33 ms with a line at 16.7 ms */
+	float history[RenderStats::s_HistorySize];
+	unsigned int count = RenderStats::GetFrameHistory(history);
+	float graphBottom = top - panelHeight + pixel * 2;
+	float barWidth = (panelWidth - pixel * 4) / RenderStats::s_HistorySize;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		float height = std::min(history[i] / 33.3f, 1.0f) * graphHeight;
+		AddQuad(left + pixel * 2 + i * barWidth, graphBottom, barWidth, height, history[i] > 17.0f ? s_GraphSlow : s_GraphGood);
+	}
+	AddQuad(left + pixel * 2, graphBottom + graphHeight * 0.5f, panelWidth - pixel * 4, 1.0f, s_GraphTarget);
+
+	m_VertexBuffer.SetData(m_Vertices.data(), (unsigned int)(m_Vertices.size() * sizeof(Vertex)));
+	renderer.Draw(m_VertexArray, *m_IndexBuffer, m_Shader, (unsigned int)(m_Vertices.size() / 4 * 6));
+}
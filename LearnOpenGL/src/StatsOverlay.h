@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+
+/*
+* Draws the last frame's RenderStats and a frame time graph in a corner
+* Everything is solid colored quads, text uses a built in 3x5 pixel font, so
+* the overlay needs no textures and costs a single draw call.
+*/
+class StatsOverlay
+{
+private:
+	struct Vertex
+	{
+		float X, Y;
+		float R, G, B, A;
+	};
+
+	static const unsigned int s_MaxQuads = 8192;
+
+	int m_Width, m_Height;
+	Shader m_Shader;
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	std::vector<Vertex> m_Vertices;
+public:
+	/* width and height of the target in pixels, the overlay is drawn in pixel units */
+	StatsOverlay(int width, int height);
+
+	void Draw(const Renderer& renderer, const RenderStatsFrame& stats);
+
+private:
+	void AddQuad(float x, float y, float width, float height, const float* color);
+	/* uppercase letters, digits and a little punctuation, returns the x after the last character */
+	float AddText(float x, float y, const char* text, float pixelSize, const float* color);
+};
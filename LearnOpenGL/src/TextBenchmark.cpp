@@ -0,0 +1,124 @@
+#include "TextBenchmark.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "Framebuffer.h"
+#include "ImageWriter.h"
+#include "TextRenderer.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+/* fixed seed so every run lays out the same strings */
+static unsigned int NextRandom(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+TextBenchmark::TextBenchmark(const std::string& fontPath, int width, int height, unsigned int frames)
+	: m_FontPath(fontPath), m_Width(width), m_Height(height), m_Frames(frames)
+{
+}
+
+bool TextBenchmark::Run(const std::string& imagePath)
+{
+	TrueTypeFont font;
+	if (!font.Load(m_FontPath))
+		return false;
+
+	Framebuffer framebuffer(m_Width, m_Height);
+	framebuffer.Bind();
+	GLCall(glEnable(GL_BLEND));
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	Renderer renderer;
+	TextRenderer text;
+
+	/* lines of random words, enough to fill the target at 14 pixels */
+	const float pixelSize = 14.0f;
+	unsigned int lineCount = (unsigned int)(m_Height / pixelSize);
+	std::vector<std::string> lines;
+	unsigned int seed = 1;
+	size_t characters = 0;
+	for (unsigned int i = 0; i < lineCount; i++)
+	{
+		std::string line;
+		while (line.size() < (size_t)m_Width / 8)
+		{
+			unsigned int length = 2 + NextRandom(seed) % 8;
+			for (unsigned int c = 0; c < length; c++)
+				line += (char)((NextRandom(seed) % 3 == 0 ? 'A' : 'a') + NextRandom(seed) % 26);
+			line += NextRandom(seed) % 6 == 0 ? ", " : " ";
+		}
+		characters += line.size();
+		lines.push_back(line);
+	}
+
+	/* every printable ASCII glyph goes through outline parsing and the distance field once */
+	std::string ascii;
+	for (char c = 33; c < 127; c++)
+		ascii += c;
+	auto start = std::chrono::steady_clock::now();
+	TextRun warmup = text.CreateRun(font, ascii, pixelSize);
+	double rasterizeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	/* layout with the glyphs cached, each line from scratch */
+	std::vector<TextRun> runs;
+	runs.reserve(lines.size());
+	unsigned long long laidOut = 0;
+	start = std::chrono::steady_clock::now();
+	for (const std::string& line : lines)
+	{
+		runs.push_back(text.CreateRun(font, line, pixelSize));
+		laidOut += runs.back().GlyphCount;
+	}
+	double layoutMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	/* draw the cached runs every frame, submission alone and with the GPU finishing */
+	glm::mat4 projection = glm::ortho(0.0f, (float)m_Width, 0.0f, (float)m_Height, -1.0f, 1.0f);
+	double submitMilliseconds = 0.0, frameMilliseconds = 0.0;
+	unsigned long long drawn = 0;
+	TextStats before = text.GetStats();
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		start = std::chrono::steady_clock::now();
+		renderer.Clear();
+		text.Begin(projection);
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			float y = m_Height - (i + 1) * pixelSize;
+			text.Draw(runs[i], 2.0f, y, glm::vec4(0.9f, 0.9f, 0.9f, 1.0f));
+			drawn += runs[i].GlyphCount;
+		}
+		text.End();
+		auto submitted = std::chrono::steady_clock::now();
+		GLCall(glFinish());
+		auto finished = std::chrono::steady_clock::now();
+
+		submitMilliseconds += std::chrono::duration<double, std::milli>(submitted - start).count();
+		frameMilliseconds += std::chrono::duration<double, std::milli>(finished - start).count();
+	}
+	TextStats stats = text.GetStats();
+
+	std::cout << "Text benchmark: " << font.GetFilePath() << ", " << runs.size() << " lines, " << characters
+		<< " characters, " << m_Width << "x" << m_Height << std::endl;
+	std::cout << "  rasterize: " << warmup.GlyphCount / rasterizeMilliseconds << " glyphs/ms ("
+		<< warmup.GlyphCount << " glyphs into the distance field cache)" << std::endl;
+	std::cout << "  layout: " << laidOut / layoutMilliseconds << " glyphs/ms" << std::endl;
+	std::cout << "  render: " << drawn / submitMilliseconds << " glyphs/ms submitted, " << drawn / frameMilliseconds
+		<< " glyphs/ms with the GPU, " << (stats.DrawCalls - before.DrawCalls) / (double)m_Frames << " draw calls and "
+		<< (stats.RunsLaidOut - before.RunsLaidOut) << " layouts over " << m_Frames << " frames" << std::endl;
+	std::cout << "  cache: " << stats.Cache.Glyphs << " glyphs on " << stats.Cache.Pages << " pages, "
+		<< stats.Cache.PagesEvicted << " pages evicted" << std::endl;
+
+	if (!imagePath.empty())
+	{
+		std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+		GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+		GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		ImageWriter::WritePNG(imagePath, pixels.data(), m_Width, m_Height);
+	}
+	framebuffer.UnBind();
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+/*
+* Measures the text path with a real font
+* Rasterizing reports how fast new glyphs go into the cache, layout how fast
+* strings are laid out with every glyph already cached, and rendering how
+* many glyphs per millisecond are drawn from cached layouts including the
+* GPU, all into an offscreen target. Needs a current GL context.
+*/
+class TextBenchmark
+{
+private:
+	std::string m_FontPath;
+	int m_Width, m_Height;
+	unsigned int m_Frames;
+public:
+	TextBenchmark(const std::string& fontPath, int width, int height, unsigned int frames);
+
+	/* writes the last rendered frame to imagePath as PNG when it is not empty, false when the font cannot be loaded */
+	bool Run(const std::string& imagePath);
+};
@@ -0,0 +1,234 @@
+#include "TextRenderer.h"
+
+#include <algorithm>
+
+#include "VertexBufferLayout.h"
+
+const unsigned int TextRenderer::s_MaxGlyphs;
+const unsigned int TextRenderer::s_RunLifetime;
+
+/* next codepoint of UTF-8 text, malformed bytes come out as U+FFFD */
+static unsigned int DecodeUTF8(const std::string& text, size_t& i)
+{
+	unsigned char lead = (unsigned char)text[i++];
+	if (lead < 0x80)
+		return lead;
+
+	int extra = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : -1;
+	if (extra < 0)
+		return 0xfffd;
+
+	unsigned int codepoint = lead & (0x3f >> extra);
+	for (int byte = 0; byte < extra; byte++)
+	{
+		if (i >= text.size() || ((unsigned char)text[i] & 0xc0) != 0x80)
+			return 0xfffd;
+		codepoint = (codepoint << 6) | ((unsigned char)text[i++] & 0x3f);
+	}
+	return codepoint;
+}
+
+TextRenderer::TextRenderer(int pageSize, unsigned int pageCount)
+	: m_Cache(pageSize, pageCount), m_Shader("res/shaders/Text.shader"),
+	m_VertexBuffer(s_MaxGlyphs * 4 * sizeof(Vertex)), m_Frame(1), m_Stats()
+{
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(3);
+	layout.Push<float>(4);
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+
+	/* every glyph is a quad with the same index pattern, so the index buffer never changes */
+	std::vector<unsigned int> indices(s_MaxGlyphs * 6);
+	for (unsigned int i = 0; i < s_MaxGlyphs; i++)
+	{
+		unsigned int first = i * 4;
+		unsigned int* quad = &indices[i * 6];
+		quad[0] = first; quad[1] = first + 1; quad[2] = first + 2;
+		quad[3] = first + 2; quad[4] = first + 3; quad[5] = first;
+	}
+	m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+	m_Shader.Bind();
+	m_Shader.SetUniform1i("u_Atlas", 0);
+
+	m_Vertices.reserve(s_MaxGlyphs * 4);
+}
+
+void TextRenderer::Begin(const glm::mat4& mvp)
+{
+	m_Shader.Bind();
+	m_Shader.SetUniformMat4f("u_MVP", mvp);
+	m_Vertices.clear();
+}
+
+void TextRenderer::DrawString(const TrueTypeFont& font, const std::string& text, float x, float y, float pixelSize, const glm::vec4& color)
+{
+	/* font, size and text together name a layout */
+	m_Key.clear();
+	m_Key.append((const char*)&pixelSize, sizeof(pixelSize));
+	unsigned int fontID = font.GetID();
+	m_Key.append((const char*)&fontID, sizeof(fontID));
+	m_Key += text;
+
+	std::unique_ptr<TextRun>& run = m_Runs[m_Key];
+	if (!run)
+	{
+		run.reset(new TextRun(CreateRun(font, text, pixelSize)));
+	}
+	else
+	{
+		m_Stats.RunCacheHits++;
+	}
+	Draw(*run, x, y, color);
+}
+
+void TextRenderer::Draw(TextRun& run, float x, float y, const glm::vec4& color)
+{
+	if (IsStale(run))
+		Layout(run);
+	run.LastUsedFrame = m_Frame;
+	for (const std::pair<int, unsigned int>& page : run.Pages)
+		m_Cache.TouchPage(page.first);
+
+	const float* source = run.Vertices.data();
+	for (unsigned int glyph = 0; glyph < run.GlyphCount; glyph++)
+	{
+		if (m_Vertices.size() >= s_MaxGlyphs * 4)
+			Flush();
+
+		for (int corner = 0; corner < 4; corner++, source += 5)
+			m_Vertices.push_back({ source[0] + x, source[1] + y, source[2], source[3], source[4], color.r, color.g, color.b, color.a });
+	}
+	m_Stats.GlyphsDrawn += run.GlyphCount;
+}
+
+void TextRenderer::End()
+{
+	Flush();
+
+	/* drop layouts nobody drew for a while, the strings on screen stay */
+	for (auto it = m_Runs.begin(); it != m_Runs.end(); )
+	{
+		if (m_Frame - it->second->LastUsedFrame > s_RunLifetime)
+			it = m_Runs.erase(it);
+		else
+			++it;
+	}
+
+	m_Cache.NextFrame();
+	m_Frame++;
+}
+
+void TextRenderer::Flush()
+{
+	if (m_Vertices.empty())
+		return;
+
+	m_Cache.Bind();
+	m_VertexBuffer.SetData(m_Vertices.data(), (unsigned int)(m_Vertices.size() * sizeof(Vertex)));
+	m_Renderer.Draw(m_VertexArray, *m_IndexBuffer, m_Shader, (unsigned int)(m_Vertices.size() / 4 * 6));
+	m_Vertices.clear();
+	m_Stats.DrawCalls++;
+}
+
+TextRun TextRenderer::CreateRun(const TrueTypeFont& font, const std::string& text, float pixelSize)
+{
+	TextRun run;
+	run.Font = &font;
+	run.Text = text;
+	run.PixelSize = pixelSize;
+	run.LastUsedFrame = m_Frame;
+	Layout(run);
+	return run;
+}
+
+void TextRenderer::Layout(TextRun& run)
+{
+	const TrueTypeFont& font = *run.Font;
+	float size = run.PixelSize;
+	float fontScale = font.GetScale(size);
+	float lineHeight = (font.GetAscent() - font.GetDescent() + font.GetLineGap()) * fontScale;
+
+	run.Vertices.clear();
+	run.Pages.clear();
+	run.GlyphCount = 0;
+	run.Width = 0.0f;
+	run.Height = lineHeight;
+	run.Incomplete = false;
+
+	float penX = 0.0f, penY = 0.0f;
+	int previous = -1;
+	for (size_t i = 0; i < run.Text.size(); )
+	{
+		unsigned int codepoint = DecodeUTF8(run.Text, i);
+		if (codepoint == '\n')
+		{
+			penX = 0.0f;
+			penY -= lineHeight;
+			run.Height += lineHeight;
+			previous = -1;
+			continue;
+		}
+
+		int glyph = font.FindGlyph(codepoint);
+		if (previous >= 0)
+			penX += font.GetKerning(previous, glyph) * fontScale;
+		previous = glyph;
+
+		const CachedGlyph* cached = m_Cache.GetGlyph(font, glyph);
+		if (!cached)
+		{
+			run.Incomplete = true;
+			penX += font.GetAdvance(glyph) * fontScale;
+			continue;
+		}
+
+		if (cached->Page >= 0)
+		{
+			float left = penX + cached->Left * size, right = penX + cached->Right * size;
+			float bottom = penY + cached->Bottom * size, top = penY + cached->Top * size;
+			float page = (float)cached->Page;
+			float corners[4][5] = {
+				{ left, bottom, cached->U0, cached->V0, page },
+				{ right, bottom, cached->U1, cached->V0, page },
+				{ right, top, cached->U1, cached->V1, page },
+				{ left, top, cached->U0, cached->V1, page }
+			};
+			run.Vertices.insert(run.Vertices.end(), &corners[0][0], &corners[0][0] + 20);
+			run.GlyphCount++;
+
+			bool known = false;
+			for (const std::pair<int, unsigned int>& used : run.Pages)
+				known = known || used.first == cached->Page;
+			if (!known)
+				run.Pages.push_back({ cached->Page, m_Cache.GetPageEpoch(cached->Page) });
+		}
+
+		penX += cached->Advance * size;
+		run.Width = std::max(run.Width, penX);
+	}
+
+	m_Stats.RunsLaidOut++;
+	m_Stats.GlyphsLaidOut += run.GlyphCount;
+}
+
+bool TextRenderer::IsStale(const TextRun& run) const
+{
+	if (run.Incomplete)
+		return true;
+	for (const std::pair<int, unsigned int>& page : run.Pages)
+	{
+		if (m_Cache.GetPageEpoch(page.first) != page.second)
+			return true;
+	}
+	return false;
+}
+
+TextStats TextRenderer::GetStats() const
+{
+	TextStats stats = m_Stats;
+	stats.CachedRuns = (unsigned int)m_Runs.size();
+	stats.Cache = m_Cache.GetStats();
+	return stats;
+}
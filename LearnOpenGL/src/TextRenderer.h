@@ -0,0 +1,105 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "GlyphCache.h"
+#include "TrueTypeFont.h"
+
+/*
+* Laid out text, kept so drawing the same string again only copies vertices
+* Positions are in pixels relative to the start of the first baseline. The
+* run records the cache pages it uses, if one of them was refilled since the
+* run is laid out again the next time it is drawn.
+*/
+struct TextRun
+{
+	/* x, y, u, v, page for each corner, four corners per glyph */
+	std::vector<float> Vertices;
+	unsigned int GlyphCount;
+	float Width, Height;
+	/* cache page and its epoch at layout time */
+	std::vector<std::pair<int, unsigned int>> Pages;
+	/* some glyphs had no room in the cache and are missing */
+	bool Incomplete;
+
+	const TrueTypeFont* Font;
+	std::string Text;
+	float PixelSize;
+	unsigned long long LastUsedFrame;
+};
+
+struct TextStats
+{
+	unsigned long long GlyphsDrawn;
+	unsigned long long DrawCalls;
+	unsigned long long RunsLaidOut;
+	unsigned long long GlyphsLaidOut;
+	unsigned long long RunCacheHits;
+	unsigned int CachedRuns;
+	GlyphCacheStats Cache;
+};
+
+/*
+* Signed distance field text, every glyph of a frame in one batched draw
+* Text is UTF-8, size is the pixel height from ascent to descent. Between
+* Begin and End each DrawString appends its cached run to the batch, End
+* uploads it and draws. Strings not drawn for a while drop out of the cache.
+*/
+class TextRenderer
+{
+private:
+	struct Vertex
+	{
+		float X, Y;
+		float U, V, Page;
+		float R, G, B, A;
+	};
+
+	static const unsigned int s_MaxGlyphs = 16384;
+	/* frames a string may go undrawn before its layout is dropped */
+	static const unsigned int s_RunLifetime = 120;
+
+	GlyphCache m_Cache;
+	Shader m_Shader;
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	std::vector<Vertex> m_Vertices;
+	Renderer m_Renderer;
+
+	std::unordered_map<std::string, std::unique_ptr<TextRun>> m_Runs;
+	/* DrawString builds its lookup key here, the buffer is reused instead of allocated per string */
+	std::string m_Key;
+	unsigned long long m_Frame;
+	TextStats m_Stats;
+public:
+	TextRenderer(int pageSize = 512, unsigned int pageCount = 4);
+
+	/* starts a batch drawn with mvp, pixel units for an orthographic projection */
+	void Begin(const glm::mat4& mvp);
+	void DrawString(const TrueTypeFont& font, const std::string& text, float x, float y, float pixelSize, const glm::vec4& color);
+	/* draws a run owned by the caller, laid out again only when stale */
+	void Draw(TextRun& run, float x, float y, const glm::vec4& color);
+	/* draws everything queued since Begin */
+	void End();
+
+	/* Fills run from its Font, Text and PixelSize */
+	void Layout(TextRun& run);
+	/* sets up and lays out a run the caller keeps */
+	TextRun CreateRun(const TrueTypeFont& font, const std::string& text, float pixelSize);
+	/* forgets every cached layout, the glyph cache stays */
+	inline void ClearRunCache() { m_Runs.clear(); }
+
+	TextStats GetStats() const;
+
+private:
+	bool IsStale(const TextRun& run) const;
+	void Flush();
+};
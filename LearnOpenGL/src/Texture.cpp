@@ -4,9 +4,11 @@
 
 #include "stb_image/stb_image.h"
 
+#include "GpuMemory.h"
+
 Texture::Texture(const std::string& path)
 	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), 
-	m_Width(0), m_Height(0), m_BPP(0)
+	m_Width(0), m_Height(0), m_BPP(0), m_MemoryID(0)
 {
 	/*
 	* Flips our texture vertically
@@ -18,6 +20,25 @@ Texture::Texture(const std::string& path)
 	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4); 
 	// now have all texture data in this local buffer
 
+	Create(m_LocalBuffer);
+
+	/* 
+	* In more complicated setups may want to retain a copy of the pixel data on CPU
+	* b/c you may want to sample or do something else with it
+	* */
+	if (m_LocalBuffer)
+		stbi_image_free(m_LocalBuffer);
+}
+
+Texture::Texture(int width, int height, const unsigned char* pixels)
+	: m_RendererID(0), m_LocalBuffer(nullptr),
+	m_Width(width), m_Height(height), m_BPP(4), m_MemoryID(0)
+{
+	Create(pixels);
+}
+
+void Texture::Create(const unsigned char* pixels)
+{
 	GLCall(glGenTextures(1, &m_RendererID));
 	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID)); 
 
@@ -33,24 +54,23 @@ Texture::Texture(const std::string& path)
 	* @param Internal format - how OpenGL will store texture data 
 	* @param Format - the texture data's format
 	*/
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	RENDER_STAT(TextureBytesUploaded, (unsigned long long)m_Width * m_Height * 4);
+	/* GL_RGBA8 and no mip levels */
+	m_MemoryID = GpuMemory::Track(GpuMemoryCategory::Texture, GpuMemory::EstimateTextureBytes(m_Width, m_Height, 4, false),
+		m_FilePath.empty() ? "Generated texture" : m_FilePath);
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
-
-	/* 
-	* In more complicated setups may want to retain a copy of the pixel data on CPU
-	* b/c you may want to sample or do something else with it
-	* */
-	if (m_LocalBuffer)
-		stbi_image_free(m_LocalBuffer);
 }
 
 Texture::~Texture()
 {
 	GLCall(glDeleteTextures(1, &m_RendererID));
+	GpuMemory::Release(m_MemoryID);
 }
 
 void Texture::Bind(unsigned int slot) const
 {
+	RENDER_STAT(TextureBinds, 1);
 	/* 
 	* Set glActiveTexture to a slot. The next texture bond will be bound to slot set unti
 	* glActiveTexture is called again with a different slot. 
@@ -64,3 +84,18 @@ void Texture::UnBind() const
 {
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 }
+
+void Texture::Update(int x, int y, int width, int height, const unsigned char* pixels)
+{
+	ASSERT(x >= 0 && y >= 0 && x + width <= m_Width && y + height <= m_Height);
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	RENDER_STAT(TextureBytesUploaded, (unsigned long long)width * height * 4);
+}
+
+void Texture::Update(const unsigned char* pixels)
+{
+	Update(0, 0, m_Width, m_Height, pixels);
+}
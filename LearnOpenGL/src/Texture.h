@@ -10,13 +10,29 @@ private:
 	unsigned char* m_LocalBuffer; 
 	//BPP - Bits per pixel 
 	int m_Width, m_Height, m_BPP;
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
 public: 
 	Texture(const std::string& path); 
+	/* RGBA8 pixels already in memory, bottom row first like OpenGL expects */
+	Texture(int width, int height, const unsigned char* pixels);
 	~Texture();
 
 	void Bind(unsigned int slot = 0) const;
 	void UnBind() const; 
 
+	/*
+	* Replaces a rectangle of the texture with RGBA8 pixels, tightly packed
+	* While a GL_PIXEL_UNPACK_BUFFER is bound pixels is an offset into that buffer
+	* instead, the copy then happens on the GPU timeline and this returns at once.
+	*/
+	void Update(int x, int y, int width, int height, const unsigned char* pixels);
+	/* whole texture */
+	void Update(const unsigned char* pixels);
+
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeight() const { return m_Height; }
+
+private:
+	void Create(const unsigned char* pixels);
 };
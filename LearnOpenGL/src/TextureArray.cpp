@@ -0,0 +1,195 @@
+#include "TextureArray.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "stb_image/stb_image.h"
+
+#include "Renderer.h"
+#include "GpuMemory.h"
+
+TextureArray::TextureArray(int width, int height, unsigned int layerCount, int channels)
+	: m_RendererID(0), m_Width(width), m_Height(height), m_Channels(channels), m_LayerCount(layerCount), m_UsedLayers(0), m_MemoryID(0)
+{
+	ASSERT(channels == 1 || channels == 4);
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	/* depth is the layer count, layers never blend into each other when sampled */
+	GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, m_Channels == 1 ? GL_R8 : GL_RGBA8, m_Width, m_Height, m_LayerCount, 0,
+		m_Channels == 1 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	m_MemoryID = GpuMemory::Track(GpuMemoryCategory::Texture,
+		GpuMemory::EstimateTextureBytes(m_Width, m_Height, m_Channels, false) * m_LayerCount,
+		"Texture array " + std::to_string(m_Width) + "x" + std::to_string(m_Height) + "x" + std::to_string(m_LayerCount));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::~TextureArray()
+{
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	GpuMemory::Release(m_MemoryID);
+}
+
+int TextureArray::AddLayer(const std::string& path)
+{
+	if (IsFull())
+		return -1;
+
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, m_Channels);
+	if (!pixels)
+	{
+		std::cout << "Failed to load " << path << " into texture array" << std::endl;
+		return -1;
+	}
+
+	int layer = AddLayer(width, height, pixels);
+	stbi_image_free(pixels);
+	return layer;
+}
+
+int TextureArray::AddLayer(int width, int height, const unsigned char* pixels)
+{
+	if (IsFull())
+		return -1;
+
+	unsigned int layer = m_UsedLayers++;
+	if (width == m_Width && height == m_Height)
+	{
+		UpdateLayer(layer, pixels);
+	}
+	else
+	{
+		std::vector<unsigned char> resized((size_t)m_Width * m_Height * m_Channels);
+		Resize(pixels, width, height, resized.data(), m_Width, m_Height, m_Channels);
+		UpdateLayer(layer, resized.data());
+	}
+	return (int)layer;
+}
+
+void TextureArray::UpdateLayer(unsigned int layer, const unsigned char* pixels)
+{
+	UpdateLayer(layer, 0, 0, m_Width, m_Height, pixels);
+}
+
+void TextureArray::UpdateLayer(unsigned int layer, int x, int y, int width, int height, const unsigned char* pixels)
+{
+	ASSERT(layer < m_LayerCount && x >= 0 && y >= 0 && x + width <= m_Width && y + height <= m_Height);
+
+	/* single channel rows are not always a multiple of the default 4 byte alignment */
+	bool unaligned = (width * m_Channels) % 4 != 0;
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	if (unaligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, width, height, 1, m_Channels == 1 ? GL_RED : GL_RGBA,
+		GL_UNSIGNED_BYTE, pixels));
+	if (unaligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+	RENDER_STAT(TextureBytesUploaded, (unsigned long long)width * height * m_Channels);
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	RENDER_STAT(TextureBinds, 1);
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+}
+
+void TextureArray::UnBind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+void TextureArray::Resize(const unsigned char* source, int sourceWidth, int sourceHeight,
+	unsigned char* destination, int width, int height, int channels)
+{
+	float scaleX = (float)sourceWidth / width;
+	float scaleY = (float)sourceHeight / height;
+	for (int y = 0; y < height; y++)
+	{
+		/* sample at the destination pixel's center mapped into the source */
+		float sy = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+		int y0 = std::min((int)sy, sourceHeight - 1);
+		int y1 = std::min(y0 + 1, sourceHeight - 1);
+		float fy = sy - y0;
+		for (int x = 0; x < width; x++)
+		{
+			float sx = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+			int x0 = std::min((int)sx, sourceWidth - 1);
+			int x1 = std::min(x0 + 1, sourceWidth - 1);
+			float fx = sx - x0;
+			for (int c = 0; c < channels; c++)
+			{
+				float top = source[((size_t)y0 * sourceWidth + x0) * channels + c] * (1.0f - fx) + source[((size_t)y0 * sourceWidth + x1) * channels + c] * fx;
+				float bottom = source[((size_t)y1 * sourceWidth + x0) * channels + c] * (1.0f - fx) + source[((size_t)y1 * sourceWidth + x1) * channels + c] * fx;
+				destination[((size_t)y * width + x) * channels + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+			}
+		}
+	}
+}
+
+TextureArraySet::TextureArraySet(unsigned int layersPerArray, int minSize, int maxSize)
+	: m_LayersPerArray(layersPerArray), m_MinSize(minSize), m_MaxSize(maxSize)
+{
+}
+
+TextureLayer TextureArraySet::Add(const std::string& path)
+{
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cout << "Failed to load " << path << " into texture array set" << std::endl;
+		return { nullptr, -1 };
+	}
+
+	TextureLayer layer = Add(width, height, pixels);
+	stbi_image_free(pixels);
+	return layer;
+}
+
+TextureLayer TextureArraySet::Add(int width, int height, const unsigned char* pixels)
+{
+	int bucketWidth = GetBucketSize(width);
+	int bucketHeight = GetBucketSize(height);
+
+	/* the newest array of a bucket is the only one that can have room */
+	TextureArray* array = nullptr;
+	for (auto it = m_Arrays.rbegin(); it != m_Arrays.rend(); ++it)
+	{
+		if ((*it)->GetWidth() == bucketWidth && (*it)->GetHeight() == bucketHeight)
+		{
+			array = it->get();
+			break;
+		}
+	}
+	if (!array || array->IsFull())
+	{
+		m_Arrays.emplace_back(new TextureArray(bucketWidth, bucketHeight, m_LayersPerArray));
+		array = m_Arrays.back().get();
+	}
+
+	return { array, array->AddLayer(width, height, pixels) };
+}
+
+int TextureArraySet::GetBucketSize(int size) const
+{
+	int bucket = m_MinSize;
+	while (bucket < size && bucket < m_MaxSize)
+		bucket *= 2;
+	return std::min(bucket, m_MaxSize);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+* GL_TEXTURE_2D_ARRAY of same sized RGBA8 or single channel R8 layers
+* Every image in the array is reachable through one bind, the shader picks the
+* layer from vertex data. So a whole sprite set with different images can be
+* drawn in a single batch without texture switches or running out of slots.
+* Images of a different size are resized to the array's size when added.
+*/
+class TextureArray
+{
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	/* 4 for RGBA8, 1 for R8 */
+	int m_Channels;
+	unsigned int m_LayerCount;
+	/* layers handed out by AddLayer, always the first ones */
+	unsigned int m_UsedLayers;
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
+public:
+	/* allocates every layer up front, their contents are undefined until added or updated */
+	TextureArray(int width, int height, unsigned int layerCount, int channels = 4);
+	~TextureArray();
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	/* Returns the layer index for vertex data, or -1 when the array is full or the image fails to load */
+	int AddLayer(const std::string& path);
+	/* pixels with the array's channel count, bottom row first like OpenGL expects */
+	int AddLayer(int width, int height, const unsigned char* pixels);
+
+	/* Replaces a whole layer, pixels must be the array's size */
+	void UpdateLayer(unsigned int layer, const unsigned char* pixels);
+	/* Replaces a rectangle of a layer, pixels are width * height * channels tightly packed */
+	void UpdateLayer(unsigned int layer, int x, int y, int width, int height, const unsigned char* pixels);
+
+	void Bind(unsigned int slot = 0) const;
+	void UnBind() const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetChannels() const { return m_Channels; }
+	inline unsigned int GetLayerCount() const { return m_LayerCount; }
+	inline unsigned int GetUsedLayers() const { return m_UsedLayers; }
+	inline bool IsFull() const { return m_UsedLayers == m_LayerCount; }
+
+	/* Bilinear resize of 8 bit pixels with channels interleaved values each */
+	static void Resize(const unsigned char* source, int sourceWidth, int sourceHeight,
+		unsigned char* destination, int width, int height, int channels = 4);
+};
+
+/* Where an image ended up in a TextureArraySet */
+struct TextureLayer
+{
+	TextureArray* Array;
+	int Layer;
+};
+
+/*
+* Texture arrays grouped by size bucket
+* For images that do not share a size and do not pack well into an atlas.
+* Each image goes into the array of its bucket, the next power of two at or
+* above its width and height, and is stretched to fill it. A new array of the
+* same bucket is made when one fills up. Sort draws by array to keep binds low.
+*/
+class TextureArraySet
+{
+private:
+	std::vector<std::unique_ptr<TextureArray>> m_Arrays;
+	unsigned int m_LayersPerArray;
+	int m_MinSize, m_MaxSize;
+public:
+	/* buckets are clamped to [minSize, maxSize], larger images are scaled down */
+	TextureArraySet(unsigned int layersPerArray, int minSize = 16, int maxSize = 2048);
+
+	/* Array is null when the image could not be loaded */
+	TextureLayer Add(const std::string& path);
+	TextureLayer Add(int width, int height, const unsigned char* pixels);
+
+	inline const std::vector<std::unique_ptr<TextureArray>>& GetArrays() const { return m_Arrays; }
+
+	int GetBucketSize(int size) const;
+};
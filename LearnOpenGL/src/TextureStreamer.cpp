@@ -0,0 +1,314 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "Renderer.h"
+#include "GpuMemory.h"
+
+/* levels this size and smaller are always resident, a few kilobytes per texture */
+static const int s_TailSize = 64;
+/* level loads in flight at once, keeps the job system free for frame work */
+static const unsigned int s_MaxPendingLoads = 4;
+/* GpuMemory evicts lower priorities first, streamed levels are the cheapest thing to give back */
+static const int s_EvictPriority = -100;
+
+StreamedTexture::StreamedTexture(const std::string& path)
+	: m_RendererID(0), m_FilePath(path), m_ResidentLevel(0), m_WantedLevel(0), m_TailLevel(0),
+	m_Loading(false), m_LastUsedFrame(0), m_ResidentBytes(0), m_MemoryID(0)
+{
+	if (!m_Chain.Open(path))
+	{
+		std::cout << "Failed to open mip chain " << path << std::endl;
+		return;
+	}
+
+	int levelCount = m_Chain.GetLevelCount();
+	m_TailLevel = levelCount - 1;
+	while (m_TailLevel > 0 && std::max(m_Chain.GetWidth(m_TailLevel - 1), m_Chain.GetHeight(m_TailLevel - 1)) <= s_TailSize)
+		m_TailLevel--;
+	/* nothing resident yet, the streamer uploads the tail right after construction */
+	m_ResidentLevel = levelCount;
+	m_WantedLevel = m_TailLevel;
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+StreamedTexture::~StreamedTexture()
+{
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	GpuMemory::Release(m_MemoryID);
+}
+
+void StreamedTexture::Bind(unsigned int slot) const
+{
+	RENDER_STAT(TextureBinds, 1);
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+}
+
+void StreamedTexture::UnBind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+TextureStreamer::TextureStreamer(JobSystem* jobs, unsigned long long budgetBytes)
+	: m_Jobs(jobs), m_Budget(budgetBytes), m_Frame(1), m_Stats()
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	/* loads still running write into textures we are about to delete */
+	if (m_Jobs)
+		m_Jobs->Wait(m_Loads);
+}
+
+StreamedTexture* TextureStreamer::Load(const std::string& path)
+{
+	std::string mipPath = path + ".mips";
+	/* baked again when missing, from an older version or when the image changed since */
+	if (!MipChain::IsCurrent(mipPath, path))
+		MipChain::Bake(path, mipPath);
+
+	m_Textures.emplace_back(new StreamedTexture(mipPath));
+	StreamedTexture& texture = *m_Textures.back();
+	texture.m_MemoryID = GpuMemory::Track(GpuMemoryCategory::Texture, 0, mipPath, s_EvictPriority,
+		[this, &texture]() { EvictAllLevels(texture); });
+
+	/* the tail is small, load it now so the texture can be drawn straight away */
+	std::vector<unsigned char> pixels;
+	for (int level = texture.GetLevelCount() - 1; level >= texture.m_TailLevel; level--)
+	{
+		if (!texture.m_Chain.ReadLevel(level, pixels))
+			break;
+		UploadLevel(texture, level, pixels.data());
+	}
+	return &texture;
+}
+
+void TextureStreamer::RequestFootprint(StreamedTexture* texture, float screenPixels)
+{
+	if (texture->GetLevelCount() == 0)
+		return;
+
+	/* each level halves the size, the finest useful one has about a texel per pixel */
+	int size = std::max(texture->GetWidth(), texture->GetHeight());
+	int level = texture->m_TailLevel;
+	if (screenPixels >= 1.0f)
+		level = std::min(texture->m_TailLevel, std::max(0, (int)std::floor(std::log2(size / screenPixels))));
+
+	/* drawn more than once this frame, the largest footprint wins */
+	if (texture->m_LastUsedFrame == m_Frame)
+		texture->m_WantedLevel = std::min(texture->m_WantedLevel, level);
+	else
+		texture->m_WantedLevel = level;
+	texture->m_LastUsedFrame = m_Frame;
+}
+
+float TextureStreamer::ComputeScreenFootprint(const glm::mat4& mvp, const AABB& bounds, int viewportWidth, int viewportHeight)
+{
+	glm::vec2 min(1e30f), max(-1e30f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 point(corner & 1 ? bounds.Max.x : bounds.Min.x, corner & 2 ? bounds.Max.y : bounds.Min.y,
+			corner & 4 ? bounds.Max.z : bounds.Min.z, 1.0f);
+		glm::vec4 clip = mvp * point;
+		/* behind the camera, assume it fills the screen rather than guess */
+		if (clip.w <= 1e-5f)
+			return (float)std::max(viewportWidth, viewportHeight);
+
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		min = glm::min(min, ndc);
+		max = glm::max(max, ndc);
+	}
+
+	min = glm::clamp(min, glm::vec2(-1.0f), glm::vec2(1.0f));
+	max = glm::clamp(max, glm::vec2(-1.0f), glm::vec2(1.0f));
+	glm::vec2 pixels = (max - min) * 0.5f * glm::vec2((float)viewportWidth, (float)viewportHeight);
+	return std::max(pixels.x, pixels.y);
+}
+
+void TextureStreamer::UploadLevel(StreamedTexture& texture, int level, const unsigned char* pixels)
+{
+	ASSERT(level == texture.m_ResidentLevel - 1);
+
+	int width = texture.m_Chain.GetWidth(level);
+	int height = texture.m_Chain.GetHeight(level);
+	unsigned long long bytes = texture.m_Chain.GetLevelSize(level);
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, texture.m_RendererID));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	/* only now that the level exists may sampling reach it */
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	RENDER_STAT(TextureBytesUploaded, bytes);
+
+	texture.m_ResidentLevel = level;
+	texture.m_ResidentBytes += bytes;
+	m_Stats.ResidentBytes += bytes;
+	m_Stats.LevelsLoaded++;
+	m_Stats.BytesLoaded += bytes;
+	/* last, going over the GpuMemory budget may evict levels again right here */
+	GpuMemory::Resize(texture.m_MemoryID, texture.m_ResidentBytes);
+}
+
+void TextureStreamer::EvictLevel(StreamedTexture& texture)
+{
+	int level = texture.m_ResidentLevel;
+	ASSERT(level < texture.m_TailLevel);
+	unsigned long long bytes = texture.m_Chain.GetLevelSize(level);
+
+	/* raise the base first so the level is never sampled, then free it with a zero sized image */
+	GLCall(glBindTexture(GL_TEXTURE_2D, texture.m_RendererID));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	texture.m_ResidentLevel = level + 1;
+	texture.m_ResidentBytes -= bytes;
+	m_Stats.ResidentBytes -= bytes;
+	m_Stats.LevelsEvicted++;
+	m_Stats.BytesEvicted += bytes;
+	GpuMemory::Resize(texture.m_MemoryID, texture.m_ResidentBytes);
+}
+
+void TextureStreamer::EvictAllLevels(StreamedTexture& texture)
+{
+	while (texture.m_ResidentLevel < texture.m_TailLevel)
+		EvictLevel(texture);
+}
+
+unsigned long long TextureStreamer::GetBudget() const
+{
+	unsigned long long gpuBudget = GpuMemory::GetBudget();
+	if (gpuBudget == 0)
+		return m_Budget;
+
+	/* streamed levels get the room every other allocation leaves */
+	unsigned long long live = GpuMemory::GetTotalLiveBytes();
+	unsigned long long others = live > m_Stats.ResidentBytes ? live - m_Stats.ResidentBytes : 0;
+	unsigned long long room = gpuBudget > others ? gpuBudget - others : 0;
+	return std::min(m_Budget, room);
+}
+
+bool TextureStreamer::MakeRoom(unsigned long long bytes, std::pmr::memory_resource* scratch)
+{
+	unsigned long long budget = GetBudget();
+	if (m_Stats.ResidentBytes + bytes <= budget)
+		return true;
+
+	std::pmr::vector<StreamedTexture*> candidates(scratch);
+	for (const std::unique_ptr<StreamedTexture>& texture : m_Textures)
+	{
+		if (texture->m_ResidentLevel < texture->m_TailLevel)
+			candidates.push_back(texture.get());
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->m_LastUsedFrame < b->m_LastUsedFrame;
+	});
+
+	/* least recently used first, textures drawn this frame only give up levels finer than they need */
+	for (StreamedTexture* texture : candidates)
+	{
+		bool usedNow = texture->m_LastUsedFrame == m_Frame;
+		while (texture->m_ResidentLevel < texture->m_TailLevel && m_Stats.ResidentBytes + bytes > budget
+			&& (!usedNow || texture->m_ResidentLevel < texture->m_WantedLevel))
+			EvictLevel(*texture);
+	}
+	return m_Stats.ResidentBytes + bytes <= budget;
+}
+
+void TextureStreamer::Update(std::pmr::memory_resource* scratch)
+{
+	std::vector<LoadedLevel> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_LoadedMutex);
+		loaded.swap(m_Loaded);
+	}
+
+	for (LoadedLevel& level : loaded)
+	{
+		StreamedTexture& texture = *level.Texture;
+		texture.m_Loading = false;
+		m_Stats.PendingLoads--;
+
+		/* the texture may have been evicted or no longer want the level while it loaded */
+		if (level.Pixels.empty() || level.Level != texture.m_ResidentLevel - 1 || level.Level < texture.m_WantedLevel)
+			continue;
+		if (!MakeRoom(level.Pixels.size(), scratch))
+			continue;
+		UploadLevel(texture, level.Level, level.Pixels.data());
+	}
+
+	/* the budget may have been lowered */
+	MakeRoom(0, scratch);
+
+	/* the most starved textures load first */
+	std::pmr::vector<StreamedTexture*> wanting(scratch);
+	for (const std::unique_ptr<StreamedTexture>& texture : m_Textures)
+	{
+		if (texture->m_LastUsedFrame == m_Frame && texture->m_WantedLevel < texture->m_ResidentLevel && !texture->m_Loading)
+			wanting.push_back(texture.get());
+	}
+	std::sort(wanting.begin(), wanting.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->m_ResidentLevel - a->m_WantedLevel > b->m_ResidentLevel - b->m_WantedLevel;
+	});
+
+	for (StreamedTexture* texture : wanting)
+	{
+		if (m_Stats.PendingLoads >= s_MaxPendingLoads)
+			break;
+
+		int level = texture->m_ResidentLevel - 1;
+		/* do not start a load the budget could never take */
+		if (!MakeRoom(texture->m_Chain.GetLevelSize(level), scratch))
+			continue;
+
+		texture->m_Loading = true;
+		m_Stats.PendingLoads++;
+
+		auto load = [this, texture, level]()
+		{
+			LoadedLevel loaded = { texture, level, std::vector<unsigned char>() };
+			if (!texture->m_Chain.ReadLevel(level, loaded.Pixels))
+				loaded.Pixels.clear();
+
+			std::lock_guard<std::mutex> lock(m_LoadedMutex);
+			m_Loaded.push_back(std::move(loaded));
+		};
+
+		if (m_Jobs)
+			m_Jobs->Execute(load, &m_Loads);
+		else
+			load();
+	}
+
+	m_Frame++;
+}
+
+TextureStreamingStats TextureStreamer::GetStats() const
+{
+	TextureStreamingStats stats = m_Stats;
+	stats.Textures = (unsigned int)m_Textures.size();
+	stats.BudgetBytes = GetBudget();
+	stats.ResidentLevels = 0;
+	stats.Starved = 0;
+	for (const std::unique_ptr<StreamedTexture>& texture : m_Textures)
+	{
+		stats.ResidentLevels += texture->GetLevelCount() - texture->m_ResidentLevel;
+		stats.Starved += texture->m_WantedLevel < texture->m_ResidentLevel;
+	}
+	return stats;
+}
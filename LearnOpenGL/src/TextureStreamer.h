@@ -0,0 +1,129 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Bounds.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+
+/*
+* Texture whose finer mip levels come and go
+* Levels from m_ResidentLevel to the last are in GPU memory, GL_TEXTURE_BASE_LEVEL
+* is kept at m_ResidentLevel so sampling never touches a missing level.
+*/
+class StreamedTexture
+{
+private:
+	friend class TextureStreamer;
+
+	unsigned int m_RendererID;
+	std::string m_FilePath;
+	MipChain m_Chain;
+	/* finest level in GPU memory */
+	int m_ResidentLevel;
+	/* finest level the last frame's footprint asked for */
+	int m_WantedLevel;
+	/* coarsest levels that are always resident, loaded up front */
+	int m_TailLevel;
+	bool m_Loading;
+	unsigned long long m_LastUsedFrame;
+	unsigned long long m_ResidentBytes;
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
+public:
+	StreamedTexture(const std::string& path);
+	~StreamedTexture();
+
+	void Bind(unsigned int slot = 0) const;
+	void UnBind() const;
+
+	inline int GetWidth() const { return m_Chain.GetWidth(0); }
+	inline int GetHeight() const { return m_Chain.GetHeight(0); }
+	inline int GetResidentLevel() const { return m_ResidentLevel; }
+	inline int GetLevelCount() const { return m_Chain.GetLevelCount(); }
+};
+
+struct TextureStreamingStats
+{
+	unsigned int Textures;
+	/* levels in GPU memory over all textures */
+	unsigned int ResidentLevels;
+	unsigned long long ResidentBytes;
+	unsigned long long BudgetBytes;
+	unsigned int PendingLoads;
+	unsigned long long LevelsLoaded;
+	unsigned long long LevelsEvicted;
+	unsigned long long BytesLoaded;
+	unsigned long long BytesEvicted;
+	/* textures showing a coarser level than their footprint asks for */
+	unsigned int Starved;
+};
+
+/*
+* Keeps only the mip levels each texture needs on screen
+* Every frame the renderer reports how many pixels a texture covers, that
+* picks the finest useful level. Missing levels are read from a baked .mips
+* file on the job system one level at a time and uploaded in Update. When
+* over budget the finest levels of the least recently used textures go first.
+* The budget shrinks to whatever the GpuMemory budget leaves after every other
+* allocation. Streamed textures are also the first thing GpuMemory evicts when
+* eviction is on, they give back everything above their tail and load again
+* when wanted.
+*/
+class TextureStreamer
+{
+private:
+	struct LoadedLevel
+	{
+		StreamedTexture* Texture;
+		int Level;
+		std::vector<unsigned char> Pixels;
+	};
+
+	JobSystem* m_Jobs;
+	unsigned long long m_Budget;
+	std::vector<std::unique_ptr<StreamedTexture>> m_Textures;
+	unsigned long long m_Frame;
+
+	std::mutex m_LoadedMutex;
+	std::vector<LoadedLevel> m_Loaded;
+	JobCounter m_Loads;
+
+	TextureStreamingStats m_Stats;
+public:
+	/* jobs may be null, levels then load synchronously in Update */
+	TextureStreamer(JobSystem* jobs, unsigned long long budgetBytes);
+	~TextureStreamer();
+
+	/* Bakes path + ".mips" first if it does not exist. The streamer owns the texture */
+	StreamedTexture* Load(const std::string& path);
+
+	/* Marks the texture used this frame at a size of screenPixels along its larger side */
+	void RequestFootprint(StreamedTexture* texture, float screenPixels);
+	/* pixels covered along the larger screen axis by bounds drawn with mvp */
+	static float ComputeScreenFootprint(const glm::mat4& mvp, const AABB& bounds, int viewportWidth, int viewportHeight);
+
+	/*
+	* Uploads finished loads, evicts over budget and starts new loads. GL thread only.
+	* The lists it sorts are taken from scratch, usually the frame arena.
+	*/
+	void Update(std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+	inline void SetBudget(unsigned long long bytes) { m_Budget = bytes; }
+	/* the budget given, or less when the GpuMemory budget leaves less room */
+	unsigned long long GetBudget() const;
+	TextureStreamingStats GetStats() const;
+
+private:
+	void UploadLevel(StreamedTexture& texture, int level, const unsigned char* pixels);
+	void EvictLevel(StreamedTexture& texture);
+	/* what GpuMemory calls, every level above the tail goes */
+	void EvictAllLevels(StreamedTexture& texture);
+	/* frees memory for bytes more, least recently used first, never touching textures used this frame */
+	bool MakeRoom(unsigned long long bytes, std::pmr::memory_resource* scratch);
+};
@@ -0,0 +1,189 @@
+#include "TransformBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+
+/* nodes per tree, the forest has nodeCount / this many roots */
+static const unsigned int s_TreeSize = 100;
+
+struct NaiveNode
+{
+	glm::vec3 Position;
+	glm::quat Rotation;
+	glm::vec3 Scale;
+	glm::mat4 World;
+	std::vector<NaiveNode*> Children;
+};
+
+static void UpdateNaive(NaiveNode* node, const glm::mat4& parentWorld)
+{
+	node->World = parentWorld * glm::translate(glm::mat4(1.0f), node->Position) * glm::mat4_cast(node->Rotation)
+		* glm::scale(glm::mat4(1.0f), node->Scale);
+	for (NaiveNode* child : node->Children)
+		UpdateNaive(child, node->World);
+}
+
+/* what a frame changes, the same edits go to the naive graph and the hierarchy */
+struct TransformEdit
+{
+	unsigned int Node;
+	bool Rotate;
+	glm::vec3 Position;
+	glm::quat Rotation;
+};
+
+TransformBenchmark::TransformBenchmark(unsigned int nodeCount, unsigned int frames)
+	: m_NodeCount(std::max(nodeCount, s_TreeSize)), m_Frames(std::max(frames, 1u))
+{
+}
+
+bool TransformBenchmark::Run()
+{
+	unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	std::cout << "Transform benchmark: " << m_NodeCount << " nodes in trees of " << s_TreeSize << ", " << m_Frames << " frames, "
+		<< cores << " hardware threads" << std::endl;
+
+	/* the forest, every node's parent comes before it */
+	unsigned int random = 1;
+	auto nextRandom = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) * (1.0f / 16777216.0f);
+	};
+	std::vector<int> parents(m_NodeCount);
+	std::vector<glm::vec3> positions(m_NodeCount), scales(m_NodeCount);
+	std::vector<glm::quat> rotations(m_NodeCount);
+	for (unsigned int i = 0; i < m_NodeCount; i++)
+	{
+		unsigned int inTree = i % s_TreeSize;
+		parents[i] = inTree == 0 ? -1 : (int)(i - inTree + (unsigned int)(nextRandom() * inTree));
+		positions[i] = glm::vec3(nextRandom() * 4.0f - 2.0f, nextRandom() * 4.0f - 2.0f, nextRandom() * 4.0f - 2.0f);
+		rotations[i] = glm::angleAxis(nextRandom() * 6.28f, glm::normalize(glm::vec3(nextRandom(), nextRandom(), nextRandom()) + 0.1f));
+		scales[i] = glm::vec3(0.9f + nextRandom() * 0.2f);
+	}
+
+	/* a single core still gets an oversubscribed threaded run, so the split's overhead shows */
+	JobSystem jobs(std::max(cores, 2u) - 1, true);
+
+	bool correct = true;
+	for (int sparse = 0; sparse < 2; sparse++)
+	{
+		/* every root spins, or 1% of all nodes move */
+		std::vector<std::vector<TransformEdit>> frames(m_Frames);
+		for (unsigned int frame = 0; frame < m_Frames; frame++)
+		{
+			if (!sparse)
+			{
+				for (unsigned int root = 0; root < m_NodeCount; root += s_TreeSize)
+					frames[frame].push_back({ root, true, glm::vec3(0.0f), glm::angleAxis(frame * 0.02f + root, glm::vec3(0.0f, 1.0f, 0.0f)) });
+			}
+			else
+			{
+				for (unsigned int i = 0; i < m_NodeCount / 100; i++)
+				{
+					unsigned int node = (unsigned int)(nextRandom() * m_NodeCount) % m_NodeCount;
+					frames[frame].push_back({ node, false, positions[node] + glm::vec3(0.0f, std::sin(frame * 0.1f), 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f) });
+				}
+			}
+		}
+
+		std::vector<glm::mat4> naiveWorlds(m_NodeCount);
+		std::vector<NaiveNode*> naiveRoots;
+		{
+			/* one allocation per node like a typical scene graph, not one array */
+			std::vector<std::unique_ptr<NaiveNode>> nodes(m_NodeCount);
+			for (unsigned int i = 0; i < m_NodeCount; i++)
+			{
+				nodes[i].reset(new NaiveNode{ positions[i], rotations[i], scales[i], glm::mat4(1.0f), {} });
+				if (parents[i] < 0)
+					naiveRoots.push_back(nodes[i].get());
+				else
+					nodes[parents[i]]->Children.push_back(nodes[i].get());
+			}
+			for (NaiveNode* root : naiveRoots)
+				UpdateNaive(root, glm::mat4(1.0f));
+
+			double naiveMilliseconds = 0.0;
+			for (unsigned int frame = 0; frame < m_Frames; frame++)
+			{
+				for (const TransformEdit& edit : frames[frame])
+				{
+					if (edit.Rotate)
+						nodes[edit.Node]->Rotation = edit.Rotation;
+					else
+						nodes[edit.Node]->Position = edit.Position;
+				}
+				auto start = std::chrono::steady_clock::now();
+				for (NaiveNode* root : naiveRoots)
+					UpdateNaive(root, glm::mat4(1.0f));
+				naiveMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			}
+			naiveMilliseconds /= m_Frames;
+			std::cout << "  " << (sparse ? "1% moving" : "all moving") << ", naive glm: " << naiveMilliseconds << " ms per frame" << std::endl;
+
+			for (unsigned int i = 0; i < m_NodeCount; i++)
+				naiveWorlds[i] = nodes[i]->World;
+
+			for (int threaded = 0; threaded < 2; threaded++)
+			{
+				TransformHierarchy hierarchy(threaded ? &jobs : nullptr);
+				for (unsigned int i = 0; i < m_NodeCount; i++)
+				{
+					TransformHierarchy::NodeID node = hierarchy.CreateNode(parents[i] < 0 ? TransformHierarchy::s_InvalidNode : (unsigned int)parents[i]);
+					hierarchy.SetPosition(node, positions[i]);
+					hierarchy.SetRotation(node, rotations[i]);
+					hierarchy.SetScale(node, scales[i]);
+				}
+				hierarchy.Update();
+
+				double milliseconds = 0.0;
+				unsigned long long updated = 0;
+				for (unsigned int frame = 0; frame < m_Frames; frame++)
+				{
+					for (const TransformEdit& edit : frames[frame])
+					{
+						if (edit.Rotate)
+							hierarchy.SetRotation(edit.Node, edit.Rotation);
+						else
+							hierarchy.SetPosition(edit.Node, edit.Position);
+					}
+					auto start = std::chrono::steady_clock::now();
+					hierarchy.Update();
+					milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					updated += hierarchy.GetUpdatedCount();
+				}
+				milliseconds /= m_Frames;
+
+				/* same math in a different order, only rounding may differ */
+				float largest = 0.0f;
+				for (unsigned int i = 0; i < m_NodeCount; i++)
+				{
+					const glm::mat4& world = hierarchy.GetWorldMatrix(i);
+					for (int column = 0; column < 4; column++)
+						for (int row = 0; row < 4; row++)
+							largest = std::max(largest, std::abs(world[column][row] - naiveWorlds[i][column][row]) / std::max(1.0f, std::abs(naiveWorlds[i][column][row])));
+				}
+				bool same = largest < 1.0e-4f;
+				correct = correct && same;
+
+				unsigned int threads = threaded ? jobs.GetThreadCount() : 1;
+				std::cout << "  " << (sparse ? "1% moving" : "all moving") << ", hierarchy on " << threads << (threads == 1 ? " thread: " : " threads: ")
+					<< milliseconds << " ms per frame, " << naiveMilliseconds / milliseconds << "x naive, "
+					<< updated / m_Frames << " world matrices per frame, largest difference " << largest
+					<< (same ? "" : ", DIFFERENT MATRICES") << std::endl;
+			}
+		}
+	}
+	return correct;
+}
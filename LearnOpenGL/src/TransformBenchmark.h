@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+* Measures TransformHierarchy against a naive scene graph
+* The naive graph is what Application.cpp used to do per object: a heap node
+* per transform with a list of children, and every frame a recursive walk
+* that builds translate * rotate * scale with glm and multiplies it onto the
+* parent. Both get the same forest of random trees, then run the same frames
+* twice: once with every root spinning, so every world matrix changes, and
+* once with 1% of the nodes moving, where the hierarchy's dirty tracking
+* skips the rest. The hierarchy runs on one thread and then on the job
+* system, and every world matrix is compared with the naive one at the end.
+*/
+class TransformBenchmark
+{
+private:
+	unsigned int m_NodeCount;
+	unsigned int m_Frames;
+public:
+	TransformBenchmark(unsigned int nodeCount = 100000, unsigned int frames = 60);
+
+	/* Prints a line per case, returns false if any world matrix differs from the naive one */
+	bool Run();
+};
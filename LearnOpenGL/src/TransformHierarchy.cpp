@@ -0,0 +1,282 @@
+#include "TransformHierarchy.h"
+
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define TRANSFORM_USE_SSE 1
+#endif
+
+#include "Renderer.h"
+#include "JobSystem.h"
+
+static const unsigned int s_NoSlot = 0xffffffff;
+/* below this many nodes threading costs more than it saves */
+static const unsigned int s_ParallelThreshold = 16384;
+
+/* dirty flags */
+static const unsigned char s_LocalChanged = 1;
+static const unsigned char s_WorldChanged = 2;
+
+TransformHierarchy::TransformHierarchy(JobSystem* jobs)
+	: m_Jobs(jobs), m_OrderDirty(false), m_UpdatedCount(0)
+{
+}
+
+TransformHierarchy::NodeID TransformHierarchy::CreateNode(NodeID parent)
+{
+	ASSERT(parent == s_InvalidNode || parent < m_SlotOfNode.size());
+
+	NodeID node = (NodeID)m_SlotOfNode.size();
+	unsigned int slot = (unsigned int)m_Positions.size();
+
+	m_Positions.push_back(glm::vec3(0.0f));
+	m_Rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	m_Scales.push_back(glm::vec3(1.0f));
+	m_LocalMatrices.push_back(glm::mat4(1.0f));
+	m_WorldMatrices.push_back(glm::mat4(1.0f));
+	m_ParentSlots.push_back(parent == s_InvalidNode ? s_NoSlot : m_SlotOfNode[parent]);
+	m_SubtreeSizes.push_back(1);
+	m_Dirty.push_back(s_LocalChanged);
+	m_NodeOfSlot.push_back(node);
+
+	m_SlotOfNode.push_back(slot);
+	m_ParentNodes.push_back(parent);
+
+	/* a new root at the end keeps every subtree contiguous, a new child does not */
+	if (parent == s_InvalidNode)
+		m_RootSlots.push_back(slot);
+	else
+		m_OrderDirty = true;
+
+	return node;
+}
+
+void TransformHierarchy::SetParent(NodeID node, NodeID parent)
+{
+	/* walk up from the new parent, finding node there would create a cycle */
+	for (NodeID ancestor = parent; ancestor != s_InvalidNode; ancestor = m_ParentNodes[ancestor])
+		ASSERT(ancestor != node);
+
+	m_ParentNodes[node] = parent;
+	m_OrderDirty = true;
+	MarkDirty(node);
+}
+
+void TransformHierarchy::SetPosition(NodeID node, const glm::vec3& position)
+{
+	m_Positions[m_SlotOfNode[node]] = position;
+	MarkDirty(node);
+}
+
+void TransformHierarchy::SetRotation(NodeID node, const glm::quat& rotation)
+{
+	m_Rotations[m_SlotOfNode[node]] = rotation;
+	MarkDirty(node);
+}
+
+void TransformHierarchy::SetScale(NodeID node, const glm::vec3& scale)
+{
+	m_Scales[m_SlotOfNode[node]] = scale;
+	MarkDirty(node);
+}
+
+void TransformHierarchy::MarkDirty(NodeID node)
+{
+	m_Dirty[m_SlotOfNode[node]] |= s_LocalChanged;
+}
+
+void TransformHierarchy::Update()
+{
+	if (m_OrderDirty)
+		RebuildOrder();
+
+	unsigned int nodeCount = (unsigned int)m_Positions.size();
+	if (!m_Jobs || nodeCount < s_ParallelThreshold || m_RootSlots.size() < 2)
+	{
+		m_UpdatedCount = UpdateRange(0, nodeCount);
+		return;
+	}
+
+	/* root subtrees are disjoint contiguous ranges, so each one can be updated independently */
+	std::atomic<unsigned int> updated(0);
+	JobCounter counter;
+	m_Jobs->ParallelFor((unsigned int)m_RootSlots.size(), [this, &updated](unsigned int begin, unsigned int end)
+	{
+		unsigned int count = 0;
+		for (unsigned int i = begin; i < end; i++)
+		{
+			unsigned int root = m_RootSlots[i];
+			count += UpdateRange(root, root + m_SubtreeSizes[root]);
+		}
+		updated.fetch_add(count, std::memory_order_relaxed);
+	}, &counter, 1);
+	m_Jobs->Wait(counter);
+
+	m_UpdatedCount = updated.load();
+}
+
+unsigned int TransformHierarchy::UpdateRange(unsigned int begin, unsigned int end)
+{
+	unsigned int updated = 0;
+
+	for (unsigned int i = begin; i < end; i++)
+	{
+		unsigned char flags = m_Dirty[i];
+		unsigned int parent = m_ParentSlots[i];
+
+		/* parent was visited earlier in this pass, so its flags already say if it moved */
+		if (parent != s_NoSlot && (m_Dirty[parent] & s_WorldChanged))
+			flags |= s_WorldChanged;
+
+		if (flags & s_LocalChanged)
+		{
+			/* T * R * S without building three matrices */
+			glm::mat4& local = m_LocalMatrices[i];
+			local = glm::mat4_cast(m_Rotations[i]);
+			local[0] *= m_Scales[i].x;
+			local[1] *= m_Scales[i].y;
+			local[2] *= m_Scales[i].z;
+			local[3] = glm::vec4(m_Positions[i], 1.0f);
+			flags |= s_WorldChanged;
+		}
+
+		if (flags & s_WorldChanged)
+		{
+			if (parent == s_NoSlot)
+				m_WorldMatrices[i] = m_LocalMatrices[i];
+			else
+				Multiply(m_WorldMatrices[parent], m_LocalMatrices[i], m_WorldMatrices[i]);
+			updated++;
+		}
+
+		m_Dirty[i] = flags;
+	}
+
+	/* children read the flags above, so they can only be cleared once the whole range is done */
+	for (unsigned int i = begin; i < end; i++)
+		m_Dirty[i] = 0;
+
+	return updated;
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+	unsigned int nodeCount = (unsigned int)m_SlotOfNode.size();
+
+	/* children of every node packed into one array, childStart[n] .. childStart[n + 1] */
+	std::vector<unsigned int> childStart(nodeCount + 1, 0);
+	for (NodeID node = 0; node < nodeCount; node++)
+	{
+		if (m_ParentNodes[node] != s_InvalidNode)
+			childStart[m_ParentNodes[node] + 1]++;
+	}
+	for (unsigned int i = 0; i < nodeCount; i++)
+		childStart[i + 1] += childStart[i];
+
+	std::vector<NodeID> children(childStart[nodeCount]);
+	std::vector<unsigned int> fill(childStart.begin(), childStart.end() - 1);
+	for (NodeID node = 0; node < nodeCount; node++)
+	{
+		if (m_ParentNodes[node] != s_InvalidNode)
+			children[fill[m_ParentNodes[node]]++] = node;
+	}
+
+	/* depth first walk gives the new slot order */
+	std::vector<NodeID> order;
+	order.reserve(nodeCount);
+	std::vector<NodeID> stack;
+	for (NodeID root = 0; root < nodeCount; root++)
+	{
+		if (m_ParentNodes[root] != s_InvalidNode)
+			continue;
+
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			NodeID node = stack.back();
+			stack.pop_back();
+			order.push_back(node);
+			/* pushed in reverse so children come out in creation order */
+			for (unsigned int c = childStart[node + 1]; c > childStart[node]; c--)
+				stack.push_back(children[c - 1]);
+		}
+	}
+	ASSERT(order.size() == nodeCount);
+
+	std::vector<glm::vec3> positions(nodeCount), scales(nodeCount);
+	std::vector<glm::quat> rotations(nodeCount);
+	std::vector<glm::mat4> locals(nodeCount), worlds(nodeCount);
+	std::vector<unsigned char> dirty(nodeCount);
+	std::vector<unsigned int> slotOfNode(nodeCount);
+
+	for (unsigned int slot = 0; slot < nodeCount; slot++)
+	{
+		NodeID node = order[slot];
+		unsigned int old = m_SlotOfNode[node];
+		positions[slot] = m_Positions[old];
+		rotations[slot] = m_Rotations[old];
+		scales[slot] = m_Scales[old];
+		locals[slot] = m_LocalMatrices[old];
+		worlds[slot] = m_WorldMatrices[old];
+		dirty[slot] = m_Dirty[old];
+		slotOfNode[node] = slot;
+	}
+
+	m_Positions.swap(positions);
+	m_Rotations.swap(rotations);
+	m_Scales.swap(scales);
+	m_LocalMatrices.swap(locals);
+	m_WorldMatrices.swap(worlds);
+	m_Dirty.swap(dirty);
+	m_SlotOfNode.swap(slotOfNode);
+	m_NodeOfSlot = order;
+
+	m_RootSlots.clear();
+	for (unsigned int slot = 0; slot < nodeCount; slot++)
+	{
+		NodeID parent = m_ParentNodes[order[slot]];
+		m_ParentSlots[slot] = parent == s_InvalidNode ? s_NoSlot : m_SlotOfNode[parent];
+		m_SubtreeSizes[slot] = 1;
+		if (parent == s_InvalidNode)
+			m_RootSlots.push_back(slot);
+	}
+	/* children come after parents, so walking backwards accumulates whole subtrees */
+	for (unsigned int slot = nodeCount; slot-- > 0;)
+	{
+		if (m_ParentSlots[slot] != s_NoSlot)
+			m_SubtreeSizes[m_ParentSlots[slot]] += m_SubtreeSizes[slot];
+	}
+
+	m_OrderDirty = false;
+}
+
+void TransformHierarchy::Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+{
+#ifdef TRANSFORM_USE_SSE
+	/*
+	* Column major, so each result column is a linear combination of a's columns
+	* weighted by the matching column of b: 4 broadcasts, 4 mul and 3 add per column
+	*/
+	const float* pa = &a[0][0];
+	const float* pb = &b[0][0];
+	float* pr = &result[0][0];
+
+	__m128 a0 = _mm_loadu_ps(pa + 0);
+	__m128 a1 = _mm_loadu_ps(pa + 4);
+	__m128 a2 = _mm_loadu_ps(pa + 8);
+	__m128 a3 = _mm_loadu_ps(pa + 12);
+
+	for (int column = 0; column < 4; column++)
+	{
+		const float* b_col = pb + column * 4;
+		__m128 r = _mm_mul_ps(a0, _mm_set1_ps(b_col[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b_col[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b_col[2])));
+		r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b_col[3])));
+		_mm_storeu_ps(pr + column * 4, r);
+	}
+#else
+	result = a * b;
+#endif
+}
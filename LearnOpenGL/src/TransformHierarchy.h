@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+class JobSystem;
+
+/*
+* Data oriented scene graph transforms
+* Every attribute lives in its own array (structure of arrays) and nodes are
+* kept in depth first order, so parents always come before their children and
+* each root's subtree is one contiguous range. Update walks the arrays once and
+* only recomputes nodes that changed or whose parent changed.
+*/
+class TransformHierarchy
+{
+public:
+	/* stable handle, slots move around when the hierarchy is reordered */
+	typedef unsigned int NodeID;
+	static const NodeID s_InvalidNode = 0xffffffff;
+
+private:
+	JobSystem* m_Jobs;
+
+	/* indexed by slot, in depth first order */
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::quat> m_Rotations;
+	std::vector<glm::vec3> m_Scales;
+	std::vector<glm::mat4> m_LocalMatrices;
+	std::vector<glm::mat4> m_WorldMatrices;
+	std::vector<unsigned int> m_ParentSlots;
+	std::vector<unsigned int> m_SubtreeSizes;
+	std::vector<unsigned char> m_Dirty;
+	std::vector<NodeID> m_NodeOfSlot;
+	std::vector<unsigned int> m_RootSlots;
+
+	/* indexed by NodeID */
+	std::vector<unsigned int> m_SlotOfNode;
+	std::vector<NodeID> m_ParentNodes;
+
+	bool m_OrderDirty;
+	unsigned int m_UpdatedCount;
+public:
+	/* jobs may be null, large hierarchies are split across threads by root subtree when it is set */
+	TransformHierarchy(JobSystem* jobs = nullptr);
+
+	NodeID CreateNode(NodeID parent = s_InvalidNode);
+	void SetParent(NodeID node, NodeID parent);
+
+	void SetPosition(NodeID node, const glm::vec3& position);
+	void SetRotation(NodeID node, const glm::quat& rotation);
+	void SetScale(NodeID node, const glm::vec3& scale);
+
+	/* Recomputes world matrices of dirty nodes and their descendants */
+	void Update();
+
+	inline const glm::mat4& GetWorldMatrix(NodeID node) const { return m_WorldMatrices[m_SlotOfNode[node]]; }
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_SlotOfNode.size(); }
+	/* world matrices recomputed by the last Update */
+	inline unsigned int GetUpdatedCount() const { return m_UpdatedCount; }
+
+	/* result = a * b, SSE when available, result may not alias a or b */
+	static void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result);
+
+private:
+	void RebuildOrder();
+	unsigned int UpdateRange(unsigned int begin, unsigned int end);
+	void MarkDirty(NodeID node);
+};
@@ -0,0 +1,500 @@
+#include "TrueTypeFont.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+unsigned int TrueTypeFont::s_NextID = 1;
+
+/* composite glyphs may nest, real fonts stay far below this */
+static const int s_MaxCompositeDepth = 8;
+
+TrueTypeFont::TrueTypeFont()
+	: m_ID(s_NextID++), m_Cmap(), m_Glyf(), m_Loca(), m_Hmtx(), m_Kern(), m_CmapSubtable(0), m_GlyphCount(0), m_UnitsPerEm(0),
+	m_LocaFormat(0), m_HMetricCount(0), m_Ascent(0), m_Descent(0), m_LineGap(0)
+{
+}
+
+bool TrueTypeFont::Load(const std::string& path)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+	{
+		std::cout << "Failed to open font " << path << std::endl;
+		return false;
+	}
+	m_Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	m_FilePath = path;
+
+	/* 0x00010000 or 'true', 'OTTO' is CFF outlines which are not supported */
+	unsigned int version = m_Data.size() >= 12 ? U32(0) : 0;
+	Table head = {}, maxp = {}, hhea = {};
+	if (version == 0x00010000 || version == 0x74727565)
+	{
+		head = FindTable("head");
+		maxp = FindTable("maxp");
+		hhea = FindTable("hhea");
+		m_Cmap = FindTable("cmap");
+		m_Glyf = FindTable("glyf");
+		m_Loca = FindTable("loca");
+		m_Hmtx = FindTable("hmtx");
+		m_Kern = FindTable("kern");
+	}
+
+	if (!head.Length || !maxp.Length || !hhea.Length || !m_Cmap.Length || !m_Glyf.Length || !m_Loca.Length || !m_Hmtx.Length)
+	{
+		std::cout << "Unsupported font " << path << ", only TrueType outlines can be read" << std::endl;
+		m_Data.clear();
+		return false;
+	}
+
+	/* the fixed size parts of the tables read below */
+	if (!InTable(head, head.Offset, 54) || !InTable(maxp, maxp.Offset, 6) || !InTable(hhea, hhea.Offset, 36) || !InTable(m_Cmap, m_Cmap.Offset, 4))
+	{
+		std::cout << "Font " << path << " is truncated" << std::endl;
+		m_Data.clear();
+		return false;
+	}
+
+	m_UnitsPerEm = (int)U16(head.Offset + 18);
+	m_LocaFormat = I16(head.Offset + 50);
+	m_GlyphCount = (int)U16(maxp.Offset + 4);
+	m_Ascent = I16(hhea.Offset + 4);
+	m_Descent = I16(hhea.Offset + 6);
+	m_LineGap = I16(hhea.Offset + 8);
+	if (m_Ascent == m_Descent)
+	{
+		std::cout << "Font " << path << " has no vertical metrics" << std::endl;
+		m_Data.clear();
+		return false;
+	}
+	/* no more metrics than hmtx actually holds */
+	m_HMetricCount = std::min((int)U16(hhea.Offset + 34), (int)(m_Hmtx.Length / 4));
+
+	/* pick the best unicode subtable, full range format 12 over the basic plane only format 4 */
+	unsigned int tableCount = U16(m_Cmap.Offset + 2);
+	unsigned int best = 0, bestFormat = 0;
+	for (unsigned int i = 0; i < tableCount && InTable(m_Cmap, m_Cmap.Offset + 4 + i * 8, 8); i++)
+	{
+		unsigned int record = m_Cmap.Offset + 4 + i * 8;
+		unsigned int platform = U16(record), encoding = U16(record + 2);
+		bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+		unsigned int subtableOffset = U32(record + 4);
+		unsigned int subtable = m_Cmap.Offset + subtableOffset;
+		if (!unicode || subtableOffset > m_Cmap.Length || !InTable(m_Cmap, subtable, 16))
+			continue;
+
+		unsigned int format = U16(subtable);
+		if ((format == 12 && bestFormat != 12) || (format == 4 && bestFormat == 0))
+		{
+			best = subtable;
+			bestFormat = format;
+		}
+	}
+	if (!best)
+	{
+		std::cout << "Font " << path << " has no unicode character map" << std::endl;
+		m_Data.clear();
+		return false;
+	}
+	m_CmapSubtable = best;
+
+	return true;
+}
+
+TrueTypeFont::Table TrueTypeFont::FindTable(const char* tag) const
+{
+	const Table file = { 0, (unsigned int)m_Data.size() };
+	unsigned int tableCount = U16(4);
+	for (unsigned int i = 0; i < tableCount; i++)
+	{
+		unsigned int record = 12 + i * 16;
+		if (!InTable(file, record, 16))
+			return Table();
+		if (memcmp(&m_Data[record], tag, 4) == 0)
+		{
+			Table table = { U32(record + 8), U32(record + 12) };
+			return InTable(file, table.Offset, table.Length) ? table : Table();
+		}
+	}
+	return Table();
+}
+
+int TrueTypeFont::FindGlyph(unsigned int codepoint) const
+{
+	if (!IsLoaded())
+		return 0;
+
+	unsigned int format = U16(m_CmapSubtable);
+	if (format == 4)
+	{
+		if (codepoint > 0xffff)
+			return 0;
+
+		unsigned int segCountX2 = U16(m_CmapSubtable + 6);
+		unsigned int endCodes = m_CmapSubtable + 14;
+		unsigned int startCodes = endCodes + segCountX2 + 2;
+		unsigned int idDeltas = startCodes + segCountX2;
+		unsigned int idRangeOffsets = idDeltas + segCountX2;
+		if (!InTable(m_Cmap, endCodes, segCountX2 * 4 + 2))
+			return 0;
+
+		/* first segment whose end code is at or past the codepoint */
+		unsigned int low = 0, high = segCountX2 / 2;
+		while (low < high)
+		{
+			unsigned int middle = (low + high) / 2;
+			if (U16(endCodes + middle * 2) < codepoint)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		if (low == segCountX2 / 2)
+			return 0;
+
+		unsigned int start = U16(startCodes + low * 2);
+		if (codepoint < start)
+			return 0;
+
+		unsigned int delta = U16(idDeltas + low * 2);
+		unsigned int rangeOffset = U16(idRangeOffsets + low * 2);
+		if (rangeOffset == 0)
+			return (int)((codepoint + delta) & 0xffff);
+
+		/* the offset is relative to where it is stored */
+		unsigned int address = idRangeOffsets + low * 2 + rangeOffset + (codepoint - start) * 2;
+		if (!InTable(m_Cmap, address, 2))
+			return 0;
+		unsigned int glyph = U16(address);
+		return glyph ? (int)((glyph + delta) & 0xffff) : 0;
+	}
+	else if (format == 12)
+	{
+		unsigned int groupCount = U32(m_CmapSubtable + 12);
+		if (groupCount > m_Cmap.Length / 12 || !InTable(m_Cmap, m_CmapSubtable + 16, groupCount * 12))
+			return 0;
+
+		unsigned int low = 0, high = groupCount;
+		while (low < high)
+		{
+			unsigned int middle = (low + high) / 2;
+			unsigned int group = m_CmapSubtable + 16 + middle * 12;
+			if (codepoint < U32(group))
+				high = middle;
+			else if (codepoint > U32(group + 4))
+				low = middle + 1;
+			else
+				return (int)(U32(group + 8) + codepoint - U32(group));
+		}
+	}
+	return 0;
+}
+
+int TrueTypeFont::GetAdvance(int glyph) const
+{
+	if (!IsLoaded() || m_HMetricCount == 0 || glyph < 0)
+		return 0;
+
+	/* glyphs past the last full metric share its advance, monospaced fonts store just one. Load keeps the count inside hmtx */
+	int metric = std::min(glyph, m_HMetricCount - 1);
+	return (int)U16(m_Hmtx.Offset + metric * 4);
+}
+
+int TrueTypeFont::GetKerning(int left, int right) const
+{
+	if (!InTable(m_Kern, m_Kern.Offset, 4))
+		return 0;
+
+	/* only the first subtable, and only horizontal format 0 which is what fonts with a kern table use */
+	if (U16(m_Kern.Offset + 2) < 1 || !InTable(m_Kern, m_Kern.Offset + 4, 14))
+		return 0;
+	unsigned int subtable = m_Kern.Offset + 4;
+	unsigned int coverage = U16(subtable + 4);
+	if ((coverage >> 8) != 0 || (coverage & 1) == 0)
+		return 0;
+
+	unsigned int pairCount = U16(subtable + 6);
+	unsigned int pairs = subtable + 14;
+	if (!InTable(m_Kern, pairs, pairCount * 6))
+		return 0;
+
+	unsigned int key = ((unsigned int)left << 16) | (unsigned int)right;
+	unsigned int low = 0, high = pairCount;
+	while (low < high)
+	{
+		unsigned int middle = (low + high) / 2;
+		unsigned int pairKey = U32(pairs + middle * 6);
+		if (pairKey < key)
+			low = middle + 1;
+		else if (pairKey > key)
+			high = middle;
+		else
+			return I16(pairs + middle * 6 + 4);
+	}
+	return 0;
+}
+
+bool TrueTypeFont::GetGlyphRange(int glyph, unsigned int& offset, unsigned int& length) const
+{
+	if (glyph < 0 || glyph >= m_GlyphCount)
+		return false;
+
+	unsigned int start, end;
+	if (m_LocaFormat == 0)
+	{
+		if (!InTable(m_Loca, m_Loca.Offset + glyph * 2, 4))
+			return false;
+		start = U16(m_Loca.Offset + glyph * 2) * 2;
+		end = U16(m_Loca.Offset + glyph * 2 + 2) * 2;
+	}
+	else
+	{
+		if (!InTable(m_Loca, m_Loca.Offset + glyph * 4, 8))
+			return false;
+		start = U32(m_Loca.Offset + glyph * 4);
+		end = U32(m_Loca.Offset + glyph * 4 + 4);
+	}
+
+	if (start > m_Glyf.Length)
+		return false;
+	offset = m_Glyf.Offset + start;
+	length = end > start ? end - start : 0;
+	return InTable(m_Glyf, offset, length);
+}
+
+bool TrueTypeFont::GetOutline(int glyph, GlyphOutline& outline, float tolerance) const
+{
+	outline.Edges.clear();
+	outline.MinX = outline.MinY = outline.MaxX = outline.MaxY = 0;
+	if (!IsLoaded())
+		return false;
+
+	unsigned int offset, length;
+	if (!GetGlyphRange(glyph, offset, length))
+		return false;
+	if (length < 10)
+		return true;
+
+	/* the header bounds also hold for composites */
+	outline.MinX = I16(offset + 2);
+	outline.MinY = I16(offset + 4);
+	outline.MaxX = I16(offset + 6);
+	outline.MaxY = I16(offset + 8);
+	return AppendOutline(glyph, glm::mat2(1.0f), glm::vec2(0.0f), outline.Edges, tolerance, 0);
+}
+
+/* adds a quadratic bezier as enough lines to stay within tolerance of the curve */
+static void AppendQuadratic(std::vector<GlyphEdge>& edges, const glm::vec2& p0, const glm::vec2& p1, const glm::vec2& p2, float tolerance)
+{
+	/* the curve strays at most a quarter of this from its chord */
+	float deviation = glm::length(p0 - 2.0f * p1 + p2) * 0.25f;
+	int segments = std::min(16, std::max(1, (int)std::ceil(std::sqrt(deviation / tolerance))));
+
+	glm::vec2 previous = p0;
+	for (int i = 1; i <= segments; i++)
+	{
+		float t = (float)i / segments;
+		glm::vec2 point = (1.0f - t) * (1.0f - t) * p0 + 2.0f * (1.0f - t) * t * p1 + t * t * p2;
+		edges.push_back({ previous, point });
+		previous = point;
+	}
+}
+
+bool TrueTypeFont::AppendOutline(int glyph, const glm::mat2& transform, const glm::vec2& offset,
+	std::vector<GlyphEdge>& edges, float tolerance, int depth) const
+{
+	unsigned int start, length;
+	if (depth > s_MaxCompositeDepth || !GetGlyphRange(glyph, start, length))
+		return false;
+	if (length < 10)
+		return true;
+
+	unsigned int end = start + length;
+	int contourCount = I16(start);
+
+	if (contourCount < 0)
+	{
+		/* composite, a list of other glyphs each with its own placement */
+		unsigned int position = start + 10;
+		unsigned int flags;
+		do
+		{
+			if (position + 4 > end)
+				return false;
+			flags = U16(position);
+			int component = (int)U16(position + 2);
+			position += 4;
+
+			/* the arguments, words or bytes, then the scale in whichever form the flags pick */
+			unsigned int argumentSize = (flags & 0x0001) ? 4 : 2;
+			unsigned int scaleSize = (flags & 0x0008) ? 2 : (flags & 0x0040) ? 4 : (flags & 0x0080) ? 8 : 0;
+			if (argumentSize + scaleSize > end - position)
+				return false;
+
+			glm::vec2 componentOffset(0.0f);
+			if (flags & 0x0001)
+			{
+				componentOffset = glm::vec2((float)I16(position), (float)I16(position + 2));
+				position += 4;
+			}
+			else
+			{
+				componentOffset = glm::vec2((float)(signed char)U8(position), (float)(signed char)U8(position + 1));
+				position += 2;
+			}
+			/* without ARGS_ARE_XY_VALUES the arguments are matching point numbers, placed at the origin here */
+			if (!(flags & 0x0002))
+				componentOffset = glm::vec2(0.0f);
+
+			/* F2Dot14 scale, one value, x and y, or a full 2x2 matrix */
+			glm::mat2 matrix(1.0f);
+			if (flags & 0x0008)
+			{
+				float scale = I16(position) / 16384.0f;
+				matrix = glm::mat2(scale);
+				position += 2;
+			}
+			else if (flags & 0x0040)
+			{
+				matrix = glm::mat2(I16(position) / 16384.0f, 0.0f, 0.0f, I16(position + 2) / 16384.0f);
+				position += 4;
+			}
+			else if (flags & 0x0080)
+			{
+				matrix = glm::mat2(I16(position) / 16384.0f, I16(position + 2) / 16384.0f,
+					I16(position + 4) / 16384.0f, I16(position + 6) / 16384.0f);
+				position += 8;
+			}
+
+			if (!AppendOutline(component, transform * matrix, transform * componentOffset + offset, edges, tolerance, depth + 1))
+				return false;
+		} while (flags & 0x0020);
+		return true;
+	}
+
+	/* simple glyph: contour end points, instructions, flags, then x and y deltas */
+	unsigned int endPoints = start + 10;
+	if (endPoints + contourCount * 2 + 2 > end)
+		return false;
+	int pointCount = contourCount > 0 ? (int)U16(endPoints + (contourCount - 1) * 2) + 1 : 0;
+	unsigned int position = endPoints + contourCount * 2;
+	position += 2 + U16(position);
+
+	std::vector<unsigned char> pointFlags(pointCount);
+	for (int i = 0; i < pointCount; )
+	{
+		if (position >= end)
+			return false;
+		unsigned char flag = (unsigned char)U8(position++);
+		int repeat = 1;
+		if (flag & 0x08)
+		{
+			if (position >= end)
+				return false;
+			repeat += U8(position++);
+		}
+		for (; repeat > 0 && i < pointCount; repeat--)
+			pointFlags[i++] = flag;
+	}
+
+	/* short deltas are a byte with the sign in the flags, otherwise a word unless the same flag says unchanged */
+	std::vector<glm::vec2> points(pointCount);
+	for (int axis = 0; axis < 2; axis++)
+	{
+		unsigned char shortBit = axis == 0 ? 0x02 : 0x04;
+		unsigned char sameBit = axis == 0 ? 0x10 : 0x20;
+		int value = 0;
+		for (int i = 0; i < pointCount; i++)
+		{
+			if (pointFlags[i] & shortBit)
+			{
+				if (position + 1 > end)
+					return false;
+				int delta = (int)U8(position++);
+				value += (pointFlags[i] & sameBit) ? delta : -delta;
+			}
+			else if (!(pointFlags[i] & sameBit))
+			{
+				if (position + 2 > end)
+					return false;
+				value += I16(position);
+				position += 2;
+			}
+			points[i][axis] = (float)value;
+		}
+	}
+
+	for (glm::vec2& point : points)
+		point = transform * point + offset;
+
+	int first = 0;
+	for (int contour = 0; contour < contourCount; contour++)
+	{
+		int last = (int)U16(endPoints + contour * 2);
+		if (last < first || last >= pointCount)
+			return false;
+		int count = last - first + 1;
+
+		/* start on an on curve point, or between two off curve points where one is implied */
+		auto onCurve = [&](int i) { return (pointFlags[first + i] & 0x01) != 0; };
+		auto point = [&](int i) { return points[first + i]; };
+		glm::vec2 startPoint;
+		int begin, steps;
+		if (onCurve(0))
+		{
+			startPoint = point(0);
+			begin = 1;
+			steps = count - 1;
+		}
+		else if (onCurve(count - 1))
+		{
+			startPoint = point(count - 1);
+			begin = 0;
+			steps = count - 1;
+		}
+		else
+		{
+			startPoint = (point(0) + point(count - 1)) * 0.5f;
+			begin = 0;
+			steps = count;
+		}
+
+		glm::vec2 previous = startPoint, control;
+		bool hasControl = false;
+		for (int step = 0; step < steps; step++)
+		{
+			int i = (begin + step) % count;
+			if (onCurve(i))
+			{
+				if (hasControl)
+					AppendQuadratic(edges, previous, control, point(i), tolerance);
+				else
+					edges.push_back({ previous, point(i) });
+				previous = point(i);
+				hasControl = false;
+			}
+			else
+			{
+				/* two off curve points in a row have an on curve point halfway between them */
+				if (hasControl)
+				{
+					glm::vec2 middle = (control + point(i)) * 0.5f;
+					AppendQuadratic(edges, previous, control, middle, tolerance);
+					previous = middle;
+				}
+				control = point(i);
+				hasControl = true;
+			}
+		}
+		if (hasControl)
+			AppendQuadratic(edges, previous, control, startPoint, tolerance);
+		else if (previous != startPoint)
+			edges.push_back({ previous, startPoint });
+
+		first = last + 1;
+	}
+	return true;
+}
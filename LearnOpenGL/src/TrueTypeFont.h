@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+/* Straight piece of a glyph outline in font units, curves are already flattened */
+struct GlyphEdge
+{
+	glm::vec2 A, B;
+};
+
+struct GlyphOutline
+{
+	std::vector<GlyphEdge> Edges;
+	/* font units, all zero for glyphs without contours such as the space */
+	int MinX, MinY, MaxX, MaxY;
+};
+
+/*
+* Minimal TrueType reader, just enough for text rendering
+* Reads the cmap (formats 4 and 12), hmtx, kern (format 0) and glyf tables,
+* including composite glyphs placed by offset. Hinting, GPOS kerning and
+* CFF based OpenType fonts are not supported. Everything is read straight
+* from the file bytes kept in memory, nothing is decoded up front.
+*/
+class TrueTypeFont
+{
+private:
+	/* where a table sits in the file, a length of 0 when the font does not have it */
+	struct Table
+	{
+		unsigned int Offset, Length;
+	};
+
+	std::vector<unsigned char> m_Data;
+	std::string m_FilePath;
+	/* unique per font so caches can key glyphs by font */
+	unsigned int m_ID;
+
+	Table m_Cmap, m_Glyf, m_Loca, m_Hmtx, m_Kern;
+	/* the unicode subtable picked from cmap */
+	unsigned int m_CmapSubtable;
+	int m_GlyphCount;
+	int m_UnitsPerEm;
+	/* 0 for 16 bit loca offsets, 1 for 32 bit */
+	int m_LocaFormat;
+	int m_HMetricCount;
+	int m_Ascent, m_Descent, m_LineGap;
+
+	static unsigned int s_NextID;
+public:
+	TrueTypeFont();
+
+	bool Load(const std::string& path);
+	inline bool IsLoaded() const { return !m_Data.empty(); }
+
+	/* 0, the missing glyph, when the font has no glyph for the codepoint */
+	int FindGlyph(unsigned int codepoint) const;
+	/* font units */
+	int GetAdvance(int glyph) const;
+	int GetKerning(int left, int right) const;
+	/* Flattened outline, curves are split so no edge strays more than about tolerance font units from the curve */
+	bool GetOutline(int glyph, GlyphOutline& outline, float tolerance) const;
+
+	/* multiply font units by this to get pixels at pixelHeight from ascent to descent */
+	inline float GetScale(float pixelHeight) const { return pixelHeight / (float)(m_Ascent - m_Descent); }
+	inline int GetAscent() const { return m_Ascent; }
+	inline int GetDescent() const { return m_Descent; }
+	inline int GetLineGap() const { return m_LineGap; }
+	inline int GetUnitsPerEm() const { return m_UnitsPerEm; }
+	inline int GetGlyphCount() const { return m_GlyphCount; }
+	inline unsigned int GetID() const { return m_ID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+
+private:
+	Table FindTable(const char* tag) const;
+	/* byte range of a glyph in glyf, empty glyphs have a length of 0 */
+	bool GetGlyphRange(int glyph, unsigned int& offset, unsigned int& length) const;
+	bool AppendOutline(int glyph, const glm::mat2& transform, const glm::vec2& offset,
+		std::vector<GlyphEdge>& edges, float tolerance, int depth) const;
+
+	inline unsigned int U8(unsigned int offset) const { return m_Data[offset]; }
+	inline unsigned int U16(unsigned int offset) const { return (m_Data[offset] << 8) | m_Data[offset + 1]; }
+	inline int I16(unsigned int offset) const { return (short)U16(offset); }
+	inline unsigned int U32(unsigned int offset) const { return (U16(offset) << 16) | U16(offset + 2); }
+	/* the file can be anything, every read is checked against the table it is in first */
+	inline bool InTable(const Table& table, unsigned int offset, unsigned int length) const
+	{
+		return offset >= table.Offset && offset - table.Offset <= table.Length && length <= table.Length - (offset - table.Offset);
+	}
+};
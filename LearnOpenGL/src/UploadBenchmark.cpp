@@ -0,0 +1,135 @@
+#include "UploadBenchmark.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "Renderer.h"
+#include "Texture.h"
+#include "DynamicTexture.h"
+#include "JobSystem.h"
+
+UploadBenchmark::UploadBenchmark(JobSystem* jobs, int width, int height, unsigned int frames)
+	: m_Jobs(jobs), m_Width(width), m_Height(height), m_Frames(frames)
+{
+}
+
+bool UploadBenchmark::Run()
+{
+	double frameMegabytes = (double)m_Width * m_Height * 4 / (1024.0 * 1024.0);
+	std::cout << "Upload benchmark: " << m_Width << "x" << m_Height << " RGBA8, " << m_Frames << " frames, "
+		<< frameMegabytes * 60.0 << " MB/s needed for 60 Hz" << std::endl;
+
+	std::vector<UploadBenchmarkResult> results;
+	results.push_back(RunClientMemory());
+	results.push_back(RunRing(false));
+	if (GLEW_ARB_buffer_storage)
+		results.push_back(RunRing(true));
+	else
+		std::cout << "  GL_ARB_buffer_storage not supported, skipping persistent mapping" << std::endl;
+
+	bool correct = true;
+	for (const UploadBenchmarkResult& result : results)
+	{
+		std::cout << "  " << result.Method << ": " << result.MegabytesPerSecond << " MB/s, "
+			<< result.MillisecondsPerFrame << " ms per frame, " << result.Stalls << " stalls"
+			<< (result.MegabytesPerSecond >= frameMegabytes * 60.0 ? ", keeps up with 60 Hz" : "")
+			<< (result.Correct ? "" : ", WRONG PIXELS") << std::endl;
+		correct = correct && result.Correct;
+	}
+	return correct;
+}
+
+UploadBenchmarkResult UploadBenchmark::RunClientMemory()
+{
+	Texture texture(m_Width, m_Height, nullptr);
+	/* two frames in memory, a worker fills one while the other uploads */
+	std::vector<unsigned char> frames[2];
+	JobCounter counters[2];
+	for (std::vector<unsigned char>& frame : frames)
+		frame.resize((size_t)m_Width * m_Height * 4);
+
+	auto start = std::chrono::steady_clock::now();
+	GenerateFrame(frames[0].data(), 0, counters[0]);
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		if (frame + 1 < m_Frames)
+			GenerateFrame(frames[(frame + 1) % 2].data(), frame + 1, counters[(frame + 1) % 2]);
+
+		m_Jobs->Wait(counters[frame % 2]);
+		/* copies out of client memory before returning */
+		texture.Update(frames[frame % 2].data());
+	}
+	GLCall(glFinish());
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double megabytes = (double)m_Width * m_Height * 4 * m_Frames / (1024.0 * 1024.0);
+	return { "glTexSubImage2D from client memory", megabytes / seconds, (float)(seconds * 1000.0 / m_Frames), 0,
+		CheckTexture(texture, m_Frames - 1) };
+}
+
+UploadBenchmarkResult UploadBenchmark::RunRing(bool persistent)
+{
+	DynamicTexture texture(m_Width, m_Height, 3, persistent);
+	DynamicTextureWrite writes[2];
+	JobCounter counters[2];
+
+	auto start = std::chrono::steady_clock::now();
+	writes[0] = texture.BeginWrite();
+	GenerateFrame(writes[0].Pixels, 0, counters[0]);
+	for (unsigned int frame = 0; frame < m_Frames; frame++)
+	{
+		/* the worker writes straight into the next buffer while this one uploads */
+		if (frame + 1 < m_Frames)
+		{
+			writes[(frame + 1) % 2] = texture.BeginWrite();
+			GenerateFrame(writes[(frame + 1) % 2].Pixels, frame + 1, counters[(frame + 1) % 2]);
+		}
+
+		m_Jobs->Wait(counters[frame % 2]);
+		texture.Commit(writes[frame % 2]);
+	}
+	GLCall(glFinish());
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double megabytes = (double)m_Width * m_Height * 4 * m_Frames / (1024.0 * 1024.0);
+	return { persistent ? "DynamicTexture, persistently mapped" : "DynamicTexture, orphaned", megabytes / seconds,
+		(float)(seconds * 1000.0 / m_Frames), texture.GetStallCount(), CheckTexture(texture.GetTexture(), m_Frames - 1) };
+}
+
+void UploadBenchmark::GenerateFrame(unsigned char* pixels, unsigned int frame, JobCounter& counter) const
+{
+	int width = m_Width;
+	/* rows in parallel, a moving gradient with a frame stamp in the blue channel */
+	m_Jobs->ParallelFor((unsigned int)m_Height, [pixels, frame, width](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int y = begin; y < end; y++)
+		{
+			unsigned char* row = pixels + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+				row[x * 4 + 0] = (unsigned char)(x + frame);
+				row[x * 4 + 1] = (unsigned char)(y + frame * 3);
+				row[x * 4 + 2] = (unsigned char)frame;
+				row[x * 4 + 3] = 255;
+			}
+		}
+	}, &counter, 16);
+}
+
+bool UploadBenchmark::CheckTexture(const Texture& texture, unsigned int frame) const
+{
+	std::vector<unsigned char> expected((size_t)m_Width * m_Height * 4);
+	std::vector<unsigned char> actual(expected.size());
+	JobCounter counter;
+	GenerateFrame(expected.data(), frame, counter);
+	m_Jobs->Wait(counter);
+
+	texture.Bind();
+	GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, actual.data()));
+	texture.UnBind();
+	return actual == expected;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+class JobSystem;
+class Texture;
+struct JobCounter;
+
+struct UploadBenchmarkResult
+{
+	const char* Method;
+	/* upload rate over all frames, including the final glFinish */
+	double MegabytesPerSecond;
+	float MillisecondsPerFrame;
+	/* times the producer had to wait for the GPU to free a buffer */
+	unsigned long long Stalls;
+	/* the texture held the last frame's pixels afterwards */
+	bool Correct;
+};
+
+/*
+* Measures how fast a texture can be rewritten every frame
+* Frames are generated on the job system, the next one while the last one
+* uploads, and sent with each upload method in turn: plain glTexSubImage2D
+* from client memory and a DynamicTexture ring, orphaned and, when supported,
+* persistently mapped. The rate needed for the size at 60 Hz is printed for
+* comparison. Needs a current GL context.
+*/
+class UploadBenchmark
+{
+private:
+	JobSystem* m_Jobs;
+	int m_Width, m_Height;
+	unsigned int m_Frames;
+public:
+	UploadBenchmark(JobSystem* jobs, int width = 1920, int height = 1080, unsigned int frames = 120);
+
+	/* Prints a line per method, returns false if any left the wrong pixels in the texture */
+	bool Run();
+
+private:
+	UploadBenchmarkResult RunClientMemory();
+	UploadBenchmarkResult RunRing(bool persistent);
+
+	/* procedural pattern that changes every frame, like a heatmap or a decoded video frame */
+	void GenerateFrame(unsigned char* pixels, unsigned int frame, JobCounter& counter) const;
+	bool CheckTexture(const Texture& texture, unsigned int frame) const;
+};
@@ -14,6 +14,12 @@ VertexArray::~VertexArray()
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+    AddBuffer(vb, layout, 0, 0);
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute, unsigned int divisor,
+    unsigned int byteOffset)
 {
     /* bind vertex array */
     Bind();
@@ -21,13 +27,14 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	vb.Bind();
     /* setup layout */
     const auto& elements = layout.GetElements();
+    /* byte offset of each attribute inside a vertex, has to carry over between attributes */
+    unsigned int offset = byteOffset;
     for (unsigned int i = 0; i < elements.size(); i++)
     {
         const auto& element = elements[i]; 
-        unsigned int offset = 0;
 
         /* To enable and disable index in vertex attribute array */
-        GLCall(glEnableVertexAttribArray(i));
+        GLCall(glEnableVertexAttribArray(firstAttribute + i));
 
         /* glVertexAttribPointer info:
         * Tells OpenGL how to read data. Specifies layout.
@@ -39,8 +46,12 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
         * @param pointer - how many bytes to go forward to next attribute, bytes to attributes from vertex ptr
         */
         /* Binds vao to currently bound vertex buffer */
-        GLCall(glVertexAttribPointer(i, element.count, element.type, 
-            element.normalized, layout.GetStride(), (const void*)offset));
+        GLCall(glVertexAttribPointer(firstAttribute + i, element.count, element.type, 
+            element.normalized, layout.GetStride(), (const void*)(size_t)offset));
+        if (divisor)
+        {
+            GLCall(glVertexAttribDivisor(firstAttribute + i, divisor));
+        }
         offset += element.count * VertexBufferElement::GetSizeOfType(element.type); 
 
     }
@@ -49,6 +60,7 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 
 void VertexArray::Bind() const
 {
+    RENDER_STAT(VertexArrayBinds, 1);
     GLCall(glBindVertexArray(m_RendererID));
 }
 
@@ -13,6 +13,14 @@ public:
 	~VertexArray();
 
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout); 
+	/*
+	* layout's attributes start at firstAttribute instead of 0, so several buffers
+	* can feed one vertex array. A divisor of 1 advances them once per instance.
+	* Reading starts byteOffset into vb, calling again with another offset moves
+	* the same attributes, which stands in for a base instance.
+	*/
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute, unsigned int divisor,
+		unsigned int byteOffset = 0);
 
 	void Bind() const; 
 	void UnBind() const; 
@@ -1,8 +1,10 @@
 #include "VertexBuffer.h"
 
 #include "Renderer.h"
+#include "GpuMemory.h"
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+    : m_Size(size)
 {
     GLCall(glGenBuffers(1, &m_RendererID));
 
@@ -12,15 +14,28 @@ VertexBuffer::VertexBuffer(const void* data, unsigned int size)
     /* give OpenGL the data, can do this later buffer just needs to be bound */
     /* cannot use a signed type for index buffer*/
     GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    RENDER_STAT(BufferBytesUploaded, size);
+    m_MemoryID = GpuMemory::Track(GpuMemoryCategory::VertexBuffer, size, "Static vertex buffer");
+}
+
+VertexBuffer::VertexBuffer(unsigned int size)
+    : m_Size(size)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+    m_MemoryID = GpuMemory::Track(GpuMemoryCategory::VertexBuffer, size, "Dynamic vertex buffer");
 }
 
 VertexBuffer::~VertexBuffer()
 {
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GpuMemory::Release(m_MemoryID);
 }
 
 void VertexBuffer::Bind() const 
 {
+    RENDER_STAT(BufferBinds, 1);
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
 }
 
@@ -28,3 +43,64 @@ void VertexBuffer::UnBind() const
 {
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
+
+void VertexBuffer::SetData(const void* data, unsigned int size)
+{
+    ASSERT(size <= m_Size);
+    Bind();
+    /*
+    * Orphan the old storage first, if the GPU is still reading last frame's
+    * contents the driver hands out fresh memory instead of waiting
+    */
+    GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+    RENDER_STAT(BufferBytesUploaded, size);
+}
+
+void VertexBuffer::Orphan(unsigned int size)
+{
+    Bind();
+    if (size > m_Size)
+    {
+        m_Size = size;
+        GpuMemory::Resize(m_MemoryID, size);
+    }
+    GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+}
+
+void* VertexBuffer::Map(unsigned int size)
+{
+    ASSERT(size <= m_Size);
+    Bind();
+    /* invalidating gets fresh storage like Orphan, the GPU may still be reading the old contents */
+    GLCall(void* data = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    RENDER_STAT(BufferBytesUploaded, size);
+    return data;
+}
+
+void VertexBuffer::Unmap()
+{
+    Bind();
+    GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+}
+
+void VertexBuffer::BindFeedback(unsigned int index) const
+{
+    RENDER_STAT(BufferBinds, 1);
+    GLCall(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, index, m_RendererID));
+}
+
+void VertexBuffer::BindFeedback(unsigned int index, unsigned int offset, unsigned int size) const
+{
+    ASSERT(offset + size <= m_Size);
+    RENDER_STAT(BufferBinds, 1);
+    GLCall(glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, index, m_RendererID, offset, size));
+}
+
+void VertexBuffer::SetSubData(const void* data, unsigned int offset, unsigned int size)
+{
+    ASSERT(offset + size <= m_Size);
+    Bind();
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+    RENDER_STAT(BufferBytesUploaded, size);
+}
@@ -3,12 +3,36 @@ class VertexBuffer
 {
 private: 
 	unsigned int m_RendererID; 
+	unsigned int m_Size;
+	/* GpuMemory allocation id */
+	unsigned int m_MemoryID;
 public: 
 	/* size means bytes */
 	VertexBuffer(const void* data, unsigned int size); 
+	/* dynamic buffer of size bytes, filled later with SetData */
+	VertexBuffer(unsigned int size);
 	~VertexBuffer(); 
 
 	void Bind() const;
 	void UnBind() const;
+
+	/* replaces the start of the buffer, leaves it bound */
+	void SetData(const void* data, unsigned int size);
+	/* orphans the storage like SetData without filling it, grows it when size is larger, leaves it bound */
+	void Orphan(unsigned int size);
+	/* writes size bytes at offset into the current storage, leaves it bound */
+	void SetSubData(const void* data, unsigned int offset, unsigned int size);
+	/*
+	* Orphans the storage and maps its first size bytes for writing, any thread
+	* may fill them until Unmap. Leaves the buffer bound.
+	*/
+	void* Map(unsigned int size);
+	void Unmap();
+	/* makes the buffer where transform feedback binding point index writes to */
+	void BindFeedback(unsigned int index) const;
+	/* only size bytes from offset, offset a multiple of 4 */
+	void BindFeedback(unsigned int index, unsigned int offset, unsigned int size) const;
+
+	inline unsigned int GetSize() const { return m_Size; }
 };
 
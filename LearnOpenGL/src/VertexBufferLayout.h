@@ -1,4 +1,5 @@
 #pragma once
+#include <memory_resource>
 #include <vector>
 #include <GL/glew.h>
 #include "Renderer.h"
@@ -27,40 +28,44 @@ struct VertexBufferElement
 class VertexBufferLayout
 {
 private: 
-	std::vector<VertexBufferElement> m_Elements;
+	std::pmr::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride; 
 public: 
-	VertexBufferLayout()
-		: m_Stride(0) {};
+	/* a layout built every frame can take its elements from the frame arena */
+	VertexBufferLayout(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: m_Elements(resource), m_Stride(0) {};
 
+	/* float, unsigned int and unsigned char only, other types fail to compile */
 	template<typename T>
 	void Push(unsigned int count)
 	{
-		static_assert(false);
+		/* depends on T so it only fires when instantiated, a plain false is rejected outside MSVC */
+		static_assert(sizeof(T) == 0, "VertexBufferLayout::Push supports float, unsigned int and unsigned char");
 	}
 
-	template<>
-	void Push<float>(unsigned int count)
-	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE});
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
-	}
-
-	template<>
-	void Push<unsigned int>(unsigned int count)
-	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
-	}
-
-	template<>
-	void Push<unsigned char>(unsigned int count)
-	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
-	}
-	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
+	inline const std::pmr::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	//const&
 	inline unsigned int GetStride() const { return m_Stride; }
 };
 
+/* explicit specializations belong at namespace scope, GCC and Clang reject them inside the class */
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count)
+{
+	m_Elements.push_back({ GL_FLOAT, count, GL_FALSE});
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned int>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned char>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+}